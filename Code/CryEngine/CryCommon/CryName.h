@@ -20,6 +20,58 @@
 #include <ISystem.h>
 #include <StlUtils.h>
 
+#if (defined(_MSC_VER) && _MSC_VER >= 1900) || __cplusplus >= 201103L
+	#define CRY_NAME_CONSTEXPR_HASH
+	#include <type_traits>
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Hash of a name as stored in the name table entries: 32-bit FNV-1a over
+// the characters, lower cased unless CNAMETABLE_CASE_SENSITIVE, so names
+// that compare equal have the same hash.
+//////////////////////////////////////////////////////////////////////////
+#define CRY_NAME_HASH_BASIS 2166136261u
+#define CRY_NAME_HASH_PRIME 16777619u
+
+#ifdef CNAMETABLE_CASE_SENSITIVE
+	#define CRY_NAME_HASH_CHAR(c) ((uint32)(unsigned char)(c))
+#else
+	#define CRY_NAME_HASH_CHAR(c) ((uint32)(unsigned char)((c) >= 'A' && (c) <= 'Z' ? (c)+('a'-'A') : (c)))
+#endif
+
+inline uint32 CryNameHash( const char *str )
+{
+	uint32 nHash = CRY_NAME_HASH_BASIS;
+	for (; *str; ++str)
+		nHash = (nHash ^ CRY_NAME_HASH_CHAR(*str)) * CRY_NAME_HASH_PRIME;
+	return nHash;
+}
+
+#ifdef CRY_NAME_CONSTEXPR_HASH
+// CryNameHash for the compiler, see CRY_NAME_LITERAL.
+constexpr uint32 CryNameHashConst( const char *str,uint32 nHash = CRY_NAME_HASH_BASIS )
+{
+	return *str ? CryNameHashConst(str+1,(nHash ^ CRY_NAME_HASH_CHAR(*str)) * CRY_NAME_HASH_PRIME) : nHash;
+}
+#endif
+
+// A string with its CryNameHash, CCryName doesn't hash it again.
+struct SCryNameHashed
+{
+	SCryNameHashed( const char *_str,uint32 _nHash ) : str(_str),nHash(_nHash) {}
+
+	const char *str;
+	uint32 nHash;
+};
+
+// Name literal hashed at compile time where the compiler has constexpr:
+//   static const CCryName s_idle( CRY_NAME_LITERAL("Idle") );
+#ifdef CRY_NAME_CONSTEXPR_HASH
+	#define CRY_NAME_LITERAL(s) SCryNameHashed( s,std::integral_constant<uint32,CryNameHashConst(s)>::value )
+#else
+	#define CRY_NAME_LITERAL(s) SCryNameHashed( s,CryNameHash(s) )
+#endif
+
 
 
 
@@ -43,27 +95,43 @@ struct INameTable
 	// Name entry header, immediately after this header in memory starts actual string data.
 	struct SNameEntry
 	{
-		// Reference count of this string.
-		int nRefCount;
+		// Reference count of this string. It only drops to 0 or rises from 0 with the table locked.
+		volatile int nRefCount;
 		// Current length of string.
 		int nLength;
 		// Size of memory allocated at the end of this class.
 		int nAllocSize;
+		// CryNameHash of the string.
+		uint32 nHash;
+		// Next entry in the same bucket of the name table.
+		SNameEntry *pNext;
 		// Here in memory starts character buffer of size nAllocSize.
 		//char data[nAllocSize]
 
 		char* GetStr() { return (char*)(this+1); }
-		void  AddRef() { nRefCount++; /*InterlockedIncrement(&_header()->nRefCount);*/};
-		int   Release() { return --nRefCount; };
+		// Only for the holder of a reference.
+		void  AddRef() { CryInterlockedAdd(&nRefCount,1); }
+		// Drops a reference unless it is the last one, which only the name table can release.
+		bool  ReleaseIfNotLast()
+		{
+			for (int n = CryLockWordLoad(&nRefCount); n > 1; n = CryLockWordLoad(&nRefCount))
+			{
+				if (CryInterlockedTrySet(&nRefCount,n,n-1))
+					return true;
+			}
+			return false;
+		}
     int   GetMemoryUsage() { return sizeof(SNameEntry)+strlen(GetStr()); }
 	};
 #endif
 
 	// Finds an existing name table entry, or creates a new one if not found.
-  virtual SNameEntry* GetEntry( const char *str ) = 0;
+	// nHash is CryNameHash(str), the entry comes with a reference for the caller.
+  virtual SNameEntry* GetEntry( const char *str,uint32 nHash ) = 0;
 	// Only finds an existing name table entry, return 0 if not found.
-	virtual SNameEntry* FindEntry( const char *str ) = 0;
-	// Release existing name table entry.
+	// Adds a reference for the caller like GetEntry.
+	virtual SNameEntry* FindEntry( const char *str,uint32 nHash ) = 0;
+	// Releases a reference of the caller, the entry is deleted with the last one.
 	virtual void Release( SNameEntry *pEntry ) = 0;
   virtual int GetMemoryUsage() = 0;
 };
@@ -99,6 +167,8 @@ class CNameTable : public INameTable
 
   SNameTableBlock *m_pBlocks;
   SNameTableBlock *m_pClosedBlocks;
+  // guards the set and the blocks, names can be created from any thread
+  volatile int m_lock;
 
   char *Alloc(const char *str)
   {
@@ -159,10 +229,11 @@ class CNameTable : public INameTable
   }
 
 public:
-  CNameTable() : m_pBlocks(NULL), m_pClosedBlocks(NULL) { }
+  CNameTable() : m_pBlocks(NULL), m_pClosedBlocks(NULL), m_lock(0) { }
 
-  virtual INameTable::SNameEntry *FindEntry(const char *str)
+  virtual INameTable::SNameEntry *FindEntry(const char *str, uint32 nHash)
   {
+    WriteLock lock(m_lock);
     TableT &table = m_Table;
 
     if (table.empty())
@@ -173,8 +244,9 @@ public:
     return reinterpret_cast<INameTable::SNameEntry *>(*it);
   }
 
-  virtual INameTable::SNameEntry *GetEntry(const char *str)
+  virtual INameTable::SNameEntry *GetEntry(const char *str, uint32 nHash)
   {
+    WriteLock lock(m_lock);
     TableT &table = m_Table;
 
     if (table.empty())
@@ -197,6 +269,7 @@ public:
 
   virtual int GetMemoryUsage()
   {
+    WriteLock lock(m_lock);
     const TableT &table = m_Table;
     int size = sizeof(TableT) + table.size() * sizeof(char *);
 
@@ -221,44 +294,92 @@ public:
 };
 #else // else if defined USE_WRONLY_NAMETABLE
 #define CRY_NAME_HASHTABLE_SIZE 1024*8
+// The table is split into 1<<CRY_NAME_TABLE_SHARD_BITS shards of CRY_NAME_HASHTABLE_SIZE buckets in total.
+#define CRY_NAME_TABLE_SHARD_BITS 6
+#define CRY_NAME_TABLE_SHARDS (1<<CRY_NAME_TABLE_SHARD_BITS)
 
+//////////////////////////////////////////////////////////////////////////
+// Name table that can be used from any thread. The entries are spread over
+// shards by the top bits of their hash, each shard has its own lock and
+// chained hash table, so threads only wait for each other when they touch
+// names of the same shard. Lookups share the lock, adding and deleting an
+// entry takes it exclusively. Outside the lock a reference count only
+// changes while the caller holds another reference, so an entry can't be
+// found again while it is deleted.
 //////////////////////////////////////////////////////////////////////////
 class CNameTable : public INameTable
 {
 public:
 	CNameTable()
-#ifdef USE_HASH_MAP
-		: m_nameMap(CRY_NAME_HASHTABLE_SIZE)
-#endif //USE_HASH_MAP
-	{}
+	{
+		for (int i=0; i<CRY_NAME_TABLE_SHARDS; ++i)
+		{
+			SShard &shard = m_shards[i];
+			shard.nBuckets = CRY_NAME_HASHTABLE_SIZE/CRY_NAME_TABLE_SHARDS;
+			shard.pBuckets = (SNameEntry**)calloc( shard.nBuckets,sizeof(SNameEntry*) );
+			shard.nCount = 0;
+			shard.lock = 0;
+		}
+	}
+
+	~CNameTable()
+	{
+		// Like the entries of a map, entries still referenced are not freed.
+		for (int i=0; i<CRY_NAME_TABLE_SHARDS; ++i)
+			free(m_shards[i].pBuckets);
+	}
 
 	// Only finds an existing name table entry, return 0 if not found.
-	virtual SNameEntry* FindEntry( const char *str )
+	virtual SNameEntry* FindEntry( const char *str,uint32 nHash )
 	{
-		SNameEntry *pEntry = stl::find_in_map( m_nameMap,str,0 );
+		SShard &shard = GetShard(nHash);
+		ReadLock lock(shard.lock);
+		SNameEntry *pEntry = Find( shard,str,nHash );
+		if (pEntry)
+			pEntry->AddRef();
 		return pEntry;
 	}
 
 	// Finds an existing name table entry, or creates a new one if not found.
-	virtual SNameEntry* GetEntry( const char *str )
+	virtual SNameEntry* GetEntry( const char *str,uint32 nHash )
 	{
-		SNameEntry *pEntry = stl::find_in_map( m_nameMap,str,0 );
-		if (!pEntry)
+		SShard &shard = GetShard(nHash);
+		{
+			ReadLock lock(shard.lock);
+			if (SNameEntry *pEntry = Find( shard,str,nHash ))
+			{
+				pEntry->AddRef();
+				return pEntry;
+			}
+		}
+
+		// Another thread may have added it in between.
+		WriteLock lock(shard.lock);
+		SNameEntry *pEntry = Find( shard,str,nHash );
+		if (pEntry)
 		{
-			// Create a new entry.
-			unsigned int nLen = strlen(str);
-			unsigned int allocLen = sizeof(SNameEntry) + (nLen+1)*sizeof(char);
-			pEntry = (SNameEntry*)malloc( allocLen );
-			pEntry->nRefCount = 0;
-			pEntry->nLength = nLen;
-			pEntry->nAllocSize = allocLen;
-			// Copy string to the end of name entry.
-			char *pEntryStr = pEntry->GetStr();
-			memcpy( pEntryStr,str,nLen+1 );
-			// put in map.
-			//m_nameMap.insert( NameMap::value_type(pEntry->GetStr(),pEntry) );
-			m_nameMap[pEntry->GetStr()] = pEntry;
+			pEntry->AddRef();
+			return pEntry;
 		}
+
+		// Create a new entry.
+		unsigned int nLen = strlen(str);
+		unsigned int allocLen = sizeof(SNameEntry) + (nLen+1)*sizeof(char);
+		pEntry = (SNameEntry*)malloc( allocLen );
+		pEntry->nRefCount = 1;
+		pEntry->nLength = nLen;
+		pEntry->nAllocSize = allocLen;
+		pEntry->nHash = nHash;
+		// Copy string to the end of name entry.
+		char *pEntryStr = pEntry->GetStr();
+		memcpy( pEntryStr,str,nLen+1 );
+
+		if (shard.nCount >= shard.nBuckets)
+			Rehash( shard,shard.nBuckets*2 );
+		SNameEntry *&pBucket = shard.pBuckets[nHash & (shard.nBuckets-1)];
+		pEntry->pNext = pBucket;
+		pBucket = pEntry;
+		++shard.nCount;
 		return pEntry;
 	}
 
@@ -266,43 +387,93 @@ public:
 	virtual void Release( SNameEntry *pEntry )
 	{
 		assert(pEntry);
-		m_nameMap.erase( pEntry->GetStr() );
+		SShard &shard = GetShard(pEntry->nHash);
+		WriteLock lock(shard.lock);
+
+		// Holders of other references may drop theirs meanwhile, but never the last one.
+		int nRefCount;
+		do
+		{
+			nRefCount = CryLockWordLoad(&pEntry->nRefCount);
+			assert(nRefCount > 0);
+		} while (!CryInterlockedTrySet(&pEntry->nRefCount,nRefCount,nRefCount-1));
+		if (nRefCount > 1)
+			return;
+
+		SNameEntry **ppLink = &shard.pBuckets[pEntry->nHash & (shard.nBuckets-1)];
+		while (*ppLink != pEntry)
+			ppLink = &(*ppLink)->pNext;
+		*ppLink = pEntry->pNext;
+		--shard.nCount;
 		free(pEntry);
 	}
+
   virtual int GetMemoryUsage()
   {
     int nSize = 0;
-    NameMap::iterator it;
-    int n = 0;
-    for (it=m_nameMap.begin(); it!=m_nameMap.end(); it++)
+    for (int i=0; i<CRY_NAME_TABLE_SHARDS; ++i)
     {
-      nSize += strlen(it->first);
-      nSize += it->second->GetMemoryUsage();
-      n++;
+      SShard &shard = m_shards[i];
+      ReadLock lock(shard.lock);
+      nSize += shard.nBuckets*sizeof(SNameEntry*);
+      for (int j=0; j<shard.nBuckets; ++j)
+      {
+        for (SNameEntry *pEntry = shard.pBuckets[j]; pEntry; pEntry = pEntry->pNext)
+          nSize += pEntry->GetMemoryUsage();
+      }
     }
-    nSize += n*8;
-#ifdef USE_HASH_MAP
-    nSize += CRY_NAME_HASHTABLE_SIZE;
-#endif //USE_HASH_MAP
     return nSize;
   }
 
 private:
+	struct SShard
+	{
+		// entries by the low bits of their hash
+		SNameEntry **pBuckets;
+		int nBuckets;
+		int nCount;
+		volatile int lock;
+		// keeps the locks of neighbouring shards apart
+		char pad[64-sizeof(SNameEntry**)-3*sizeof(int)];
+	};
+
+	SShard& GetShard( uint32 nHash ) { return m_shards[nHash >> (32-CRY_NAME_TABLE_SHARD_BITS)]; }
+
+	static SNameEntry* Find( const SShard &shard,const char *str,uint32 nHash )
+	{
+		for (SNameEntry *pEntry = shard.pBuckets[nHash & (shard.nBuckets-1)]; pEntry; pEntry = pEntry->pNext)
+		{
+			if (pEntry->nHash == nHash && compare(pEntry->GetStr(),str) == 0)
+				return pEntry;
+		}
+		return 0;
+	}
+
+	static void Rehash( SShard &shard,int nBuckets )
+	{
+		SNameEntry **pBuckets = (SNameEntry**)calloc( nBuckets,sizeof(SNameEntry*) );
+		for (int i=0; i<shard.nBuckets; ++i)
+		{
+			for (SNameEntry *pEntry = shard.pBuckets[i], *pNext; pEntry; pEntry = pNext)
+			{
+				pNext = pEntry->pNext;
+				SNameEntry *&pBucket = pBuckets[pEntry->nHash & (nBuckets-1)];
+				pEntry->pNext = pBucket;
+				pBucket = pEntry;
+			}
+		}
+		free(shard.pBuckets);
+		shard.pBuckets = pBuckets;
+		shard.nBuckets = nBuckets;
+	}
+
 #ifdef CNAMETABLE_CASE_SENSITIVE
-  #ifdef USE_HASH_MAP
-    typedef stl::hash_map<const char*,SNameEntry*,stl::hash_strcmp<const char*> > NameMap;
-  #else
-    typedef std::map<const char*,SNameEntry*,stl::less_strcmp<const char*> > NameMap;
-  #endif
+	static int compare( const char *s1,const char *s2 ) { return strcmp(s1,s2); }
 #else
-  #ifdef USE_HASH_MAP
-    typedef stl::hash_map<const char*,SNameEntry*,stl::hash_stricmp<const char*> > NameMap;
-  #else
-    typedef std::map<const char*,SNameEntry*,stl::less_stricmp<const char*> > NameMap;
-  #endif
+	static int compare( const char *s1,const char *s2 ) { return stricmp(s1,s2); }
 #endif
 
-	NameMap m_nameMap;
+	SShard m_shards[CRY_NAME_TABLE_SHARDS];
 };
 #endif // end else if defined USE_WRONLY_NAMETABLE
 
@@ -315,11 +486,13 @@ public:
 	CCryName();
 	CCryName( const CCryName& n );
 	CCryName( const char *s );
+	CCryName( const SCryNameHashed &s );
 	CCryName( const char *s,bool bOnlyFind );
 	~CCryName();
 
 	CCryName& operator=( const CCryName& n );
 	CCryName& operator=( const char *s );
+	CCryName& operator=( const SCryNameHashed &s );
 
 	bool	operator==( const CCryName &n ) const;
 	bool	operator!=( const CCryName &n ) const;
@@ -335,12 +508,14 @@ public:
 
 	const	char*	c_str() const { return (m_str) ? m_str: ""; }
 	int	length() const { return _length(); };
+	// CryNameHash of the name, 0 for the empty name.
+	uint32 GetHash() const { return _hash(); }
 
-	static bool find( const char *str ) { return GetNameTable()->FindEntry(str) != 0; }
+	static bool find( const char *str ) { return !CCryName(str,true).empty(); }
   static const char *create( const char *str )
   {
     CCryName name = CCryName(str);
-    name._addref(name.c_str());
+    name._addref(name.m_str);
     return name.c_str();
   }
   static int GetMemoryUsage()
@@ -362,11 +537,20 @@ private:
     // Note: can not use a 'static CNameTable sTable' here, because that
     // implies a static destruction order depenency - the name table is
     // accessed from static destructor calls.
-		static CNameTable *table = NULL;
+		static CNameTable *volatile table = NULL;
 
-    if (table == NULL)
-      table = new CNameTable();
-    return table;
+		CNameTable *pTable = CryLoadAcquire(&table);
+		if (pTable == NULL)
+		{
+			// threads that get here at the same time agree on the first table
+			pTable = new CNameTable();
+			if (CNameTable *pOther = (CNameTable*)CryInterlockedCompareExchangePointer((void *volatile *)&table,pTable,NULL))
+			{
+				delete pTable;
+				pTable = pOther;
+			}
+		}
+    return pTable;
 	}
 #else
 	//static INameTable* GetNameTable() { return GetISystem()->GetINameTable(); }
@@ -381,16 +565,20 @@ private:
   }
   void _release( const char *pBuffer) { }
 	int  _length() const { return (m_str) ? strlen(m_str) + 1 : 0; };
+	uint32 _hash() const { return (m_str) ? CryNameHash(m_str) : 0; }
 	void _addref( const char *pBuffer ) { }
 #else
 	SNameEntry* _entry( const char *pBuffer ) const { assert(pBuffer); return ((SNameEntry*)pBuffer)-1; }
 	void _release( const char *pBuffer ) {
-		if (pBuffer && _entry(pBuffer)->Release() <= 0)
+		if (pBuffer && !_entry(pBuffer)->ReleaseIfNotLast())
 			GetNameTable()->Release(_entry(pBuffer));
 	}
 	int  _length() const { return (m_str) ? _entry(m_str)->nLength : 0; };
+	uint32 _hash() const { return (m_str) ? _entry(m_str)->nHash : 0; }
 	void _addref( const char *pBuffer ) { if (pBuffer) _entry(pBuffer)->AddRef(); }
 #endif
+	// takes over the reference that the name table added to the entry
+	void _assign( const char *s,uint32 nHash );
 
 	const char *m_str;
 };
@@ -415,20 +603,23 @@ inline CCryName::CCryName( const char *s )
 	*this = s;
 }
 
+//////////////////////////////////////////////////////////////////////////
+inline CCryName::CCryName( const SCryNameHashed &s )
+{
+	m_str = 0;
+	*this = s;
+}
+
 //////////////////////////////////////////////////////////////////////////
 inline CCryName::CCryName( const char *s,bool bOnlyFind )
 {
 	assert(s);
 	m_str = 0;
-	const char *pBuf = 0;
 	if (*s) // if not empty
 	{
-		SNameEntry *pNameEntry = GetNameTable()->FindEntry(s);
+		SNameEntry *pNameEntry = GetNameTable()->FindEntry(s,CryNameHash(s));
 		if (pNameEntry)
-		{
 			m_str = pNameEntry->GetStr();
-			_addref(m_str);
-		}
 	}
 }
 
@@ -453,18 +644,29 @@ inline CCryName&	CCryName::operator=( const CCryName &n )
 inline CCryName&	CCryName::operator=( const char *s )
 {
 	assert(s);
+	_assign( s,(*s) ? CryNameHash(s) : 0 );
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+inline CCryName&	CCryName::operator=( const SCryNameHashed &s )
+{
+	assert(s.str && (!*s.str || s.nHash == CryNameHash(s.str)));
+	_assign( s.str,s.nHash );
+	return *this;
+}
+
+//////////////////////////////////////////////////////////////////////////
+inline void CCryName::_assign( const char *s,uint32 nHash )
+{
 	const char *pBuf = 0;
 	if (*s) // if not empty
 	{
-		pBuf = GetNameTable()->GetEntry(s)->GetStr();
-	}
-	if (m_str != pBuf)
-	{
-		_release(m_str);
-		m_str = pBuf;
-		_addref(m_str);
+		pBuf = GetNameTable()->GetEntry(s,nHash)->GetStr();
 	}
-	return *this;
+	// if the name doesn't change this drops the second reference
+	_release(m_str);
+	m_str = pBuf;
 }
 
 
@@ -510,3 +712,220 @@ inline bool	operator!=( const char *s,const CCryName &n ) {
 }
 
 #endif //__CryName_h__
+
+//////////////////////////////////////////////////////////////////////////
+// CryNameTest
+//
+// Stress test of CCryName from several threads and the name table as it
+// was before it could be used from other threads, to compare against.
+// Compiled in when CRY_NAME_TEST_SUITE is defined before including this
+// file, which works even if it was included before without it. Timing
+// and reporting is left to the caller (the game runs it with
+// g_nameTableTest). The threads use CCryThread, so the test runs on every
+// platform, including Linux builds with ThreadSanitizer.
+//////////////////////////////////////////////////////////////////////////
+#if defined(CRY_NAME_TEST_SUITE) && !defined(USE_WRONLY_NAMETABLE) && !defined(__CryName_TestSuite_h__)
+#define __CryName_TestSuite_h__
+
+namespace CryNameTest
+{
+	struct Result
+	{
+		Result() : names(0), errors(0) {}
+
+		int names;  // names created
+		int errors; // names with the wrong string, hash or entry, or left behind
+	};
+
+	// Names of the test are "CryNameTest_<index>" in one of three spellings.
+	enum { NAME_COUNT = 512 };
+
+	inline void GetName( char *buffer,int index,int spelling )
+	{
+		static const char *const formats[] = { "CryNameTest_%d", "CRYNAMETEST_%d", "crynametest_%d" };
+		sprintf( buffer,formats[spelling % 3],index );
+	}
+
+	struct ThreadData
+	{
+		const CCryName *pinned; // the even names, held by the test for the whole run
+		int iterations;
+		int volatile *errors;
+	};
+
+	inline void StressThread( void *userData )
+	{
+		ThreadData *data = static_cast<ThreadData*>(userData);
+		CCryName held[8];
+		// rand() is not thread safe
+		uint32 seed = (uint32)(UINT_PTR)held + (uint32)CryGetTicks();
+		char buffer[64];
+		int errors = 0;
+
+		for (int i=0; i<data->iterations; ++i)
+		{
+			seed = seed*1664525u + 1013904223u;
+			const int index = (seed >> 8) % NAME_COUNT;
+			GetName( buffer,index,seed >> 24 );
+
+			// the odd names are created and deleted all the time
+			CCryName name = (i & 1) ? CCryName(SCryNameHashed(buffer,CryNameHash(buffer))) : CCryName(buffer);
+			if (name.GetHash() != CryNameHash(buffer) || name.length() != (int)strlen(buffer) || name != buffer)
+				++errors;
+			if (!(index & 1) && name != data->pinned[index])
+				++errors;
+			if (!CCryName::find(buffer))
+				++errors;
+
+			// copies add and drop references outside the lock of the table
+			held[(seed >> 4) & 7] = name;
+		}
+
+		CryInterlockedAdd( data->errors,errors );
+	}
+
+	// Runs threadCount threads that create, copy, find and drop CCryNames of a shared set of names for
+	// the given number of iterations each. Every name has to resolve to the one entry of its string, and
+	// all names the test didn't hold have to be gone again at the end.
+	inline Result TestThreaded( int threadCount,int iterations )
+	{
+		static const int MAX_THREADS = 32;
+		if (threadCount < 1)
+			threadCount = 1;
+		if (threadCount > MAX_THREADS)
+			threadCount = MAX_THREADS;
+
+		Result result;
+		char buffer[64];
+
+		// a literal hashed by the compiler is the same name
+		if (CCryName(CRY_NAME_LITERAL("CryNameTest_Literal")) != CCryName("cRYnAMEtEST_lITERAL") ||
+			CCryName(CRY_NAME_LITERAL("CryNameTest_Literal")).GetHash() != CryNameHash("CRYNAMETEST_LITERAL"))
+			++result.errors;
+
+		std::vector<CCryName> pinned(NAME_COUNT);
+		for (int i=0; i<NAME_COUNT; i+=2)
+		{
+			GetName( buffer,i,i );
+			pinned[i] = buffer;
+		}
+
+		int volatile errors = 0;
+		ThreadData data;
+		data.pinned = &pinned[0];
+		data.iterations = iterations;
+		data.errors = &errors;
+
+		CCryThread *threads[MAX_THREADS];
+		for (int i=0; i<threadCount; ++i)
+			threads[i] = new CCryThread( StressThread,&data );
+		for (int i=0; i<threadCount; ++i)
+			delete threads[i];
+
+		result.names = threadCount*iterations;
+		result.errors += errors;
+
+		for (int i=0; i<NAME_COUNT; ++i)
+		{
+			GetName( buffer,i,0 );
+			if (CCryName::find(buffer) != !(i & 1))
+				++result.errors;
+		}
+
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// The name table before it was split into shards, without locks and
+	// hashes in the entries.
+	//////////////////////////////////////////////////////////////////////////
+	class CLegacyNameTable
+	{
+	public:
+		struct SNameEntry
+		{
+			int nRefCount;
+			int nLength;
+			int nAllocSize;
+
+			char* GetStr() { return (char*)(this+1); }
+			void  AddRef() { nRefCount++; }
+			int   Release() { return --nRefCount; }
+		};
+
+		CLegacyNameTable()
+#ifdef USE_HASH_MAP
+			: m_nameMap(CRY_NAME_HASHTABLE_SIZE)
+#endif //USE_HASH_MAP
+		{}
+
+		~CLegacyNameTable()
+		{
+			for (NameMap::iterator it = m_nameMap.begin(); it != m_nameMap.end(); ++it)
+				free(it->second);
+		}
+
+		SNameEntry* GetEntry( const char *str )
+		{
+			SNameEntry *pEntry = stl::find_in_map( m_nameMap,str,0 );
+			if (!pEntry)
+			{
+				unsigned int nLen = strlen(str);
+				unsigned int allocLen = sizeof(SNameEntry) + (nLen+1)*sizeof(char);
+				pEntry = (SNameEntry*)malloc( allocLen );
+				pEntry->nRefCount = 0;
+				pEntry->nLength = nLen;
+				pEntry->nAllocSize = allocLen;
+				memcpy( pEntry->GetStr(),str,nLen+1 );
+				m_nameMap[pEntry->GetStr()] = pEntry;
+			}
+			return pEntry;
+		}
+
+		void Release( SNameEntry *pEntry )
+		{
+			m_nameMap.erase( pEntry->GetStr() );
+			free(pEntry);
+		}
+
+	private:
+#ifdef CNAMETABLE_CASE_SENSITIVE
+  #ifdef USE_HASH_MAP
+		typedef stl::hash_map<const char*,SNameEntry*,stl::hash_strcmp<const char*> > NameMap;
+  #else
+		typedef std::map<const char*,SNameEntry*,stl::less_strcmp<const char*> > NameMap;
+  #endif
+#else
+  #ifdef USE_HASH_MAP
+		typedef stl::hash_map<const char*,SNameEntry*,stl::hash_stricmp<const char*> > NameMap;
+  #else
+		typedef std::map<const char*,SNameEntry*,stl::less_stricmp<const char*> > NameMap;
+  #endif
+#endif
+
+		NameMap m_nameMap;
+	};
+
+	// Creates and drops a name the way CCryName does, in the legacy table and in a name table.
+	// Returns the length of the name.
+	inline int CreateAndDrop( CLegacyNameTable &table,const char *str )
+	{
+		CLegacyNameTable::SNameEntry *pEntry = table.GetEntry(str);
+		pEntry->AddRef();
+		const int nLength = pEntry->nLength;
+		if (pEntry->Release() <= 0)
+			table.Release(pEntry);
+		return nLength;
+	}
+
+	inline int CreateAndDrop( INameTable &table,const char *str,uint32 nHash )
+	{
+		INameTable::SNameEntry *pEntry = table.GetEntry(str,nHash);
+		const int nLength = pEntry->nLength;
+		if (!pEntry->ReleaseIfNotLast())
+			table.Release(pEntry);
+		return nLength;
+	}
+}
+
+#endif //defined(CRY_NAME_TEST_SUITE) && !defined(USE_WRONLY_NAMETABLE)
@@ -0,0 +1,646 @@
+//////////////////////////////////////////////////////////////////////
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+//
+//	File:Cry_GeoIntersectBatch.h
+//	Description: Batched intersection-tests of one ray or lineseg against
+//	             many AABBs or spheres
+//
+//	The shapes are passed as structure of arrays (one float array per
+//	component), so SSE tests 4 shapes per instruction, 8 per loop
+//	iteration. Without SSE, and for the last count%4 shapes, the same
+//	math runs one shape at a time.
+//
+//	Unlike the one-at-a-time tests in Cry_GeoIntersect.h the shapes are
+//	solid and closed: a ray or lineseg that starts inside or just touches
+//	a shape hits it. For every hit the entry parameter t is reported,
+//	point = start + t*(end-start) for linesegs and
+//	point = origin + t*direction for rays, t is 0 if the start is inside.
+//
+//////////////////////////////////////////////////////////////////////
+
+#ifndef CRYINTERSECTIONBATCH_H
+#define CRYINTERSECTIONBATCH_H
+
+#if _MSC_VER > 1000
+# pragma once
+#endif
+
+#include <Cry_Geo.h>
+#include <float.h>
+
+// SSE is always there on x64, even where _CPU_SSE is not defined.
+#if defined(_CPU_SSE) || defined(_CPU_AMD64)
+	#define CRY_GEO_BATCH_SSE
+	#include <xmmintrin.h>
+#endif
+
+namespace Intersect {
+
+	//----------------------------------------------------------------------------------
+	//  AABBArrays, SphereArrays
+	//
+	//  Views of shapes kept as one array per component, they don't own the arrays.
+	//  The arrays need no padding or alignment.
+	//----------------------------------------------------------------------------------
+	struct AABBArrays {
+		AABBArrays() : minX(0),minY(0),minZ(0),maxX(0),maxY(0),maxZ(0),count(0),margin(0.0f) {}
+
+		const float *minX, *minY, *minZ;
+		const float *maxX, *maxY, *maxZ;
+		int count;
+		//! grows every box on all sides
+		float margin;
+	};
+
+	struct SphereArrays {
+		SphereArrays() : centerX(0),centerY(0),centerZ(0),radius(0),count(0),margin(0.0f) {}
+
+		const float *centerX, *centerY, *centerZ;
+		const float *radius;
+		int count;
+		//! added to every radius
+		float margin;
+	};
+
+	namespace BatchDetail {
+
+		// How far ahead of the test the shape arrays are prefetched, in shapes (two cache lines).
+		enum { PREFETCH_AHEAD = 32 };
+
+		// avoids inf*0 in the slab test for axis parallel directions
+		ILINE float SafeInv(float x) {
+			if (fabsf(x) > 1e-8f)
+				return 1.0f/x;
+			return x < 0.0f ? -1e30f : 1e30f;
+		}
+
+		//----------------------------------------------------------------------------------
+		// Slab test: the entry is the latest of the per-axis entries, the exit the earliest exit.
+		//----------------------------------------------------------------------------------
+		struct AABBKernel {
+			AABBKernel(const Vec3 &_origin,const Vec3 &dir,float _tMax,const AABBArrays &_boxes)
+				: boxes(_boxes), origin(_origin), inv(SafeInv(dir.x),SafeInv(dir.y),SafeInv(dir.z)), tMax(_tMax) {}
+
+			ILINE bool Test(int i, float &t) const {
+				float t1 = (boxes.minX[i]-boxes.margin-origin.x)*inv.x;
+				float t2 = (boxes.maxX[i]+boxes.margin-origin.x)*inv.x;
+				float tEnter = max(min(t1,t2),0.0f);
+				float tExit = min(max(t1,t2),tMax);
+
+				t1 = (boxes.minY[i]-boxes.margin-origin.y)*inv.y;
+				t2 = (boxes.maxY[i]+boxes.margin-origin.y)*inv.y;
+				tEnter = max(tEnter,min(t1,t2));
+				tExit = min(tExit,max(t1,t2));
+
+				t1 = (boxes.minZ[i]-boxes.margin-origin.z)*inv.z;
+				t2 = (boxes.maxZ[i]+boxes.margin-origin.z)*inv.z;
+				tEnter = max(tEnter,min(t1,t2));
+				tExit = min(tExit,max(t1,t2));
+
+				t = tEnter;
+				return tEnter <= tExit;
+			}
+
+#if defined(CRY_GEO_BATCH_SSE)
+			// _MM_PREFETCH of Cry_XOptimise.h is empty where _CPU_SSE is not defined, x64 included
+			ILINE void Prefetch(int i) const {
+				_mm_prefetch( (const char*)(boxes.minX+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(boxes.minY+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(boxes.minZ+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(boxes.maxX+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(boxes.maxY+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(boxes.maxZ+i),_MM_HINT_T0 );
+			}
+
+			//! tests shapes i..i+3, returns the hit lanes as a bit mask
+			ILINE int Test4(int i, __m128 &t) const {
+				const __m128 m = _mm_set1_ps(boxes.margin);
+
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(boxes.minX+i),m),_mm_set1_ps(origin.x)),_mm_set1_ps(inv.x));
+				__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxX+i),m),_mm_set1_ps(origin.x)),_mm_set1_ps(inv.x));
+				__m128 tEnter = _mm_max_ps(_mm_min_ps(t1,t2),_mm_setzero_ps());
+				__m128 tExit = _mm_min_ps(_mm_max_ps(t1,t2),_mm_set1_ps(tMax));
+
+				t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(boxes.minY+i),m),_mm_set1_ps(origin.y)),_mm_set1_ps(inv.y));
+				t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxY+i),m),_mm_set1_ps(origin.y)),_mm_set1_ps(inv.y));
+				tEnter = _mm_max_ps(tEnter,_mm_min_ps(t1,t2));
+				tExit = _mm_min_ps(tExit,_mm_max_ps(t1,t2));
+
+				t1 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(boxes.minZ+i),m),_mm_set1_ps(origin.z)),_mm_set1_ps(inv.z));
+				t2 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(boxes.maxZ+i),m),_mm_set1_ps(origin.z)),_mm_set1_ps(inv.z));
+				tEnter = _mm_max_ps(tEnter,_mm_min_ps(t1,t2));
+				tExit = _mm_min_ps(tExit,_mm_max_ps(t1,t2));
+
+				t = tEnter;
+				return _mm_movemask_ps(_mm_cmple_ps(tEnter,tExit));
+			}
+#endif
+
+			const AABBArrays &boxes;
+			Vec3 origin;
+			Vec3 inv;
+			float tMax;
+		};
+
+		//----------------------------------------------------------------------------------
+		// With m = origin-center: |m + t*dir|^2 = r^2 gives a*t^2 + 2*b*t + c = 0.
+		// The start is inside if c <= 0, else the entry is the smaller root.
+		//----------------------------------------------------------------------------------
+		struct SphereKernel {
+			SphereKernel(const Vec3 &_origin,const Vec3 &_dir,float _tMax,const SphereArrays &_spheres)
+				: spheres(_spheres), origin(_origin), dir(_dir), a(max(_dir|_dir,1e-30f)), tMax(_tMax) {}
+
+			ILINE bool Test(int i, float &t) const {
+				const Vec3 m(origin.x-spheres.centerX[i], origin.y-spheres.centerY[i], origin.z-spheres.centerZ[i]);
+				const float r = spheres.radius[i]+spheres.margin;
+				const float b = m|dir;
+				const float c = (m|m) - r*r;
+				if (c <= 0.0f) {
+					t = 0.0f;
+					return true;
+				}
+				const float disc = b*b - a*c;
+				t = (-b - sqrt_tpl(max(disc,0.0f))) / a;
+				return disc >= 0.0f && t >= 0.0f && t <= tMax;
+			}
+
+#if defined(CRY_GEO_BATCH_SSE)
+			ILINE void Prefetch(int i) const {
+				_mm_prefetch( (const char*)(spheres.centerX+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(spheres.centerY+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(spheres.centerZ+i),_MM_HINT_T0 );
+				_mm_prefetch( (const char*)(spheres.radius+i),_MM_HINT_T0 );
+			}
+
+			ILINE int Test4(int i, __m128 &t) const {
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 mx = _mm_sub_ps(_mm_set1_ps(origin.x),_mm_loadu_ps(spheres.centerX+i));
+				const __m128 my = _mm_sub_ps(_mm_set1_ps(origin.y),_mm_loadu_ps(spheres.centerY+i));
+				const __m128 mz = _mm_sub_ps(_mm_set1_ps(origin.z),_mm_loadu_ps(spheres.centerZ+i));
+				const __m128 r = _mm_add_ps(_mm_loadu_ps(spheres.radius+i),_mm_set1_ps(spheres.margin));
+
+				const __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mx,_mm_set1_ps(dir.x)),_mm_mul_ps(my,_mm_set1_ps(dir.y))),_mm_mul_ps(mz,_mm_set1_ps(dir.z)));
+				const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(mx,mx),_mm_mul_ps(my,my)),_mm_mul_ps(mz,mz)),_mm_mul_ps(r,r));
+				const __m128 disc = _mm_sub_ps(_mm_mul_ps(b,b),_mm_mul_ps(_mm_set1_ps(a),c));
+				const __m128 tEnter = _mm_div_ps(_mm_sub_ps(_mm_sub_ps(zero,b),_mm_sqrt_ps(_mm_max_ps(disc,zero))),_mm_set1_ps(a));
+
+				const __m128 inside = _mm_cmple_ps(c,zero);
+				const __m128 enters = _mm_and_ps(_mm_cmpge_ps(disc,zero),_mm_and_ps(_mm_cmpge_ps(tEnter,zero),_mm_cmple_ps(tEnter,_mm_set1_ps(tMax))));
+
+				t = _mm_andnot_ps(inside,tEnter);
+				return _mm_movemask_ps(_mm_or_ps(inside,enters));
+			}
+#endif
+
+			const SphereArrays &spheres;
+			Vec3 origin;
+			Vec3 dir;
+			float a;
+			float tMax;
+		};
+
+		//----------------------------------------------------------------------------------
+		// Sinks receive the hits in index order and return false to stop the test.
+		//----------------------------------------------------------------------------------
+		struct CollectSink {
+			CollectSink(int *_pResults,float *_pT,int _maxResults) : pResults(_pResults), pT(_pT), maxResults(_maxResults), numResults(0) {}
+
+			ILINE bool Add(int i, float t) {
+				if (pT)
+					pT[numResults] = t;
+				pResults[numResults++] = i;
+				return numResults < maxResults;
+			}
+
+			int *pResults;
+			float *pT;
+			int maxResults;
+			int numResults;
+		};
+
+		struct FirstSink {
+			FirstSink() : index(-1), t(0.0f) {}
+
+			ILINE bool Add(int i, float _t) {
+				if (index < 0 || _t < t) {
+					index = i;
+					t = _t;
+				}
+				return true;
+			}
+
+			int index;
+			float t;
+		};
+
+		template <class Kernel, class Sink>
+		inline void Run(const Kernel &kernel, int count, Sink &sink) {
+			int i = 0;
+#if defined(CRY_GEO_BATCH_SSE)
+			float t[8];
+			// 8 shapes per iteration, the two halves are independent and overlap in the pipeline
+			for (; i+8 <= count; i+=8) {
+				// clamped, so the prefetch never points past the arrays
+				kernel.Prefetch(min(i+PREFETCH_AHEAD,count-1));
+				__m128 t0, t1;
+				const int mask = kernel.Test4(i,t0) | (kernel.Test4(i+4,t1) << 4);
+				if (!mask)
+					continue;
+				_mm_storeu_ps(t,t0);
+				_mm_storeu_ps(t+4,t1);
+				for (int lane=0; lane<8; ++lane) {
+					if ((mask & (1<<lane)) && !sink.Add(i+lane,t[lane]))
+						return;
+				}
+			}
+			if (i+4 <= count) {
+				__m128 t0;
+				const int mask = kernel.Test4(i,t0);
+				_mm_storeu_ps(t,t0);
+				for (int lane=0; lane<4; ++lane) {
+					if ((mask & (1<<lane)) && !sink.Add(i+lane,t[lane]))
+						return;
+				}
+				i += 4;
+			}
+#endif
+			for (; i<count; ++i) {
+				float t;
+				if (kernel.Test(i,t) && !sink.Add(i,t))
+					return;
+			}
+		}
+
+	} // namespace BatchDetail
+
+	//----------------------------------------------------------------------------------
+	//  Ray_AABBs, Lineseg_AABBs, Ray_Spheres, Lineseg_Spheres
+	//
+	//  Writes the indices of the hit shapes in ascending order to pResults, and their
+	//  entry parameters to pT if given. Stops after maxResults hits and returns the
+	//  number of hits.
+	//----------------------------------------------------------------------------------
+	inline int Ray_AABBs( const Ray &ray,const AABBArrays &boxes, int *pResults,int maxResults, float *pT=0 ) {
+		if (maxResults <= 0)
+			return 0;
+		BatchDetail::CollectSink sink(pResults,pT,maxResults);
+		BatchDetail::Run(BatchDetail::AABBKernel(ray.origin,ray.direction,FLT_MAX,boxes),boxes.count,sink);
+		return sink.numResults;
+	}
+
+	inline int Lineseg_AABBs( const Lineseg &ls,const AABBArrays &boxes, int *pResults,int maxResults, float *pT=0 ) {
+		if (maxResults <= 0)
+			return 0;
+		BatchDetail::CollectSink sink(pResults,pT,maxResults);
+		BatchDetail::Run(BatchDetail::AABBKernel(ls.start,ls.end-ls.start,1.0f,boxes),boxes.count,sink);
+		return sink.numResults;
+	}
+
+	inline int Ray_Spheres( const Ray &ray,const SphereArrays &spheres, int *pResults,int maxResults, float *pT=0 ) {
+		if (maxResults <= 0)
+			return 0;
+		BatchDetail::CollectSink sink(pResults,pT,maxResults);
+		BatchDetail::Run(BatchDetail::SphereKernel(ray.origin,ray.direction,FLT_MAX,spheres),spheres.count,sink);
+		return sink.numResults;
+	}
+
+	inline int Lineseg_Spheres( const Lineseg &ls,const SphereArrays &spheres, int *pResults,int maxResults, float *pT=0 ) {
+		if (maxResults <= 0)
+			return 0;
+		BatchDetail::CollectSink sink(pResults,pT,maxResults);
+		BatchDetail::Run(BatchDetail::SphereKernel(ls.start,ls.end-ls.start,1.0f,spheres),spheres.count,sink);
+		return sink.numResults;
+	}
+
+	//----------------------------------------------------------------------------------
+	//  Ray_AABBsFirst, Lineseg_AABBsFirst, Ray_SpheresFirst, Lineseg_SpheresFirst
+	//
+	//  Returns the index of the shape that is entered first (-1 if none) and its entry
+	//  parameter in t. Of shapes entered at the same t the lowest index wins.
+	//----------------------------------------------------------------------------------
+	inline int Ray_AABBsFirst( const Ray &ray,const AABBArrays &boxes, float &t ) {
+		BatchDetail::FirstSink sink;
+		BatchDetail::Run(BatchDetail::AABBKernel(ray.origin,ray.direction,FLT_MAX,boxes),boxes.count,sink);
+		t = sink.t;
+		return sink.index;
+	}
+
+	inline int Lineseg_AABBsFirst( const Lineseg &ls,const AABBArrays &boxes, float &t ) {
+		BatchDetail::FirstSink sink;
+		BatchDetail::Run(BatchDetail::AABBKernel(ls.start,ls.end-ls.start,1.0f,boxes),boxes.count,sink);
+		t = sink.t;
+		return sink.index;
+	}
+
+	inline int Ray_SpheresFirst( const Ray &ray,const SphereArrays &spheres, float &t ) {
+		BatchDetail::FirstSink sink;
+		BatchDetail::Run(BatchDetail::SphereKernel(ray.origin,ray.direction,FLT_MAX,spheres),spheres.count,sink);
+		t = sink.t;
+		return sink.index;
+	}
+
+	inline int Lineseg_SpheresFirst( const Lineseg &ls,const SphereArrays &spheres, float &t ) {
+		BatchDetail::FirstSink sink;
+		BatchDetail::Run(BatchDetail::SphereKernel(ls.start,ls.end-ls.start,1.0f,spheres),spheres.count,sink);
+		t = sink.t;
+		return sink.index;
+	}
+
+}; //Intersect
+
+//////////////////////////////////////////////////////////////////////
+// IntersectBatchTest
+//
+// Checks the batch tests against the scalar tests of Cry_GeoOverlap.h,
+// Cry_GeoIntersect.h and Cry_GeoDistance.h, compiled in when
+// GEO_BATCH_TEST_SUITE is defined before including this file. Random
+// scenes are mixed with edge cases: axis parallel directions, starts
+// inside or on the surface, grazing and zero length linesegs, flat boxes
+// and zero radius spheres. Where the scalar test gives a different answer
+// for the shape grown and shrunk by a small epsilon the case is on the
+// boundary and only counted as ambiguous, since the scalar tests differ
+// in how they treat touching. Timing is left to the caller (the game runs
+// it with g_geoBatchTest).
+//////////////////////////////////////////////////////////////////////
+#if defined(GEO_BATCH_TEST_SUITE)
+
+namespace IntersectBatchTest
+{
+	struct Result
+	{
+		Result() : tests(0), errors(0), ambiguous(0) {}
+
+		int tests;     // shape tests compared
+		int errors;    // hits, entry points or results that disagree
+		int ambiguous; // disagreements on the boundary of a shape
+	};
+
+	// Shapes as arrays plus the same shapes as AABB and Sphere for the scalar tests.
+	struct Scene
+	{
+		void Clear()
+		{
+			minX.resize(0); minY.resize(0); minZ.resize(0); maxX.resize(0); maxY.resize(0); maxZ.resize(0);
+			centerX.resize(0); centerY.resize(0); centerZ.resize(0); radius.resize(0);
+			boxes.resize(0); spheres.resize(0);
+		}
+
+		void Add(const AABB &box, const Sphere &sphere)
+		{
+			minX.push_back(box.min.x); minY.push_back(box.min.y); minZ.push_back(box.min.z);
+			maxX.push_back(box.max.x); maxY.push_back(box.max.y); maxZ.push_back(box.max.z);
+			centerX.push_back(sphere.center.x); centerY.push_back(sphere.center.y); centerZ.push_back(sphere.center.z);
+			radius.push_back(sphere.radius);
+			boxes.push_back(box);
+			spheres.push_back(sphere);
+		}
+
+		Intersect::AABBArrays GetBoxes(float margin) const
+		{
+			Intersect::AABBArrays arrays;
+			arrays.minX = &minX[0]; arrays.minY = &minY[0]; arrays.minZ = &minZ[0];
+			arrays.maxX = &maxX[0]; arrays.maxY = &maxY[0]; arrays.maxZ = &maxZ[0];
+			arrays.count = (int)boxes.size();
+			arrays.margin = margin;
+			return arrays;
+		}
+
+		Intersect::SphereArrays GetSpheres(float margin) const
+		{
+			Intersect::SphereArrays arrays;
+			arrays.centerX = &centerX[0]; arrays.centerY = &centerY[0]; arrays.centerZ = &centerZ[0];
+			arrays.radius = &radius[0];
+			arrays.count = (int)spheres.size();
+			arrays.margin = margin;
+			return arrays;
+		}
+
+		std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+		std::vector<float> centerX, centerY, centerZ, radius;
+		std::vector<AABB> boxes;
+		std::vector<Sphere> spheres;
+	};
+
+	inline AABB Grow(const AABB &box, float amount) { return AABB(box.min-Vec3(amount,amount,amount), box.max+Vec3(amount,amount,amount)); }
+	inline Sphere Grow(const Sphere &sphere, float amount) { return Sphere(sphere.center, max(sphere.radius+amount, 0.0f)); }
+
+	// The scalar tests: 0 = miss, 1 = hit with the entry point (the start if it is inside) in point,
+	// 2 = hit where the scalar test doesn't give the entry point.
+	inline int Scalar(const Lineseg &ls, const AABB &box, Vec3 &point)
+	{
+		if (!Overlap::Lineseg_AABB(ls, box))
+			return 0;
+		return Intersect::Lineseg_AABB(ls, box, point) ? 1 : 2;
+	}
+
+	inline int Scalar(const Ray &ray, const AABB &box, Vec3 &point)
+	{
+		return Intersect::Ray_AABB(ray, box, point) ? 1 : 0;
+	}
+
+	inline int Scalar(const Lineseg &ls, const Sphere &sphere, Vec3 &point)
+	{
+		// Overlap::Lineseg_Sphere doesn't handle zero length linesegs
+		float t;
+		if (Distance::Point_LinesegSq(sphere.center, ls, t) > sphere.radius*sphere.radius)
+			return 0;
+		Vec3 exit;
+		const int result = Intersect::Lineseg_Sphere(ls, sphere, point, exit);
+		if (result == 2)
+			point = ls.start;
+		return result ? 1 : 2;
+	}
+
+	inline int Scalar(const Ray &ray, const Sphere &sphere, Vec3 &point)
+	{
+		Vec3 exit;
+		const int result = Intersect::Ray_Sphere(ray, sphere, point, exit);
+		if (result == 2)
+			point = ray.origin;
+		return result ? 1 : 0;
+	}
+
+	inline Vec3 GetPoint(const Lineseg &ls, float t) { return ls.start + (ls.end-ls.start)*t; }
+	inline Vec3 GetPoint(const Ray &ray, float t) { return ray.origin + ray.direction*t; }
+
+	inline int Batch(const Lineseg &ls, const Scene &scene, float margin, bool spheres, int *pResults, int maxResults, float *pT)
+	{
+		return spheres ? Intersect::Lineseg_Spheres(ls, scene.GetSpheres(margin), pResults, maxResults, pT) : Intersect::Lineseg_AABBs(ls, scene.GetBoxes(margin), pResults, maxResults, pT);
+	}
+
+	inline int Batch(const Ray &ray, const Scene &scene, float margin, bool spheres, int *pResults, int maxResults, float *pT)
+	{
+		return spheres ? Intersect::Ray_Spheres(ray, scene.GetSpheres(margin), pResults, maxResults, pT) : Intersect::Ray_AABBs(ray, scene.GetBoxes(margin), pResults, maxResults, pT);
+	}
+
+	inline int BatchFirst(const Lineseg &ls, const Scene &scene, float margin, bool spheres, float &t)
+	{
+		return spheres ? Intersect::Lineseg_SpheresFirst(ls, scene.GetSpheres(margin), t) : Intersect::Lineseg_AABBsFirst(ls, scene.GetBoxes(margin), t);
+	}
+
+	inline int BatchFirst(const Ray &ray, const Scene &scene, float margin, bool spheres, float &t)
+	{
+		return spheres ? Intersect::Ray_SpheresFirst(ray, scene.GetSpheres(margin), t) : Intersect::Ray_AABBsFirst(ray, scene.GetBoxes(margin), t);
+	}
+
+	// Compares one query against every shape of the scene, as boxes and as spheres.
+	template <class Query>
+	inline void Check(const Query &query, const Scene &scene, float margin, float epsilon, Result &result)
+	{
+		const int count = (int)scene.boxes.size();
+		std::vector<int> hits(count);
+		std::vector<float> t(count);
+		std::vector<int> hitIndex(count);
+
+		for (int spheres = 0; spheres < 2; ++spheres)
+		{
+			const int numHits = Batch(query, scene, margin, spheres != 0, count ? &hits[0] : 0, count, count ? &t[0] : 0);
+
+			std::fill(hitIndex.begin(), hitIndex.end(), -1);
+			int first = -1;
+			for (int i = 0; i < numHits; ++i)
+			{
+				if (hits[i] < 0 || hits[i] >= count || (i > 0 && hits[i] <= hits[i-1]))
+				{
+					++result.errors;
+					return;
+				}
+				hitIndex[hits[i]] = i;
+				if (first < 0 || t[i] < t[first])
+					first = i;
+			}
+
+			for (int shape = 0; shape < count; ++shape)
+			{
+				++result.tests;
+
+				Vec3 point;
+				const int scalar = (spheres ? Scalar(query, Grow(scene.spheres[shape], margin), point) : Scalar(query, Grow(scene.boxes[shape], margin), point));
+				const bool hit = (hitIndex[shape] >= 0);
+				if (hit != (scalar != 0))
+				{
+					Vec3 unused;
+					const bool grown = (spheres ? Scalar(query, Grow(scene.spheres[shape], margin+epsilon), unused) : Scalar(query, Grow(scene.boxes[shape], margin+epsilon), unused)) != 0;
+					const bool shrunk = (spheres ? Scalar(query, Grow(scene.spheres[shape], margin-epsilon), unused) : Scalar(query, Grow(scene.boxes[shape], margin-epsilon), unused)) != 0;
+					if (grown != shrunk)
+						++result.ambiguous;
+					else
+						++result.errors;
+					continue;
+				}
+				if (!hit)
+					continue;
+
+				if (scalar == 1 && GetPoint(query, t[hitIndex[shape]]).GetDistance(point) > epsilon*4.0f)
+					++result.errors;
+			}
+
+			// the first hit and a truncated result have to agree with the full result
+			float tFirst;
+			const int indexFirst = BatchFirst(query, scene, margin, spheres != 0, tFirst);
+			if (indexFirst != (first < 0 ? -1 : hits[first]) || (first >= 0 && tFirst != t[first]))
+				++result.errors;
+
+			int truncated[3];
+			const int numTruncated = Batch(query, scene, margin, spheres != 0, truncated, 3, 0);
+			if (numTruncated != min(numHits, 3))
+				++result.errors;
+			for (int i = 0; i < numTruncated && i < numHits; ++i)
+			{
+				if (truncated[i] != hits[i])
+					++result.errors;
+			}
+		}
+	}
+
+	inline Vec3 RandomVec(float range) { return Vec3(Random(-range, range), Random(-range, range), Random(-range, range)); }
+
+	// Runs the given number of random queries, half rays and half linesegs, each against a scene of 37 shapes
+	// so the 8 and 4 wide loops and the scalar tail are all used.
+	inline Result TestAgainstScalar(int iterations)
+	{
+		static const int SHAPES = 37;
+		static const float RANGE = 50.0f;
+		// float precision at the scene size, the slab test divides by the direction
+		static const float EPSILON = 0.005f;
+
+		Result result;
+		Scene scene;
+
+		for (int iteration = 0; iteration < iterations; ++iteration)
+		{
+			const int edgeCase = iteration % 8;
+
+			scene.Clear();
+			for (int i = 0; i < SHAPES; ++i)
+			{
+				const Vec3 center = RandomVec(RANGE*0.5f);
+				Vec3 half(Random(0.0f, 5.0f), Random(0.0f, 5.0f), Random(0.0f, 5.0f));
+				float radius = Random(0.0f, 5.0f);
+				if (edgeCase == 1 && (i & 1))
+				{
+					// flat and empty boxes, zero radius spheres
+					half[i % 3] = 0.0f;
+					if (i % 5 == 0)
+						half.Set(0.0f, 0.0f, 0.0f);
+					radius = 0.0f;
+				}
+				scene.Add(AABB(center-half, center+half), Sphere(center, radius));
+			}
+
+			const int target = iteration % SHAPES;
+			const AABB &box = scene.boxes[target];
+			const Sphere &sphere = scene.spheres[target];
+			Vec3 start = RandomVec(RANGE);
+			Vec3 dir = RandomVec(RANGE);
+
+			switch (edgeCase)
+			{
+			case 2:
+				// axis parallel, aimed at the box centre
+				dir[iteration % 3] = 0.0f;
+				dir[(iteration+1) % 3] = 0.0f;
+				start = box.GetCenter() - dir;
+				break;
+			case 3:
+				// starting inside
+				start = Random() < 0.5f ? box.GetCenter() : sphere.center;
+				break;
+			case 4:
+				// starting on the max face of the box, or the surface of the sphere
+				start = box.GetCenter();
+				start[iteration % 3] = box.max[iteration % 3];
+				if (iteration & 8)
+					start = sphere.center + Vec3(0.0f, 0.0f, sphere.radius);
+				break;
+			case 5:
+				// grazing along the max face of the box
+				start[iteration % 3] = box.max[iteration % 3];
+				dir[iteration % 3] = 0.0f;
+				break;
+			case 6:
+				// ending exactly at the box centre
+				dir = box.GetCenter() - start;
+				break;
+			case 7:
+				// zero length linesegs, rays get a unit direction
+				dir.Set(0.0f, 0.0f, 0.0f);
+				break;
+			}
+
+			const float margin = (iteration % 3 == 0 ? Random(0.0f, 1.0f) : 0.0f);
+
+			Check(Lineseg(start, start+dir), scene, margin, EPSILON, result);
+			if (dir.GetLengthSquared() == 0.0f)
+				dir.Set(0.0f, 1.0f, 0.0f);
+			Check(Ray(start, dir), scene, margin, EPSILON, result);
+		}
+
+		return result;
+	}
+}
+
+#endif //defined(GEO_BATCH_TEST_SUITE)
+
+#endif //CRYINTERSECTIONBATCH_H
@@ -0,0 +1,295 @@
+//---------------------------------------------------------------------------
+// Copyright 2008 Crytek GmbH
+//---------------------------------------------------------------------------
+#ifndef __FRAMEARENA_H__
+#define __FRAMEARENA_H__
+
+//---------------------------------------------------------------------------
+// Linear memory arena for short lived per-frame scratch data.
+//
+// Allocation just bumps a pointer inside the current block, there is no
+// per-allocation overhead besides alignment, and deallocation is a no-op.
+// All memory is given back at once by Reset(), which the owner calls at a
+// frame boundary (the game resets the main thread arena at the start of
+// CGame::Update). Nothing allocated from the arena may be used after that.
+//
+// When a frame needs more than the current block, further blocks are
+// chained. On Reset the chain is replaced by a single block big enough for
+// the largest frame so far, so in the steady state there is one block and
+// no heap traffic at all.
+//
+// Every thread has an arena of its own (see Get()), so no synchronization
+// is needed. Threads other than the main thread have to call Reset()
+// themselves at a point where their scratch data is dead, and should call
+// ReleaseThreadArena() before they exit. Arenas of threads that don't are
+// freed when the module unloads.
+//
+// With FRAME_ARENA_DEBUG (on by default in debug builds) new allocations
+// are filled with 0xCD and reset memory with 0xDD, so stale pointers into
+// a previous frame show up quickly.
+//
+// See STLFrameArenaAllocator.h for an STL-compatible interface.
+//---------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_DEBUG) && !defined(FRAME_ARENA_DEBUG)
+#define FRAME_ARENA_DEBUG
+#endif
+
+namespace stl
+{
+	class FrameArena
+	{
+	public:
+		enum {DefaultBlockSize = 64 * 1024};
+		enum {DefaultAlignment = 2 * sizeof(void*)};
+
+		enum {PoisonAllocated = 0xCD};
+		enum {PoisonReset = 0xDD};
+
+		explicit FrameArena(size_t blockSize = DefaultBlockSize);
+		~FrameArena();
+
+		void* Allocate(size_t size, size_t alignment = DefaultAlignment);
+
+		// Gives back everything allocated since the last reset and starts a new frame.
+		void Reset();
+
+		// Frees all blocks, e.g. when a level is unloaded.
+		void FreeMemory();
+
+		// Bytes allocated in the current frame, including alignment padding.
+		size_t GetUsed() const {return m_usedInFullBlocks + (m_pBlock ? m_pBlock->used : 0);}
+		// Most bytes any frame has used.
+		size_t GetHighWaterMark() const {return (m_highWaterMark > GetUsed() ? m_highWaterMark : GetUsed());}
+		size_t GetCapacity() const {return m_capacity;}
+		// Allocations that didn't fit the current block and had to chain a new one.
+		int GetOverflowCount() const {return m_overflowCount;}
+		int GetFrameId() const {return m_frameId;}
+
+		// The arena of the calling thread, created on first use.
+		static FrameArena& Get();
+		// Frees the arena of the calling thread, if it has one. The next Get() creates a new one.
+		static void ReleaseThreadArena();
+
+	private:
+		FrameArena(const FrameArena&);
+		FrameArena& operator=(const FrameArena&);
+
+		// All arenas created by Get(), the ones still alive are freed with the module.
+		struct Registry
+		{
+			FrameArena* pFirst;
+			volatile int lock;
+
+			~Registry();
+		};
+
+		static Registry& GetRegistry();
+		static FrameArena*& GetThreadArena();
+
+		struct Block
+		{
+			Block* pPrev;
+			size_t size;
+			size_t used;
+
+			char* GetData() {return reinterpret_cast<char*>(this) + HeaderSize;}
+		};
+		enum {HeaderSize = (sizeof(Block) + DefaultAlignment - 1) & ~(DefaultAlignment - 1)};
+
+		void* AllocateSlow(size_t size, size_t alignment);
+		void AddBlock(size_t size);
+		void FreeBlocks();
+
+		Block* m_pBlock;
+		size_t m_blockSize;
+		size_t m_usedInFullBlocks;
+		size_t m_highWaterMark;
+		size_t m_capacity;
+		int m_blockCount;
+		int m_overflowCount;
+		int m_frameId;
+
+		FrameArena* m_pPrevRegistered;
+		FrameArena* m_pNextRegistered;
+	};
+
+	inline FrameArena::FrameArena(size_t blockSize)
+	:	m_pBlock(0),
+		m_blockSize(blockSize),
+		m_usedInFullBlocks(0),
+		m_highWaterMark(0),
+		m_capacity(0),
+		m_blockCount(0),
+		m_overflowCount(0),
+		m_frameId(0),
+		m_pPrevRegistered(0),
+		m_pNextRegistered(0)
+	{
+	}
+
+	inline FrameArena::~FrameArena()
+	{
+		FreeBlocks();
+	}
+
+	ILINE void* FrameArena::Allocate(size_t size, size_t alignment)
+	{
+		if (Block* pBlock = m_pBlock)
+		{
+			// Align the address rather than the offset, the block itself is only as aligned as operator new makes it.
+			size_t base = reinterpret_cast<size_t>(pBlock->GetData());
+			size_t offset = ((base + pBlock->used + alignment - 1) & ~(alignment - 1)) - base;
+			if (offset + size <= pBlock->size)
+			{
+				pBlock->used = offset + size;
+				char* p = pBlock->GetData() + offset;
+#if defined(FRAME_ARENA_DEBUG)
+				memset(p, PoisonAllocated, size);
+#endif
+				return p;
+			}
+		}
+
+		return AllocateSlow(size, alignment);
+	}
+
+	inline void* FrameArena::AllocateSlow(size_t size, size_t alignment)
+	{
+		if (m_pBlock)
+		{
+			m_usedInFullBlocks += m_pBlock->used;
+			++m_overflowCount;
+		}
+
+		// Leave room for aligning the start of the block.
+		size_t blockSize = size + alignment;
+		AddBlock(blockSize > m_blockSize ? blockSize : m_blockSize);
+
+		return Allocate(size, alignment);
+	}
+
+	inline void FrameArena::AddBlock(size_t size)
+	{
+		Block* pBlock = reinterpret_cast<Block*>(new char[HeaderSize + size]);
+		pBlock->pPrev = m_pBlock;
+		pBlock->size = size;
+		pBlock->used = 0;
+		m_pBlock = pBlock;
+		m_capacity += size;
+		++m_blockCount;
+	}
+
+	inline void FrameArena::Reset()
+	{
+		size_t used = GetUsed();
+		if (used > m_highWaterMark)
+			m_highWaterMark = used;
+
+		if (m_blockCount > 1)
+		{
+			// The frame didn't fit one block - replace the chain by one block that holds the largest frame so far,
+			// rounded up to whole default blocks.
+			FreeBlocks();
+			m_blockSize = (m_highWaterMark + DefaultBlockSize - 1) & ~(size_t)(DefaultBlockSize - 1);
+			AddBlock(m_blockSize);
+		}
+		else if (m_pBlock)
+		{
+#if defined(FRAME_ARENA_DEBUG)
+			memset(m_pBlock->GetData(), PoisonReset, m_pBlock->used);
+#endif
+			m_pBlock->used = 0;
+		}
+
+		m_usedInFullBlocks = 0;
+		++m_frameId;
+	}
+
+	inline void FrameArena::FreeMemory()
+	{
+		FreeBlocks();
+		m_usedInFullBlocks = 0;
+		++m_frameId;
+	}
+
+	inline void FrameArena::FreeBlocks()
+	{
+		while (Block* pBlock = m_pBlock)
+		{
+			m_pBlock = pBlock->pPrev;
+#if defined(FRAME_ARENA_DEBUG)
+			memset(pBlock->GetData(), PoisonReset, pBlock->used);
+#endif
+			delete [] reinterpret_cast<char*>(pBlock);
+		}
+		m_capacity = 0;
+		m_blockCount = 0;
+	}
+
+	inline FrameArena::Registry::~Registry()
+	{
+		while (FrameArena* pArena = pFirst)
+		{
+			pFirst = pArena->m_pNextRegistered;
+			delete pArena;
+		}
+	}
+
+	inline FrameArena::Registry& FrameArena::GetRegistry()
+	{
+		// No constructor, so it is zero initialized before any thread can get here.
+		static Registry s_registry;
+		return s_registry;
+	}
+
+	inline FrameArena*& FrameArena::GetThreadArena()
+	{
+		// Only the pointer is thread local, the arena itself is created on the heap.
+		static THREADLOCAL FrameArena* s_pArena = 0;
+		return s_pArena;
+	}
+
+	inline FrameArena& FrameArena::Get()
+	{
+		FrameArena*& pArena = GetThreadArena();
+		if (!pArena)
+		{
+			pArena = new FrameArena;
+
+			Registry& registry = GetRegistry();
+			WriteLock lock(registry.lock);
+			pArena->m_pNextRegistered = registry.pFirst;
+			if (registry.pFirst)
+				registry.pFirst->m_pPrevRegistered = pArena;
+			registry.pFirst = pArena;
+		}
+		return *pArena;
+	}
+
+	inline void FrameArena::ReleaseThreadArena()
+	{
+		FrameArena*& pArena = GetThreadArena();
+		if (!pArena)
+			return;
+
+		{
+			Registry& registry = GetRegistry();
+			WriteLock lock(registry.lock);
+			if (pArena->m_pPrevRegistered)
+				pArena->m_pPrevRegistered->m_pNextRegistered = pArena->m_pNextRegistered;
+			else
+				registry.pFirst = pArena->m_pNextRegistered;
+			if (pArena->m_pNextRegistered)
+				pArena->m_pNextRegistered->m_pPrevRegistered = pArena->m_pPrevRegistered;
+		}
+
+		delete pArena;
+		pArena = 0;
+	}
+}
+
+#endif //__FRAMEARENA_H__
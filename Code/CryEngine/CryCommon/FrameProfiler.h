@@ -375,6 +375,49 @@ public:
 	}
 };
 
+//////////////////////////////////////////////////////////////////////////
+//! Frame profile capture.
+//! While a capture runs, every CFrameProfilerSection of the module records its name, begin and end
+//! ticks and nesting depth into a buffer of the calling thread. The buffers are only written by their
+//! own thread, so recording takes no lock, and are read back after CryFrameProfileCaptureStop.
+//! Recording does not depend on the engine profiler being enabled, so it also works on dedicated
+//! servers. Like the lock contention table the capture is per module, it lives in platform_impl.h.
+//!
+#if defined(USE_FRAME_PROFILER) && !defined(_RELEASE) && !defined(__SPU__)
+	#define FRAME_PROFILE_CAPTURE
+#endif
+
+#if defined(FRAME_PROFILE_CAPTURE)
+
+struct SFrameProfileCaptureEvent
+{
+	const char *sName;
+	//! In CryGetTicks units.
+	int64 nStart;
+	int64 nEnd;
+	//! Number of recorded sections enclosing this one on the same thread.
+	uint16 nDepth;
+	//! EProfiledSubsystem of the profiler.
+	uint16 nSubsystem;
+};
+
+//! Receives consecutive events of one thread, in the order the sections ended.
+//! nThread numbers the recording threads of the module, unlike OS thread ids it is never reused.
+typedef void (*FrameProfileCaptureCallback)( int nThread,uint32 nThreadId,const SFrameProfileCaptureEvent *pEvents,int nEvents,void *pUserData );
+
+extern volatile bool g_bFrameProfileCapture;
+
+int64 CryFrameProfileCaptureBegin();
+void  CryFrameProfileCaptureEnd( const CFrameProfiler *pProfiler,int64 nStart );
+//! Discards the previous capture and starts recording.
+void  CryFrameProfileCaptureStart();
+void  CryFrameProfileCaptureStop();
+//! Passes the events of the last capture to pCallback, call it after stopping.
+//! Returns the number of events that were dropped because a thread buffer was full.
+int   CryFrameProfileCaptureEnumerate( FrameProfileCaptureCallback pCallback,void *pUserData );
+
+#endif // FRAME_PROFILE_CAPTURE
+
 //////////////////////////////////////////////////////////////////////////
 //! CFrameProfilerSection is an auto class placed where code block need to be profiled.
 //! Every time this object is constructed and destruted the time between constructor
@@ -387,6 +430,11 @@ public:
 	int64 m_excludeTime;
 	CFrameProfiler *m_pFrameProfiler;
 	CFrameProfilerSection *m_pParent;
+#if defined(FRAME_PROFILE_CAPTURE)
+	// Only read by this module, kept behind the members the engine callbacks use.
+	CFrameProfiler *m_pCaptureProfiler;
+	int64 m_captureStart;
+#endif
 
 	__forceinline CFrameProfilerSection( CFrameProfiler *profiler )
 	{
@@ -399,9 +447,17 @@ public:
 			m_pFrameProfiler = profiler;
 			gEnv->callbackStartSection( this );
 		}
+#if defined(FRAME_PROFILE_CAPTURE)
+		m_pCaptureProfiler = profiler;
+		m_captureStart = (CryLoadAcquire(&g_bFrameProfileCapture) ? CryFrameProfileCaptureBegin() : 0);
+#endif
 	}
 	__forceinline ~CFrameProfilerSection()
 	{
+#if defined(FRAME_PROFILE_CAPTURE)
+		if (m_captureStart)
+			CryFrameProfileCaptureEnd( m_pCaptureProfiler,m_captureStart );
+#endif
 		if (m_pFrameProfiler)
 			gEnv->callbackEndSection( this );
 	}
@@ -133,91 +133,236 @@
 	#define CryLeaveCriticalSectionGlobal CryLeaveCriticalSection
 
 
-ILINE void CrySpinLock(volatile int *pLock,int checkVal,int setVal)
-{ 
-#ifdef _CPU_X86
-# ifdef __GNUC__
-	register int val;
-	__asm__(
-		"0:  mov %[checkVal], %%eax\n"
-		"    lock cmpxchg %[setVal], (%[pLock])\n"
-		"    jnz 0b"
-		: "=m" (*pLock)
-		: [pLock] "r" (pLock), "m" (*pLock),
-		  [checkVal] "m" (checkVal),
-		  [setVal] "r" (setVal)
-		: "eax"
-		);
-# else
-	__asm
-	{
-		mov edx, setVal
-		mov ecx, pLock
-Spin:
-		// Trick from Intel Optimizations guide
-#ifdef _CPU_SSE
-		pause
-#endif 
-		mov eax, checkVal
-		lock cmpxchg [ecx], edx
-		jnz Spin
-	}
-# endif
-#else
+//////////////////////////////////////////////////////////////////////////
+// Spin locks.
+// The lock words are plain ints shared with modules and structures built
+// against them, so where std::atomic is available they are accessed in
+// place through std::atomic<int>, which has the size and representation of
+// int on all supported compilers. Older compilers use the interlocked
+// intrinsics. Waiting uses exponential back-off and eventually yields the
+// time slice instead of hammering the lock with cmpxchg.
+//
+// Define CRY_LOCK_CONTENTION_PROFILE to record per lock spin counts and
+// wait times of all contended acquisitions made by a module. The table is
+// implemented in platform_impl.h, see CryLockContentionGetStats. Only the
+// slow path records, uncontended locks cost the same as without it; the
+// game module defines it in its Profile configurations.
+//////////////////////////////////////////////////////////////////////////
+#if (defined(_MSC_VER) && _MSC_VER >= 1700) || __cplusplus >= 201103L
+	#define CRY_STD_ATOMIC_LOCKS
+	#include <atomic>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#include <intrin.h>
+#endif
 
+#if defined(LINUX)
+	#include <sched.h>
+#endif
 
+// Number of pause instructions of the last busy wait before a waiter starts to yield.
+#define CRY_SPIN_MAX_PAUSE 64
 
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
 
+#if !defined(CRY_STD_ATOMIC_LOCKS)
+	#error CRY_LOCK_CONTENTION_PROFILE requires std::atomic
+#endif
 
+// Maximum number of distinct lock words tracked per module.
+#define CRY_LOCK_CONTENTION_MAX_LOCKS 256
 
+struct SCryLockContentionStats
+{
+	const volatile int *pLock;
+	const char *sName;
+	// acquisitions that found the lock taken
+	int64 nContended;
+	int64 nSpins;
+	int64 nYields;
+	// in CryGetTicks units
+	int64 nWaitTicks;
+	int64 nMaxWaitTicks;
+};
 
+void CryLockContentionRecord( volatile int *pLock, int nSpins, int nYields, int64 nWaitTicks );
+// Names a lock word in the table, sName must stay valid.
+void CryLockContentionSetName( volatile int *pLock, const char *sName );
+// Copies the tracked locks into pStats, returns their number.
+int  CryLockContentionGetStats( SCryLockContentionStats *pStats, int nMaxStats );
+void CryLockContentionReset();
 
+#endif // CRY_LOCK_CONTENTION_PROFILE
 
+//////////////////////////////////////////////////////////////////////////
+ILINE void CryCpuPause()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	_mm_pause();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#endif
+}
 
+ILINE void CryYieldThread()
+{
+#if defined(LINUX)
+	sched_yield();
+#else
+	CrySleep(0);
+#endif
+}
 
+//////////////////////////////////////////////////////////////////////////
+// Busy wait step: pauses for 1, 2, 4 .. CRY_SPIN_MAX_PAUSE iterations, then yields.
+struct CCrySpinBackoff
+{
+	CCrySpinBackoff() : nPause(1), nSpins(0), nYields(0) {}
 
+	ILINE void Wait()
+	{
+		++nSpins;
+		if (nPause <= CRY_SPIN_MAX_PAUSE)
+		{
+			for (int i=0; i<nPause; ++i)
+				CryCpuPause();
+			nPause <<= 1;
+		}
+		else
+		{
+			++nYields;
+			CryYieldThread();
+		}
+	}
 
+	int nPause;
+	int nSpins;
+	int nYields;
+};
 
-	// NOTE: The code below will fail on 64bit architectures!
-	while(_InterlockedCompareExchange((volatile long*)pLock,setVal,checkVal)!=checkVal);
+//////////////////////////////////////////////////////////////////////////
+#if defined(CRY_STD_ATOMIC_LOCKS)
+ILINE std::atomic<int>& CryAtomicLockWord(volatile int *pLock)
+{
+	static_assert(sizeof(std::atomic<int>) == sizeof(int), "lock words are accessed in place");
+	return *reinterpret_cast<std::atomic<int>*>(const_cast<int*>(pLock));
+}
+#endif
 
+ILINE int CryLockWordLoad(volatile int *pLock)
+{
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	return CryAtomicLockWord(pLock).load(std::memory_order_relaxed);
+#else
+	return *pLock;
 #endif
 }
 
 //////////////////////////////////////////////////////////////////////////
-ILINE void CryInterlockedAdd(volatile int *pVal, int iAdd)
+// Acquire/release access to words that are shared between threads without
+// a lock, like the indices of the lock-free Pipe. Without std::atomic they
+// are plain volatile accesses, which MSVC already orders this way.
+template <typename T> ILINE T CryLoadAcquire(T volatile *p)
 {
-#ifdef _CPU_X86
-# ifdef __GNUC__
-	__asm__(
-		"lock add %[iAdd], (%[pVal])\n"
-		: "=m" (*pVal)
-		: [pVal] "r" (pVal), "m" (*pVal), [iAdd] "r" (iAdd)
-		);
-# else
-	__asm
-	{
-		mov edx, pVal
-		mov eax, iAdd
-		lock add [edx], eax
-	}
-# endif
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	static_assert(sizeof(std::atomic<T>) == sizeof(T), "shared words are accessed in place");
+	return reinterpret_cast<std::atomic<T>*>(const_cast<T*>(p))->load(std::memory_order_acquire);
 #else
+	return *p;
+#endif
+}
 
+template <typename T> ILINE void CryStoreRelease(T volatile *p, T value)
+{
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	static_assert(sizeof(std::atomic<T>) == sizeof(T), "shared words are accessed in place");
+	reinterpret_cast<std::atomic<T>*>(const_cast<T*>(p))->store(value, std::memory_order_release);
+#else
+	*p = value;
+#endif
+}
 
+ILINE bool CryTrySpinLock(volatile int *pLock,int checkVal,int setVal)
+{
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	return CryAtomicLockWord(pLock).compare_exchange_strong(checkVal, setVal, std::memory_order_acquire, std::memory_order_relaxed);
+#else
+	// NOTE: The code below will fail on architectures where long is wider than int!
+	return _InterlockedCompareExchange((volatile long*)pLock,setVal,checkVal)==checkVal;
+#endif
+}
 
+// Slow path of CrySpinLock, deliberately not forced inline.
+inline void CrySpinLockWait(volatile int *pLock,int checkVal,int setVal)
+{
+	CCrySpinBackoff backoff;
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	const int64 nStart = CryGetTicks();
+#endif
 
+	// only retry the exchange once the word looks free, so waiters don't keep stealing the cache line
+	do
+	{
+		backoff.Wait();
+	} while (CryLockWordLoad(pLock)!=checkVal || !CryTrySpinLock(pLock,checkVal,setVal));
 
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	CryLockContentionRecord(pLock, backoff.nSpins, backoff.nYields, CryGetTicks()-nStart);
+#endif
+}
 
+ILINE void CrySpinLock(volatile int *pLock,int checkVal,int setVal)
+{ 
+	if (!CryTrySpinLock(pLock,checkVal,setVal))
+		CrySpinLockWait(pLock,checkVal,setVal);
+}
 
+//////////////////////////////////////////////////////////////////////////
+ILINE void CryInterlockedAdd(volatile int *pVal, int iAdd)
+{
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	CryAtomicLockWord(pVal).fetch_add(iAdd);
+#else
+	// NOTE: The code below will fail on architectures where long is wider than int!
+	_InterlockedExchangeAdd((volatile long*)pVal,iAdd);
+#endif
+}
 
+//////////////////////////////////////////////////////////////////////////
+// Sets the word to setVal if it is checkVal, with full ordering. Unlike
+// CryInterlockedCompareExchange it works on int words where long is wider.
+ILINE bool CryInterlockedTrySet(volatile int *pVal, int checkVal, int setVal)
+{
+#if defined(CRY_STD_ATOMIC_LOCKS)
+	return CryAtomicLockWord(pVal).compare_exchange_strong(checkVal, setVal);
+#else
+	// NOTE: The code below will fail on architectures where long is wider than int!
+	return _InterlockedCompareExchange((volatile long*)pVal,setVal,checkVal)==checkVal;
+#endif
+}
 
+//////////////////////////////////////////////////////////////////////////
+// Waits until no writer holds the lock word, readers count in the bits below WRITE_LOCK_VAL.
+inline void CryReadLockWait(volatile int *pLock)
+{
+	if (!(CryLockWordLoad(pLock) & ~(WRITE_LOCK_VAL-1)))
+		return;
 
+	CCrySpinBackoff backoff;
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	const int64 nStart = CryGetTicks();
+#endif
 
+	// the acquire load that sees the writer gone orders the reads of the reader after the writer's writes
+	// (rather than a fence after the loop, which ThreadSanitizer doesn't understand)
+	do
+	{
+		backoff.Wait();
+	} while (CryLoadAcquire(pLock) & ~(WRITE_LOCK_VAL-1));
 
-	// NOTE: The code below will fail on 64bit architectures!
-	_InterlockedExchangeAdd((volatile long*)pVal,iAdd);
-
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	CryLockContentionRecord(pLock, backoff.nSpins, backoff.nYields, CryGetTicks()-nStart);
 #endif
 }
 
@@ -227,7 +372,7 @@ struct ReadLock
 	ILINE ReadLock(volatile int &rw)
 	{
 		CryInterlockedAdd(prw=&rw,1);
-		volatile char *pw=(volatile char*)&rw+2; for(;*pw;);
+		CryReadLockWait(prw);
 	}
 	~ReadLock()
 	{
@@ -245,7 +390,7 @@ struct ReadLockCond
 		{
 			CryInterlockedAdd(&rw,1);
 			bActivated = 1;
-			volatile char *pw=(volatile char*)&rw+2; for(;*pw;);
+			CryReadLockWait(&rw);
 		}
 		else
 		{
@@ -47,11 +47,20 @@
 //                       single value onto the queue. Constant complexity
 //                       in equilibrium case.
 //
+// PushRange(items, n) - MUST ONLY BE CALLED FROM WRITER THREAD. Push n
+//                       values at once. The values are copied in whole
+//                       spans per page and published once per span, so
+//                       the per item cost is a plain copy.
+//
 // bool Pop(item) -      MUST ONLY BE CALLED FROM READER THREAD. Retrieve
 //                       the next value from the queue. The return value
 //                       indicates whether there was anything to retrieve.
 //                       Constant complexity in equilibrium case.
 //
+// int PopRange(items, n) - MUST ONLY BE CALLED FROM READER THREAD. Retrieve
+//                       up to n values in whole spans per page. Returns
+//                       the number of values retrieved.
+//
 // Clear() -             MUST ONLY BE CALLED FROM WRITER THREAD. Remove all
 //                       items from the queue. Constant complexity in
 //                       equilibrium case.
@@ -83,6 +92,12 @@
 // the traffic in the current situation - in this situation performance is
 // optimal.
 //
+// The page and item indices are published with release stores and read
+// with acquire loads (CryStoreRelease/CryLoadAcquire), so the items written
+// before an index update are visible to the other thread after it.
+//
+// See MultiProducerPipe below for several writer threads.
+//
 //--------------------------------------------------------------------------
 
 #if defined(PROFILE_PIPE_SYS)
@@ -129,12 +144,14 @@ public:
 
 	// Operations that can be called from the writer thread.
 	void Push(const Item& item);
+	void PushRange(const Item* items, int count);
 	void Replace(const Item& item, const Item& replacement);
 	void Swap(Pipe& other);
 	void Clear();
 
 	// Operations that can be called from the reader thread.
 	bool Pop(Item& item);
+	int PopRange(Item* items, int maxCount);
 
 #if defined(PIPE_TESTING)
 	int lastHead, lastTail, lastSize, lastPageCount, lastPagesExpired;
@@ -170,6 +187,15 @@ private:
 		Page* volatile pages[MAX_PAGES];
 	};
 
+	// Writer thread helpers.
+	Data* PrepareWrite();
+	Page* GetLastPage(Data* data, int& tail, int& size);
+	static int GetFreeCount(Page* page, int tail, int size);
+	Page* AddPage(Data* data, int minCount, int& tail, int& size);
+
+	// Reader thread helper.
+	Page* GetReadPage(Data* data, int& head, int& tail, int& size);
+
 	Data* volatile m_data;
 };
 
@@ -190,10 +216,8 @@ template <typename T> inline Pipe<T>::~Pipe()
 	}
 }
 
-template <typename T> inline void Pipe<T>::Push(const Item& item)
+template <typename T> inline typename Pipe<T>::Data* Pipe<T>::PrepareWrite()
 {
-	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
-
 	// First we need to check whether the class is empty - this means we have to initialize the object.
 	Data* data = m_data;
 	if (!data)
@@ -202,7 +226,7 @@ template <typename T> inline void Pipe<T>::Push(const Item& item)
 		data->expiredHead = 0;
 		data->head = 0;
 		data->tail = 0;
-		m_data = data;
+		CryStoreRelease(&m_data, data);
 	}
 
 	// Now we should clean up any pages in the expired queue. When a page is emptied, and there is a larger page
@@ -210,12 +234,11 @@ template <typename T> inline void Pipe<T>::Push(const Item& item)
 	// lags behind, so we can use it to see if there are any pages that *both* the reader and writer threads are
 	// done with. These can then be safely deleted.
 	int expiredHead = data->expiredHead;
-	int pageHead = data->head;
-	int pageTail = data->tail;
+	int pageHead = CryLoadAcquire(&data->head);
 	for (; expiredHead != pageHead; expiredHead = (expiredHead < MAX_PAGES - 1 ? expiredHead + 1 : 0))
 	{
 #if defined(PIPE_TESTING)
-		int pageCount = pageTail - expiredHead;
+		int pageCount = data->tail - expiredHead;
 		if (pageCount < 0)
 			pageCount += MAX_PAGES;
 		if (f)
@@ -226,72 +249,142 @@ template <typename T> inline void Pipe<T>::Push(const Item& item)
 	}
 	data->expiredHead = expiredHead;
 
-	// In order to guarantee delivery order, we can only add to the last page. If there is no last page or there
-	// is no space in the last page, then we must allocate a new page.
-	Page* page = 0;
-	int head = 0;
-	int tail = -1; // This makes the calculations think the queue is full if there is no page.
-	int size = 0;
-	if (pageHead != pageTail)
-	{
-		int lastPageIndex = pageTail - 1;
-		if (lastPageIndex < 0)
-			lastPageIndex += MAX_PAGES;
-		page = data->pages[lastPageIndex];
-		head = page->head;
-		tail = page->tail;
-		size = page->size;
-	}
+	return data;
+}
+
+template <typename T> inline typename Pipe<T>::Page* Pipe<T>::GetLastPage(Data* data, int& tail, int& size)
+{
+	// In order to guarantee delivery order, we can only add to the last page. Expired pages have already been
+	// deleted, so there is a last page unless expiredHead has caught up with the tail.
+	tail = 0;
+	size = 0;
+
+	int pageTail = data->tail;
+	if (data->expiredHead == pageTail)
+		return 0;
+
+	int lastPageIndex = pageTail - 1;
+	if (lastPageIndex < 0)
+		lastPageIndex += MAX_PAGES;
 
-	// Figure out how many free elements are in this page.
-	int freeCount = head - tail;
-	if (freeCount < 0)
+	Page* page = data->pages[lastPageIndex];
+	tail = page->tail;
+	size = page->size;
+	return page;
+}
+
+template <typename T> inline int Pipe<T>::GetFreeCount(Page* page, int tail, int size)
+{
+	// One element is always left unused, so that a full page can be told apart from an empty one.
+	int freeCount = CryLoadAcquire(&page->head) - tail;
+	if (freeCount <= 0)
 		freeCount += size;
+	return freeCount - 1;
+}
 
-	// If there is no free page, create a new one now.
-	if (!page || freeCount == 1)
-	{
-		// Calculate the size of the new page - we start at 16 elements and double the size each time after that.
-		int newSize = size * SIZE_INCREASE_FACTOR;
-		if (newSize == 0)
-			newSize = DEFAULT_INITIAL_SIZE;
-		int newSizeInBytes = sizeof(Page) + (newSize - 1) * sizeof(Item); // The -1 is because the Page structure has a 1-element array member.
-
-		// Create and initialize the page.
-		page = reinterpret_cast<Page*>(new char[newSizeInBytes]);
-		page->size = size = newSize;
-		page->head = head = 0;
-		page->tail = tail = 0;
-
-		page->skipSend = 0;
-		page->skipReceive = 0;
-		page->lastSkipHeadSend = 0;
-		page->lastSkipHeadReceive = 0;
-
-		// Add the page to the page queue. We have made the page queue big enough that it is inconceivable that it
-		// could ever be full (if the page queue became full, it would mean that the writer thread added more than
-		// 68bn items without any being read by the reader thread).
-		data->pages[pageTail] = page;
-		++pageTail;
-		if (pageTail >= MAX_PAGES)
-			pageTail = 0;
-		data->tail = pageTail;
+template <typename T> inline typename Pipe<T>::Page* Pipe<T>::AddPage(Data* data, int minCount, int& tail, int& size)
+{
+	// Calculate the size of the new page - we start at DEFAULT_INITIAL_SIZE elements and double the size each time
+	// after that. A range push may need more than that in one go.
+	int newSize = size * SIZE_INCREASE_FACTOR;
+	if (newSize == 0)
+		newSize = DEFAULT_INITIAL_SIZE;
+	while (newSize - 1 < minCount)
+		newSize *= SIZE_INCREASE_FACTOR;
+	int newSizeInBytes = sizeof(Page) + (newSize - 1) * sizeof(Item); // The -1 is because the Page structure has a 1-element array member.
+
+	// Create and initialize the page.
+	Page* page = reinterpret_cast<Page*>(new char[newSizeInBytes]);
+	page->size = size = newSize;
+	page->head = 0;
+	page->tail = tail = 0;
+
+	page->skipSend = 0;
+	page->skipReceive = 0;
+	page->lastSkipHeadSend = 0;
+	page->lastSkipHeadReceive = 0;
+
+	// Add the page to the page queue. We have made the page queue big enough that it is inconceivable that it
+	// could ever be full (if the page queue became full, it would mean that the writer thread added more than
+	// 68bn items without any being read by the reader thread).
+	int pageTail = data->tail;
+	data->pages[pageTail] = page;
+	++pageTail;
+	if (pageTail >= MAX_PAGES)
+		pageTail = 0;
+	CryStoreRelease(&data->tail, pageTail);
 
 #if defined(PIPE_TESTING)
-		int pageCount = pageTail - expiredHead;
-		if (pageCount < 0)
-			pageCount += MAX_PAGES;
-		if (f)
-			fprintf(f, "Creating page of size %d, %d pages exist\n", newSize, pageCount);
+	int pageCount = pageTail - data->expiredHead;
+	if (pageCount < 0)
+		pageCount += MAX_PAGES;
+	if (f)
+		fprintf(f, "Creating page of size %d, %d pages exist\n", newSize, pageCount);
 #endif //defined(PIPE_TESTING)
-	}
+
+	return page;
+}
+
+template <typename T> inline void Pipe<T>::Push(const Item& item)
+{
+	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
+
+	Data* data = PrepareWrite();
+
+	// If there is no last page or there is no space in the last page, then we must allocate a new page.
+	int tail, size;
+	Page* page = GetLastPage(data, tail, size);
+	if (!page || GetFreeCount(page, tail, size) == 0)
+		page = AddPage(data, 1, tail, size);
 
 	// Add the item to the selected page. We can now safely assume that the page is not full.
 	page->elements[tail] = item;
 	++tail;
 	if (tail >= size)
 		tail = 0;
-	page->tail = tail;
+	CryStoreRelease(&page->tail, tail);
+}
+
+template <typename T> inline void Pipe<T>::PushRange(const Item* items, int count)
+{
+	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
+
+	if (count <= 0)
+		return;
+
+	Data* data = PrepareWrite();
+
+	// Fill whatever is left of the last page first, the rest goes to a new page that is big enough to take it all.
+	int tail, size;
+	Page* page = GetLastPage(data, tail, size);
+	int freeCount = (page ? GetFreeCount(page, tail, size) : 0);
+
+	while (count > 0)
+	{
+		if (freeCount == 0)
+		{
+			page = AddPage(data, count, tail, size);
+			freeCount = size - 1;
+		}
+
+		// The free space may wrap around the end of the page, so copy it as up to two contiguous spans. The
+		// elements are only volatile for the reader's sake - the reader won't touch them before the tail moves.
+		int span = (count < freeCount ? count : freeCount);
+		if (span > size - tail)
+			span = size - tail;
+
+		Item* elements = const_cast<Item*>(&page->elements[tail]);
+		for (int i = 0; i < span; ++i)
+			elements[i] = items[i];
+
+		items += span;
+		count -= span;
+		freeCount -= span;
+		tail += span;
+		if (tail >= size)
+			tail = 0;
+		CryStoreRelease(&page->tail, tail);
+	}
 }
 
 template <typename T> inline void Pipe<T>::Swap(Pipe& other)
@@ -307,8 +400,8 @@ template <typename T> inline void Pipe<T>::Swap(Pipe& other)
 	// only safe to call Swap() on the instance that is being actively read, passing it the inactive
 	// instance as the parameter.
 	Data* data = m_data;
-	m_data = other.m_data; // At this point both instances refer to the same data.
-	other.m_data = data;
+	CryStoreRelease(&m_data, (Data*)other.m_data); // At this point both instances refer to the same data.
+	CryStoreRelease(&other.m_data, data);
 }
 
 template <typename T> inline void Pipe<T>::Replace(const Item& item, const Item& replacement)
@@ -326,10 +419,10 @@ template <typename T> inline void Pipe<T>::Replace(const Item& item, const Item&
 
 	// Loop through all the pages that are still active, searching for any items to replace.
 	int iterations = 0;
-	for (int pageIndex = data->head, pageTail = data->tail; pageIndex != pageTail; pageIndex = (pageIndex < MAX_PAGES - 1 ? pageIndex + 1 : 0))
+	for (int pageIndex = CryLoadAcquire(&data->head), pageTail = data->tail; pageIndex != pageTail; pageIndex = (pageIndex < MAX_PAGES - 1 ? pageIndex + 1 : 0))
 	{
 		Page* page = data->pages[pageIndex];
-		int head = page->head;
+		int head = CryLoadAcquire(&page->head);
 		int tail = page->tail;
 		int size = page->size;
 
@@ -356,7 +449,7 @@ template <typename T> inline void Pipe<T>::Clear()
 	// thread can copy into the head. Yet this too is unsafe, since the reader thread wont know whether a skip
 	// value is new or whether it is the same one it read last time. Therefore we use a monotonically increasing variable
 	// to convey the desired skip position to the reader thread.
-	for (int pageIndex = data->head, pageTail = data->tail; pageIndex != pageTail; pageIndex = (pageIndex < MAX_PAGES - 1 ? pageIndex + 1 : 0))
+	for (int pageIndex = CryLoadAcquire(&data->head), pageTail = data->tail; pageIndex != pageTail; pageIndex = (pageIndex < MAX_PAGES - 1 ? pageIndex + 1 : 0))
 	{
 		Page* page = data->pages[pageIndex];
 		//int head = page->head;
@@ -390,7 +483,7 @@ template <typename T> inline void Pipe<T>::Clear()
 			s_lastSkipHeadSend = page->lastSkipHeadSend;
 			s_oldDistance = oldDistance;
 			s_skipReceive = skipReceive;
-			
+
 			//DebugBreak();
 		}
 #endif //defined(PIPE_TESTING)
@@ -401,7 +494,7 @@ template <typename T> inline void Pipe<T>::Clear()
 		// variable is monotonic, and so does not throw away information. Even if the variable wraps, the mechanism
 		// works with differences, so it should be fine unless we want to skip more than 2bn elements before the reader
 		// reacts.
-		page->skipSend += skipDistance;
+		CryStoreRelease(&page->skipSend, page->skipSend + skipDistance);
 
 #if defined(PIPE_TESTING)
 		page->dbgSkipDistance = skipDistance;
@@ -411,18 +504,11 @@ template <typename T> inline void Pipe<T>::Clear()
 	}
 }
 
-template <typename T> inline bool Pipe<T>::Pop(Item& item)
+template <typename T> inline typename Pipe<T>::Page* Pipe<T>::GetReadPage(Data* data, int& head, int& tail, int& size)
 {
-	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
-
-	// Check whether we have been initialized.
-	Data* data = m_data;
-	if (!data)
-		return false;
-
 	// Find out how many pages exist.
 	int pageHead = data->head;
-	int pageTail = data->tail;
+	int pageTail = CryLoadAcquire(&data->tail);
 	int pageCount = pageTail - pageHead;
 	if (pageCount < 0)
 		pageCount += MAX_PAGES;
@@ -431,23 +517,23 @@ template <typename T> inline bool Pipe<T>::Pop(Item& item)
 	// move the head index past them. This will indicate to the writer thread that it can
 	// safely delete those pages.
 	Page* page = 0;
-	int head = -1;
-	int tail = -1;
-	int size = 0;
+	head = -1;
+	tail = -1;
+	size = 0;
 	if (pageHead != pageTail)
 	{
 		for (;;)
 		{
 			Page* p = data->pages[pageHead];
 			head = p->head;
-			tail = p->tail;
+			tail = CryLoadAcquire(&p->tail);
 			size = p->size;
 
 			// It's possible that the writer thread wants us to skip some elements - this happens
 			// when the queue is cleared, for example. The writer thread conveys the desired head
 			// position to us by increasing the value of a variable - the difference is the amount
 			// the head variable should be moved (based on the last time we were told to skip forward).
-			unsigned int skipSend = p->skipSend;
+			unsigned int skipSend = CryLoadAcquire(&p->skipSend);
 			unsigned int skipDistance = skipSend - p->skipReceive;
 			if (skipDistance)
 			{
@@ -470,7 +556,8 @@ template <typename T> inline bool Pipe<T>::Pop(Item& item)
 					DebugBreak();
 				}
 
-				p->head = head = p->lastSkipHeadReceive; // I'm pretty sure it's impossible for our head to be ahead of this value...
+				head = p->lastSkipHeadReceive; // I'm pretty sure it's impossible for our head to be ahead of this value...
+				CryStoreRelease(&p->head, head);
 			}
 
 			if (head != tail)
@@ -490,190 +577,391 @@ template <typename T> inline bool Pipe<T>::Pop(Item& item)
 #if defined(PIPE_TESTING)
 	lastPagesExpired = pageHead - data->head;
 #endif //defined(PIPE_TESTING)
-	data->head = pageHead;
-
-	// If we found no non-empty page, then the queue is empty and we return nothing.
-	if (!page)
-		return false;
+	CryStoreRelease(&data->head, pageHead);
 
 #if defined(PIPE_TESTING)
-	lastHead = head;
-	lastTail = tail;
-	lastSize = size;
-	lastPageCount = pageCount;
+	if (page)
+	{
+		lastHead = head;
+		lastTail = tail;
+		lastSize = size;
+		lastPageCount = pageCount;
+	}
 #endif //defined(PIPE_TESTING)
 
+	return page;
+}
+
+template <typename T> inline bool Pipe<T>::Pop(Item& item)
+{
+	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
+
+	// Check whether we have been initialized.
+	Data* data = CryLoadAcquire(&m_data);
+	if (!data)
+		return false;
+
+	// If we find no non-empty page, then the queue is empty and we return nothing.
+	int head, tail, size;
+	Page* page = GetReadPage(data, head, tail, size);
+	if (!page)
+		return false;
+
 	// Get the first item of the selected page. It is now safe to assume that the page is not empty.
 	item = page->elements[head];
 	++head;
 	if (head >= size)
 		head = 0;
-	page->head = head;
+	CryStoreRelease(&page->head, head);
 	return true;
 }
 
-#if defined(PIPE_TESTING)
-
-namespace PipeTest
+template <typename T> inline int Pipe<T>::PopRange(Item* items, int maxCount)
 {
-	inline void TestPipeSingleThread()
+	PIPE_FUNCTION_PROFILER(PROFILE_PIPE_SYS);
+
+	Data* data = CryLoadAcquire(&m_data);
+	if (!data)
+		return 0;
+
+	int count = 0;
+	while (count < maxCount)
 	{
-		static const int ITERATION_COUNT = 100;
-		static const int PUSH_COUNT = 100000;
+		int head, tail, size;
+		Page* page = GetReadPage(data, head, tail, size);
+		if (!page)
+			break;
+
+		// The items may wrap around the end of the page, take the contiguous part up to the tail or the page end.
+		int span = (tail > head ? tail : size) - head;
+		if (span > maxCount - count)
+			span = maxCount - count;
+
+		const Item* elements = const_cast<const Item*>(&page->elements[head]);
+		for (int i = 0; i < span; ++i)
+			items[count + i] = elements[i];
+
+		count += span;
+		head += span;
+		if (head >= size)
+			head = 0;
+		CryStoreRelease(&page->head, head);
+	}
 
-		Pipe<int> pipe;
-		f = fopen("c:\\pipetestsinglethread.txt", "w");
-		int currentValue = 0;
-		for (int iteration = 0; iteration < ITERATION_COUNT; ++iteration)
-		{
-			fprintf(f, "\n******************************   ITERATION %d   **************************************\n", iteration);
-			int pushCount = rand() % PUSH_COUNT;
-			int popCount = rand() % PUSH_COUNT;
+	return count;
+}
 
-			for (int i = 0; i < pushCount; ++i)
-			{
-				fprintf(f, "Pushing: %d\n", currentValue);
-				pipe.Push(currentValue++);
-			}
+//--------------------------------------------------------------------------
+// MultiProducerPipe
+//
+// Queue from several writer threads to a single reader thread, e.g. to hand
+// the results of worker threads back to the main thread. Every producer
+// writes to a Pipe of its own, so the producers never contend with each
+// other, and the reader merges the pipes round robin. The items of one
+// producer arrive in the order they were pushed, there is no order between
+// the items of different producers.
+//
+// int AddProducer() -   Thread-safe. Returns the producer index a writer
+//                       thread passes to the writer operations, or -1 if
+//                       all MAX_PRODUCERS producers are taken.
+//
+// Push/PushRange/Clear(producer, ...) - MUST ONLY BE CALLED FROM THE
+//                       WRITER THREAD THAT OWNS THE PRODUCER INDEX.
+//
+// Pop/PopRange -        MUST ONLY BE CALLED FROM READER THREAD.
+//
+//--------------------------------------------------------------------------
+template <typename T> class MultiProducerPipe
+{
+public:
+	typedef T Item;
 
-			for (int i = 0; i < popCount; ++i)
-			{
-				int value;
-				if (pipe.Pop(value))
-					fprintf(f, "%sPopping: %d\n", indentation, value);
-				else
-					fprintf(f, "%sPopping: -\n", indentation);
-			}
+	enum {MAX_PRODUCERS = 32};
 
-			fprintf(f, "%sClearing:\n", indentation);
-			pipe.Clear();
-			for (int i = 0; i < 2; ++i)
-			{
-				int value;
-				if (pipe.Pop(value))
-					fprintf(f, "%sPopping: %d\n", indentation, value);
-				else
-					fprintf(f, "%sPopping: -\n", indentation);
-			}
-		}
-		fclose(f);
-		f = 0;
-	}
+	// Non-thread-safe operations.
+	MultiProducerPipe();
 
-	struct TestPipeThreadData
-	{
-		Pipe<int>* pipe;
-	};
+	// Can be called from any thread.
+	int AddProducer();
 
-	inline DWORD WINAPI TestPipeWriterThread(void* userData)
-	{
-		static const int MAX_VALUES = 100000000;
+	// Operations that can be called from the writer thread owning the producer index.
+	void Push(int producer, const Item& item) {m_pipes[producer].Push(item);}
+	void PushRange(int producer, const Item* items, int count) {m_pipes[producer].PushRange(items, count);}
+	void Clear(int producer) {m_pipes[producer].Clear();}
 
-		if (f)
-			fprintf(f, "Writer thread beginning\n");
+	// Operations that can be called from the reader thread.
+	bool Pop(Item& item);
+	int PopRange(Item* items, int maxCount);
+
+private:
+	int GetProducerCount();
 
-		TestPipeThreadData* threadData = static_cast<TestPipeThreadData*>(userData);
-		Pipe<int>& pipe = *threadData->pipe;
-		for (int i = 0; i < MAX_VALUES; ++i)
+	Pipe<T> m_pipes[MAX_PRODUCERS];
+	int volatile m_producerCount;
+	int m_nextProducer;
+};
+
+template <typename T> inline MultiProducerPipe<T>::MultiProducerPipe()
+:	m_producerCount(0),
+	m_nextProducer(0)
+{
+}
+
+template <typename T> inline int MultiProducerPipe<T>::AddProducer()
+{
+	// Only claim an index that exists, so the count never goes past MAX_PRODUCERS.
+	for (;;)
+	{
+		int producer = CryLoadAcquire(&m_producerCount);
+		if (producer >= MAX_PRODUCERS)
 		{
-			if (i % 100000 == 0)
-			{
-				if (f)
-					fprintf(f, "Clearing queue\n");
-				pipe.Clear();
-			}
-			//if (i % 100000 == 10)
-			//{
-			//	int replaceIndex = i - 9;
-			//	if (f)
-			//		fprintf(f, "Replacing %d\n", replaceIndex);
-			//	pipe.Replace(replaceIndex, 0);
-			//}
-
-			pipe.Push(i);
+			assert(!"MultiProducerPipe: all producers are taken");
+			return -1;
 		}
 
-		if (f)
-			fprintf(f, "Pushing -1\n");
-		pipe.Push(-1);
+		if (CryInterlockedTrySet(&m_producerCount, producer, producer + 1))
+			return producer;
+	}
+}
 
-		if (f)
-			fprintf(f, "Writer thread exitting\n");
+template <typename T> inline int MultiProducerPipe<T>::GetProducerCount()
+{
+	return CryLoadAcquire(&m_producerCount);
+}
 
-		return 0;
+template <typename T> inline bool MultiProducerPipe<T>::Pop(Item& item)
+{
+	// Start after the producer we took the last item from, so a busy producer can't starve the others.
+	int producerCount = GetProducerCount();
+	for (int i = 0; i < producerCount; ++i)
+	{
+		int producer = (m_nextProducer + i) % producerCount;
+		if (m_pipes[producer].Pop(item))
+		{
+			m_nextProducer = producer + 1;
+			return true;
+		}
 	}
+	return false;
+}
+
+template <typename T> inline int MultiProducerPipe<T>::PopRange(Item* items, int maxCount)
+{
+	int producerCount = GetProducerCount();
+	int count = 0;
+	for (int i = 0; i < producerCount && count < maxCount; ++i)
+		count += m_pipes[(m_nextProducer + i) % producerCount].PopRange(items + count, maxCount - count);
+
+	if (producerCount)
+		m_nextProducer = (m_nextProducer + 1) % producerCount;
+	return count;
+}
 
-	inline DWORD WINAPI TestPipeReaderThread(void* userData)
+//--------------------------------------------------------------------------
+// PipeTest
+//
+// Stress tests for Pipe and MultiProducerPipe, compiled in when PIPE_TESTING
+// or PIPE_TEST_SUITE is defined before including this file. The tests only
+// count items and ordering errors, timing and reporting is left to the
+// caller (the game runs them with g_pipeTest). The threaded tests use
+// CCryThread, so they run on every platform, including Linux builds with
+// ThreadSanitizer.
+//--------------------------------------------------------------------------
+#if defined(PIPE_TESTING) || defined(PIPE_TEST_SUITE)
+
+namespace PipeTest
+{
+	struct Result
 	{
-		TestPipeThreadData* threadData = static_cast<TestPipeThreadData*>(userData);
-		Pipe<int>& pipe = *threadData->pipe;
+		Result() : items(0), errors(0) {}
 
-		if (f)
-			fprintf(f, "%sReader thread beginning\n", indentation);
+		int items;  // items that arrived at the reader
+		int errors; // items lost, duplicated or out of order
+	};
 
-		static Pipe<int>* TEST;
-		TEST = &pipe;
+	// Values carry the producer in the top bits and a sequence number in the rest.
+	enum {PRODUCER_SHIFT = 24};
+	enum {MAX_SEQUENCE = (1 << PRODUCER_SHIFT) - 1};
 
-		int lastReceivedValue = -1;
-		for (;;)
+	// Random sequence of single and range pushes and pops and clears from one thread, checked against the
+	// values that must come out next. Since the values are consecutive the reference model is two counters.
+	inline Result TestSingleThread(int iterations)
+	{
+		static const int MAX_BATCH = 3000;
+
+		Result result;
+		Pipe<int> pipe;
+		int nextPush = 0;
+		int nextPop = 0;
+		int buffer[MAX_BATCH];
+
+		for (int iteration = 0; iteration < iterations; ++iteration)
 		{
-			int value;
-			if (pipe.Pop(value))
+			switch (rand() % 5)
 			{
-				if (value == -1)
+			case 0:
+				for (int i = rand() % MAX_BATCH; i > 0; --i)
+					pipe.Push(nextPush++);
+				break;
+
+			case 1:
+				{
+					int count = rand() % MAX_BATCH;
+					for (int i = 0; i < count; ++i)
+						buffer[i] = nextPush++;
+					pipe.PushRange(buffer, count);
+				}
+				break;
+
+			case 2:
+				for (int i = rand() % MAX_BATCH; i > 0; --i)
 				{
-					if (f)
-						fprintf(f, "%sReceived -1\n", indentation);
-					break;
+					int value;
+					bool popped = pipe.Pop(value);
+					if (popped != (nextPop < nextPush) || (popped && value != nextPop))
+						++result.errors;
+					if (!popped)
+						break;
+					++nextPop;
+					++result.items;
 				}
+				break;
 
-				if (value - lastReceivedValue != 1)
+			case 3:
 				{
-					if (pipe.lastPagesExpired)
+					int count = pipe.PopRange(buffer, rand() % MAX_BATCH);
+					for (int i = 0; i < count; ++i)
 					{
-						pipe.lastPagesExpired = pipe.lastPagesExpired;
+						if (buffer[i] != nextPop++)
+							++result.errors;
 					}
-
-					if (f)
-						fprintf(f, "%sMissed %d items starting with %d (lastHead = %d, lastTail = %d, lastSize = %d, lastPageCount = %d, lastPagesExpired = %d)\n",
-							indentation, value - lastReceivedValue - 1, lastReceivedValue + 1, pipe.lastHead, pipe.lastTail, pipe.lastSize, pipe.lastPageCount, pipe.lastPagesExpired);
+					if (nextPop > nextPush)
+						++result.errors;
+					result.items += count;
 				}
+				break;
 
-				lastReceivedValue = value;
+			case 4:
+				if (rand() % 4 == 0)
+				{
+					pipe.Clear();
+					nextPop = nextPush;
+				}
+				break;
 			}
 		}
 
-		if (f)
-			fprintf(f, "%sReader thread exitting\n", indentation);
+		return result;
+	}
 
-		return 0;
+	struct ThreadData
+	{
+		Pipe<int>* pipe;
+		MultiProducerPipe<int>* multiPipe;
+		int count;
+		int batch;
+		int volatile* finished;
+	};
+
+	inline void ProducerThread(void* userData)
+	{
+		ThreadData* threadData = static_cast<ThreadData*>(userData);
+		int producer = (threadData->multiPipe ? threadData->multiPipe->AddProducer() : 0);
+
+		int buffer[256];
+		int batch = (threadData->batch < 256 ? threadData->batch : 256);
+		for (int sequence = 0; sequence < threadData->count; )
+		{
+			int count = (batch < threadData->count - sequence ? batch : threadData->count - sequence);
+			for (int i = 0; i < count; ++i)
+				buffer[i] = (producer << PRODUCER_SHIFT) | sequence++;
+
+			if (threadData->multiPipe && count == 1)
+				threadData->multiPipe->Push(producer, buffer[0]);
+			else if (threadData->multiPipe)
+				threadData->multiPipe->PushRange(producer, buffer, count);
+			else if (count == 1)
+				threadData->pipe->Push(buffer[0]);
+			else
+				threadData->pipe->PushRange(buffer, count);
+		}
+
+		CryInterlockedIncrement(threadData->finished);
 	}
 
-	inline void TestPipeMultiThread()
+	// Pushes count values from each of producerCount writer threads, in batches of batch items (1 for single
+	// pushes), and reads them on the calling thread. With one producer the plain Pipe is used. Every producer's
+	// values have to arrive complete and in order.
+	inline Result TestThreaded(int producerCount, int count, int batch)
 	{
-		TestPipeThreadData threadData;
+		static const int READ_BATCH = 256;
+
+		if (producerCount < 1)
+			producerCount = 1;
+		if (producerCount > MultiProducerPipe<int>::MAX_PRODUCERS)
+			producerCount = MultiProducerPipe<int>::MAX_PRODUCERS;
+		if (count > MAX_SEQUENCE)
+			count = MAX_SEQUENCE;
+		if (batch < 1)
+			batch = 1;
+
 		Pipe<int> pipe;
+		MultiProducerPipe<int> multiPipe;
+		int volatile finished = 0;
+
+		ThreadData threadData;
 		threadData.pipe = &pipe;
+		threadData.multiPipe = (producerCount > 1 ? &multiPipe : 0);
+		threadData.count = count;
+		threadData.batch = batch;
+		threadData.finished = &finished;
 
-		f = fopen("c:\\pipetestmultithread.txt", "w");
+		CCryThread* threads[MultiProducerPipe<int>::MAX_PRODUCERS];
+		for (int i = 0; i < producerCount; ++i)
+			threads[i] = new CCryThread(ProducerThread, &threadData);
 
-		HANDLE hWriterThread = CreateThread(0, 0, TestPipeWriterThread, &threadData, 0, 0);
-		HANDLE hReaderThread = CreateThread(0, 0, TestPipeReaderThread, &threadData, 0, 0);
+		Result result;
+		int expected[MultiProducerPipe<int>::MAX_PRODUCERS] = {0};
+		int buffer[READ_BATCH];
 
-		HANDLE threads[] = {hWriterThread, hReaderThread};
-		WaitForMultipleObjects(sizeof(threads) / sizeof(threads[0]), threads, TRUE, INFINITE);
+		// Read until all producers are done and a pass after that found nothing more.
+		for (bool done = false; ; )
+		{
+			int received;
+			if (batch > 1)
+				received = (threadData.multiPipe ? multiPipe.PopRange(buffer, READ_BATCH) : pipe.PopRange(buffer, READ_BATCH));
+			else
+				received = ((threadData.multiPipe ? multiPipe.Pop(buffer[0]) : pipe.Pop(buffer[0])) ? 1 : 0);
 
-		fclose(f);
-		f = 0;
-	}
+			for (int i = 0; i < received; ++i)
+			{
+				int producer = (buffer[i] >> PRODUCER_SHIFT);
+				int sequence = (buffer[i] & MAX_SEQUENCE);
+				if (producer >= producerCount || sequence != expected[producer])
+					++result.errors;
+				if (producer < producerCount)
+					expected[producer] = sequence + 1;
+			}
+			result.items += received;
 
-	inline void TestPipe()
-	{
-		//TestPipeSingleThread();
-		TestPipeMultiThread();
+			if (received)
+				continue;
+			if (done)
+				break;
+			done = (CryLoadAcquire(&finished) == producerCount);
+			if (!done)
+				CryYieldThread();
+		}
+
+		for (int i = 0; i < producerCount; ++i)
+			delete threads[i];
+
+		int missing = producerCount * count - result.items;
+		result.errors += (missing > 0 ? missing : -missing);
+		return result;
 	}
 }
 
-#endif //defined(PIPE_TESTING)
+#endif //defined(PIPE_TESTING) || defined(PIPE_TEST_SUITE)
 
 #endif //__PIPE_H__
@@ -0,0 +1,154 @@
+//---------------------------------------------------------------------------
+// Copyright 2008 Crytek GmbH
+//---------------------------------------------------------------------------
+#ifndef __STLFRAMEARENAALLOCATOR_H__
+#define __STLFRAMEARENAALLOCATOR_H__
+
+//---------------------------------------------------------------------------
+// STL-compatible interface for the frame arena (see FrameArena.h).
+//
+// Unlike STLPoolAllocator this works with any container, including vectors
+// and strings. Deallocation does nothing, the memory comes back when the
+// arena is reset, so the container must not live past the end of the
+// frame - use it for local scratch containers only.
+//
+// To create a vector of type UserDataType in the calling thread's arena,
+// use the following syntax:
+//
+// std::vector<UserDataType, stl::FrameArenaAllocator<UserDataType> > myVector;
+//---------------------------------------------------------------------------
+
+#include "FrameArena.h"
+#include <stddef.h>
+#include <climits>
+#include <new>
+
+namespace stl
+{
+	template <class T> class FrameArenaAllocator
+	{
+	public:
+		typedef size_t    size_type;
+		typedef ptrdiff_t difference_type;
+		typedef T*        pointer;
+		typedef const T*  const_pointer;
+		typedef T&        reference;
+		typedef const T&  const_reference;
+		typedef T         value_type;
+		template <class U> struct rebind
+		{
+			typedef FrameArenaAllocator<U> other;
+		};
+
+		FrameArenaAllocator() throw()
+		:	m_pArena(&FrameArena::Get()),
+			m_frameId(m_pArena->GetFrameId())
+		{
+		}
+
+		explicit FrameArenaAllocator(FrameArena& arena) throw()
+		:	m_pArena(&arena),
+			m_frameId(arena.GetFrameId())
+		{
+		}
+
+		template <class U> FrameArenaAllocator(const FrameArenaAllocator<U>& other) throw()
+		:	m_pArena(other.GetArena()),
+			m_frameId(other.GetFrameId())
+		{
+		}
+
+		pointer address(reference x) const
+		{
+			return &x;
+		}
+
+		const_pointer address(const_reference x) const
+		{
+			return &x;
+		}
+
+		pointer allocate(size_type n, const void* hint = 0)
+		{
+			// A container that survived a reset would hand out memory that is about to be reused.
+			assert(m_frameId == m_pArena->GetFrameId());
+			size_t alignment = (__alignof(T) > FrameArena::DefaultAlignment ? __alignof(T) : FrameArena::DefaultAlignment);
+			return static_cast<T*>(m_pArena->Allocate(n * sizeof(T), alignment));
+		}
+
+		void deallocate(pointer p, size_type n)
+		{
+			assert(m_frameId == m_pArena->GetFrameId());
+		}
+
+		size_type max_size() const throw()
+		{
+			return INT_MAX / sizeof(T);
+		}
+
+		void construct(pointer p, const T& val)
+		{
+			new(static_cast<void*>(p)) T(val);
+		}
+
+		void construct(pointer p)
+		{
+			new(static_cast<void*>(p)) T();
+		}
+
+		void destroy(pointer p)
+		{
+			p->~T();
+		}
+
+		FrameArena* GetArena() const {return m_pArena;}
+		int GetFrameId() const {return m_frameId;}
+
+		template <class U> bool operator==(const FrameArenaAllocator<U>& other) const {return m_pArena == other.GetArena();}
+		template <class U> bool operator!=(const FrameArenaAllocator<U>& other) const {return m_pArena != other.GetArena();}
+
+	private:
+		FrameArena* m_pArena;
+		int m_frameId;
+	};
+
+	template <> class FrameArenaAllocator<void>
+	{
+	public:
+		typedef void* pointer;
+		typedef const void* const_pointer;
+		typedef void value_type;
+		template <class U>
+		struct rebind { typedef FrameArenaAllocator<U> other; };
+
+		FrameArenaAllocator() throw()
+		:	m_pArena(&FrameArena::Get()),
+			m_frameId(m_pArena->GetFrameId())
+		{
+		}
+
+		explicit FrameArenaAllocator(FrameArena& arena) throw()
+		:	m_pArena(&arena),
+			m_frameId(arena.GetFrameId())
+		{
+		}
+
+		template <class U> FrameArenaAllocator(const FrameArenaAllocator<U>& other) throw()
+		:	m_pArena(other.GetArena()),
+			m_frameId(other.GetFrameId())
+		{
+		}
+
+		FrameArena* GetArena() const {return m_pArena;}
+		int GetFrameId() const {return m_frameId;}
+
+		template <class U> bool operator==(const FrameArenaAllocator<U>& other) const {return m_pArena == other.GetArena();}
+		template <class U> bool operator!=(const FrameArenaAllocator<U>& other) const {return m_pArena != other.GetArena();}
+
+	private:
+		FrameArena* m_pArena;
+		int m_frameId;
+	};
+}
+
+#endif //__STLFRAMEARENAALLOCATOR_H__
@@ -303,6 +303,282 @@ int64 CryQueryPerformanceCounter()
 #endif
 #endif
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lock contention table, see CRY_LOCK_CONTENTION_PROFILE in MultiThread.h.
+// Open addressing on the lock word address, slots are claimed with a compare exchange and never freed.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(CRY_LOCK_CONTENTION_PROFILE) && (!defined(_LIB) || defined(_LAUNCHER))
+namespace
+{
+	struct SCryLockContentionSlot
+	{
+		std::atomic<const volatile int*> pLock;
+		std::atomic<const char*> sName;
+		std::atomic<int64> nContended;
+		std::atomic<int64> nSpins;
+		std::atomic<int64> nYields;
+		std::atomic<int64> nWaitTicks;
+		std::atomic<int64> nMaxWaitTicks;
+	};
+
+	// zero initialized as a global
+	SCryLockContentionSlot g_cryLockContention[CRY_LOCK_CONTENTION_MAX_LOCKS];
+
+	SCryLockContentionSlot* CryLockContentionFind( volatile int *pLock )
+	{
+		const unsigned int nHash = (unsigned int)(((size_t)pLock >> 2) * 2654435761u);
+		for (int i=0; i<CRY_LOCK_CONTENTION_MAX_LOCKS; ++i)
+		{
+			SCryLockContentionSlot &slot = g_cryLockContention[(nHash+i) % CRY_LOCK_CONTENTION_MAX_LOCKS];
+			const volatile int *pSlotLock = slot.pLock.load(std::memory_order_acquire);
+			if (pSlotLock == pLock)
+				return &slot;
+			if (!pSlotLock && (slot.pLock.compare_exchange_strong(pSlotLock, pLock) || pSlotLock == pLock))
+				return &slot;
+		}
+		// table full, the lock goes unrecorded
+		return 0;
+	}
+}
+
+void CryLockContentionRecord( volatile int *pLock, int nSpins, int nYields, int64 nWaitTicks )
+{
+	SCryLockContentionSlot *pSlot = CryLockContentionFind(pLock);
+	if (!pSlot)
+		return;
+
+	pSlot->nContended.fetch_add(1, std::memory_order_relaxed);
+	pSlot->nSpins.fetch_add(nSpins, std::memory_order_relaxed);
+	pSlot->nYields.fetch_add(nYields, std::memory_order_relaxed);
+	pSlot->nWaitTicks.fetch_add(nWaitTicks, std::memory_order_relaxed);
+
+	int64 nMax = pSlot->nMaxWaitTicks.load(std::memory_order_relaxed);
+	while (nWaitTicks > nMax && !pSlot->nMaxWaitTicks.compare_exchange_weak(nMax, nWaitTicks, std::memory_order_relaxed))
+		;
+}
+
+void CryLockContentionSetName( volatile int *pLock, const char *sName )
+{
+	if (SCryLockContentionSlot *pSlot = CryLockContentionFind(pLock))
+		pSlot->sName.store(sName, std::memory_order_relaxed);
+}
+
+int CryLockContentionGetStats( SCryLockContentionStats *pStats, int nMaxStats )
+{
+	int nStats = 0;
+	for (int i=0; i<CRY_LOCK_CONTENTION_MAX_LOCKS && nStats<nMaxStats; ++i)
+	{
+		const SCryLockContentionSlot &slot = g_cryLockContention[i];
+		const volatile int *pLock = slot.pLock.load(std::memory_order_acquire);
+		if (!pLock)
+			continue;
+
+		SCryLockContentionStats &stats = pStats[nStats++];
+		stats.pLock = pLock;
+		stats.sName = slot.sName.load(std::memory_order_relaxed);
+		stats.nContended = slot.nContended.load(std::memory_order_relaxed);
+		stats.nSpins = slot.nSpins.load(std::memory_order_relaxed);
+		stats.nYields = slot.nYields.load(std::memory_order_relaxed);
+		stats.nWaitTicks = slot.nWaitTicks.load(std::memory_order_relaxed);
+		stats.nMaxWaitTicks = slot.nMaxWaitTicks.load(std::memory_order_relaxed);
+	}
+	return nStats;
+}
+
+void CryLockContentionReset()
+{
+	// the slots keep their lock and name, only the counters restart
+	for (int i=0; i<CRY_LOCK_CONTENTION_MAX_LOCKS; ++i)
+	{
+		SCryLockContentionSlot &slot = g_cryLockContention[i];
+		slot.nContended.store(0, std::memory_order_relaxed);
+		slot.nSpins.store(0, std::memory_order_relaxed);
+		slot.nYields.store(0, std::memory_order_relaxed);
+		slot.nWaitTicks.store(0, std::memory_order_relaxed);
+		slot.nMaxWaitTicks.store(0, std::memory_order_relaxed);
+	}
+}
+#endif // CRY_LOCK_CONTENTION_PROFILE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frame profile capture, see FRAME_PROFILE_CAPTURE in FrameProfiler.h.
+// Every thread that records gets a chain of event chunks, linked into a global list with a compare exchange.
+// Only the owning thread writes its chunks, it publishes each event by a release store of the chunk count.
+// The buffers are never freed and are reused by the next capture, a thread notices a new capture by the
+// session number and rewinds its chain itself.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(FRAME_PROFILE_CAPTURE) && (!defined(_LIB) || defined(_LAUNCHER))
+
+// Events per chunk and chunks per thread, about 32MB of events per thread at most.
+#define FRAME_PROFILE_CAPTURE_CHUNK_EVENTS 4096
+#define FRAME_PROFILE_CAPTURE_MAX_CHUNKS 256
+
+volatile bool g_bFrameProfileCapture = false;
+
+namespace
+{
+	struct SFrameProfileCaptureChunk
+	{
+		SFrameProfileCaptureChunk *volatile pNext;
+		volatile int nCount;
+		SFrameProfileCaptureEvent events[FRAME_PROFILE_CAPTURE_CHUNK_EVENTS];
+	};
+
+	struct SFrameProfileCaptureThread
+	{
+		SFrameProfileCaptureThread *pNext;
+		SFrameProfileCaptureChunk *pFirst;
+		SFrameProfileCaptureChunk *pWrite;
+		uint32 nThreadId;
+		int nThread;
+		volatile int nSession;
+		volatile int nDropped;
+		int nChunks;
+		int nDepth;
+	};
+
+	SFrameProfileCaptureThread *volatile g_pFrameProfileCaptureThreads = 0;
+	volatile int g_nFrameProfileCaptureSession = 0;
+	volatile int g_nFrameProfileCaptureThreadCount = 0;
+	// 64 bit, so only accessed through CryLoadAcquire/CryStoreRelease, a plain access can tear on 32 bit
+	volatile int64 g_nFrameProfileCaptureStart = 0;
+
+	THREADLOCAL SFrameProfileCaptureThread *g_pFrameProfileCaptureThread = 0;
+
+	SFrameProfileCaptureChunk* CryFrameProfileCaptureNewChunk()
+	{
+		SFrameProfileCaptureChunk *pChunk = new SFrameProfileCaptureChunk;
+		pChunk->pNext = 0;
+		pChunk->nCount = 0;
+		return pChunk;
+	}
+
+	// The calling thread's buffer, rewound if a new capture started since it last recorded.
+	SFrameProfileCaptureThread* CryFrameProfileCaptureGetThread()
+	{
+		SFrameProfileCaptureThread *pThread = g_pFrameProfileCaptureThread;
+		if (!pThread)
+		{
+			pThread = new SFrameProfileCaptureThread;
+			pThread->pFirst = pThread->pWrite = CryFrameProfileCaptureNewChunk();
+#if defined(LINUX)
+			// the GetCurrentThreadId wrapper returns 0 on Linux
+			pThread->nThreadId = (uint32)(size_t)pthread_self();
+#else
+			pThread->nThreadId = (uint32)GetCurrentThreadId();
+#endif
+			pThread->nThread = CryInterlockedIncrement(&g_nFrameProfileCaptureThreadCount) - 1;
+			pThread->nSession = 0;
+			pThread->nDropped = 0;
+			pThread->nChunks = 1;
+			pThread->nDepth = 0;
+
+			void *pHead;
+			do
+			{
+				pHead = CryLoadAcquire(&g_pFrameProfileCaptureThreads);
+				pThread->pNext = (SFrameProfileCaptureThread*)pHead;
+			}
+			while (CryInterlockedCompareExchangePointer((void* volatile*)&g_pFrameProfileCaptureThreads, pThread, pHead) != pHead);
+
+			g_pFrameProfileCaptureThread = pThread;
+		}
+
+		const int nSession = CryLoadAcquire(&g_nFrameProfileCaptureSession);
+		if (pThread->nSession != nSession)
+		{
+			for (SFrameProfileCaptureChunk *pChunk = pThread->pFirst; pChunk; pChunk = pChunk->pNext)
+				CryStoreRelease(&pChunk->nCount, 0);
+			pThread->pWrite = pThread->pFirst;
+			pThread->nDepth = 0;
+			CryStoreRelease(&pThread->nDropped, 0);
+			CryStoreRelease(&pThread->nSession, nSession);
+		}
+		return pThread;
+	}
+}
+
+int64 CryFrameProfileCaptureBegin()
+{
+	++CryFrameProfileCaptureGetThread()->nDepth;
+	const int64 nTicks = CryGetTicks();
+	// 0 means not recorded to the section
+	return nTicks ? nTicks : 1;
+}
+
+void CryFrameProfileCaptureEnd( const CFrameProfiler *pProfiler,int64 nStart )
+{
+	const int64 nEnd = CryGetTicks();
+	SFrameProfileCaptureThread *pThread = CryFrameProfileCaptureGetThread();
+	if (pThread->nDepth > 0)
+		--pThread->nDepth;
+
+	// begun in an earlier capture
+	if (nStart < CryLoadAcquire(&g_nFrameProfileCaptureStart))
+		return;
+
+	SFrameProfileCaptureChunk *pChunk = pThread->pWrite;
+	if (pChunk->nCount == FRAME_PROFILE_CAPTURE_CHUNK_EVENTS)
+	{
+		if (!pChunk->pNext)
+		{
+			if (pThread->nChunks == FRAME_PROFILE_CAPTURE_MAX_CHUNKS)
+			{
+				CryStoreRelease(&pThread->nDropped, pThread->nDropped + 1);
+				return;
+			}
+			CryStoreRelease(&pChunk->pNext, CryFrameProfileCaptureNewChunk());
+			++pThread->nChunks;
+		}
+		pThread->pWrite = pChunk = pChunk->pNext;
+	}
+
+	SFrameProfileCaptureEvent &event = pChunk->events[pChunk->nCount];
+	event.sName = pProfiler->m_name;
+	event.nStart = nStart;
+	event.nEnd = nEnd;
+	event.nDepth = (uint16)pThread->nDepth;
+	event.nSubsystem = (uint16)pProfiler->m_subsystem;
+	CryStoreRelease(&pChunk->nCount, pChunk->nCount + 1);
+}
+
+void CryFrameProfileCaptureStart()
+{
+	CryStoreRelease(&g_bFrameProfileCapture, false);
+	// published before the session changes, a thread that sees the new session also sees the new start
+	CryStoreRelease(&g_nFrameProfileCaptureStart, CryGetTicks());
+	CryInterlockedIncrement(&g_nFrameProfileCaptureSession);
+	CryStoreRelease(&g_bFrameProfileCapture, true);
+}
+
+void CryFrameProfileCaptureStop()
+{
+	CryStoreRelease(&g_bFrameProfileCapture, false);
+}
+
+int CryFrameProfileCaptureEnumerate( FrameProfileCaptureCallback pCallback,void *pUserData )
+{
+	const int nSession = CryLoadAcquire(&g_nFrameProfileCaptureSession);
+	int nDropped = 0;
+	for (SFrameProfileCaptureThread *pThread = CryLoadAcquire(&g_pFrameProfileCaptureThreads); pThread; pThread = pThread->pNext)
+	{
+		// threads that recorded nothing in this capture still hold the previous one
+		if (CryLoadAcquire(&pThread->nSession) != nSession)
+			continue;
+
+		for (SFrameProfileCaptureChunk *pChunk = pThread->pFirst; pChunk; pChunk = CryLoadAcquire(&pChunk->pNext))
+		{
+			const int nCount = CryLoadAcquire(&pChunk->nCount);
+			if (!nCount)
+				break;
+			pCallback(pThread->nThread, pThread->nThreadId, pChunk->events, nCount, pUserData);
+		}
+		nDropped += CryLoadAcquire(&pThread->nDropped);
+	}
+	return nDropped;
+}
+#endif // FRAME_PROFILE_CAPTURE
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Threads implementation. For static linking it must be declared inline otherwise creating multiple symbols
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
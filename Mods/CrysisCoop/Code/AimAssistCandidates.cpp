@@ -0,0 +1,181 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "AimAssistCandidates.h"
+#include "Game.h"
+#include <IActorSystem.h>
+#include <IVehicleSystem.h>
+#include <Cry_GeoIntersectBatch.h>
+
+//------------------------------------------------------------------------
+CAimAssistCandidates::CAimAssistCandidates()
+: m_count(0),
+	m_frameId(-1),
+	m_range(0.0f)
+{
+}
+
+//------------------------------------------------------------------------
+void CAimAssistCandidates::Reset()
+{
+	m_entityIds.resize(0);
+	m_minX.resize(0); m_minY.resize(0); m_minZ.resize(0);
+	m_maxX.resize(0); m_maxY.resize(0); m_maxZ.resize(0);
+	m_count = 0;
+	m_frameId = -1;
+	m_range = 0.0f;
+}
+
+//------------------------------------------------------------------------
+void CAimAssistCandidates::Refresh(float range)
+{
+	if (!gEnv->pRenderer)
+		return;
+
+	const int frameId = gEnv->pRenderer->GetFrameID(false);
+	if (frameId == m_frameId && range <= m_range)
+		return;
+
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	Reset();
+	m_frameId = frameId;
+	m_range = range;
+
+	const CCamera &cam = gEnv->pRenderer->GetCamera();
+	const Vec3 camPos = cam.GetPosition();
+	const AABB rangeBox(camPos-Vec3(range,range,range), camPos+Vec3(range,range,range));
+
+	IGameFramework *pFramework = g_pGame->GetIGameFramework();
+	AABB bounds;
+
+	IActorIteratorPtr pActorIt = pFramework->GetIActorSystem()->CreateActorIterator();
+	while (IActor *pActor = pActorIt->Next())
+	{
+		IEntity *pEntity = pActor->GetEntity();
+		if (!pEntity || pEntity->IsHidden())
+			continue;
+
+		pEntity->GetWorldBounds(bounds);
+		if (bounds.IsIntersectBox(rangeBox) && cam.IsAABBVisible_F(bounds))
+			Add(pEntity->GetId(), bounds);
+	}
+
+	IVehicleIteratorPtr pVehicleIt = pFramework->GetIVehicleSystem()->CreateVehicleIterator();
+	while (IVehicle *pVehicle = pVehicleIt->Next())
+	{
+		IEntity *pEntity = pVehicle->GetEntity();
+		if (!pEntity || pEntity->IsHidden())
+			continue;
+
+		pEntity->GetWorldBounds(bounds);
+		if (bounds.IsIntersectBox(rangeBox) && cam.IsAABBVisible_F(bounds))
+			Add(pEntity->GetId(), bounds);
+	}
+}
+
+//------------------------------------------------------------------------
+void CAimAssistCandidates::Add(EntityId entityId, const AABB &bounds)
+{
+	m_entityIds.push_back(entityId);
+	m_minX.push_back(bounds.min.x); m_minY.push_back(bounds.min.y); m_minZ.push_back(bounds.min.z);
+	m_maxX.push_back(bounds.max.x); m_maxY.push_back(bounds.max.y); m_maxZ.push_back(bounds.max.z);
+	++m_count;
+}
+
+//------------------------------------------------------------------------
+int CAimAssistCandidates::IntersectSegment(const Lineseg &seg, float margin, int *pResults, int maxResults) const
+{
+	if (!m_count)
+		return 0;
+
+	Intersect::AABBArrays boxes;
+	boxes.minX = &m_minX[0]; boxes.minY = &m_minY[0]; boxes.minZ = &m_minZ[0];
+	boxes.maxX = &m_maxX[0]; boxes.maxY = &m_maxY[0]; boxes.maxZ = &m_maxZ[0];
+	boxes.count = m_count;
+	boxes.margin = margin;
+
+	return Intersect::Lineseg_AABBs(seg, boxes, pResults, maxResults);
+}
+
+//------------------------------------------------------------------------
+int CAimAssistCandidates::IntersectSegmentScalar(const Lineseg &seg, float margin, int *pResults, int maxResults) const
+{
+	const Vec3 dir = seg.end-seg.start;
+	const Vec3 inv(Intersect::BatchDetail::SafeInv(dir.x), Intersect::BatchDetail::SafeInv(dir.y), Intersect::BatchDetail::SafeInv(dir.z));
+
+	int numResults = 0;
+
+	for (int i=0; i<m_count && numResults<maxResults; ++i)
+	{
+		float t1 = (m_minX[i]-margin-seg.start.x)*inv.x;
+		float t2 = (m_maxX[i]+margin-seg.start.x)*inv.x;
+		float tEnter = max(min(t1, t2), 0.0f);
+		float tExit = min(max(t1, t2), 1.0f);
+
+		t1 = (m_minY[i]-margin-seg.start.y)*inv.y;
+		t2 = (m_maxY[i]+margin-seg.start.y)*inv.y;
+		tEnter = max(tEnter, min(t1, t2));
+		tExit = min(tExit, max(t1, t2));
+
+		t1 = (m_minZ[i]-margin-seg.start.z)*inv.z;
+		t2 = (m_maxZ[i]+margin-seg.start.z)*inv.z;
+		tEnter = max(tEnter, min(t1, t2));
+		tExit = min(tExit, max(t1, t2));
+
+		if (tEnter <= tExit)
+			pResults[numResults++] = i;
+	}
+
+	return numResults;
+}
+
+//------------------------------------------------------------------------
+void CAimAssistCandidates::GetMemoryStatistics(ICrySizer *s) const
+{
+	s->AddContainer(m_entityIds);
+	s->AddContainer(m_minX); s->AddContainer(m_minY); s->AddContainer(m_minZ);
+	s->AddContainer(m_maxX); s->AddContainer(m_maxY); s->AddContainer(m_maxZ);
+}
+
+//------------------------------------------------------------------------
+void CAimAssistCandidates::Benchmark(int count, int iterations)
+{
+	// actor sized boxes scattered in front of the origin, segments fanned out like aim lines
+	CAimAssistCandidates bench;
+	for (int i=0; i<count; ++i)
+	{
+		const Vec3 pos(Random(-50.0f, 50.0f), Random(5.0f, 150.0f), Random(-2.0f, 5.0f));
+		bench.Add(i+1, AABB(pos-Vec3(0.4f,0.4f,0.0f), pos+Vec3(0.4f,0.4f,1.8f)));
+	}
+
+	const int numSegs = 64;
+	std::vector<Lineseg> segs;
+	segs.reserve(numSegs);
+	for (int i=0; i<numSegs; ++i)
+	{
+		const Vec3 dir = Vec3(Random(-0.4f, 0.4f), 1.0f, Random(-0.05f, 0.05f)).GetNormalized();
+		segs.push_back(Lineseg(Vec3(0,0,1.6f), Vec3(0,0,1.6f)+dir*150.0f));
+	}
+
+	int results[MAX_HITS];
+	int hitsBatch = 0, hitsScalar = 0;
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		hitsBatch += bench.IntersectSegment(segs[n%numSegs], 0.0f, results, MAX_HITS);
+	const float batchTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		hitsScalar += bench.IntersectSegmentScalar(segs[n%numSegs], 0.0f, results, MAX_HITS);
+	const float scalarTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	CryLogAlways("[AimAssist] %d candidates, %d segments: batch %.3fms (%.3fus each), scalar %.3fms (%.3fus each)",
+		count, iterations, batchTime, batchTime*1000.0f/max(1, iterations), scalarTime, scalarTime*1000.0f/max(1, iterations));
+
+	if (hitsBatch != hitsScalar)
+		GameWarning("[AimAssist] Batch and scalar tests disagree: %d vs %d hits", hitsBatch, hitsScalar);
+}
@@ -0,0 +1,54 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __AIM_ASSIST_CANDIDATES_H__
+#define __AIM_ASSIST_CANDIDATES_H__
+
+#pragma once
+
+// Per-frame set of possible aim assistance targets for the client camera.
+// Built once per render frame from the actors and vehicles inside the view
+// frustum, their world bounds are kept as arrays per component so the aim
+// line can be tested with the batched Intersect::Lineseg_AABBs.
+// Used by CSingle::UpdateAutoAim and CSingle::CrosshairAssistAiming.
+class CAimAssistCandidates
+{
+public:
+	enum { MAX_HITS = 64 };
+
+	CAimAssistCandidates();
+
+	// rebuilds the set unless it was already built this frame for at least this range
+	void Refresh(float range);
+	void Reset();
+
+	// tests the segment against all candidate bounds grown by margin,
+	// writes the indices of the crossed candidates and returns their count
+	int IntersectSegment(const Lineseg &seg, float margin, int *pResults, int maxResults) const;
+
+	int GetCount() const { return m_count; }
+	EntityId GetEntityId(int idx) const { return m_entityIds[idx]; }
+
+	void GetMemoryStatistics(ICrySizer *s) const;
+
+	// times the batched test against the scalar one on a synthetic set
+	static void Benchmark(int count, int iterations);
+
+private:
+	void Add(EntityId entityId, const AABB &bounds);
+	int IntersectSegmentScalar(const Lineseg &seg, float margin, int *pResults, int maxResults) const;
+
+	typedef std::vector<float> TFloatVector;
+
+	std::vector<EntityId>	m_entityIds;
+	// world bounds
+	TFloatVector					m_minX, m_minY, m_minZ;
+	TFloatVector					m_maxX, m_maxY, m_maxZ;
+	int										m_count;
+
+	int										m_frameId;
+	float									m_range;
+};
+
+#endif // __AIM_ASSIST_CANDIDATES_H__
@@ -3,6 +3,7 @@
 #include "PlayerMovementController.h"
 #include "IVehicleSystem.h"
 #include "Weapon.h"
+#include "Coop\CoopSystem.h"
 
 CCoopGrunt::CCoopGrunt() :
 	m_nStance(STANCE_RELAXED),
@@ -48,7 +49,7 @@ void CCoopGrunt::RegisterMultiplayerAI()
 {
 	if (GetHealth() <= 0 && GetEntity()->GetAI())
 	{
-		gEnv->bMultiplayer = false;
+		CCoopSystem::GetInstance()->SetMultiplayer(false);
 
 		IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
 		gEnv->pScriptSystem->BeginCall(pScriptTable, "UnregisterAI");
@@ -56,11 +57,11 @@ void CCoopGrunt::RegisterMultiplayerAI()
 		gEnv->pScriptSystem->EndCall(pScriptTable);
 		CryLogAlways("AI Unregistered for Grunt %s", GetEntity()->GetName());
 
-		gEnv->bMultiplayer = true;
+		CCoopSystem::GetInstance()->SetMultiplayer(true);
 	}
 	else if (!GetEntity()->GetAI() && GetHealth() > 0)
 	{
-		gEnv->bMultiplayer = false;
+		CCoopSystem::GetInstance()->SetMultiplayer(false);
 
 		IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
 		gEnv->pScriptSystem->BeginCall(pScriptTable, "RegisterAI");
@@ -68,7 +69,7 @@ void CCoopGrunt::RegisterMultiplayerAI()
 		gEnv->pScriptSystem->EndCall(pScriptTable);
 		CryLogAlways("AI Registered for Grunt %s", GetEntity()->GetName());
 
-		gEnv->bMultiplayer = true;
+		CCoopSystem::GetInstance()->SetMultiplayer(true);
 	}
 }
 
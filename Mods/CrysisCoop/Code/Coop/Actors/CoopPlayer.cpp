@@ -2,21 +2,17 @@
 #include "CoopPlayer.h"
 #include <IConsole.h>
 #include <IGameFramework.h>
+#include "Coop\CoopSystem.h"
 
-CCoopPlayer::CCoopPlayer() : m_pSystemUpdateRate(0),
-	m_fDetectionTimer(0),
-	m_fDetectionValue(0),
-	m_fLastDetectionValue(0),
-	m_fNetDetectionDelay(0.f),
-	m_fMusicIntensity(0.f),
-	m_bMusicForceMood(false),
-	m_fMusicDelay(0.f)
+CCoopPlayer::CCoopPlayer() :
+	m_fDetectionValue(0)
 {
 }
 
 CCoopPlayer::~CCoopPlayer()
 {
-	m_pSystemUpdateRate = 0;
+	CCoopSystem::GetInstance()->GetMusicController().UnregisterPlayer(GetEntityId());
+	CCoopSystem::GetInstance()->GetPerceptionSummary().UnregisterPlayer(GetEntityId());
 }
 
 //CPlayer
@@ -25,7 +21,8 @@ bool CCoopPlayer::Init(IGameObject * pGameObject)
 	if (!CPlayer::Init(pGameObject))
 		return false;
 
-	m_pSystemUpdateRate = gEnv->pConsole->GetCVar("ai_UpdateInterval");
+	CCoopSystem::GetInstance()->GetMusicController().RegisterPlayer(GetEntityId());
+	CCoopSystem::GetInstance()->GetPerceptionSummary().RegisterPlayer(GetEntityId());
 
 	return true;
 }
@@ -38,25 +35,13 @@ void CCoopPlayer::PostInit(IGameObject * pGameObject)
 void CCoopPlayer::Update(SEntityUpdateContext& ctx, int updateSlot)
 {
 	CPlayer::Update(ctx, updateSlot);
-	UpdateMusic(ctx.fFrameTime);
-
-	if (gEnv->bServer)
-	{
-		if (m_fNetDetectionDelay > 0.1f)
-		{
-			m_fNetDetectionDelay = 0.f;
-			GetGameObject()->InvokeRMI(CCoopPlayer::ClUpdateAwareness(), SAwarenessParams(m_fDetectionValue),  eRMI_ToClientChannel, GetChannelId());
-		}
-		else
-			m_fNetDetectionDelay += ctx.fFrameTime;
-	}
 
 
     if (IsPlayer() && gEnv->bServer)
     {
         if (GetHealth() <= 0 && GetEntity()->GetAI())
         {
-            gEnv->bMultiplayer = false;
+            CCoopSystem::GetInstance()->SetMultiplayer(false);
  
             IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
 			
@@ -66,11 +51,11 @@ void CCoopPlayer::Update(SEntityUpdateContext& ctx, int updateSlot)
 
 			CryLogAlways("AI Registered for Player %s", GetEntity()->GetName());
  
-            gEnv->bMultiplayer = true;
+            CCoopSystem::GetInstance()->SetMultiplayer(true);
         }
         else if (!GetEntity()->GetAI() && GetSpectatorMode() == eASM_None && GetHealth() > 0)
         {
-            gEnv->bMultiplayer = false;
+            CCoopSystem::GetInstance()->SetMultiplayer(false);
  
             IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
  
@@ -80,7 +65,7 @@ void CCoopPlayer::Update(SEntityUpdateContext& ctx, int updateSlot)
 
 			CryLogAlways("AI Unregistered for Player %s", GetEntity()->GetName());
  
-            gEnv->bMultiplayer = true;
+            CCoopSystem::GetInstance()->SetMultiplayer(true);
         }
     }
 
@@ -101,52 +86,14 @@ void CCoopPlayer::Update(SEntityUpdateContext& ctx, int updateSlot)
 
 }
 
-void CCoopPlayer::UpdateMusic(float frameTime)
+void CCoopPlayer::ForceMusicMood(float intensity, bool force)
 {
-	m_fMusicDelay += frameTime;
-
-	if (IsClient() && m_fMusicDelay > 3.0f)
-	{
-		m_fMusicDelay = 0.f;
-
-		const char* mood = gEnv->pMusicSystem->GetMood();
-
-		if (!m_bMusicForceMood)
-			m_fMusicIntensity = m_fDetectionValue;
-
-		if (m_fMusicIntensity < 0.1f)
-		{
-			if (strcmp(mood, "incidental") != 0)
-				gEnv->pMusicSystem->SetMood("incidental", false);
-		}
-		else if (m_fMusicIntensity < 0.2f)
-		{
-			if (strcmp(mood, "ambient") != 0)
-				gEnv->pMusicSystem->SetMood("ambient", false);
-		}
-		else if (m_fMusicIntensity < 0.65f)
-		{
-			if (strcmp(mood, "middle") != 0)
-				gEnv->pMusicSystem->SetMood("middle", false);
-		}
-		else
-		{
-			if (strcmp(mood, "action") != 0)
-				gEnv->pMusicSystem->SetMood("action", false);
-		}
-	}
+	CCoopSystem::GetInstance()->GetMusicController().ForceIntensity(intensity, force);
 }
 
 void CCoopPlayer::PostUpdate(float frameTime)
 {
 	CPlayer::PostUpdate(frameTime);
-
-	if (gEnv->bServer)
-	{
-		// Called here not to interfere with AI system.
-		UpdateDetectionValue(frameTime);
-	}
-	
 }
 
 bool CCoopPlayer::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags)
@@ -158,55 +105,15 @@ bool CCoopPlayer::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 prof
 }
 //~CPlayer
 
-void CCoopPlayer::UpdateDetectionValue(float frameTime)
+// Summary:
+//	Called by CCoopPerceptionSummary on the server once per AI tick.
+void CCoopPlayer::SetDetectionValue(float fValue, bool bReplicate)
 {
-	// Local player can use AI system's default method.
-	if (GetEntityId() == g_pGame->GetIGameFramework()->GetClientActorId())
-	{
-		SAIDetectionLevels aiDetectionLevels;
-		gEnv->pAISystem->GetDetectionLevels(0, aiDetectionLevels);
-		m_fDetectionValue = max(max(aiDetectionLevels.puppetExposure, aiDetectionLevels.puppetThreat),
-								max(aiDetectionLevels.vehicleExposure, aiDetectionLevels.vehicleThreat));
-		return;
-	}
-
-	m_fDetectionTimer += frameTime;
-	// Only detect with AI system update intervals.
-	if (m_fDetectionTimer >= m_pSystemUpdateRate->GetFVal() + 0.05f)
-	{
-		// No AI for player nothing to be detected
-		if (!GetEntity()->GetAI())
-			return;
-
-		m_fDetectionTimer = 0.0f;
-
-		float* pAIActorFloat = (float*)GetEntity()->GetAI()->CastToIAIActor();
-
-		// Varies between X86 and X64
-		int nDataIndex = (sizeof(void*) == 8) ? 502 : 473;
-
-		// Create snapshot
-		pAIActorFloat[nDataIndex + 4] = pAIActorFloat[nDataIndex + 0];
-		pAIActorFloat[nDataIndex + 5] = pAIActorFloat[nDataIndex + 1];
-		pAIActorFloat[nDataIndex + 6] = pAIActorFloat[nDataIndex + 2];
-		pAIActorFloat[nDataIndex + 7] = pAIActorFloat[nDataIndex + 3];
-
-		SAIDetectionLevels aiDetectionLevels;
-		aiDetectionLevels.puppetExposure = pAIActorFloat[nDataIndex + 0];
-		aiDetectionLevels.puppetThreat = pAIActorFloat[nDataIndex + 1];
-		aiDetectionLevels.vehicleExposure = pAIActorFloat[nDataIndex + 2];
-		aiDetectionLevels.vehicleThreat = pAIActorFloat[nDataIndex + 3];
-
-		// Reset originals
-		pAIActorFloat[nDataIndex + 0] = 0;
-		pAIActorFloat[nDataIndex + 1] = 0;
-		pAIActorFloat[nDataIndex + 2] = 0;
-		pAIActorFloat[nDataIndex + 3] = 0;
-
-		m_fDetectionValue = max(max(aiDetectionLevels.puppetExposure, aiDetectionLevels.puppetThreat),
-								max(aiDetectionLevels.vehicleExposure, aiDetectionLevels.vehicleThreat));
-
-	}
+	m_fDetectionValue = fValue;
+
+	// every client aggregates the alertness of all players for its music
+	if (bReplicate)
+		GetGameObject()->InvokeRMI(CCoopPlayer::ClUpdateAwareness(), SAwarenessParams(m_fDetectionValue), eRMI_ToRemoteClients);
 }
 
 IMPLEMENT_RMI(CCoopPlayer, ClUpdateAwareness)
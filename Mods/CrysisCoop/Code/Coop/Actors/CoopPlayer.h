@@ -31,14 +31,10 @@ public:
 		}
 	};
 
-	void ForceMusicMood(float intensity, bool force){m_bMusicForceMood = force; m_fMusicIntensity = intensity; m_fMusicDelay = 5.f;};
+	void ForceMusicMood(float intensity, bool force);
 
 	DECLARE_CLIENT_RMI_PREATTACH(ClUpdateAwareness, SAwarenessParams, eNRT_ReliableUnordered);
 
-private:
-	void UpdateDetectionValue(float frameTime);
-	void UpdateMusic(float frameTime);
-
 public:
 	
 	// Summary:
@@ -47,19 +43,12 @@ public:
 		return m_fDetectionValue;
 	}
 
+	// Summary:
+	//	Sets the detection value on the server, sending it to the clients if bReplicate.
+	void SetDetectionValue(float fValue, bool bReplicate);
+
 private:
-	struct ICVar* m_pSystemUpdateRate;
-	float m_fDetectionTimer;
 	float m_fDetectionValue;
-
-	float m_fMusicDelay;
-
-	float m_fLastDetectionValue;
-
-	float m_fNetDetectionDelay;
-
-	float m_fMusicIntensity;
-	bool m_bMusicForceMood;
 };
 
 #endif // __COOPPLAYER_H__
\ No newline at end of file
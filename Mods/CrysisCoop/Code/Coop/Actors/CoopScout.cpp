@@ -36,7 +36,7 @@ void CCoopScout::RegisterMultiplayerAI()
 {
 	if (GetHealth() <= 0 && GetEntity()->GetAI())
 	{
-		gEnv->bMultiplayer = false;
+		CCoopSystem::GetInstance()->SetMultiplayer(false);
 
 		IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
 		gEnv->pScriptSystem->BeginCall(pScriptTable, "UnregisterAI");
@@ -44,11 +44,11 @@ void CCoopScout::RegisterMultiplayerAI()
 		gEnv->pScriptSystem->EndCall(pScriptTable);
 		CryLogAlways("AI Unregistered for Scout %s", GetEntity()->GetName());
 
-		gEnv->bMultiplayer = true;
+		CCoopSystem::GetInstance()->SetMultiplayer(true);
 	}
 	else if (!GetEntity()->GetAI() && GetHealth() > 0)
 	{
-		gEnv->bMultiplayer = false;
+		CCoopSystem::GetInstance()->SetMultiplayer(false);
 
 		IScriptTable* pScriptTable = GetEntity()->GetScriptTable();
 		gEnv->pScriptSystem->BeginCall(pScriptTable, "RegisterAI");
@@ -56,7 +56,7 @@ void CCoopScout::RegisterMultiplayerAI()
 		gEnv->pScriptSystem->EndCall(pScriptTable);
 		CryLogAlways("AI Registered for Scout %s", GetEntity()->GetName());
 
-		gEnv->bMultiplayer = true;
+		CCoopSystem::GetInstance()->SetMultiplayer(true);
 	}
 }
 
@@ -0,0 +1,325 @@
+#include <StdAfx.h>
+#include "CoopMusicController.h"
+
+#include <IMusicSystem.h>
+#include <IActorSystem.h>
+#include <IConsole.h>
+
+#include "Game.h"
+#include "Coop/Actors/CoopPlayer.h"
+
+float CCoopMusicController::sTeamWeight = 0.5f;
+int CCoopMusicController::sDebugMusic = 0;
+
+namespace
+{
+	// Seconds between two mood decisions.
+	const float DECISION_INTERVAL = 3.0f;
+
+	struct SMoodEntry
+	{
+		CCoopMusicController::EMood mood;
+		const char* sName;
+		// alertness below which this mood is used, the last entry takes the rest
+		float fMaxIntensity;
+	};
+
+	const SMoodEntry g_moodTable[CCoopMusicController::eMood_Count] =
+	{
+		{ CCoopMusicController::eMood_Incidental,	"incidental",	0.1f },
+		{ CCoopMusicController::eMood_Ambient,		"ambient",		0.2f },
+		{ CCoopMusicController::eMood_Middle,		"middle",		0.65f },
+		{ CCoopMusicController::eMood_Action,		"action",		FLT_MAX },
+	};
+}
+
+CCoopMusicController::CCoopMusicController()
+{
+}
+
+void CCoopMusicController::Reset()
+{
+	m_state = SState();
+	m_sTheme.clear();
+	for (int i = 0; i < eMood_Count; ++i)
+		m_moodNames[i].clear();
+}
+
+// Summary:
+//	Aggregates the alertness of the players and switches the mood when due (client).
+void CCoopMusicController::Update(float fFrameTime)
+{
+	IMusicSystem* pMusicSystem = gEnv->pMusicSystem;
+	if (!gEnv->bClient || !pMusicSystem)
+		return;
+
+	const EMood mood = Step(m_state, fFrameTime, GetAggregateAlertness());
+	if (mood == eMood_None)
+		return;
+
+	const char* sTheme = pMusicSystem->GetTheme();
+	if (!sTheme)
+		sTheme = "";
+
+	if (m_sTheme.empty() || m_sTheme != sTheme)
+		ResolveMoods(sTheme);
+
+	const string& sName = m_moodNames[mood];
+	if (sName.empty())
+		return;
+
+	// the mood may also have been changed by scripts or flowgraph since the last decision
+	const char* sCurrent = pMusicSystem->GetMood();
+	if (!sCurrent || stricmp(sCurrent, sName.c_str()) != 0)
+	{
+		pMusicSystem->SetMood(sName.c_str(), false);
+
+		if (sDebugMusic)
+			CryLogAlways("[CCoopMusicController] Mood %s -> %s", sCurrent ? sCurrent : "<none>", sName.c_str());
+	}
+}
+
+void CCoopMusicController::ForceIntensity(float fIntensity, bool bForce)
+{
+	m_state.bForced = bForce;
+	m_state.fForcedIntensity = fIntensity;
+	m_state.fDelay = DECISION_INTERVAL;
+}
+
+void CCoopMusicController::RegisterPlayer(EntityId playerId)
+{
+	stl::push_back_unique(m_players, playerId);
+}
+
+void CCoopMusicController::UnregisterPlayer(EntityId playerId)
+{
+	stl::find_and_erase(m_players, playerId);
+}
+
+const char* CCoopMusicController::GetMoodName(EMood mood)
+{
+	if (mood < 0 || mood >= eMood_Count)
+		return "none";
+
+	return g_moodTable[mood].sName;
+}
+
+// Summary:
+//	Mood for an alertness value, from the table thresholds.
+CCoopMusicController::EMood CCoopMusicController::SelectMood(float fIntensity)
+{
+	for (int i = 0; i < eMood_Count - 1; ++i)
+	{
+		if (fIntensity < g_moodTable[i].fMaxIntensity)
+			return g_moodTable[i].mood;
+	}
+
+	return g_moodTable[eMood_Count - 1].mood;
+}
+
+// Summary:
+//	Advances the decision by fFrameTime with this tick's aggregate alertness.
+//	Short peaks between two decisions are kept so they still raise the mood.
+CCoopMusicController::EMood CCoopMusicController::Step(SState& state, float fFrameTime, float fAlertness)
+{
+	state.fPeakIntensity = max(state.fPeakIntensity, fAlertness);
+	state.fDelay += fFrameTime;
+
+	if (state.fDelay < DECISION_INTERVAL)
+		return eMood_None;
+
+	const float fIntensity = state.bForced ? state.fForcedIntensity : state.fPeakIntensity;
+
+	state.fDelay = 0.f;
+	state.fPeakIntensity = 0.f;
+	state.mood = SelectMood(fIntensity);
+
+	return state.mood;
+}
+
+float CCoopMusicController::CombineAlertness(float fLocal, float fOthers, float fTeamWeight)
+{
+	return max(fLocal, fOthers * fTeamWeight);
+}
+
+// Summary:
+//	Maps the table entries onto the moods of the current theme. A mood the
+//	theme lacks falls back to the closest one it has, calmer moods first.
+void CCoopMusicController::ResolveMoods(const char* sTheme)
+{
+	m_sTheme = sTheme;
+
+	bool available[eMood_Count];
+	int nAvailable = 0;
+
+	for (int i = 0; i < eMood_Count; ++i)
+		available[i] = false;
+
+	if (IStringItVec* pMoods = gEnv->pMusicSystem->GetMoods(sTheme))
+	{
+		pMoods->AddRef();
+		for (pMoods->MoveFirst(); !pMoods->IsEnd(); )
+		{
+			const char* sMood = pMoods->Next();
+			for (int i = 0; i < eMood_Count; ++i)
+			{
+				if (!available[i] && sMood && stricmp(sMood, g_moodTable[i].sName) == 0)
+				{
+					available[i] = true;
+					++nAvailable;
+				}
+			}
+		}
+		pMoods->Release();
+	}
+
+	for (int i = 0; i < eMood_Count; ++i)
+	{
+		// nothing known about the theme, use the names as they are
+		if (!nAvailable || available[i])
+		{
+			m_moodNames[i] = g_moodTable[i].sName;
+			continue;
+		}
+
+		m_moodNames[i].clear();
+		for (int nDist = 1; nDist < eMood_Count && m_moodNames[i].empty(); ++nDist)
+		{
+			if (i - nDist >= 0 && available[i - nDist])
+				m_moodNames[i] = g_moodTable[i - nDist].sName;
+			else if (i + nDist < eMood_Count && available[i + nDist])
+				m_moodNames[i] = g_moodTable[i + nDist].sName;
+		}
+	}
+
+	if (sDebugMusic)
+	{
+		for (int i = 0; i < eMood_Count; ++i)
+			CryLogAlways("[CCoopMusicController] Theme '%s': %s -> %s", sTheme, g_moodTable[i].sName, m_moodNames[i].c_str());
+	}
+}
+
+// Summary:
+//	Local player alertness combined with the weighted alertness of the others.
+//	The server sends every player's detection value to all clients.
+float CCoopMusicController::GetAggregateAlertness() const
+{
+	IActorSystem* pActorSystem = g_pGame->GetIGameFramework()->GetIActorSystem();
+	const EntityId localId = g_pGame->GetIGameFramework()->GetClientActorId();
+
+	float fLocal = 0.f;
+	float fOthers = 0.f;
+
+	for (std::vector<EntityId>::const_iterator it = m_players.begin(); it != m_players.end(); ++it)
+	{
+		CCoopPlayer* pPlayer = static_cast<CCoopPlayer*>(pActorSystem->GetActor(*it));
+		if (!pPlayer || pPlayer->GetHealth() <= 0)
+			continue;
+
+		if (*it == localId)
+			fLocal = pPlayer->GetDetectionValue();
+		else
+			fOthers = max(fOthers, pPlayer->GetDetectionValue());
+	}
+
+	return CombineAlertness(fLocal, fOthers, sTeamWeight);
+}
+
+namespace
+{
+	struct SMusicTestCase
+	{
+		const char* sName;
+		float fDuration;
+		// alertness at time t
+		float (*pCurve)(float t);
+		// forced intensity, negative when not forced
+		float fForced;
+		CCoopMusicController::EMood expected[8];
+	};
+
+	float CurveCalm(float t) { return 0.f; }
+	float CurveRamp(float t) { return t / 40.f; }
+	float CurveRiseAndDecay(float t) { return max(0.f, t < 40.f ? t / 40.f : (80.f - t) / 40.f); }
+	// brief burst of gunfire between two decisions
+	float CurveSpike(float t) { return (t > 4.f && t < 4.2f) ? 0.8f : 0.f; }
+
+	const CCoopMusicController::EMood Inc = CCoopMusicController::eMood_Incidental;
+	const CCoopMusicController::EMood Amb = CCoopMusicController::eMood_Ambient;
+	const CCoopMusicController::EMood Mid = CCoopMusicController::eMood_Middle;
+	const CCoopMusicController::EMood Act = CCoopMusicController::eMood_Action;
+	const CCoopMusicController::EMood End = CCoopMusicController::eMood_None;
+
+	const SMusicTestCase g_musicTestCases[] =
+	{
+		{ "calm",				20.f,	CurveCalm,			-1.f,	{ Inc, End } },
+		{ "ramp",				30.f,	CurveRamp,			-1.f,	{ Inc, Amb, Mid, Act, End } },
+		{ "rise and decay",		90.f,	CurveRiseAndDecay,	-1.f,	{ Inc, Amb, Mid, Act, Mid, Amb, Inc, End } },
+		{ "spike",				12.f,	CurveSpike,			-1.f,	{ Inc, Act, Inc, End } },
+		{ "forced",				10.f,	CurveCalm,			0.5f,	{ Mid, End } },
+	};
+}
+
+// Summary:
+//	Feeds synthetic alertness curves through Step at a fixed 30 fps and
+//	checks the sequence of mood transitions. Deterministic, no music system needed.
+bool CCoopMusicController::SelfTest()
+{
+	const float fFrameTime = 1.f / 30.f;
+	int nFailed = 0;
+
+	// team weighting: a fully alert teammate alone should not start the action music
+	if (SelectMood(CombineAlertness(0.f, 1.f, 0.5f)) != eMood_Middle || SelectMood(CombineAlertness(0.7f, 0.2f, 0.5f)) != eMood_Action)
+	{
+		CryLogAlways("[CCoopMusicController] Self test 'team weight' FAILED");
+		++nFailed;
+	}
+
+	for (int nCase = 0; nCase < (int)(sizeof(g_musicTestCases) / sizeof(g_musicTestCases[0])); ++nCase)
+	{
+		const SMusicTestCase& test = g_musicTestCases[nCase];
+
+		SState state;
+		if (test.fForced >= 0.f)
+		{
+			state.bForced = true;
+			state.fForcedIntensity = test.fForced;
+			state.fDelay = DECISION_INTERVAL;
+		}
+
+		int nTransitions = 0;
+		bool bPassed = true;
+
+		for (float t = 0.f; t < test.fDuration; t += fFrameTime)
+		{
+			const EMood previous = state.mood;
+			const EMood mood = Step(state, fFrameTime, test.pCurve(t));
+			if (mood == eMood_None || mood == previous)
+				continue;
+
+			if (nTransitions == 8 || test.expected[nTransitions] != mood)
+				bPassed = false;
+
+			if (sDebugMusic)
+				CryLogAlways("[CCoopMusicController]   %.2fs: %s -> %s", t, GetMoodName(previous), GetMoodName(mood));
+
+			++nTransitions;
+		}
+
+		if (nTransitions < 8 && test.expected[nTransitions] != eMood_None)
+			bPassed = false;
+
+		CryLogAlways("[CCoopMusicController] Self test '%s': %d transitions, %s", test.sName, nTransitions, bPassed ? "passed" : "FAILED");
+
+		if (!bPassed)
+			++nFailed;
+	}
+
+	return nFailed == 0;
+}
+
+void CCoopMusicController::CmdSelfTest(IConsoleCmdArgs* pArgs)
+{
+	if (!SelfTest())
+		GameWarning("[CCoopMusicController] Music mood self test failed");
+}
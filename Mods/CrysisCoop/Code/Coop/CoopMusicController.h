@@ -0,0 +1,99 @@
+#ifndef _CoopMusicController_H_
+#define _CoopMusicController_H_
+
+struct IConsoleCmdArgs;
+
+// Summary:
+//	Picks the music mood on clients from the alertness of all coop players.
+//	The moods are kept in an enum table that is resolved once per theme
+//	against the moods the music system actually has, so the decision itself
+//	only compares enums. Owned and updated by CCoopSystem.
+class CCoopMusicController
+{
+public:
+	enum EMood
+	{
+		eMood_None = -1,
+		eMood_Incidental = 0,
+		eMood_Ambient,
+		eMood_Middle,
+		eMood_Action,
+		eMood_Count
+	};
+
+	// Summary:
+	//	Decision state, kept apart from the music system so the mood
+	//	selection can be stepped with synthetic input (see SelfTest).
+	struct SState
+	{
+		SState() : fDelay(0.f), fPeakIntensity(0.f), fForcedIntensity(0.f), bForced(false), mood(eMood_None) {}
+
+		float fDelay;
+		// highest aggregate alertness since the last decision
+		float fPeakIntensity;
+		float fForcedIntensity;
+		bool bForced;
+		EMood mood;
+	};
+
+	CCoopMusicController();
+
+	void Reset();
+
+	// Summary:
+	//	Aggregates the alertness of the players and switches the mood when due (client).
+	void Update(float fFrameTime);
+
+	// Summary:
+	//	Overrides the alertness with a fixed intensity until called with bForce false.
+	//	The next update decides immediately.
+	void ForceIntensity(float fIntensity, bool bForce);
+
+	// Summary:
+	//	Players whose alertness is aggregated, registered by CCoopPlayer.
+	void RegisterPlayer(EntityId playerId);
+	void UnregisterPlayer(EntityId playerId);
+
+	EMood GetMood() const { return m_state.mood; }
+	static const char* GetMoodName(EMood mood);
+
+	// Summary:
+	//	Mood for an alertness value, from the table thresholds.
+	static EMood SelectMood(float fIntensity);
+
+	// Summary:
+	//	Advances the decision by fFrameTime with this tick's aggregate alertness.
+	//	Returns the selected mood when a decision is due, eMood_None otherwise.
+	static EMood Step(SState& state, float fFrameTime, float fAlertness);
+
+	// Summary:
+	//	Alertness used for the music: the local player's own value, or the
+	//	highest value of the other players scaled by fTeamWeight if that is higher.
+	static float CombineAlertness(float fLocal, float fOthers, float fTeamWeight);
+
+	// Summary:
+	//	Feeds synthetic alertness curves through Step and checks the resulting
+	//	mood transitions. Bound to coop_musicSelfTest.
+	static bool SelfTest();
+	static void CmdSelfTest(IConsoleCmdArgs* pArgs);
+
+	static float sTeamWeight;
+	static int sDebugMusic;
+
+private:
+	// Summary:
+	//	Maps the table entries onto the moods of the current theme.
+	void ResolveMoods(const char* sTheme);
+
+	// Summary:
+	//	Local player alertness combined with the weighted alertness of the others.
+	float GetAggregateAlertness() const;
+
+	SState	m_state;
+	std::vector<EntityId>	m_players;
+	string	m_sTheme;
+	// table entry -> mood name of the current theme
+	string	m_moodNames[eMood_Count];
+};
+
+#endif // _CoopMusicController_H_
@@ -0,0 +1,371 @@
+#include <StdAfx.h>
+#include "CoopPerceptionSummary.h"
+
+#include <IActorSystem.h>
+#include <IConsole.h>
+
+#include "Game.h"
+#include "Coop/CoopSystem.h"
+#include "Coop/Actors/CoopPlayer.h"
+
+float CCoopPerceptionSummary::sReplicationThreshold = 0.02f;
+int CCoopPerceptionSummary::sDebugPerception = 0;
+
+namespace
+{
+	// Seconds after which an unchanged value is sent again.
+	const float RESEND_INTERVAL = 2.0f;
+
+	// threat of the attention target -> threat level, indexed by EAITargetThreat
+	const float g_threatLevels[AITHREAT_LAST] =
+	{
+		0.f,	// AITHREAT_NONE
+		0.15f,	// AITHREAT_INTERESTING
+		0.5f,	// AITHREAT_THREATENING
+		1.f,	// AITHREAT_AGGRESSIVE
+	};
+
+	// how the target is perceived -> exposure level, indexed by EAITargetType
+	const float g_exposureLevels[AITARGET_LAST] =
+	{
+		0.f,	// AITARGET_NONE
+		0.1f,	// AITARGET_SOUND
+		0.3f,	// AITARGET_MEMORY
+		0.6f,	// AITARGET_VISUAL
+		0.f,	// AITARGET_ENEMY
+		0.f,	// AITARGET_FRIENDLY
+		0.f,	// AITARGET_BEACON
+		0.f,	// AITARGET_GRENADE
+		0.f,	// AITARGET_RPG
+	};
+}
+
+CCoopPerceptionSummary::CCoopPerceptionSummary()
+	: m_nLastAITick(-1)
+{
+}
+
+void CCoopPerceptionSummary::Reset()
+{
+	for (TPlayerMap::iterator it = m_players.begin(); it != m_players.end(); ++it)
+		it->second = SPlayerPerception();
+
+	m_observations.clear();
+	m_nLastAITick = -1;
+}
+
+// Summary:
+//	Rebuilds the summary when the AI system ticked and replicates changed values (server).
+void CCoopPerceptionSummary::Update(float fFrameTime)
+{
+	IAISystem* pAISystem = gEnv->pAISystem;
+	if (!gEnv->bServer || !pAISystem || m_players.empty())
+		return;
+
+	const int nAITick = pAISystem->GetAITickCount();
+	const bool bTicked = nAITick != m_nLastAITick;
+
+	if (bTicked)
+	{
+		FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+		m_nLastAITick = nAITick;
+
+		GatherObservations(m_observations);
+		Summarize(m_observations, m_players);
+
+		// the AI system keeps its own accumulated levels for the local player, use them too
+		const EntityId localId = g_pGame->GetIGameFramework()->GetClientActorId();
+		TPlayerMap::iterator it = m_players.find(localId);
+		if (it != m_players.end())
+		{
+			SAIDetectionLevels levels;
+			pAISystem->GetDetectionLevels(0, levels);
+			it->second.levels.Append(levels);
+			it->second.fValue = GetDetectionValue(it->second.levels);
+		}
+	}
+
+	PublishValues(fFrameTime, bTicked);
+}
+
+void CCoopPerceptionSummary::RegisterPlayer(EntityId playerId)
+{
+	m_players.insert(TPlayerMap::value_type(playerId, SPlayerPerception()));
+}
+
+void CCoopPerceptionSummary::UnregisterPlayer(EntityId playerId)
+{
+	m_players.erase(playerId);
+}
+
+float CCoopPerceptionSummary::GetDetectionValue(EntityId playerId) const
+{
+	TPlayerMap::const_iterator it = m_players.find(playerId);
+	return it != m_players.end() ? it->second.fValue : 0.f;
+}
+
+// Summary:
+//	Folds the observations into the levels of the registered players.
+void CCoopPerceptionSummary::Summarize(const TObservations& observations, TPlayerMap& players)
+{
+	for (TPlayerMap::iterator it = players.begin(); it != players.end(); ++it)
+		it->second.levels.Reset();
+
+	SAIDetectionLevels levels;
+	for (TObservations::const_iterator it = observations.begin(); it != observations.end(); ++it)
+	{
+		TPlayerMap::iterator player = players.find(it->targetId);
+		if (player == players.end())
+			continue;
+
+		GetObservationLevels(*it, levels);
+		player->second.levels.Append(levels);
+	}
+
+	for (TPlayerMap::iterator it = players.begin(); it != players.end(); ++it)
+		it->second.fValue = GetDetectionValue(it->second.levels);
+}
+
+void CCoopPerceptionSummary::GetObservationLevels(const SObservation& observation, SAIDetectionLevels& levels)
+{
+	levels.Reset();
+
+	const float fThreat = (observation.threat >= 0 && observation.threat < AITHREAT_LAST) ? g_threatLevels[observation.threat] : 0.f;
+	const float fExposure = (observation.type >= 0 && observation.type < AITARGET_LAST) ? g_exposureLevels[observation.type] : 0.f;
+
+	if (observation.bVehicle)
+	{
+		levels.vehicleThreat = fThreat;
+		levels.vehicleExposure = fExposure;
+	}
+	else
+	{
+		levels.puppetThreat = fThreat;
+		levels.puppetExposure = fExposure;
+	}
+}
+
+float CCoopPerceptionSummary::GetDetectionValue(const SAIDetectionLevels& levels)
+{
+	return max(max(levels.puppetExposure, levels.puppetThreat), max(levels.vehicleExposure, levels.vehicleThreat));
+}
+
+bool CCoopPerceptionSummary::NeedsReplication(const SPlayerPerception& perception, float fThreshold)
+{
+	return fabsf(perception.fValue - perception.fLastSent) > fThreshold || perception.fSinceSent > RESEND_INTERVAL;
+}
+
+// Summary:
+//	Reads the attention targets of all enabled puppets and vehicles.
+void CCoopPerceptionSummary::GatherObservations(TObservations& observations) const
+{
+	observations.resize(0);
+
+	GatherObservations(AIOBJECT_PUPPET, false, observations);
+	GatherObservations(AIOBJECT_VEHICLE, true, observations);
+}
+
+void CCoopPerceptionSummary::GatherObservations(short nType, bool bVehicle, TObservations& observations) const
+{
+	AutoAIObjectIter it(gEnv->pAISystem->GetFirstAIObject(IAISystem::OBJFILTER_TYPE, nType));
+	for (; it->GetObject(); it->Next())
+	{
+		IAIObject* pAI = it->GetObject();
+		if (!pAI->IsEnabled())
+			continue;
+
+		IPipeUser* pPipeUser = pAI->CastToIPipeUser();
+		if (!pPipeUser)
+			continue;
+
+		// sound and memory targets of a player are dummies without an entity, those stay unattributed
+		IAIObject* pTarget = pPipeUser->GetAttentionTarget();
+		if (!pTarget || !pTarget->GetEntityID())
+			continue;
+
+		observations.push_back(SObservation(pTarget->GetEntityID(), pPipeUser->GetAttentionTargetThreat(), pPipeUser->GetAttentionTargetType(), bVehicle));
+	}
+}
+
+// Summary:
+//	Hands the values to the players and replicates the changed ones.
+void CCoopPerceptionSummary::PublishValues(float fFrameTime, bool bTicked)
+{
+	IActorSystem* pActorSystem = g_pGame->GetIGameFramework()->GetIActorSystem();
+
+	for (TPlayerMap::iterator it = m_players.begin(); it != m_players.end(); ++it)
+	{
+		SPlayerPerception& perception = it->second;
+		perception.fSinceSent += fFrameTime;
+
+		if (!bTicked && perception.fSinceSent <= RESEND_INTERVAL)
+			continue;
+
+		CCoopPlayer* pPlayer = static_cast<CCoopPlayer*>(pActorSystem->GetActor(it->first));
+		if (!pPlayer)
+			continue;
+
+		const bool bReplicate = NeedsReplication(perception, sReplicationThreshold);
+		if (bReplicate)
+		{
+			perception.fLastSent = perception.fValue;
+			perception.fSinceSent = 0.f;
+		}
+
+		pPlayer->SetDetectionValue(perception.fValue, bReplicate);
+
+		if (sDebugPerception && bTicked)
+		{
+			const SAIDetectionLevels& levels = perception.levels;
+			CryLogAlways("[CCoopPerceptionSummary] %s: %.2f (puppet %.2f/%.2f, vehicle %.2f/%.2f)%s", pPlayer->GetEntity()->GetName(), perception.fValue,
+				levels.puppetExposure, levels.puppetThreat, levels.vehicleExposure, levels.vehicleThreat, bReplicate ? " sent" : "");
+		}
+	}
+}
+
+// Summary:
+//	Runs scripted observations of a mock AI population through the summary
+//	and the replication rule. No AI system is needed.
+bool CCoopPerceptionSummary::SelfTest()
+{
+	const EntityId playerA = 1, playerB = 2, stranger = 3;
+	int nFailed = 0;
+
+	TPlayerMap players;
+	players.insert(TPlayerMap::value_type(playerA, SPlayerPerception()));
+	players.insert(TPlayerMap::value_type(playerB, SPlayerPerception()));
+
+	// tick 1: a grunt fights A, a vehicle eyes A, another grunt heard B, one targets a non player
+	TObservations observations;
+	observations.push_back(SObservation(playerA, AITHREAT_AGGRESSIVE, AITARGET_VISUAL, false));
+	observations.push_back(SObservation(playerA, AITHREAT_THREATENING, AITARGET_VISUAL, true));
+	observations.push_back(SObservation(playerB, AITHREAT_INTERESTING, AITARGET_SOUND, false));
+	observations.push_back(SObservation(stranger, AITHREAT_AGGRESSIVE, AITARGET_VISUAL, false));
+	Summarize(observations, players);
+
+	const SPlayerPerception& a = players[playerA];
+	const SPlayerPerception& b = players[playerB];
+	const bool bTick1 = a.fValue == 1.f && a.levels.vehicleThreat == 0.5f && a.levels.vehicleExposure == 0.6f
+		&& b.fValue == 0.15f && b.levels.puppetExposure == 0.1f && b.levels.vehicleThreat == 0.f
+		&& players.find(stranger) == players.end();
+
+	CryLogAlways("[CCoopPerceptionSummary] Self test 'summarize': %s", bTick1 ? "passed" : "FAILED");
+	if (!bTick1)
+		++nFailed;
+
+	// tick 2: everybody lost interest, nothing may stick from the previous tick
+	observations.clear();
+	Summarize(observations, players);
+
+	const bool bTick2 = players[playerA].fValue == 0.f && players[playerB].fValue == 0.f;
+	CryLogAlways("[CCoopPerceptionSummary] Self test 'reset between ticks': %s", bTick2 ? "passed" : "FAILED");
+	if (!bTick2)
+		++nFailed;
+
+	// replication: a slowly rising value at 10 AI ticks per second only goes out on steps over the threshold
+	SPlayerPerception perception;
+	int nSent = 0;
+	for (int nTick = 0; nTick < 10; ++nTick)
+	{
+		perception.fValue = nTick * 0.01f;
+		perception.fSinceSent += 0.1f;
+		if (NeedsReplication(perception, 0.025f))
+		{
+			perception.fLastSent = perception.fValue;
+			perception.fSinceSent = 0.f;
+			++nSent;
+		}
+	}
+
+	perception.fSinceSent = RESEND_INTERVAL + 0.1f;
+	const bool bReplication = nSent == 3 && NeedsReplication(perception, 0.025f);
+	CryLogAlways("[CCoopPerceptionSummary] Self test 'replication': %d sends, %s", nSent, bReplication ? "passed" : "FAILED");
+	if (!bReplication)
+		++nFailed;
+
+	return nFailed == 0;
+}
+
+// Summary:
+//	Gathers the observations of the AI of the loaded level and checks them
+//	against the puppets and vehicles found through the entity system.
+bool CCoopPerceptionSummary::LevelSelfTest() const
+{
+	IAISystem* pAISystem = gEnv->pAISystem;
+	if (!pAISystem || !g_pGame->GetIGameFramework()->GetILevelSystem()->GetCurrentLevel())
+	{
+		CryLogAlways("[CCoopPerceptionSummary] Self test 'level': skipped, load a level with AI first");
+		return true;
+	}
+
+	TObservations observations;
+	GatherObservations(observations);
+
+	// the same agents reached through their entities instead of the AI object iterator
+	typedef std::map<EntityId, int> TTargetCounts;
+	TTargetCounts expected, gathered;
+	TObservations walked;
+	int nAgents = 0;
+
+	IEntityItPtr pIt = gEnv->pEntitySystem->GetEntityIterator();
+	while (!pIt->IsEnd())
+	{
+		IEntity* pEntity = pIt->Next();
+		IAIObject* pAI = pEntity ? pEntity->GetAI() : 0;
+		if (!pAI || (pAI->GetAIType() != AIOBJECT_PUPPET && pAI->GetAIType() != AIOBJECT_VEHICLE))
+			continue;
+
+		++nAgents;
+
+		IPipeUser* pPipeUser = pAI->CastToIPipeUser();
+		IAIObject* pTarget = pPipeUser ? pPipeUser->GetAttentionTarget() : 0;
+		if (!pAI->IsEnabled() || !pTarget || !pTarget->GetEntityID())
+			continue;
+
+		++expected[pTarget->GetEntityID()];
+		walked.push_back(SObservation(pTarget->GetEntityID(), pPipeUser->GetAttentionTargetThreat(), pPipeUser->GetAttentionTargetType(), pAI->GetAIType() == AIOBJECT_VEHICLE));
+	}
+
+	if (!nAgents)
+	{
+		CryLogAlways("[CCoopPerceptionSummary] Self test 'level': skipped, the level has no puppets or vehicles");
+		return true;
+	}
+
+	int nMissingTargets = 0;
+	for (TObservations::const_iterator it = observations.begin(); it != observations.end(); ++it)
+	{
+		++gathered[it->targetId];
+		if (!gEnv->pEntitySystem->GetEntity(it->targetId))
+			++nMissingTargets;
+	}
+
+	// both sets of observations have to rate the registered players the same
+	TPlayerMap fromGathered = m_players, fromWalked = m_players;
+	Summarize(observations, fromGathered);
+	Summarize(walked, fromWalked);
+
+	int nPlayerMismatches = 0;
+	for (TPlayerMap::const_iterator it = fromGathered.begin(); it != fromGathered.end(); ++it)
+	{
+		TPlayerMap::const_iterator walkedIt = fromWalked.find(it->first);
+		if (walkedIt == fromWalked.end() || fabsf(walkedIt->second.fValue - it->second.fValue) > 0.0001f)
+			++nPlayerMismatches;
+	}
+
+	const bool bPassed = gathered == expected && !nMissingTargets && !nPlayerMismatches;
+	CryLogAlways("[CCoopPerceptionSummary] Self test 'level': %d agents, %d observations (%d expected), %d of %d players differ, %s",
+		nAgents, (int)observations.size(), (int)walked.size(), nPlayerMismatches, (int)m_players.size(), bPassed ? "passed" : "FAILED");
+
+	return bPassed;
+}
+
+void CCoopPerceptionSummary::CmdSelfTest(IConsoleCmdArgs* pArgs)
+{
+	const bool bScripted = SelfTest();
+	const bool bLevel = CCoopSystem::GetInstance()->GetPerceptionSummary().LevelSelfTest();
+
+	if (!bScripted || !bLevel)
+		GameWarning("[CCoopPerceptionSummary] Perception summary self test failed");
+}
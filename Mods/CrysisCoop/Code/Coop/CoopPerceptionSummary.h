@@ -0,0 +1,106 @@
+#ifndef _CoopPerceptionSummary_H_
+#define _CoopPerceptionSummary_H_
+
+#include <IAISystem.h>
+#include <IAgent.h>
+
+struct IConsoleCmdArgs;
+
+// Summary:
+//	Server side summary of how much the AI perceives each coop player.
+//	Once per AI tick the attention targets of all enabled puppets and vehicles
+//	are read through the public IAIObject/IPipeUser interfaces and folded
+//	into per player detection levels. The resulting detection value is
+//	pushed to CCoopPlayer, which replicates it through ClUpdateAwareness
+//	when it changed by more than coop_perceptionThreshold.
+//	Owned and updated by CCoopSystem.
+class CCoopPerceptionSummary
+{
+public:
+	// Summary:
+	//	What one AI agent currently perceives of its attention target.
+	struct SObservation
+	{
+		SObservation() : targetId(0), threat(AITHREAT_NONE), type(AITARGET_NONE), bVehicle(false) {}
+		SObservation(EntityId _targetId, EAITargetThreat _threat, EAITargetType _type, bool _bVehicle)
+			: targetId(_targetId), threat(_threat), type(_type), bVehicle(_bVehicle) {}
+
+		EntityId targetId;
+		EAITargetThreat threat;
+		EAITargetType type;
+		bool bVehicle;
+	};
+
+	struct SPlayerPerception
+	{
+		SPlayerPerception() : fValue(0.f), fLastSent(0.f), fSinceSent(0.f) {}
+
+		SAIDetectionLevels levels;
+		float fValue;
+		// value and time of the last replication
+		float fLastSent;
+		float fSinceSent;
+	};
+
+	typedef std::vector<SObservation> TObservations;
+	typedef stl::hash_map<EntityId, SPlayerPerception, stl::hash_uint32> TPlayerMap;
+
+	CCoopPerceptionSummary();
+
+	void Reset();
+
+	// Summary:
+	//	Rebuilds the summary when the AI system ticked and replicates changed values (server).
+	void Update(float fFrameTime);
+
+	void RegisterPlayer(EntityId playerId);
+	void UnregisterPlayer(EntityId playerId);
+
+	float GetDetectionValue(EntityId playerId) const;
+
+	// Summary:
+	//	Folds the observations into the levels of the registered players.
+	//	Observations of anything else than a registered player are ignored.
+	static void Summarize(const TObservations& observations, TPlayerMap& players);
+
+	// Summary:
+	//	Detection levels one observation contributes to its target.
+	static void GetObservationLevels(const SObservation& observation, SAIDetectionLevels& levels);
+	static float GetDetectionValue(const SAIDetectionLevels& levels);
+
+	// Summary:
+	//	True if the value moved far enough from the last replicated one, or
+	//	was not sent for a while (clients that joined since the last change).
+	static bool NeedsReplication(const SPlayerPerception& perception, float fThreshold);
+
+	// Summary:
+	//	Runs scripted observations of a mock AI population through the summary
+	//	and the replication rule. Bound to coop_perceptionSelfTest.
+	static bool SelfTest();
+	static void CmdSelfTest(IConsoleCmdArgs* pArgs);
+
+	// Summary:
+	//	Gathers the observations of the AI of the loaded level and checks them
+	//	against the puppets and vehicles found through the entity system.
+	//	Skipped without a level with AI. Run by coop_perceptionSelfTest too.
+	bool LevelSelfTest() const;
+
+	static float sReplicationThreshold;
+	static int sDebugPerception;
+
+private:
+	// Summary:
+	//	Reads the attention targets of all enabled puppets and vehicles.
+	void GatherObservations(TObservations& observations) const;
+	void GatherObservations(short nType, bool bVehicle, TObservations& observations) const;
+
+	// Summary:
+	//	Hands the values to the players and replicates the changed ones.
+	void PublishValues(float fFrameTime, bool bTicked);
+
+	TPlayerMap		m_players;
+	TObservations	m_observations;
+	int				m_nLastAITick;
+};
+
+#endif // _CoopPerceptionSummary_H_
@@ -0,0 +1,287 @@
+#include <StdAfx.h>
+#include "CoopStringTable.h"
+
+#include <IMovieSystem.h>
+#include <IDialogSystem.h>
+
+#include "CoopSystem.h"
+#include "DialogSystem/DialogSystem.h"
+#include "Game.h"
+#include "GameRules.h"
+
+int CCoopStringTable::sDebugStringTable = 0;
+
+CCoopStringTable::CCoopStringTable() :
+	m_nEncoded(0),
+	m_nDefined(0),
+	m_nTextBits(0),
+	m_nNetBits(0)
+{
+}
+
+// Summary:
+//	Collects the sequence names and dialog script ids of the loaded level (server).
+void CCoopStringTable::Build()
+{
+	Clear();
+
+	std::vector<string> strings;
+
+	if (gEnv->pMovieSystem)
+	{
+		ISequenceIt* pSeqIt = gEnv->pMovieSystem->GetSequences();
+		for (IAnimSequence* pSeq = pSeqIt->first(); pSeq; pSeq = pSeqIt->next())
+			strings.push_back(pSeq->GetName());
+		pSeqIt->Release();
+	}
+
+	if (CDialogSystem* pDialogSystem = CCoopSystem::GetInstance()->GetDialogSystem())
+	{
+		IDialogScriptIteratorPtr pIter = pDialogSystem->CreateScriptIterator();
+		IDialogScriptIterator::SDialogScript script;
+		while (pIter->Next(script))
+			strings.push_back(script.id);
+	}
+
+	std::sort(strings.begin(), strings.end());
+	strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+
+	for (std::vector<string>::const_iterator it = strings.begin(); it != strings.end(); ++it)
+	{
+		if (Add(*it) == INVALID_INDEX)
+		{
+			GameWarning("[CCoopStringTable] Table full, %d strings left out", int(strings.end() - it));
+			break;
+		}
+	}
+
+	CryLogAlways("[CCoopStringTable] Built table with %d strings", GetCount());
+}
+
+void CCoopStringTable::Clear()
+{
+	m_strings.clear();
+	m_indices.clear();
+	m_undefined.clear();
+
+	m_nEncoded = 0;
+	m_nDefined = 0;
+	m_nTextBits = 0;
+	m_nNetBits = 0;
+}
+
+// Summary:
+//	Server side: turns a string into its compact network form, adding it
+//	to the table on first use.
+CCoopStringTable::SNetString CCoopStringTable::Encode(const char* sText)
+{
+	SNetString netString;
+
+	TIndexMap::const_iterator it = m_indices.find(CONST_TEMP_STRING(sText));
+	if (it != m_indices.end())
+	{
+		netString.nIndex = it->second;
+	}
+	else
+	{
+		// clients that connect from now on get it with the table, the others need it inline
+		netString.nIndex = Add(sText);
+		if (netString.nIndex != INVALID_INDEX && !m_channels.empty())
+			m_undefined.insert(TUndefinedMap::value_type(netString.nIndex, m_channels));
+	}
+
+	// keep defining it inline until every channel acknowledged, a client may have missed an earlier RMI
+	if (netString.nIndex == INVALID_INDEX || m_undefined.find(netString.nIndex) != m_undefined.end())
+	{
+		netString.bDefine = netString.nIndex != INVALID_INDEX;
+		netString.sText = sText;
+	}
+
+	++m_nEncoded;
+	if (netString.bDefine)
+		++m_nDefined;
+	m_nTextBits += 8 * ((int)strlen(sText) + 1);
+	m_nNetBits += netString.GetBits();
+
+	if (sDebugStringTable)
+		CryLogAlways("[CCoopStringTable] '%s' -> %d%s", sText, netString.nIndex == INVALID_INDEX ? -1 : (int)netString.nIndex, netString.sText.empty() ? "" : " (text sent)");
+
+	return netString;
+}
+
+// Summary:
+//	Like Encode, but for catch-up RMIs to a single joining channel: never adds
+//	to the table, and always sends the text along with the index, since the
+//	table chunks go out through the game rules and aren't ordered with them.
+CCoopStringTable::SNetString CCoopStringTable::Lookup(const char* sText) const
+{
+	SNetString netString;
+
+	TIndexMap::const_iterator it = m_indices.find(CONST_TEMP_STRING(sText));
+	if (it != m_indices.end())
+	{
+		netString.nIndex = it->second;
+		netString.bDefine = true;
+	}
+	netString.sText = sText;
+
+	return netString;
+}
+
+// Summary:
+//	Client side: resolves a received string, storing definitions.
+const char* CCoopStringTable::Decode(const SNetString& netString)
+{
+	if (netString.nIndex == INVALID_INDEX)
+		return netString.sText.c_str();
+
+	if (netString.bDefine)
+	{
+		Set(netString.nIndex, netString.sText);
+
+		if (!gEnv->bServer)
+		{
+			if (CGameRules* pGameRules = g_pGame->GetGameRules())
+				pGameRules->GetGameObject()->InvokeRMI(CGameRules::SvCoopStringTableAck(), SAckParams(netString.nIndex), eRMI_ToServer);
+		}
+	}
+
+	if (netString.nIndex >= m_strings.size())
+	{
+		GameWarning("[CCoopStringTable] Unknown string index %d", (int)netString.nIndex);
+		return "";
+	}
+
+	return m_strings[netString.nIndex].c_str();
+}
+
+// Summary:
+//	Fills the chunk starting at nFirst, returns false past the end of the table.
+bool CCoopStringTable::GetChunk(TIndex nFirst, SChunkParams& chunk) const
+{
+	if (nFirst >= m_strings.size())
+		return false;
+
+	const int nEnd = min((int)m_strings.size(), (int)nFirst + (int)CHUNK_SIZE);
+
+	chunk.nFirst = nFirst;
+	chunk.strings.assign(m_strings.begin() + nFirst, m_strings.begin() + nEnd);
+
+	return true;
+}
+
+void CCoopStringTable::SetChunk(const SChunkParams& chunk)
+{
+	for (int i = 0; i < (int)chunk.strings.size(); ++i)
+		Set(chunk.nFirst + i, chunk.strings[i]);
+
+	if (!gEnv->bServer && !chunk.strings.empty())
+	{
+		if (CGameRules* pGameRules = g_pGame->GetGameRules())
+			pGameRules->GetGameObject()->InvokeRMI(CGameRules::SvCoopStringTableAck(), SAckParams(chunk.nFirst, (uint8)chunk.strings.size()), eRMI_ToServer);
+	}
+
+	if (sDebugStringTable)
+		CryLogAlways("[CCoopStringTable] Received strings %d-%d", (int)chunk.nFirst, (int)chunk.nFirst + (int)chunk.strings.size() - 1);
+}
+
+void CCoopStringTable::AddChannel(int channelId)
+{
+	m_channels.insert(channelId);
+}
+
+void CCoopStringTable::RemoveChannel(int channelId)
+{
+	m_channels.erase(channelId);
+
+	for (TUndefinedMap::iterator it = m_undefined.begin(); it != m_undefined.end(); )
+	{
+		it->second.erase(channelId);
+		if (it->second.empty())
+			m_undefined.erase(it++);
+		else
+			++it;
+	}
+}
+
+void CCoopStringTable::Ack(TIndex nIndex, int nCount, int channelId)
+{
+	TUndefinedMap::iterator it = m_undefined.lower_bound(nIndex);
+	while (it != m_undefined.end() && (int)it->first < (int)nIndex + nCount)
+	{
+		it->second.erase(channelId);
+		if (it->second.empty())
+			m_undefined.erase(it++);
+		else
+			++it;
+	}
+
+	if (sDebugStringTable)
+		CryLogAlways("[CCoopStringTable] Channel %d acknowledged %d-%d", channelId, (int)nIndex, (int)nIndex + nCount - 1);
+}
+
+// Summary:
+//	Server side: the table is about to be sent to the channel, its strings are
+//	defined inline for that channel until it acknowledges their chunk.
+void CCoopStringTable::OnSendTable(int channelId)
+{
+	// the local client shares the server's table
+	if (m_channels.find(channelId) == m_channels.end())
+		return;
+
+	for (TIndex i = 0; i < (TIndex)m_strings.size(); ++i)
+		m_undefined[i].insert(channelId);
+}
+
+// Summary:
+//	Logs the bytes the encoded strings of this level took, against sending them as text.
+void CCoopStringTable::LogBandwidth() const
+{
+	// what channel setup sends once per client: per chunk the first index and the count
+	int nTableBits = 0;
+	for (std::vector<string>::const_iterator it = m_strings.begin(); it != m_strings.end(); ++it)
+		nTableBits += 8 * ((int)it->length() + 1);
+	nTableBits += (((int)m_strings.size() + CHUNK_SIZE - 1) / CHUNK_SIZE) * (16 + 8);
+
+	CryLogAlways("[CCoopStringTable] %d strings encoded this level, %d of them defined inline, %d still unacknowledged",
+		m_nEncoded, m_nDefined, (int)m_undefined.size());
+	CryLogAlways("[CCoopStringTable]   as text: %d bytes, as table references: %d bytes (%.1f%%) per client",
+		(m_nTextBits + 7) / 8, (m_nNetBits + 7) / 8, m_nTextBits ? 100.f * m_nNetBits / m_nTextBits : 0.f);
+	CryLogAlways("[CCoopStringTable]   table transfer on channel setup: %d strings, %d bytes per client",
+		GetCount(), (nTableBits + 7) / 8);
+}
+
+void CCoopStringTable::CmdBandwidth(IConsoleCmdArgs* pArgs)
+{
+	if (!gEnv->bServer)
+	{
+		GameWarning("[CCoopStringTable] coop_stringTableBandwidth only runs on the server");
+		return;
+	}
+
+	CCoopSystem::GetInstance()->GetStringTable().LogBandwidth();
+}
+
+CCoopStringTable::TIndex CCoopStringTable::Add(const string& sText)
+{
+	if (m_strings.size() >= INVALID_INDEX)
+		return INVALID_INDEX;
+
+	TIndex nIndex = (TIndex)m_strings.size();
+	m_strings.push_back(sText);
+	m_indices.insert(TIndexMap::value_type(sText, nIndex));
+
+	return nIndex;
+}
+
+void CCoopStringTable::Set(TIndex nIndex, const string& sText)
+{
+	if (nIndex == INVALID_INDEX)
+		return;
+
+	if (nIndex >= m_strings.size())
+		m_strings.resize(nIndex + 1);
+
+	m_strings[nIndex] = sText;
+	m_indices[sText] = nIndex;
+}
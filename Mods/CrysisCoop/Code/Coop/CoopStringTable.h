@@ -0,0 +1,166 @@
+#ifndef _CoopStringTable_H_
+#define _CoopStringTable_H_
+
+// Summary:
+//	Per-level table of the strings the coop synchronizers send to clients
+//	(sequence names, dialog script ids, overlay messages).
+//	The server builds it when the level has loaded and CGameRules sends it to
+//	each client during channel setup; the RMIs then only carry indices.
+//	Strings added later are sent as text along with their index until every
+//	remote channel has acknowledged them (CGameRules::SvCoopStringTableAck).
+//	The chunks aren't ordered with the synchronizer RMIs either, so the strings
+//	of the table are sent as text too until the channel acknowledged their chunk.
+class CCoopStringTable
+{
+public:
+	typedef uint16 TIndex;
+	static const TIndex INVALID_INDEX = 0xffff;
+
+	// Summary:
+	//	String as sent inside an RMI. Strings added to the table after a client
+	//	got it are sent together with their new index (bDefine) until acknowledged.
+	struct SNetString
+	{
+		SNetString() : nIndex(INVALID_INDEX), bDefine(false) {}
+
+		TIndex nIndex;
+		bool bDefine;
+		string sText;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("nIndex", nIndex, 'ui16');
+			if (nIndex != INVALID_INDEX)
+				ser.Value("bDefine", bDefine, 'bool');
+			if (nIndex == INVALID_INDEX || bDefine)
+				ser.Value("sText", sText);
+		}
+
+		// approximate size on the wire, strings counted with their terminator
+		int GetBits() const
+		{
+			int nBits = 16;
+			if (nIndex != INVALID_INDEX)
+				nBits += 1;
+			if (nIndex == INVALID_INDEX || bDefine)
+				nBits += 8 * ((int)sText.length() + 1);
+			return nBits;
+		}
+	};
+
+	// Summary:
+	//	Client to server: the definitions of nIndex .. nIndex+nCount-1 arrived,
+	//	inline or as a chunk of the table.
+	struct SAckParams
+	{
+		SAckParams() : nIndex(INVALID_INDEX), nCount(1) {}
+		SAckParams(TIndex nIndex, uint8 nCount = 1) : nIndex(nIndex), nCount(nCount) {}
+
+		TIndex nIndex;
+		uint8 nCount;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("nIndex", nIndex, 'ui16');
+			ser.Value("nCount", nCount, 'ui8');
+		}
+	};
+
+	// Summary:
+	//	Chunk of the table, sent by CGameRules::PostInitClient.
+	struct SChunkParams
+	{
+		SChunkParams() : nFirst(0) {}
+
+		TIndex nFirst;
+		std::vector<string> strings;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("nFirst", nFirst, 'ui16');
+
+			uint8 nCount = (uint8)strings.size();
+			ser.Value("nCount", nCount, 'ui8');
+			if (ser.IsReading())
+				strings.resize(nCount);
+
+			for (int i = 0; i < nCount; ++i)
+				ser.Value("s", strings[i]);
+		}
+	};
+
+	enum { CHUNK_SIZE = 32 };
+
+	CCoopStringTable();
+
+	// Summary:
+	//	Collects the sequence names and dialog script ids of the loaded level (server).
+	void Build();
+	void Clear();
+
+	// Summary:
+	//	Server side: turns a string into its compact network form, adding it
+	//	to the table on first use.
+	SNetString Encode(const char* sText);
+
+	// Summary:
+	//	Like Encode, but for catch-up RMIs to a single joining channel: never adds
+	//	to the table, and always sends the text along with the index, since the
+	//	table chunks go out through the game rules and aren't ordered with them.
+	SNetString Lookup(const char* sText) const;
+
+	// Summary:
+	//	Client side: resolves a received string, storing and acknowledging definitions.
+	const char* Decode(const SNetString& netString);
+
+	// Summary:
+	//	Server side: remote channels that have to acknowledge strings added
+	//	after the table was built. Channels persist across level changes.
+	void AddChannel(int channelId);
+	void RemoveChannel(int channelId);
+	void Ack(TIndex nIndex, int nCount, int channelId);
+
+	// Summary:
+	//	Server side: the table is about to be sent to the channel, its strings are
+	//	defined inline for that channel until it acknowledges their chunk.
+	void OnSendTable(int channelId);
+
+	// Summary:
+	//	Logs the bytes the encoded strings of this level took, against sending them as text.
+	void LogBandwidth() const;
+	static void CmdBandwidth(IConsoleCmdArgs* pArgs);
+
+	// Summary:
+	//	Fills the chunk starting at nFirst, returns false past the end of the table.
+	bool GetChunk(TIndex nFirst, SChunkParams& chunk) const;
+	// Summary:
+	//	Client side: stores a received chunk and acknowledges it.
+	void SetChunk(const SChunkParams& chunk);
+
+	int GetCount() const { return (int)m_strings.size(); }
+
+	static int sDebugStringTable;
+
+private:
+	TIndex Add(const string& sText);
+	void Set(TIndex nIndex, const string& sText);
+
+	typedef std::map<string, TIndex> TIndexMap;
+	typedef std::set<int> TChannelSet;
+	typedef std::map<TIndex, TChannelSet> TUndefinedMap;
+
+	std::vector<string>	m_strings;
+	TIndexMap			m_indices;
+	TChannelSet			m_channels;
+	// strings a channel may not know yet, and those channels: strings added after the
+	// table was sent, and the strings of a table whose chunks are still on the way
+	TUndefinedMap		m_undefined;
+
+	// what the encoded strings of this level took, and would have taken as text
+	int					m_nEncoded;
+	int					m_nDefined;
+	int					m_nTextBits;
+	int					m_nNetBits;
+};
+
+#endif // _CoopStringTable_H_
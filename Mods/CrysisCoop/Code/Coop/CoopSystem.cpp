@@ -15,9 +15,17 @@
 // Static CCoopSystem class instance forward declaration.
 CCoopSystem CCoopSystem::s_instance = CCoopSystem();
 
+int CCoopSystem::sVehicleAIBatchSize = 4;
+float CCoopSystem::sVehicleAIRecheckTime = 5.0f;
+int CCoopSystem::sDebugMultiplayerToggles = 0;
+
 CCoopSystem::CCoopSystem() :
 	m_nInitialized(0),
-	m_pReadability(NULL)
+	m_pReadability(NULL),
+	m_fVehicleRecheckTimer(0.0f),
+	m_nMultiplayerToggles(0),
+	m_nMultiplayerTogglesLastFrame(0),
+	m_pDialogSystem(NULL)
 {
 }
 
@@ -57,6 +65,22 @@ bool CCoopSystem::Initialize()
 	m_pDialogSystem = new CDialogSystem();
 	m_pDialogSystem->Init();
 
+	gEnv->pEntitySystem->AddSink(this);
+
+	gEnv->pConsole->Register("coop_vehicleAIBatchSize", &sVehicleAIBatchSize, 4, 0, "Max number of pending vehicles registered into the AI system per frame");
+	gEnv->pConsole->Register("coop_vehicleAIRecheckTime", &sVehicleAIRecheckTime, 5.0f, 0, "Seconds between checks of all vehicles for an AI object dropped outside of the vehicle events, 0 disables the check");
+	gEnv->pConsole->Register("coop_debugMultiplayerToggles", &sDebugMultiplayerToggles, 0, 0, "Displays how often gEnv->bMultiplayer is toggled per frame by the coop code");
+	gEnv->pConsole->Register("coop_debugStringTable", &CCoopStringTable::sDebugStringTable, 0, 0, "Logs the strings encoded and received through the coop string table");
+	gEnv->pConsole->AddCommand("coop_stringTableBandwidth", CCoopStringTable::CmdBandwidth, 0, "Logs the bytes the synchronizer strings took this level as table references, against sending them as text");
+	gEnv->pConsole->Register("coop_musicTeamWeight", &CCoopMusicController::sTeamWeight, 0.5f, 0, "Scale applied to the alertness of the other coop players when picking the music mood");
+	gEnv->pConsole->Register("coop_debugMusic", &CCoopMusicController::sDebugMusic, 0, 0, "Logs the music mood changes and mood resolution of the coop music controller");
+	gEnv->pConsole->Register("coop_perceptionThreshold", &CCoopPerceptionSummary::sReplicationThreshold, 0.02f, 0, "Change of a player's detection value needed before the server sends it to the clients again");
+	gEnv->pConsole->Register("coop_debugPerception", &CCoopPerceptionSummary::sDebugPerception, 0, 0, "Logs the per player detection levels built by the perception summary every AI tick");
+#if !defined(_RELEASE)
+	gEnv->pConsole->AddCommand("coop_musicSelfTest", CCoopMusicController::CmdSelfTest, 0, "Runs synthetic alertness curves through the coop music mood selection and checks the transitions");
+	gEnv->pConsole->AddCommand("coop_perceptionSelfTest", CCoopPerceptionSummary::CmdSelfTest, 0, "Runs mock AI observations through the perception summary and checks the resulting detection values, then checks the observations gathered from the AI of the loaded level");
+#endif
+
 	return true;
 }
 
@@ -78,6 +102,28 @@ void CCoopSystem::Shutdown()
 
 	CCoopCutsceneSystem::GetInstance()->Unregister();
 
+	gEnv->pEntitySystem->RemoveSink(this);
+
+	while (!m_vehicleListeners.empty())
+		RemoveVehicleListener(m_vehicleListeners.begin()->first);
+	m_pendingVehicles.clear();
+
+	gEnv->pConsole->UnregisterVariable("coop_vehicleAIBatchSize", true);
+	gEnv->pConsole->UnregisterVariable("coop_vehicleAIRecheckTime", true);
+	gEnv->pConsole->UnregisterVariable("coop_debugMultiplayerToggles", true);
+	gEnv->pConsole->UnregisterVariable("coop_debugStringTable", true);
+	gEnv->pConsole->RemoveCommand("coop_stringTableBandwidth");
+	gEnv->pConsole->UnregisterVariable("coop_musicTeamWeight", true);
+	gEnv->pConsole->UnregisterVariable("coop_debugMusic", true);
+	gEnv->pConsole->UnregisterVariable("coop_perceptionThreshold", true);
+	gEnv->pConsole->UnregisterVariable("coop_debugPerception", true);
+#if !defined(_RELEASE)
+	gEnv->pConsole->RemoveCommand("coop_musicSelfTest");
+	gEnv->pConsole->RemoveCommand("coop_perceptionSelfTest");
+#endif
+
+	m_stringTable.Clear();
+
 	gEnv->pGame->GetIGameFramework()->GetILevelSystem()->RemoveListener(this);
 	SAFE_DELETE(m_pReadability);
 
@@ -97,55 +143,208 @@ void CCoopSystem::Update(float fFrameTime)
 	if (m_pDialogSystem)
 		m_pDialogSystem->Update(fFrameTime);
 
-	// Registers vehicles into the AI system
+	// Registers newly spawned vehicles into the AI system
 	if (gEnv->bServer)
 	{
-		IVehicleIteratorPtr iter = gEnv->pGame->GetIGameFramework()->GetIVehicleSystem()->CreateVehicleIterator();
-		while (IVehicle* pVehicle = iter->Next())
+		// Backstop for AI objects dropped by scripts without a vehicle event
+		m_fVehicleRecheckTimer -= fFrameTime;
+		if (sVehicleAIRecheckTime > 0.0f && m_fVehicleRecheckTimer <= 0.0f)
 		{
-			if(IEntity *pEntity = pVehicle->GetEntity())
+			m_fVehicleRecheckTimer = sVehicleAIRecheckTime;
+			QueueVehicles(true);
+		}
+
+		UpdateVehicleRegistration();
+	}
+
+	CCoopCutsceneSystem::GetInstance()->Update(fFrameTime);
+
+	// Detection values of the players, read back from the AI system once per AI tick
+	if (gEnv->bServer)
+		m_perceptionSummary.Update(fFrameTime);
+
+	m_musicController.Update(fFrameTime);
+
+	if (sDebugMultiplayerToggles)
+	{
+		DrawDebugInfo();
+
+		m_nMultiplayerTogglesLastFrame = m_nMultiplayerToggles;
+		m_nMultiplayerToggles = 0;
+	}
+}
+
+// Summary:
+//	Sets gEnv->bMultiplayer and counts the toggle for the current frame.
+void CCoopSystem::SetMultiplayer(bool bMultiplayer)
+{
+	if (sDebugMultiplayerToggles && gEnv->bMultiplayer != bMultiplayer)
+		++m_nMultiplayerToggles;
+
+	gEnv->bMultiplayer = bMultiplayer;
+}
+
+void CCoopSystem::QueueVehicle(EntityId vehicleId)
+{
+	stl::push_back_unique(m_pendingVehicles, vehicleId);
+}
+
+void CCoopSystem::QueueVehicles(bool bOnlyWithoutAI)
+{
+	IVehicleIteratorPtr iter = gEnv->pGame->GetIGameFramework()->GetIVehicleSystem()->CreateVehicleIterator();
+	while (IVehicle* pVehicle = iter->Next())
+	{
+		IEntity* pEntity = pVehicle->GetEntity();
+		if (pEntity && (!bOnlyWithoutAI || !pEntity->GetAI()))
+			QueueVehicle(pEntity->GetId());
+	}
+}
+
+// Summary:
+//	Registers a bounded batch of pending vehicles into the AI system.
+//	The singleplayer switch is done once for the whole batch.
+void CCoopSystem::UpdateVehicleRegistration()
+{
+	if (m_pendingVehicles.empty())
+		return;
+
+	IVehicleSystem* pVehicleSystem = gEnv->pGame->GetIGameFramework()->GetIVehicleSystem();
+	IScriptSystem* pIScriptSystem = gEnv->pScriptSystem;
+
+	const int nBatch = min((int)m_pendingVehicles.size(), max(sVehicleAIBatchSize, 1));
+	bool bSwitched = false;
+
+	for (int i = 0; i < nBatch; ++i)
+	{
+		IVehicle* pVehicle = pVehicleSystem->GetVehicle(m_pendingVehicles[i]);
+		IEntity* pEntity = pVehicle ? pVehicle->GetEntity() : NULL;
+		if (!pEntity)
+			continue;
+
+		if (m_vehicleListeners.find(pEntity->GetId()) == m_vehicleListeners.end())
+		{
+			CVehicleAIListener* pListener = new CVehicleAIListener(this, pEntity->GetId());
+			m_vehicleListeners.insert(TVehicleListenerMap::value_type(pEntity->GetId(), pListener));
+			pVehicle->RegisterVehicleEventListener(pListener, "CoopSystem");
+		}
+
+		if (pEntity->GetAI())
+			continue;
+
+		if (!bSwitched)
+		{
+			SetMultiplayer(false);
+			bSwitched = true;
+		}
+
+		HSCRIPTFUNCTION scriptFunction(0);
+		if (IScriptTable* pScriptTable = pEntity->GetScriptTable())
+		{
+			if (pScriptTable->GetValue("ForceCoopAI", scriptFunction))
 			{
-				if (!pEntity->GetAI())
-				{
-					gEnv->bMultiplayer = false;
-										
-					HSCRIPTFUNCTION scriptFunction(0);
-					IScriptSystem*	pIScriptSystem = gEnv->pScriptSystem;
-					if (IScriptTable* pScriptTable = pEntity->GetScriptTable())
-					{
-						if (pScriptTable->GetValue("ForceCoopAI", scriptFunction))
-						{
-							Script::Call(pIScriptSystem, scriptFunction, pScriptTable, false);
-							pIScriptSystem->ReleaseFunc(scriptFunction);
-						}
-					}
-
-
-					gEnv->bMultiplayer = true;
-				}
+				Script::Call(pIScriptSystem, scriptFunction, pScriptTable, false);
+				pIScriptSystem->ReleaseFunc(scriptFunction);
 			}
 		}
 	}
-	CCoopCutsceneSystem::GetInstance()->Update(fFrameTime);
+
+	if (bSwitched)
+		SetMultiplayer(true);
+
+	m_pendingVehicles.erase(m_pendingVehicles.begin(), m_pendingVehicles.begin() + nBatch);
+}
+
+void CCoopSystem::DrawDebugInfo()
+{
+	static float color[] = { 1,1,1,1 };
+
+	gEnv->pRenderer->Draw2dLabel(5, 5, 1.5f, color, false, "bMultiplayer toggles: %d (last frame %d)", m_nMultiplayerToggles, m_nMultiplayerTogglesLastFrame);
+	gEnv->pRenderer->Draw2dLabel(5, 20, 1.5f, color, false, "Pending vehicles: %d", (int)m_pendingVehicles.size());
+}
+
+void CCoopSystem::OnSpawn(IEntity *pEntity, SEntitySpawnParams &params)
+{
+	if (!gEnv->bServer || gEnv->bEditor)
+		return;
+
+	// The vehicle game object is not initialized yet, registration is deferred to the next update
+	if (gEnv->pGame->GetIGameFramework()->GetIVehicleSystem()->IsVehicleClass(pEntity->GetClass()->GetName()))
+		QueueVehicle(pEntity->GetId());
+}
+
+bool CCoopSystem::OnRemove(IEntity *pEntity)
+{
+	const EntityId entityId = pEntity->GetId();
+
+	stl::find_and_erase(m_pendingVehicles, entityId);
+	RemoveVehicleListener(entityId);
+
+	return true;
+}
+
+void CCoopSystem::RemoveVehicleListener(EntityId vehicleId)
+{
+	TVehicleListenerMap::iterator it = m_vehicleListeners.find(vehicleId);
+	if (it == m_vehicleListeners.end())
+		return;
+
+	if (IVehicle* pVehicle = gEnv->pGame->GetIGameFramework()->GetIVehicleSystem()->GetVehicle(vehicleId))
+		pVehicle->UnregisterVehicleEventListener(it->second);
+
+	delete it->second;
+	m_vehicleListeners.erase(it);
+}
+
+void CCoopSystem::CVehicleAIListener::OnVehicleEvent(EVehicleEvent event, const SVehicleEventParams& params)
+{
+	switch (event)
+	{
+	case eVE_Destroyed:
+	case eVE_Repair:
+	case eVE_PassengerEnter:
+	case eVE_PassengerExit:
+	case eVE_PassengerChangeSeat:
+	case eVE_SeatFreed:
+		// Scripts may drop the vehicle AI on state and seat changes, recheck it once.
+		// Anything else is caught by the coop_vehicleAIRecheckTime sweep.
+		m_pCoopSystem->QueueVehicle(m_vehicleId);
+		break;
+	}
 }
 
 void CCoopSystem::OnLoadingStart(ILevelInfo *pLevel)
 {
+	// the table belongs to the previous level, clients get the new one on channel setup
+	m_stringTable.Clear();
+	m_musicController.Reset();
+	m_perceptionSummary.Reset();
+
 	if (gEnv->bEditor) return;
 	if (!gEnv->bServer) return;
 
 	m_nInitialized = 0;
 	CryLogAlways("[CCoopSystem] Initializing AI System...");
 
-	gEnv->bMultiplayer = false;
+	CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	SetMultiplayer(false);
 	if (!gEnv->pAISystem->Init())
 		CryLogAlways("[CCoopSystem] AI System Initialization Failed");
 
 	gEnv->pAISystem->FlushSystem();
 	gEnv->pAISystem->Enable();
 
+	CTimeValue initEndTime = gEnv->pTimer->GetAsyncTime();
+
+	// LoadNavigationData only takes the level path and reads and parses the files
+	// itself, so there is nothing a worker thread could hand it; it stays here,
+	// before the level's entities are spawned.
 	gEnv->pAISystem->LoadNavigationData(pLevel->GetPath(), "mission0");
-	gEnv->bMultiplayer = true;
+	SetMultiplayer(true);
+
+	CTimeValue navigationEndTime = gEnv->pTimer->GetAsyncTime();
+	CryLogAlways("[CCoopSystem] AI init: %.1f ms, navigation: %.1f ms",
+		(initEndTime - startTime).GetMilliSeconds(), (navigationEndTime - initEndTime).GetMilliSeconds());
 
 	ICVar* pSystemUpdate = gEnv->pConsole->GetCVar("ai_systemupdate");
 	if (gEnv->bServer)
@@ -183,9 +382,20 @@ void CCoopSystem::OnLoadingComplete(ILevel *pLevel)
 	if (gEnv->bEditor) return;
 
 	int nInitialized = 0;
-	gEnv->bMultiplayer = false;
+	SetMultiplayer(false);
 	m_nInitialized = 1;
 	
 	gEnv->pAISystem->Reset(IAISystem::RESET_ENTER_GAME);
-	gEnv->bMultiplayer = true;
+	SetMultiplayer(true);
+
+	// Strings the synchronizers send during this level, see CGameRules::PostInitClient
+	if (gEnv->bServer)
+		m_stringTable.Build();
+
+	// The AI reset may drop vehicle AI objects, queue every vehicle for a single recheck
+	if (gEnv->bServer)
+	{
+		QueueVehicles(false);
+		m_fVehicleRecheckTimer = sVehicleAIRecheckTime;
+	}
 }
@@ -2,12 +2,18 @@
 #define _CoopSystem_H_
 
 #include <ILevelSystem.h>
+#include <IEntitySystem.h>
+#include <IVehicleSystem.h>
 #include "CoopReadability.h"
+#include "CoopStringTable.h"
+#include "CoopMusicController.h"
+#include "CoopPerceptionSummary.h"
 
 class CDialogSystem;
 
 class CCoopSystem 
 	: public ILevelSystemListener
+	, public IEntitySystemSink
 {
 private:
 	// Static CCoopSystem class instance forward declaration.
@@ -48,8 +54,28 @@ public:
 	virtual void OnLoadingProgress(ILevelInfo *pLevel, int progressAmount) { };
 	// ~ILevelSystemListener
 
+	// IEntitySystemSink
+	virtual bool OnBeforeSpawn(SEntitySpawnParams &params) { return true; }
+	virtual void OnSpawn(IEntity *pEntity, SEntitySpawnParams &params);
+	virtual bool OnRemove(IEntity *pEntity);
+	virtual void OnEvent(IEntity *pEntity, SEntityEvent &event) { };
+	// ~IEntitySystemSink
+
+	// Summary:
+	//	Sets gEnv->bMultiplayer and counts the toggle for the current frame.
+	//	All singleplayer/multiplayer switches done by the coop code should go through here.
+	void SetMultiplayer(bool bMultiplayer);
+
+	// Summary:
+	//	Number of bMultiplayer toggles recorded during the last completed frame,
+	//	only counted while coop_debugMultiplayerToggles is set.
+	int GetMultiplayerTogglesLastFrame() const { return m_nMultiplayerTogglesLastFrame; }
+
 
 	CDialogSystem* GetDialogSystem() { return m_pDialogSystem; }
+	CCoopStringTable& GetStringTable() { return m_stringTable; }
+	CCoopMusicController& GetMusicController() { return m_musicController; }
+	CCoopPerceptionSummary& GetPerceptionSummary() { return m_perceptionSummary; }
 
 	CCoopReadability* m_pReadability;
 
@@ -64,8 +90,55 @@ private:
 	IEntityClass* m_pEntityClassHunter;
 
 private:
+	// Summary:
+	//	Queues a vehicle entity for AI registration on the next UpdateVehicleRegistration.
+	void QueueVehicle(EntityId vehicleId);
+
+	// Summary:
+	//	Queues every vehicle, or only the vehicles without an AI object.
+	void QueueVehicles(bool bOnlyWithoutAI);
+
+	// Summary:
+	//	Registers a bounded batch of pending vehicles into the AI system.
+	void UpdateVehicleRegistration();
+
+	void RemoveVehicleListener(EntityId vehicleId);
+
+	void DrawDebugInfo();
+
+	// Summary:
+	//	Requeues its vehicle when a vehicle event may have dropped the vehicle AI.
+	class CVehicleAIListener : public IVehicleEventListener
+	{
+	public:
+		CVehicleAIListener(CCoopSystem* pCoopSystem, EntityId vehicleId) : m_pCoopSystem(pCoopSystem), m_vehicleId(vehicleId) {}
+		virtual void OnVehicleEvent(EVehicleEvent event, const SVehicleEventParams& params);
+
+	private:
+		CCoopSystem*	m_pCoopSystem;
+		EntityId		m_vehicleId;
+	};
+
+	typedef std::vector<EntityId> TVehicleIdVector;
+	typedef std::map<EntityId, CVehicleAIListener*> TVehicleListenerMap;
+
+	TVehicleIdVector	m_pendingVehicles;
+	TVehicleListenerMap	m_vehicleListeners;
+
+	float				m_fVehicleRecheckTimer;
+
+	int					m_nMultiplayerToggles;
+	int					m_nMultiplayerTogglesLastFrame;
 
 	CDialogSystem* m_pDialogSystem;
+	CCoopStringTable m_stringTable;
+	CCoopMusicController m_musicController;
+	CCoopPerceptionSummary m_perceptionSummary;
+
+public:
+	static int sVehicleAIBatchSize;
+	static float sVehicleAIRecheckTime;
+	static int sDebugMultiplayerToggles;
 
 };
 
@@ -444,7 +444,13 @@ bool CDialogSession::SetActor(CDialogScript::TActorID actorID, EntityId entityId
 	if (actorID >= CDialogScript::MAX_ACTORS)
 		return false;
 
+	EntityId oldEntityId = stl::find_in_map(m_idToEntityMap, actorID, 0);
 	m_idToEntityMap[actorID] = entityId;
+	if (m_bPlaying && oldEntityId != entityId)
+	{
+		m_pDS->UpdateEntityIndex(oldEntityId);
+		m_pDS->UpdateEntityIndex(entityId);
+	}
 	if (entityId != 0)
 	{
 		m_actorSet.SetActor(actorID);
@@ -154,6 +154,7 @@ public:
 	IEntity* GetActorEntity(CDialogScript::TActorID actorID) const;
 	EntityId GetActorEntityId(CDialogScript::TActorID actorID) const;
 	CDialogScript::TActorID GetActorIdForEntity(EntityId entityId) const;
+	const TIdToEntityMap& GetActorEntities() const { return m_idToEntityMap; }
 	IEntitySoundProxy* GetEntitySoundProxy(IEntity* pEntity) const;
 	int ScheduleNextLine(float dt); // schedule next line to be played. returns index of line
 	float GetCurTime() const
@@ -67,6 +67,33 @@ namespace
 		}
 	}
 
+	void ScriptCheckEntityIndex(IConsoleCmdArgs* pArgs)
+	{
+		CDialogSystem* pDS = CCoopSystem::GetInstance()->GetDialogSystem();
+		if (pDS)
+		{
+			if (pDS->CheckEntityIndex())
+				CryLogAlways("[DIALOG] Entity index is consistent");
+		}
+	}
+
+#if !defined(_RELEASE)
+	void ScriptBenchmarkEntityIndex(IConsoleCmdArgs* pArgs)
+	{
+		CDialogSystem* pDS = CCoopSystem::GetInstance()->GetDialogSystem();
+		if (pDS)
+		{
+			int sessions = 64;
+			int queries = 100000;
+			if (pArgs->GetArgCount() > 1)
+				sessions = max(1, atoi(pArgs->GetArg(1)));
+			if (pArgs->GetArgCount() > 2)
+				queries = max(1, atoi(pArgs->GetArg(2)));
+			pDS->BenchmarkEntityIndex(sessions, queries);
+		}
+	}
+#endif
+
 	bool InitCons()
 	{
 		CDialogSystem::sDiaLOGLevel = 0;
@@ -146,6 +173,11 @@ bool CDialogSystem::Init()
 {
 	CryLogAlways("[CDialogSystem::Init] Coop Dialog Initalized");
 
+	gEnv->pConsole->AddCommand("ds_CheckEntityIndex", ScriptCheckEntityIndex, 0, "Rebuilds the dialog entity index from the active sessions and logs differences");
+#if !defined(_RELEASE)
+	gEnv->pConsole->AddCommand("ds_BenchmarkEntityIndex", ScriptBenchmarkEntityIndex, VF_CHEAT, "Starts concurrent sessions of the first dialog script and times FindSessionAndActorForEntity against the old session walk. Usage: ds_BenchmarkEntityIndex [sessions] [queries]");
+#endif
+
 	// (MATT) Loading just the dialog for one level works only in Game, but saves a lot of RAM. 
 	// In Editor it seems very awkward to arrange so lets just load everything {2008/08/20}
 
@@ -201,6 +233,7 @@ void CDialogSystem::ReleaseSessions()
 	m_activeSessions.clear();
 	m_allSessions.clear();
 	m_restoreSessions.clear();
+	m_entityIndex.clear();
 
 	m_nextSessionID = 1;
 }
@@ -215,6 +248,11 @@ void CDialogSystem::Shutdown()
 {
 	CryLogAlways("[CDialogSystem::Shutdown] Coop Dialog Shutdown");
 
+	gEnv->pConsole->RemoveCommand("ds_CheckEntityIndex");
+#if !defined(_RELEASE)
+	gEnv->pConsole->RemoveCommand("ds_BenchmarkEntityIndex");
+#endif
+
 	ReleaseSessions();
 	ReleaseScripts();
 }
@@ -312,12 +350,18 @@ bool CDialogSystem::DeleteSession(CDialogSystem::SessionID id)
 
 bool CDialogSystem::AddSession(CDialogSession* pSession)
 {
-	return stl::push_back_unique(m_activeSessions, pSession);
+	if (!stl::push_back_unique(m_activeSessions, pSession))
+		return false;
+	UpdateSessionEntityIndex(pSession);
+	return true;
 }
 
 bool CDialogSystem::RemoveSession(CDialogSession* pSession)
 {
-	return stl::find_and_erase(m_activeSessions, pSession);
+	if (!stl::find_and_erase(m_activeSessions, pSession))
+		return false;
+	UpdateSessionEntityIndex(pSession);
+	return true;
 }
 
 void CDialogSystem::Update(const float dt)
@@ -542,6 +586,23 @@ bool CDialogSystem::IsEntityInDialog(EntityId entityId) const
 }
 
 bool CDialogSystem::FindSessionAndActorForEntity(EntityId entityId, CDialogSystem::SessionID &outSessionID, CDialogScript::TActorID &outActorId) const
+{
+	TEntityIndex::const_iterator found = m_entityIndex.find(entityId);
+	if (found != m_entityIndex.end())
+	{
+		outSessionID = found->second.sessionID;
+		outActorId = found->second.actorID;
+		return true;
+	}
+
+	outSessionID = 0;
+	outActorId = CDialogScript::NO_ACTOR_ID;
+	return false;
+}
+
+// The index only changes when sessions start/stop or swap actors, so resolving
+// an entity against the active sessions here keeps the old first-match order
+bool CDialogSystem::ScanSessionsForEntity(EntityId entityId, CDialogSystem::SessionID &outSessionID, CDialogScript::TActorID &outActorId) const
 {
 	TDialogSessionVec::const_iterator iter = m_activeSessions.begin();
 	TDialogSessionVec::const_iterator end  = m_activeSessions.end();
@@ -565,6 +626,133 @@ bool CDialogSystem::FindSessionAndActorForEntity(EntityId entityId, CDialogSyste
 	return false;
 }
 
+void CDialogSystem::UpdateEntityIndex(EntityId entityId)
+{
+	if (entityId == 0)
+		return;
+
+	SessionID sessionID;
+	CDialogScript::TActorID actorID;
+	if (ScanSessionsForEntity(entityId, sessionID, actorID))
+		m_entityIndex[entityId] = SEntityDialogRef(sessionID, actorID);
+	else
+		m_entityIndex.erase(entityId);
+}
+
+void CDialogSystem::UpdateSessionEntityIndex(const CDialogSession* pSession)
+{
+	const CDialogSession::TIdToEntityMap& entities = pSession->GetActorEntities();
+	for (CDialogSession::TIdToEntityMap::const_iterator iter = entities.begin(); iter != entities.end(); ++iter)
+		UpdateEntityIndex(iter->second);
+}
+
+bool CDialogSystem::CheckEntityIndex() const
+{
+	TEntityIndex rebuilt;
+	for (TDialogSessionVec::const_iterator iter = m_activeSessions.begin(); iter != m_activeSessions.end(); ++iter)
+	{
+		const CDialogSession::TIdToEntityMap& entities = (*iter)->GetActorEntities();
+		for (CDialogSession::TIdToEntityMap::const_iterator entityIter = entities.begin(); entityIter != entities.end(); ++entityIter)
+		{
+			const EntityId entityId = entityIter->second;
+			if (entityId == 0 || rebuilt.find(entityId) != rebuilt.end())
+				continue;
+			rebuilt[entityId] = SEntityDialogRef((*iter)->GetSessionID(), (*iter)->GetActorIdForEntity(entityId));
+		}
+	}
+
+	bool ok = rebuilt.size() == m_entityIndex.size();
+	if (!ok)
+		GameWarning("[DIALOG] CDialogSystem::CheckEntityIndex: %d entries indexed, %d expected", (int)m_entityIndex.size(), (int)rebuilt.size());
+
+	for (TEntityIndex::const_iterator iter = rebuilt.begin(); iter != rebuilt.end(); ++iter)
+	{
+		TEntityIndex::const_iterator found = m_entityIndex.find(iter->first);
+		if (found == m_entityIndex.end())
+		{
+			GameWarning("[DIALOG] CDialogSystem::CheckEntityIndex: Entity %d missing (Session %d %s)", iter->first, iter->second.sessionID, ToActor(iter->second.actorID));
+			ok = false;
+		}
+		else if (found->second.sessionID != iter->second.sessionID || found->second.actorID != iter->second.actorID)
+		{
+			GameWarning("[DIALOG] CDialogSystem::CheckEntityIndex: Entity %d indexed as Session %d %s, expected Session %d %s", iter->first,
+				found->second.sessionID, ToActor(found->second.actorID), iter->second.sessionID, ToActor(iter->second.actorID));
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+void CDialogSystem::BenchmarkEntityIndex(int sessions, int queries)
+{
+	if (m_dialogScriptMap.empty())
+	{
+		GameWarning("[DIALOG] CDialogSystem::BenchmarkEntityIndex: No dialog scripts loaded");
+		return;
+	}
+
+	// ids far above what the entity system hands out, so no real entity is touched
+	const EntityId firstEntityId = 0x7fff0000;
+	const int actorsPerSession = min(4, (int)CDialogScript::MAX_ACTORS);
+	const string scriptID = m_dialogScriptMap.begin()->first;
+
+	// every session shares its last actor with the next one, so the first-active-session order matters
+	std::vector<SessionID> sessionIDs;
+	for (int i = 0; i < sessions; ++i)
+	{
+		SessionID id = CreateSession(scriptID);
+		CDialogSession* pSession = GetSession(id);
+		if (!pSession)
+			break;
+		for (int a = 0; a < actorsPerSession; ++a)
+			pSession->SetActor(a, firstEntityId + i * (actorsPerSession - 1) + a);
+		AddSession(pSession);
+		sessionIDs.push_back(id);
+	}
+
+	// half the queries ask for an entity that isn't talking, the common case
+	const int entities = (int)sessionIDs.size() * (actorsPerSession - 1) + 1;
+	std::vector<EntityId> queryIds(queries);
+	uint32 seed = 12345;
+	for (int i = 0; i < queries; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		queryIds[i] = firstEntityId + (seed >> 8) % (2 * entities);
+	}
+
+	SessionID sessionID;
+	CDialogScript::TActorID actorID;
+	int found = 0, foundScan = 0, mismatches = 0;
+
+	CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+	for (int i = 0; i < queries; ++i)
+		found += FindSessionAndActorForEntity(queryIds[i], sessionID, actorID) ? 1 : 0;
+	CTimeValue indexTime = gEnv->pTimer->GetAsyncTime();
+	for (int i = 0; i < queries; ++i)
+		foundScan += ScanSessionsForEntity(queryIds[i], sessionID, actorID) ? 1 : 0;
+	CTimeValue scanTime = gEnv->pTimer->GetAsyncTime();
+
+	for (int i = 0; i < queries; ++i)
+	{
+		SessionID scanSessionID;
+		CDialogScript::TActorID scanActorID;
+		bool bFound = FindSessionAndActorForEntity(queryIds[i], sessionID, actorID);
+		if (bFound != ScanSessionsForEntity(queryIds[i], scanSessionID, scanActorID) || (bFound && (sessionID != scanSessionID || actorID != scanActorID)))
+			++mismatches;
+	}
+
+	bool consistent = CheckEntityIndex();
+
+	for (std::vector<SessionID>::const_iterator iter = sessionIDs.begin(); iter != sessionIDs.end(); ++iter)
+		DeleteSession(*iter);
+	ReleasePendingDeletes();
+
+	CryLogAlways("[DIALOG] Entity index: %d sessions, %d actors each, %d queries (%d hits)", (int)sessionIDs.size(), actorsPerSession, queries, found);
+	CryLogAlways("[DIALOG]   index: %.3f ms, session walk: %.3f ms (%d hits)",
+		(indexTime - startTime).GetMilliSeconds(), (scanTime - indexTime).GetMilliSeconds(), foundScan);
+	CryLogAlways("[DIALOG]   %d mismatches, index %s, %d entries left", mismatches, consistent ? "consistent" : "INCONSISTENT", (int)m_entityIndex.size());
+}
+
 void CDialogSystem::GetMemoryStatistics(ICrySizer * s)
 {
 	SIZER_SUBCOMPONENT_NAME(s,"DialogSystem");
@@ -574,6 +762,7 @@ void CDialogSystem::GetMemoryStatistics(ICrySizer * s)
 	s->AddContainer(m_activeSessions);
 	s->AddContainer(m_pendingDeleteSessions);
 	s->AddContainer(m_restoreSessions);
+	s->AddContainer(m_entityIndex);
 
 	for (TDialogScriptMap::iterator iter = m_dialogScriptMap.begin(); iter != m_dialogScriptMap.end(); ++iter)
 	{
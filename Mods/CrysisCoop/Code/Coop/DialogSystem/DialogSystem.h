@@ -64,6 +64,13 @@ public:
 	bool IsEntityInDialog(EntityId entityId) const;
 	bool FindSessionAndActorForEntity(EntityId entityId, SessionID& outSessionID, CDialogScript::TActorID& outActorId) const;
 
+	// called from CDialogSession when an actor of an active session changes
+	void UpdateEntityIndex(EntityId entityId);
+	// rebuilds the entity index from the active sessions and logs any difference
+	bool CheckEntityIndex() const;
+	// starts that many sessions at once and times the index against the session walk
+	void BenchmarkEntityIndex(int sessions, int queries);
+
 	// called from CDialogSession
 	bool AddSession(CDialogSession* pSession);
 	bool RemoveSession(CDialogSession* pSession);
@@ -85,12 +92,24 @@ protected:
 	void ReleasePendingDeletes();
 	void RestoreSessions();
 	CDialogSession* InternalCreateSession(const string& scriptID, SessionID sessionID);
+	bool ScanSessionsForEntity(EntityId entityId, SessionID& outSessionID, CDialogScript::TActorID& outActorId) const;
+	void UpdateSessionEntityIndex(const CDialogSession* pSession);
 
 protected:
 	class CDialogScriptIterator;
 	typedef std::map<SessionID, CDialogSession*> TDialogSessionMap;
 	typedef std::vector<CDialogSession*> TDialogSessionVec;
 
+	// EntityId -> first active session (in m_activeSessions order) the entity talks in
+	struct SEntityDialogRef
+	{
+		SEntityDialogRef(SessionID _sessionID = 0, CDialogScript::TActorID _actorID = CDialogScript::NO_ACTOR_ID)
+			: sessionID(_sessionID), actorID(_actorID) {}
+		SessionID               sessionID;
+		CDialogScript::TActorID actorID;
+	};
+	typedef stl::hash_map<EntityId, SEntityDialogRef, stl::hash_uint32> TEntityIndex;
+
 	int               m_nextSessionID;
 	TDialogScriptMap  m_dialogScriptMap;
 	TDialogSessionMap m_allSessions;
@@ -98,6 +117,7 @@ protected:
 	TDialogSessionVec m_activeSessionsTemp;
 	TDialogSessionVec m_pendingDeleteSessions;
 	std::vector<SessionID> m_restoreSessions;
+	TEntityIndex      m_entityIndex;
 };
 
 #endif
@@ -9,10 +9,19 @@
 class CDialogPlayer : public IDialogSessionListener
 {
 public:
+	// Summary:
+	//	Told when the session ends by itself, not when StopDialog is called.
+	struct IListener
+	{
+		// bForEveryone is false when only this machine aborted it, e.g. the local player walked away
+		virtual void OnDialogFinished(bool bForEveryone) = 0;
+	};
+
 	CDialogPlayer()
 	{
 		m_sessionID = 0;
 		m_bIsPlaying = false;
+		m_pListener = 0;
 	}
 
 	~CDialogPlayer()
@@ -22,9 +31,12 @@ public:
 
 	static const int MAX_ACTORS = 8;
 
+	void SetListener(IListener* pListener) { m_pListener = pListener; }
+
 private:
 	CDialogSystem::SessionID m_sessionID;
 	bool m_bIsPlaying;
+	IListener* m_pListener;
 
 protected:
 	CDialogSession* GetSession()
@@ -36,6 +48,16 @@ protected:
 	}
 
 public:
+	bool IsPlaying() const { return m_sessionID != 0; }
+
+	// Summary:
+	//	Script line the running session is at, -1 if there is none.
+	int GetCurrentLine()
+	{
+		CDialogSession* pSession = GetSession();
+		return pSession ? max(pSession->GetCurrentLine(), 0) : -1;
+	}
+
 	bool StopDialog()
 	{
 		m_bIsPlaying = false;
@@ -157,6 +179,8 @@ protected:
 				const CDialogSession::EAbortReason reason = pSession->GetAbortReason();
 				const int curLine = pSession->GetCurrentLine();
 				StopDialog();
+				if (m_pListener)
+					m_pListener->OnDialogFinished(reason != CDialogSession::eAR_PlayerOutOfRange && reason != CDialogSession::eAR_PlayerOutOfView);
 				//ActivateOutput(&m_actInfo, EOP_DoneFinishedOrAborted, true);
 				//ActivateOutput(&m_actInfo, EOP_Aborted, true);
 				//ActivateOutput(&m_actInfo, EOP_LastLine, curLine);
@@ -173,6 +197,8 @@ protected:
 			break;
 			case CDialogSession::eDSE_EndOfDialog:
 				StopDialog();
+				if (m_pListener)
+					m_pListener->OnDialogFinished(true);
 				//ActivateOutput(&m_actInfo, EOP_Finished, true);
 				//ActivateOutput(&m_actInfo, EOP_DoneFinishedOrAborted, true);
 				break;
@@ -8,7 +8,8 @@
 #include "Player.h"
 
 CDialogSynchronizer::CDialogSynchronizer() :
-	m_pDialogPlayer(NULL)
+	m_pDialogPlayer(NULL),
+	m_nPlayingInstance(0)
 {
 }
 
@@ -21,6 +22,7 @@ bool CDialogSynchronizer::Init(IGameObject *pGameObject)
 	SetGameObject(pGameObject);
 
 	m_pDialogPlayer = new CDialogPlayer();
+	m_pDialogPlayer->SetListener(this);
 
 	if (!GetGameObject()->BindToNetwork())
 		return false;
@@ -38,10 +40,30 @@ bool CDialogSynchronizer::PlayDialog(string sDialog, EntityId* pActors, int nAII
 {
 	if (!m_pDialogPlayer) return false;
 
+	if (gEnv->bServer)
+	{
+		// the same dialog started again within one frame is a duplicate trigger
+		const CTimeValue now = gEnv->pTimer->GetFrameStartTime();
+		if (m_runningDialog.bRunning && m_runningDialog.startedAt == now && m_runningDialog.sDialog == sDialog)
+			return true;
+
+		m_runningDialog.bRunning = true;
+		m_runningDialog.sDialog = sDialog;
+		memcpy(m_runningDialog.actors, pActors, sizeof(m_runningDialog.actors));
+		m_runningDialog.nAIInterrupt = nAIInterrupt;
+		m_runningDialog.fAwareDist = fAwareDist;
+		m_runningDialog.fAwareAngle = fAwareAngle;
+		m_runningDialog.fAwareTimeOut = fAwareTimeOut;
+		m_runningDialog.nFlags = nFlags;
+		m_runningDialog.nFromLine = nFromLine;
+		m_runningDialog.startedAt = now;
+		m_nPlayingInstance = ++m_runningDialog.nInstance;
+	}
+
 	CryLogAlways("[CDialogSynchronizer::PlayDialog] %s", sDialog);
 	
 	if (gEnv->bServer)
-		GetGameObject()->InvokeRMI(ClPlayDialog(), SDialogParams(sDialog, pActors, nAIInterrupt, fAwareDist, fAwareAngle, fAwareTimeOut, nFlags, nFromLine), eRMI_ToAllClients | eRMI_NoLocalCalls);
+		GetGameObject()->InvokeRMI(ClPlayDialog(), SDialogParams(CCoopSystem::GetInstance()->GetStringTable().Encode(sDialog.c_str()), pActors, nAIInterrupt, fAwareDist, fAwareAngle, fAwareTimeOut, nFlags, nFromLine, m_runningDialog.nInstance), eRMI_ToAllClients | eRMI_NoLocalCalls);
 	
 	if (gEnv->pSystem->IsDedicated()) return false;
 
@@ -54,14 +76,48 @@ bool CDialogSynchronizer::StopDialog()
 
 	CryLogAlways("[CDialogSynchronizer::StopDialog]");
 
-	if (gEnv->bServer)
+	// nothing the clients could still be playing, skip the RMI
+	if (gEnv->bServer && m_runningDialog.bRunning)
+	{
+		m_runningDialog.bRunning = false;
 		GetGameObject()->InvokeRMI(ClStopDialog(), SDialogStopParams(true), eRMI_ToAllClients | eRMI_NoLocalCalls);
+	}
 
 	if (gEnv->pSystem->IsDedicated()) return false;
 
 	return m_pDialogPlayer->StopDialog();
 }
 
+void CDialogSynchronizer::PostInitClient(int channelId)
+{
+	if (!gEnv->bServer || !m_pDialogPlayer || !m_runningDialog.bRunning)
+		return;
+
+	// a listen server plays the dialog itself and knows the current line,
+	// a dedicated server can only restart it from the line it was started at.
+	// bRunning is cleared when the dialog finishes, see OnDialogFinished
+	int nLine = m_runningDialog.nFromLine;
+	if (!gEnv->pSystem->IsDedicated() && m_pDialogPlayer->IsPlaying())
+		nLine = m_pDialogPlayer->GetCurrentLine();
+
+	CryLogAlways("[CDialogSynchronizer::PostInitClient] Catching up channel %d on %s at line %d", channelId, m_runningDialog.sDialog.c_str(), nLine);
+
+	// the table chunks go out through the game rules and may arrive after this, so the text goes along
+	CCoopStringTable::SNetString dialog = CCoopSystem::GetInstance()->GetStringTable().Lookup(m_runningDialog.sDialog.c_str());
+	GetGameObject()->InvokeRMI(ClPlayDialog(), SDialogParams(dialog, m_runningDialog.actors, m_runningDialog.nAIInterrupt, m_runningDialog.fAwareDist, m_runningDialog.fAwareAngle, m_runningDialog.fAwareTimeOut, m_runningDialog.nFlags, nLine, m_runningDialog.nInstance), eRMI_ToClientChannel | eRMI_NoLocalCalls, channelId);
+}
+
+void CDialogSynchronizer::OnDialogFinished(bool bForEveryone)
+{
+	// a player walking away only ends the dialog for that player
+	if (!bForEveryone)
+		return;
+
+	if (gEnv->bServer)
+		m_runningDialog.bRunning = false;
+	else
+		GetGameObject()->InvokeRMI(SvDialogFinished(), SDialogFinishedParams(m_nPlayingInstance), eRMI_ToServer);
+}
 
 IMPLEMENT_RMI(CDialogSynchronizer, ClPlayDialog)
 {
@@ -85,7 +141,8 @@ IMPLEMENT_RMI(CDialogSynchronizer, ClPlayDialog)
 		}
 	}
 
-	PlayDialog(params.sDialog, pActors, params.nAIInterrupt, params.fAwareDist, params.fAwareAngle, params.fAwareTimeOut, params.nFlags, params.nFromLine);
+	m_nPlayingInstance = params.nInstance;
+	PlayDialog(CCoopSystem::GetInstance()->GetStringTable().Decode(params.dialog), pActors, params.nAIInterrupt, params.fAwareDist, params.fAwareAngle, params.fAwareTimeOut, params.nFlags, params.nFromLine);
 
 	SAFE_DELETE_ARRAY(pActors);
 	return true;
@@ -98,3 +155,15 @@ IMPLEMENT_RMI(CDialogSynchronizer, ClStopDialog)
 	return true;
 }
 
+IMPLEMENT_RMI(CDialogSynchronizer, SvDialogFinished)
+{
+	// a dedicated server doesn't play dialogs, it learns from the clients when one is over
+	if (m_runningDialog.bRunning && m_runningDialog.nInstance == params.nInstance)
+	{
+		CryLogAlways("[CDialogSynchronizer::SvDialogFinished] %s", m_runningDialog.sDialog.c_str());
+		m_runningDialog.bRunning = false;
+	}
+
+	return true;
+}
+
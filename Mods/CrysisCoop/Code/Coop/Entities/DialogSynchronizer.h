@@ -4,11 +4,13 @@
 #include <IGameObject.h>
 
 #include "DialogPlayer.h"
+#include "Coop\CoopStringTable.h"
 
 class CDialogSession;
 
 class CDialogSynchronizer 
 	:	public CGameObjectExtensionHelper<CDialogSynchronizer, IGameObjectExtension, 16>
+	,	public CDialogPlayer::IListener
 {
 public:
 	CDialogSynchronizer();
@@ -18,8 +20,8 @@ public:
 	struct SDialogParams
 	{
 		SDialogParams() {};
-		SDialogParams(string sDialog, EntityId* pActors, int nAIInterrupt, float fAwareDist, float fAwareAngle, float fAwareTimeOut, int nFlags, int nFromLine) :
-			sDialog(sDialog),
+		SDialogParams(const CCoopStringTable::SNetString& dialog, EntityId* pActors, int nAIInterrupt, float fAwareDist, float fAwareAngle, float fAwareTimeOut, int nFlags, int nFromLine, uint8 nInstance) :
+			dialog(dialog),
 			nActor1(pActors[0]),
 			nActor2(pActors[1]),
 			nActor3(pActors[2]),
@@ -33,9 +35,10 @@ public:
 			fAwareAngle(fAwareAngle),
 			fAwareTimeOut(fAwareTimeOut),
 			nFlags(nFlags),
-			nFromLine(nFromLine)
+			nFromLine(nFromLine),
+			nInstance(nInstance)
 		{};
-		string sDialog;
+		CCoopStringTable::SNetString dialog;
 		
 		EntityId nActor1;
 		EntityId nActor2;
@@ -52,19 +55,28 @@ public:
 		float fAwareTimeOut;
 		int nFlags;
 		int nFromLine;
+		uint8 nInstance; // identifies this start in SvDialogFinished
 
 		void SerializeWith(TSerialize ser)
 		{
-			ser.Value("sDialog", sDialog);
-
-			ser.Value("nActor1", nActor1, 'eid');
-			ser.Value("nActor2", nActor2, 'eid');
-			ser.Value("nActor3", nActor3, 'eid');
-			ser.Value("nActor4", nActor4, 'eid');
-			ser.Value("nActor5", nActor5, 'eid');
-			ser.Value("nActor6", nActor6, 'eid');
-			ser.Value("nActor7", nActor7, 'eid');
-			ser.Value("nActor8", nActor8, 'eid');
+			dialog.SerializeWith(ser);
+
+			// most dialogs use two or three actors, only the used slots are sent
+			EntityId* actors[8] = { &nActor1, &nActor2, &nActor3, &nActor4, &nActor5, &nActor6, &nActor7, &nActor8 };
+			uint8 nActorMask = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				if (ser.IsReading())
+					*actors[i] = 0;
+				else if (*actors[i])
+					nActorMask |= 1 << i;
+			}
+			ser.Value("nActorMask", nActorMask, 'ui8');
+			for (int i = 0; i < 8; ++i)
+			{
+				if (nActorMask & (1 << i))
+					ser.Value("nActor", *actors[i], 'eid');
+			}
 
 			ser.Value("nAIInterrupt", nAIInterrupt);
 			ser.Value("fAwareDist", fAwareDist);
@@ -72,6 +84,19 @@ public:
 			ser.Value("fAwareTimeOut", fAwareTimeOut);
 			ser.Value("nFlags", nFlags);
 			ser.Value("nFromLine", nFromLine);
+			ser.Value("nInstance", nInstance, 'ui8');
+		}
+	};
+
+	struct SDialogFinishedParams
+	{
+		SDialogFinishedParams() : nInstance(0) {};
+		SDialogFinishedParams(uint8 nInstance) : nInstance(nInstance) {};
+		uint8 nInstance;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("nInstance", nInstance, 'ui8');
 		}
 	};
 
@@ -91,6 +116,7 @@ public:
 
 	DECLARE_CLIENT_RMI_NOATTACH(ClPlayDialog, SDialogParams, eNRT_ReliableOrdered);
 	DECLARE_CLIENT_RMI_NOATTACH(ClStopDialog, SDialogStopParams, eNRT_ReliableOrdered);
+	DECLARE_SERVER_RMI_NOATTACH(SvDialogFinished, SDialogFinishedParams, eNRT_ReliableUnordered);
 
 public:
 	bool PlayDialog(string sDialog, EntityId* pActors, int nAIInterrupt, float fAwareDist, float fAwareAngle, float fAwareTimeOut, int nFlags, int nFromLine);
@@ -101,7 +127,7 @@ public:
 	virtual bool Init(IGameObject *pGameObject);
 	virtual void InitClient(int channelId) {};
 	virtual void PostInit(IGameObject *pGameObject) { };
-	virtual void PostInitClient(int channelId) {};
+	virtual void PostInitClient(int channelId);
 	virtual void Release();
 	virtual void FullSerialize(TSerialize ser) { };
 	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags) { return true; };
@@ -118,8 +144,34 @@ public:
 	virtual void GetMemoryStatistics(ICrySizer * s) { };
 	//~IGameObjectExtension
 
+	// CDialogPlayer::IListener
+	virtual void OnDialogFinished(bool bForEveryone);
+	// ~CDialogPlayer::IListener
+
 private:
+	// Summary:
+	//	Server side record of the running dialog, replayed to late joiners.
+	struct SRunningDialog
+	{
+		SRunningDialog() : bRunning(false), nInstance(0) {}
+
+		bool bRunning; // until StopDialog or the dialog finishes on the server or any client
+		string sDialog;
+		EntityId actors[CDialogPlayer::MAX_ACTORS];
+		int nAIInterrupt;
+		float fAwareDist;
+		float fAwareAngle;
+		float fAwareTimeOut;
+		int nFlags;
+		int nFromLine;
+		uint8 nInstance;
+		CTimeValue startedAt;
+	};
+
 	CDialogPlayer* m_pDialogPlayer;
+	SRunningDialog m_runningDialog;
+	// client: instance of the dialog being played, reported back when it finishes
+	uint8 m_nPlayingInstance;
 };
 
 
@@ -36,7 +36,7 @@ IMPLEMENT_RMI(CHUDSynchronizer, ClDisplayOverlayMsg)
 	CHUD* pHud = g_pGame->GetHUD();
 	
 	if (pHud)
-		pHud->DisplayBigOverlayFlashMessage(params.sMsg, params.fDuration, params.nPosX, params.nPosY, params.vColor);
+		pHud->DisplayBigOverlayFlashMessage(CCoopSystem::GetInstance()->GetStringTable().Decode(params.msg), params.fDuration, params.nPosX, params.nPosY, params.vColor);
 
 	return true;
 }
@@ -2,6 +2,7 @@
 #define _HUDSynchronizer_H_
 
 #include <IGameObject.h>
+#include "Coop\CoopStringTable.h"
 
 class CHUDSynchronizer 
 	:	public CGameObjectExtensionHelper<CHUDSynchronizer, IGameObjectExtension>
@@ -14,16 +15,16 @@ public:
 	struct SHudOverlayParams
 	{
 		SHudOverlayParams() {};
-		SHudOverlayParams(int nPosX, int nPosY, string sMsg, float fDuration, Vec3 vColor) :
+		SHudOverlayParams(int nPosX, int nPosY, const CCoopStringTable::SNetString& msg, float fDuration, Vec3 vColor) :
 			nPosX(nPosX),
 			nPosY(nPosY),
-			sMsg(sMsg),
+			msg(msg),
 			fDuration(fDuration),
 			vColor(vColor)
 		{};
 		int nPosX;
 		int nPosY;
-		string sMsg;
+		CCoopStringTable::SNetString msg;
 		float fDuration;
 		Vec3 vColor;
 
@@ -31,7 +32,7 @@ public:
 		{
 			ser.Value("nPosX", nPosX);
 			ser.Value("nPosY", nPosY);
-			ser.Value("sMsg", sMsg);
+			msg.SerializeWith(ser);
 			ser.Value("fDuration", fDuration);
 			ser.Value("vColor", vColor);
 		}
@@ -5,6 +5,8 @@
 #include <IViewSystem.h>
 #include <IMovieSystem.h>
 
+#include "../CoopSystem.h"
+
 CSequenceSynchronizer::CSequenceSynchronizer() :
 	m_bInitialized(false)
 {
@@ -34,28 +36,104 @@ void CSequenceSynchronizer::Release()
 	delete this;
 }
 
+void CSequenceSynchronizer::PostInitClient(int channelId)
+{
+	if (!m_bInitialized || !gEnv->bServer) return;
+
+	PruneRunningSequences();
+	if (m_runningSequences.empty())
+		return;
+
+	// the text goes along with the index, see CCoopStringTable::Lookup
+
+	CCoopStringTable& stringTable = CCoopSystem::GetInstance()->GetStringTable();
+	IMovieSystem *pMovieSystem = gEnv->pMovieSystem;
+	const CTimeValue now = gEnv->pTimer->GetFrameStartTime();
+
+	SCatchUpParams params;
+	for (TRunningSequenceMap::const_iterator it = m_runningSequences.begin(); it != m_runningSequences.end(); ++it)
+	{
+		SCatchUpParams::SEntry entry;
+		entry.sequence = stringTable.Lookup(it->first.c_str());
+		entry.bBreakOnStop = it->second.bBreakOnStop;
+
+		// the server plays the sequence too, prefer its actual time. Sequences the
+		// server can't find are kept by the prune, their time is estimated
+		IAnimSequence* pSeq = pMovieSystem ? pMovieSystem->FindSequence(it->first.c_str()) : 0;
+		if (pSeq)
+			entry.fSeekTime = pMovieSystem->GetPlayingTime(pSeq);
+		else
+			entry.fSeekTime = it->second.fStartTime + (now - it->second.startedAt).GetSeconds();
+
+		params.entries.push_back(entry);
+	}
+
+	CryLogAlways("[CSequenceSynchronizer::PostInitClient] Catching up channel %d on %d sequences", channelId, (int)params.entries.size());
+
+	GetGameObject()->InvokeRMI(ClCatchUpSequences(), params, eRMI_ToClientChannel | eRMI_NoLocalCalls, channelId);
+}
+
+// Summary:
+//	Drops registry entries of sequences the server has stopped playing. Entries
+//	the server can't play itself stay until StopSeqeunce.
+void CSequenceSynchronizer::PruneRunningSequences()
+{
+	IMovieSystem *pMovieSystem = gEnv->pMovieSystem;
+	if (!pMovieSystem)
+		return;
+
+	TRunningSequenceMap::iterator it = m_runningSequences.begin();
+	while (it != m_runningSequences.end())
+	{
+		IAnimSequence* pSeq = pMovieSystem->FindSequence(it->first.c_str());
+		if (pSeq && !pMovieSystem->IsPlaying(pSeq))
+			m_runningSequences.erase(it++);
+		else
+			++it;
+	}
+}
+
 void CSequenceSynchronizer::PlaySequence(string sSequence, float fStartTime, bool bBreakOnStop)
 {
 	if (!m_bInitialized || !gEnv->bServer) return;
 
+	// a start burst for the same sequence within one frame only needs to go out once
+	const CTimeValue now = gEnv->pTimer->GetFrameStartTime();
+	TRunningSequenceMap::const_iterator running = m_runningSequences.find(sSequence);
+	if (running != m_runningSequences.end() && running->second.startedAt == now && running->second.fStartTime == fStartTime)
+		return;
+
+	SRunningSequence& entry = m_runningSequences[sSequence];
+	entry.fStartTime = fStartTime;
+	entry.bBreakOnStop = bBreakOnStop;
+	entry.startedAt = now;
+
 	CryLogAlways("[CSequenceSynchronizer::PlaySequence] %s", sSequence);
 
-	GetGameObject()->InvokeRMI(ClTrackviewSequence(), STrackviewSeqParams(true, sSequence, fStartTime, bBreakOnStop), eRMI_ToAllClients | eRMI_NoLocalCalls);
+	CCoopStringTable::SNetString sequence = CCoopSystem::GetInstance()->GetStringTable().Encode(sSequence.c_str());
+	GetGameObject()->InvokeRMI(ClTrackviewSequence(), STrackviewSeqParams(true, sequence, fStartTime, bBreakOnStop), eRMI_ToAllClients | eRMI_NoLocalCalls);
 }
 
 void CSequenceSynchronizer::StopSeqeunce(string sSequence, float fStartTime, bool bBreakOnStop)
 {
 	if (!m_bInitialized || !gEnv->bServer) return;
 
+	// stopping a sequence clients never started is not worth an RMI
+	TRunningSequenceMap::iterator running = m_runningSequences.find(sSequence);
+	if (running == m_runningSequences.end())
+		return;
+	m_runningSequences.erase(running);
+
 	CryLogAlways("[CSequenceSynchronizer::StopSequence] %s", sSequence);
 
-	GetGameObject()->InvokeRMI(ClTrackviewSequence(), STrackviewSeqParams(false, sSequence, fStartTime, bBreakOnStop), eRMI_ToAllClients | eRMI_NoLocalCalls);
+	CCoopStringTable::SNetString sequence = CCoopSystem::GetInstance()->GetStringTable().Encode(sSequence.c_str());
+	GetGameObject()->InvokeRMI(ClTrackviewSequence(), STrackviewSeqParams(false, sequence, fStartTime, bBreakOnStop), eRMI_ToAllClients | eRMI_NoLocalCalls);
 }
 
 IMPLEMENT_RMI(CSequenceSynchronizer, ClTrackviewSequence)
 {
 	bool bStart = params.bStart;
-	string sSequence = params.sSequence;
+	string sSequence = CCoopSystem::GetInstance()->GetStringTable().Decode(params.sequence);
 	float fStartTime = params.fStartTime;
 	bool bLeaveTime = params.bBreakOnStop;
 
@@ -63,25 +141,18 @@ IMPLEMENT_RMI(CSequenceSynchronizer, ClTrackviewSequence)
 
 	if (bStart)
 	{
-		IAnimSequence* pSeq = pMovieSystem->FindSequence(sSequence);
-
-		if (pSeq)
-		{
-			CryLogAlways("Client Started Sequence");
-			pMovieSystem->PlaySequence(pSeq, true);
-
-			if (fStartTime < pSeq->GetTimeRange().start)
-				fStartTime = pSeq->GetTimeRange().start;
-			else if (fStartTime > pSeq->GetTimeRange().end)
-				fStartTime = pSeq->GetTimeRange().end;
-
-			pMovieSystem->SetPlayingTime(pSeq, fStartTime);
-
-
-		}
+		StartLocalSequence(sSequence, fStartTime, bLeaveTime);
 	}
 	else
 	{
+		// stop the way it was started, a late joiner only got that from the catch-up
+		std::map<string, bool>::iterator local = m_localBreakOnStop.find(sSequence);
+		if (local != m_localBreakOnStop.end())
+		{
+			bLeaveTime = local->second;
+			m_localBreakOnStop.erase(local);
+		}
+
 		IAnimSequence* pSeq = pMovieSystem->FindSequence(sSequence);
 
 		if (pSeq)
@@ -96,4 +167,40 @@ IMPLEMENT_RMI(CSequenceSynchronizer, ClTrackviewSequence)
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+IMPLEMENT_RMI(CSequenceSynchronizer, ClCatchUpSequences)
+{
+	CCoopStringTable& stringTable = CCoopSystem::GetInstance()->GetStringTable();
+
+	for (int i = 0; i < (int)params.entries.size(); ++i)
+	{
+		const SCatchUpParams::SEntry& entry = params.entries[i];
+		StartLocalSequence(stringTable.Decode(entry.sequence), entry.fSeekTime, entry.bBreakOnStop);
+	}
+
+	return true;
+}
+
+// Summary:
+//	Starts the sequence on this client at the given time, remembering how it has to stop.
+void CSequenceSynchronizer::StartLocalSequence(const char* sSequence, float fTime, bool bBreakOnStop)
+{
+	IMovieSystem *pMovieSystem = gEnv->pMovieSystem;
+	IAnimSequence* pSeq = pMovieSystem->FindSequence(sSequence);
+
+	if (pSeq)
+	{
+		m_localBreakOnStop[sSequence] = bBreakOnStop;
+
+		CryLogAlways("Client Started Sequence");
+		pMovieSystem->PlaySequence(pSeq, true);
+
+		if (fTime < pSeq->GetTimeRange().start)
+			fTime = pSeq->GetTimeRange().start;
+		else if (fTime > pSeq->GetTimeRange().end)
+			fTime = pSeq->GetTimeRange().end;
+
+		pMovieSystem->SetPlayingTime(pSeq, fTime);
+	}
+}
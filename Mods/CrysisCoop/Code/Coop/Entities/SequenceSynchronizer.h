@@ -2,6 +2,7 @@
 #define _SequenceSynchronizer_H_
 
 #include <IGameObject.h>
+#include "Coop\CoopStringTable.h"
 
 class CSequenceSynchronizer 
 	:	public CGameObjectExtensionHelper<CSequenceSynchronizer, IGameObjectExtension>
@@ -13,28 +14,58 @@ public:
 	struct STrackviewSeqParams
 	{
 		STrackviewSeqParams() {};
-		STrackviewSeqParams(bool bStart, string sSequence, float fStartTime, bool bBreakOnStop) :
+		STrackviewSeqParams(bool bStart, const CCoopStringTable::SNetString& sequence, float fStartTime, bool bBreakOnStop) :
 			bStart(bStart),
-			sSequence(sSequence),
+			sequence(sequence),
 			fStartTime(fStartTime),
 			bBreakOnStop(bBreakOnStop)
 		{};
 
 		bool bStart;
-		string sSequence;
+		CCoopStringTable::SNetString sequence;
 		float fStartTime;
 		bool bBreakOnStop;
 
 		void SerializeWith(TSerialize ser)
 		{
 			ser.Value("bStart", bStart);
-			ser.Value("sSequence", sSequence);
+			sequence.SerializeWith(ser);
 			ser.Value("fStartTime", fStartTime);
 			ser.Value("bBreakOnStop", bBreakOnStop);
 		}
 	};
 
+	// Summary:
+	//	Sequences running on the server, sent once to a client joining mid-cinematic.
+	struct SCatchUpParams
+	{
+		struct SEntry
+		{
+			CCoopStringTable::SNetString sequence;
+			float fSeekTime;
+			bool bBreakOnStop;
+		};
+
+		std::vector<SEntry> entries;
+
+		void SerializeWith(TSerialize ser)
+		{
+			uint8 nCount = (uint8)entries.size();
+			ser.Value("nCount", nCount, 'ui8');
+			if (ser.IsReading())
+				entries.resize(nCount);
+
+			for (int i = 0; i < nCount; ++i)
+			{
+				entries[i].sequence.SerializeWith(ser);
+				ser.Value("fSeekTime", entries[i].fSeekTime);
+				ser.Value("bBreakOnStop", entries[i].bBreakOnStop, 'bool');
+			}
+		}
+	};
+
 	DECLARE_CLIENT_RMI_NOATTACH(ClTrackviewSequence, STrackviewSeqParams, eNRT_ReliableOrdered);
+	DECLARE_CLIENT_RMI_NOATTACH(ClCatchUpSequences, SCatchUpParams, eNRT_ReliableOrdered);
 
 public:
 	void PlaySequence(string sSequence, float fStartTime, bool bBreakOnStop);
@@ -45,7 +76,7 @@ public:
 	virtual bool Init(IGameObject *pGameObject);
 	virtual void InitClient(int channelId) {};
 	virtual void PostInit(IGameObject *pGameObject);
-	virtual void PostInitClient(int channelId) {};
+	virtual void PostInitClient(int channelId);
 	virtual void Release();
 	virtual void FullSerialize(TSerialize ser) { };
 	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags) { return true; };
@@ -63,6 +94,29 @@ public:
 	//~IGameObjectExtension
 
 protected:
+	// Summary:
+	//	Starts the sequence on this client at the given time, remembering how it has to stop.
+	void StartLocalSequence(const char* sSequence, float fTime, bool bBreakOnStop);
+
+	// Summary:
+	//	Drops registry entries of sequences the server has stopped playing. Entries
+	//	the server can't play itself stay until StopSeqeunce.
+	void PruneRunningSequences();
+
+	// Summary:
+	//	Server side record of a started sequence.
+	struct SRunningSequence
+	{
+		float fStartTime;
+		bool bBreakOnStop;
+		CTimeValue startedAt;
+	};
+
+	typedef std::map<string, SRunningSequence> TRunningSequenceMap;
+
+	TRunningSequenceMap m_runningSequences;
+	// client: BreakOnStop of the sequences started through this synchronizer, also the caught up ones
+	std::map<string, bool> m_localBreakOnStop;
 	bool m_bInitialized;
 };
 
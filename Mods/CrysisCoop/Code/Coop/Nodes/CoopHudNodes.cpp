@@ -3,6 +3,7 @@
 
 #include "IGameObject.h"
 #include "Coop/Entities/HUDSynchronizer.h"
+#include "Coop/CoopSystem.h"
 #include "HUD/HUD.h"
 #include "GameCVars.h"
 
@@ -112,7 +113,7 @@ public:
 			const Vec3 vColor = GetPortVec3(pActInfo, EIP_Color);
 
 			if (gEnv->bServer)
-				m_pHudSynchronizer->GetGameObject()->InvokeRMI(CHUDSynchronizer::ClDisplayOverlayMsg(), CHUDSynchronizer::SHudOverlayParams(nPosX, nPosY, sMsg, fDuration, vColor), eRMI_ToAllClients);
+				m_pHudSynchronizer->GetGameObject()->InvokeRMI(CHUDSynchronizer::ClDisplayOverlayMsg(), CHUDSynchronizer::SHudOverlayParams(nPosX, nPosY, CCoopSystem::GetInstance()->GetStringTable().Encode(sMsg.c_str()), fDuration, vColor), eRMI_ToAllClients);
 				
 		}
 		else if (IsPortActive(pActInfo, EIP_Hide))
@@ -25,6 +25,7 @@
 #include "WeaponSystem.h"
 
 #include <ICryPak.h>
+#include <FrameArena.h>
 #include <CryPath.h>
 #include <IActionMapManager.h>
 #include <IViewSystem.h>
@@ -53,6 +54,8 @@
 #include "ClientSynchedStorage.h"
 
 #include "SPAnalyst.h"
+#include "ProfileCapture.h"
+#include "JobManager.h"
 
 #include "ISaveGame.h"
 #include "ILoadGame.h"
@@ -105,6 +108,8 @@ CGame::CGame()
 	m_pClientSynchedStorage(0),
 	m_uiPlayerID(-1),
 	m_pSPAnalyst(0),
+	m_pProfileCapture(0),
+	m_pJobManager(0),
 	m_pLaptopUtil(0)
 {
 	m_pCVars = new SCVars();
@@ -135,6 +140,8 @@ CGame::~CGame()
 	SAFE_DELETE(m_pSoundMoods);
 	SAFE_DELETE(m_pHUD);
 	SAFE_DELETE(m_pSPAnalyst);
+	SAFE_DELETE(m_pProfileCapture);
+	SAFE_DELETE(m_pJobManager);
 	m_pWeaponSystem->Release();
 	SAFE_DELETE(m_pItemStrings);
 	SAFE_DELETE(m_pItemSharedParamsList);
@@ -198,6 +205,9 @@ bool CGame::Init(IGameFramework *pFramework)
 	m_pOptionsManager = COptionsManager::CreateOptionsManager();
 
 	m_pSPAnalyst = new CSPAnalyst();
+	m_pProfileCapture = new CProfileCapture();
+	m_pJobManager = new CJobManager();
+	m_pJobManager->SetWorkerCount(m_pCVars->g_jobThreads);
  
 	gEnv->pConsole->CreateKeyBind("f12", "r_getscreenshot 2");
 
@@ -401,6 +411,11 @@ bool CGame::CompleteInit()
 
 int CGame::Update(bool haveFocus, unsigned int updateFlags)
 {
+	// frame boundary, the scratch containers of the last frame are gone by now
+	stl::FrameArena::Get().Reset();
+	if (m_pProfileCapture)
+		m_pProfileCapture->Update();
+
 	bool bRun = m_pFramework->PreUpdate( true, updateFlags );
 	float frameTime = gEnv->pTimer->GetFrameTime();
 
@@ -59,6 +59,8 @@ struct SCVars;
 struct SItemStrings;
 class CItemSharedParamsList;
 class CSPAnalyst;
+class CProfileCapture;
+class CJobManager;
 class CSoundMoods;
 class CLaptopUtil;
 class CLCDWrapper;
@@ -182,6 +184,8 @@ public:
 	}
 
 	CSPAnalyst* GetSPAnalyst() const { return m_pSPAnalyst; }
+	CProfileCapture* GetProfileCapture() const { return m_pProfileCapture; }
+	CJobManager* GetJobManager() const { return m_pJobManager; }
 
 	const string& GetLastSaveGame(string &levelName);
 	const string& GetLastSaveGame() { string tmp; return GetLastSaveGame(tmp); }
@@ -223,6 +227,30 @@ protected:
 	static void CmdSay(IConsoleCmdArgs *pArgs);
 	static void CmdReloadItems(IConsoleCmdArgs *pArgs);
 	static void CmdLoadActionmap(IConsoleCmdArgs *pArgs);
+	static void CmdConvertGameplayRecord(IConsoleCmdArgs *pArgs);
+	static void CmdLockContention(IConsoleCmdArgs *pArgs);
+	static void CmdFrameArenaStats(IConsoleCmdArgs *pArgs);
+	static void CmdProfileCapture(IConsoleCmdArgs *pArgs);
+	static void CmdProfileCaptureStop(IConsoleCmdArgs *pArgs);
+	static void CmdConvertXmlToBinary(IConsoleCmdArgs *pArgs);
+	// tests and benchmarks, not in release builds
+#if !defined(_RELEASE)
+	static void CmdEntityScheduleBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdSuitEnergyNetBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdShotgunBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdAimAssistBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdObjectivesBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdLockStressTest(IConsoleCmdArgs *pArgs);
+	static void CmdPipeTest(IConsoleCmdArgs *pArgs);
+	static void CmdFrameArenaBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdProfileCaptureTest(IConsoleCmdArgs *pArgs);
+	static void CmdGeoBatchTest(IConsoleCmdArgs *pArgs);
+	static void CmdNameTableTest(IConsoleCmdArgs *pArgs);
+	static void CmdJobSystemTest(IConsoleCmdArgs *pArgs);
+	static void CmdBinaryXmlBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdStructSerializerBenchmark(IConsoleCmdArgs *pArgs);
+	static void CmdShotRandomTest(IConsoleCmdArgs *pArgs);
+#endif
   static void CmdReloadGameRules(IConsoleCmdArgs *pArgs);
   static void CmdNextLevel(IConsoleCmdArgs* pArgs);
   static void CmdStartKickVoting(IConsoleCmdArgs* pArgs);
@@ -267,6 +295,8 @@ protected:
 	CServerSynchedStorage	*m_pServerSynchedStorage;
 	CClientSynchedStorage	*m_pClientSynchedStorage;
 	CSPAnalyst          *m_pSPAnalyst;
+	CProfileCapture     *m_pProfileCapture;
+	CJobManager         *m_pJobManager;
 	bool								m_inDevMode;
 
 	EntityId m_uiPlayerID;
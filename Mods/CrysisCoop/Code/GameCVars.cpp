@@ -16,6 +16,7 @@
 #include "ItemSharedParams.h"
 
 #include <INetwork.h>
+#include <ICryPak.h>
 #include <IGameObject.h>
 #include <IActorSystem.h>
 #include <IItemSystem.h>
@@ -26,6 +27,26 @@
 #include "Menus/QuickGame.h"
 #include "Environment/BattleDust.h"
 #include "NetInputChainDebug.h"
+#include "GameplayRecordStream.h"
+#include "Shotgun.h"
+#include "LockDiagnostics.h"
+#include "ProfileCapture.h"
+#include "JobManager.h"
+#include "XMLBinaryDocument.h"
+#include "StructSerializer.h"
+#include "ShotRandom.h"
+
+#if !defined(_RELEASE)
+#define PIPE_TEST_SUITE
+#define GEO_BATCH_TEST_SUITE
+#define CRY_NAME_TEST_SUITE
+#endif
+#include <Pipe.h>
+#include <Cry_GeoIntersectBatch.h>
+#include <CryName.h>
+#include <STLFrameArenaAllocator.h>
+#include <STLPoolAllocator.h>
+#include <list>
 
 #include "Menus/FlashMenuObject.h"
 #include "Menus/MPHub.h"
@@ -44,6 +65,12 @@ static void BroadcastChangeSafeMode( ICVar * )
 	}
 }
 
+static void ChangeJobThreads( ICVar *pVar )
+{
+	if (g_pGame && g_pGame->GetJobManager())
+		g_pGame->GetJobManager()->SetWorkerCount(pVar->GetIVal());
+}
+
 void CmdBulletTimeMode( IConsoleCmdArgs* cmdArgs)
 {
 	g_pGameCVars->goc_enable = 0;
@@ -139,6 +166,7 @@ void SCVars::InitCVars(IConsole *pConsole)
 	pConsole->Register("i_offset_up", &i_offset_up, 0.0f, 0, "Item position up offset");
 	pConsole->Register("i_offset_right", &i_offset_right, 0.0f, 0, "Item position right offset");
 	pConsole->Register("i_unlimitedammo", &i_unlimitedammo, 0, VF_CHEAT, "unlimited ammo");
+	pConsole->Register("i_shotgunBatchedPellets", &i_shotgunBatchedPellets, 0, 0, "Trace the pellets of all shotguns as one batch instead of spawning a projectile per pellet (otherwise the shotgun 'batched' param decides)");
 	pConsole->Register("i_iceeffects", &i_iceeffects, 0, VF_CHEAT, "Enable/Disable specific weapon effects for ice environments");
 
 	pConsole->Register("i_lighteffectShadows", &i_lighteffectsShadows, 0, VF_DUMPTODISK, "Enable/Disable shadow casting on weapon lights. 1 - Player only, 2 - Other players/AI, 3 - All (require i_lighteffects enabled).");
@@ -213,6 +241,8 @@ void SCVars::InitCVars(IConsole *pConsole)
 	pConsole->Register("g_suitSpeedEnergyConsumption", &g_suitSpeedEnergyConsumption, 110.0f, 0, "Energy reduction in speed mode per second.");
 	pConsole->Register("g_suitSpeedEnergyConsumptionMultiplayer", &g_suitSpeedEnergyConsumptionMultiplayer, 50.0f, 0, "Energy reduction in speed mode per second in multiplayer.");
 	pConsole->Register("g_suitCloakEnergyDrainAdjuster", &g_suitCloakEnergyDrainAdjuster, 1.0f, 0, "Multiplier for energy reduction in cloak mode.");
+	pConsole->Register("g_suitEnergyNetThreshold", &g_suitEnergyNetThreshold, 4.0f, 0, "Suit energy error (out of 200) tolerated in the client prediction before the server sends an update.");
+	pConsole->Register("g_suitEnergyNetDebug", &g_suitEnergyNetDebug, 0, 0, "Logs suit energy changes versus network updates sent every 5 seconds.");
 	pConsole->Register("g_mpSpeedRechargeDelay", &g_mpSpeedRechargeDelay, 1, VF_CHEAT, "Toggles delay when sprinting below 20% energy.");
 	pConsole->Register("g_AiSuitEnergyRechargeTime", &g_AiSuitEnergyRechargeTime, 10.0f, VF_CHEAT, "Modify suit energy recharge for AI.");
 	pConsole->Register("g_AiSuitStrengthMeleeMult", &g_AiSuitStrengthMeleeMult, 0.4f, VF_CHEAT, "Modify AI strength mode melee damage relative to player damage.");
@@ -326,6 +356,7 @@ void SCVars::InitCVars(IConsole *pConsole)
 
 	pConsole->Register("g_spRecordGameplay", &g_spRecordGameplay, 0, 0, "Write sp gameplay information to harddrive.");
 	pConsole->Register("g_spGameplayRecorderUpdateRate", &g_spGameplayRecorderUpdateRate, 1.0f, 0, "Update-delta of gameplay recorder in seconds.");
+	pConsole->Register("g_jobThreads", &g_jobThreads, 0, 0, "Task threads that run game jobs (0..4), with 0 the waiting thread runs them. Idle workers still wake up every few ms on their task thread, so only raise it for systems that use jobs.", ChangeJobThreads);
   
 	pConsole->Register("pl_debug_ladders", &pl_debug_ladders, 0, VF_CHEAT);
 	pConsole->Register("pl_debug_movement", &pl_debug_movement, 0, VF_CHEAT);
@@ -414,6 +445,10 @@ void SCVars::InitCVars(IConsole *pConsole)
 	//movement cvars
   pConsole->Register("v_profileMovement", &v_profileMovement, 0, 0, "Used to enable profiling of the current vehicle movement (1 to enable)");    
   pConsole->Register("v_pa_surface", &v_pa_surface, 1, VF_CHEAT, "Enables/disables vehicle surface particles");
+  pConsole->Register("v_effectsLODNear", &v_effectsLODNear, 50.f, 0, "Distance from the viewer up to which vehicle effects update every frame (0 disables effect LOD)");
+  pConsole->Register("v_effectsLODFar", &v_effectsLODFar, 150.f, 0, "Distance from the viewer beyond which vehicle wind and effects update at a low rate");
+  pConsole->Register("v_effectsLODCull", &v_effectsLODCull, 300.f, 0, "Distance from the viewer beyond which vehicle surface effects are not updated");
+  pConsole->Register("v_debugEffectsLOD", &v_debugEffectsLOD, 0, 0, "Displays the effect LOD tier and effect update time per vehicle");
   pConsole->Register("v_wind_minspeed", &v_wind_minspeed, 0.f, VF_CHEAT, "If non-zero, vehicle wind areas always set wind >= specified value");
   pConsole->Register("v_draw_suspension", &v_draw_suspension, 0, VF_DUMPTODISK, "Enables/disables display of wheel suspension, for the vehicle that has v_profileMovement enabled");
   pConsole->Register("v_draw_slip", &v_draw_slip, 0, VF_DUMPTODISK, "Draw wheel slip status");  
@@ -588,6 +623,7 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("i_offset_up", true);
 	pConsole->UnregisterVariable("i_offset_right", true);
 	pConsole->UnregisterVariable("i_unlimitedammo", true);
+	pConsole->UnregisterVariable("i_shotgunBatchedPellets", true);
 	pConsole->UnregisterVariable("i_iceeffects", true);
 
 	pConsole->UnregisterVariable("cl_strengthscale", true);
@@ -643,6 +679,8 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("g_suitArmorHealthValue", true);
 	pConsole->UnregisterVariable("g_suitSpeedEnergyConsumption", true);
 	pConsole->UnregisterVariable("g_suitSpeedEnergyConsumptionMultiplayer", true);
+	pConsole->UnregisterVariable("g_suitEnergyNetThreshold", true);
+	pConsole->UnregisterVariable("g_suitEnergyNetDebug", true);
 
 	pConsole->UnregisterVariable("g_AiSuitEnergyRechargeTime", true);
 	pConsole->UnregisterVariable("g_AiSuitHealthRechargeTime", true);
@@ -704,6 +742,10 @@ void SCVars::ReleaseCVars()
 
 	pConsole->UnregisterVariable("v_profileMovement", true);    
 	pConsole->UnregisterVariable("v_pa_surface", true);
+	pConsole->UnregisterVariable("v_effectsLODNear", true);
+	pConsole->UnregisterVariable("v_effectsLODFar", true);
+	pConsole->UnregisterVariable("v_effectsLODCull", true);
+	pConsole->UnregisterVariable("v_debugEffectsLOD", true);
 	pConsole->UnregisterVariable("v_wind_minspeed", true);
 	pConsole->UnregisterVariable("v_draw_suspension", true);
 	pConsole->UnregisterVariable("v_draw_slip", true);  
@@ -859,6 +901,7 @@ void SCVars::ReleaseCVars()
 	pConsole->UnregisterVariable("g_claymore_limit", true);
 	pConsole->UnregisterVariable("g_avmine_limit", true);
 	pConsole->UnregisterVariable("g_debugMines", true);
+	pConsole->UnregisterVariable("g_jobThreads", true);
 
  pConsole->UnregisterVariable("aim_assistCrosshairSize", true);
   pConsole->UnregisterVariable("aim_assistCrosshairDebug", true);
@@ -914,6 +957,29 @@ void CGame::RegisterConsoleCommands()
 
 	m_pConsole->AddCommand("dumpss", CmdDumpSS, 0, "test synched storage.");
 	m_pConsole->AddCommand("dumpnt", CmdDumpItemNameTable, 0, "Dump ItemString table.");
+	m_pConsole->AddCommand("g_spConvertGameplayRecord", CmdConvertGameplayRecord, 0, "Converts a binary gameplay record (.gpr) to Excel-XML. Usage: g_spConvertGameplayRecord <file.gpr> [file.xml]");
+	m_pConsole->AddCommand("g_lockContention", CmdLockContention, VF_CHEAT, "Dumps the spin lock contention table of the game module (Profile builds). Usage: g_lockContention [reset]");
+	m_pConsole->AddCommand("g_frameArenaStats", CmdFrameArenaStats, 0, "Shows the usage of the main thread frame arena.");
+	m_pConsole->AddCommand("g_profileCapture", CmdProfileCapture, 0, "Records the profiler sections of the game module for some frames and writes them as Chrome trace JSON and binary capture. Usage: g_profileCapture [frames] [file]");
+	m_pConsole->AddCommand("g_profileCaptureStop", CmdProfileCaptureStop, 0, "Stops a running g_profileCapture and writes the frames captured so far.");
+	m_pConsole->AddCommand("g_convertXmlToBinary", CmdConvertXmlToBinary, 0, "Converts an XML file, or every XML file below a folder, to binary XML. Usage: g_convertXmlToBinary <file|folder> [outFolder]");
+#if !defined(_RELEASE)
+	m_pConsole->AddCommand("g_entityScheduleBenchmark", CmdEntityScheduleBenchmark, VF_CHEAT, "Schedules respawns and removals of fresh entities and times the scheduler against a walk over all schedules. Usage: g_entityScheduleBenchmark [count] [frames]");
+	m_pConsole->AddCommand("g_suitEnergyNetBenchmark", CmdSuitEnergyNetBenchmark, VF_CHEAT, "Runs a scripted suit energy curve through the old and new energy aspect send policies and logs bytes per second. Usage: g_suitEnergyNetBenchmark [seconds] [fps] [packetsPerSecond]");
+	m_pConsole->AddCommand("i_shotgunBenchmark", CmdShotgunBenchmark, VF_CHEAT, "Shoots the player's shotgun with projectiles and with traced pellets and logs the frame time of both. Usage: i_shotgunBenchmark [shots] [framesPerShot]");
+	m_pConsole->AddCommand("aim_assistBenchmark", CmdAimAssistBenchmark, VF_CHEAT, "Times the aim assistance candidate test. Usage: aim_assistBenchmark [candidates] [segments]");
+	m_pConsole->AddCommand("hud_objectivesBenchmark", CmdObjectivesBenchmark, VF_CHEAT, "Loads a mission objectives file and times objective id lookups. Usage: hud_objectivesBenchmark [file] [lookups]");
+	m_pConsole->AddCommand("g_lockStressTest", CmdLockStressTest, VF_CHEAT, "Runs reader and writer threads against one spin lock and checks mutual exclusion. Usage: g_lockStressTest [readers] [writers] [seconds]");
+	m_pConsole->AddCommand("g_frameArenaBenchmark", CmdFrameArenaBenchmark, VF_CHEAT, "Times scratch containers on the default allocator, stl::PoolAllocator and the frame arena. Usage: g_frameArenaBenchmark [frames]");
+	m_pConsole->AddCommand("g_pipeTest", CmdPipeTest, VF_CHEAT, "Checks ordering and measures the throughput of Pipe and MultiProducerPipe with single and range operations. Usage: g_pipeTest [items] [producers]");
+	m_pConsole->AddCommand("g_profileCaptureTest", CmdProfileCaptureTest, VF_CHEAT, "Profiles a nested workload on several threads and checks the capture and its exports.");
+	m_pConsole->AddCommand("g_geoBatchTest", CmdGeoBatchTest, VF_CHEAT, "Checks the batched ray and lineseg tests against AABBs and spheres against the scalar ones and times both. Usage: g_geoBatchTest [shapes] [linesegs]");
+	m_pConsole->AddCommand("g_nameTableTest", CmdNameTableTest, VF_CHEAT, "Creates and drops CCryNames from several threads and checks the name table, then times it against the previous table. Usage: g_nameTableTest [threads] [iterations]");
+	m_pConsole->AddCommand("g_jobSystemTest", CmdJobSystemTest, VF_CHEAT, "Checks job groups, dependencies, nested waits and parallel-for of the game job manager, then times a parallel-for. Usage: g_jobSystemTest [iterations] [elements]");
+	m_pConsole->AddCommand("g_binaryXmlBenchmark", CmdBinaryXmlBenchmark, VF_CHEAT, "Converts every XML file below a folder to binary XML, checks both forms read the same and times loading them. Usage: g_binaryXmlBenchmark [folder] [binaryFolder]");
+	m_pConsole->AddCommand("g_structSerializerBenchmark", CmdStructSerializerBenchmark, VF_CHEAT, "Checks that the field list serializers and SerializeWith of weapon RMI parameters agree and times them. Usage: g_structSerializerBenchmark [count]");
+	m_pConsole->AddCommand("g_shotRandomTest", CmdShotRandomTest, VF_CHEAT, "Runs the known answer and statistical tests of the per-shot random numbers and times them against CMTRand_int32. Usage: g_shotRandomTest [samples]");
+#endif
 
   m_pConsole->AddCommand("g_reloadGameRules", CmdReloadGameRules, 0, "Reload GameRules script");
   m_pConsole->AddCommand("g_quickGame", CmdQuickGame, 0, "Quick connect to good server.");
@@ -954,6 +1020,29 @@ void CGame::UnregisterConsoleCommands()
 	m_pConsole->RemoveCommand("i_reload");
 
 	m_pConsole->RemoveCommand("dumpss");
+	m_pConsole->RemoveCommand("g_spConvertGameplayRecord");
+	m_pConsole->RemoveCommand("g_lockContention");
+	m_pConsole->RemoveCommand("g_profileCapture");
+	m_pConsole->RemoveCommand("g_profileCaptureStop");
+	m_pConsole->RemoveCommand("g_convertXmlToBinary");
+	m_pConsole->RemoveCommand("g_frameArenaStats");
+#if !defined(_RELEASE)
+	m_pConsole->RemoveCommand("g_entityScheduleBenchmark");
+	m_pConsole->RemoveCommand("g_suitEnergyNetBenchmark");
+	m_pConsole->RemoveCommand("i_shotgunBenchmark");
+	m_pConsole->RemoveCommand("aim_assistBenchmark");
+	m_pConsole->RemoveCommand("hud_objectivesBenchmark");
+	m_pConsole->RemoveCommand("g_lockStressTest");
+	m_pConsole->RemoveCommand("g_pipeTest");
+	m_pConsole->RemoveCommand("g_profileCaptureTest");
+	m_pConsole->RemoveCommand("g_geoBatchTest");
+	m_pConsole->RemoveCommand("g_nameTableTest");
+	m_pConsole->RemoveCommand("g_jobSystemTest");
+	m_pConsole->RemoveCommand("g_binaryXmlBenchmark");
+	m_pConsole->RemoveCommand("g_structSerializerBenchmark");
+	m_pConsole->RemoveCommand("g_shotRandomTest");
+	m_pConsole->RemoveCommand("g_frameArenaBenchmark");
+#endif
 
 	m_pConsole->RemoveCommand("g_reloadGameRules");
   m_pConsole->RemoveCommand("g_quickGame");
@@ -1150,6 +1239,547 @@ void CGame::CmdLoadActionmap(IConsoleCmdArgs *pArgs)
 		g_pGame->LoadActionMaps(pArgs->GetArg(1));
 }
 
+//------------------------------------------------------------------------
+void CGame::CmdConvertGameplayRecord(IConsoleCmdArgs *pArgs)
+{
+	if (pArgs->GetArgCount() < 2)
+	{
+		GameWarning("Usage: g_spConvertGameplayRecord <file.gpr> [file.xml]");
+		return;
+	}
+
+	string xmlFile;
+	if (pArgs->GetArgCount() > 2)
+		xmlFile = pArgs->GetArg(2);
+	else
+		xmlFile = PathUtil::ReplaceExtension(pArgs->GetArg(1), "xml");
+
+	if (CGameplayRecordStream::ConvertToXML(pArgs->GetArg(1), xmlFile.c_str()))
+		CryLogAlways("Converted gameplay record %s to %s", pArgs->GetArg(1), xmlFile.c_str());
+	else
+		GameWarning("Failed to convert gameplay record %s", pArgs->GetArg(1));
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdLockContention(IConsoleCmdArgs *pArgs)
+{
+	const bool reset = pArgs->GetArgCount() > 1 && !stricmp(pArgs->GetArg(1), "reset");
+	CLockDiagnostics::DumpContention(reset);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdFrameArenaStats(IConsoleCmdArgs *pArgs)
+{
+	const stl::FrameArena &arena = stl::FrameArena::Get();
+	CryLogAlways("[FrameArena] frame %d: %d bytes used, high water mark %d, capacity %d, %d overflows",
+		arena.GetFrameId(), (int)arena.GetUsed(), (int)arena.GetHighWaterMark(), (int)arena.GetCapacity(), arena.GetOverflowCount());
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdProfileCapture(IConsoleCmdArgs *pArgs)
+{
+	int frames = 100;
+	const char *fileName = "profile_capture";
+	if (pArgs->GetArgCount() > 1)
+		frames = CLAMP(atoi(pArgs->GetArg(1)), 1, 10000);
+	if (pArgs->GetArgCount() > 2)
+		fileName = pArgs->GetArg(2);
+
+	g_pGame->GetProfileCapture()->Start(frames, fileName);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdProfileCaptureStop(IConsoleCmdArgs *pArgs)
+{
+	g_pGame->GetProfileCapture()->Stop();
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdConvertXmlToBinary(IConsoleCmdArgs *pArgs)
+{
+	if (pArgs->GetArgCount() < 2)
+	{
+		GameWarning("Usage: g_convertXmlToBinary <file|folder> [outFolder]");
+		return;
+	}
+
+	const string source = PathUtil::RemoveSlash(pArgs->GetArg(1));
+	const string outFolder = PathUtil::RemoveSlash(pArgs->GetArgCount() > 2 ? pArgs->GetArg(2) : "%USER%/BinaryXml");
+
+	if (!stricmp(PathUtil::GetExt(source.c_str()), "xml"))
+	{
+		if (CXMLBinaryDocument::ConvertFile(source.c_str(), (outFolder + "/" + source).c_str()))
+			CryLogAlways("[XMLBinary] Converted '%s' to '%s/%s'", source.c_str(), outFolder.c_str(), source.c_str());
+		return;
+	}
+
+	std::vector<string> files;
+	size_t totalSize = 0;
+	CXMLBinaryDocument::FindXmlFiles(source, files, totalSize);
+
+	int converted = 0, failed = 0;
+	for (std::vector<string>::const_iterator it = files.begin(); it != files.end(); ++it)
+	{
+		if (CXMLBinaryDocument::ConvertFile(it->c_str(), (outFolder + "/" + *it).c_str()))
+			++converted;
+		else
+			++failed;
+	}
+
+	CryLogAlways("[XMLBinary] Converted %d files below '%s' to '%s', %d failed", converted, source.c_str(), outFolder.c_str(), failed);
+}
+
+#if !defined(_RELEASE)
+//------------------------------------------------------------------------
+void CGame::CmdEntityScheduleBenchmark(IConsoleCmdArgs *pArgs)
+{
+	CGameRules *pGameRules = g_pGame->GetGameRules();
+	if (!pGameRules)
+	{
+		GameWarning("[EntitySchedules] No game rules");
+		return;
+	}
+
+	int count = 2000;
+	int frames = 300;
+	if (pArgs->GetArgCount() > 1)
+		count = max(1, atoi(pArgs->GetArg(1)));
+	if (pArgs->GetArgCount() > 2)
+		frames = max(1, atoi(pArgs->GetArg(2)));
+
+	pGameRules->BenchmarkEntitySchedules(count, frames);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdSuitEnergyNetBenchmark(IConsoleCmdArgs *pArgs)
+{
+	int seconds = 120;
+	int fps = 60;
+	int sendRate = 30;
+	if (pArgs->GetArgCount() > 1)
+		seconds = max(1, atoi(pArgs->GetArg(1)));
+	if (pArgs->GetArgCount() > 2)
+		fps = max(1, atoi(pArgs->GetArg(2)));
+	if (pArgs->GetArgCount() > 3)
+		sendRate = max(1, atoi(pArgs->GetArg(3)));
+
+	CNanoSuit::BenchmarkNetEnergy((float)seconds, fps, sendRate);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdShotgunBenchmark(IConsoleCmdArgs *pArgs)
+{
+	int shots = 20;
+	int interval = 10;
+	if (pArgs->GetArgCount() > 1)
+		shots = max(1, atoi(pArgs->GetArg(1)));
+	if (pArgs->GetArgCount() > 2)
+		interval = max(1, atoi(pArgs->GetArg(2)));
+
+	CActor *pActor = static_cast<CActor *>(g_pGame->GetIGameFramework()->GetClientActor());
+	CWeapon *pWeapon = pActor ? pActor->GetWeapon(pActor->GetCurrentItemId()) : 0;
+	IFireMode *pFireMode = pWeapon ? pWeapon->GetFireMode(pWeapon->GetCurrentFireMode()) : 0;
+	if (!pFireMode || stricmp(pFireMode->GetType(), "Shotgun"))
+	{
+		GameWarning("i_shotgunBenchmark needs the player to hold a weapon in a shotgun fire mode");
+		return;
+	}
+
+	CShotgun::RequestBenchmark(pWeapon->GetEntityId(), shots, interval);
+	pWeapon->RequireUpdate(eIUS_FireMode);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdAimAssistBenchmark(IConsoleCmdArgs *pArgs)
+{
+	int count = 200;
+	int iterations = 100000;
+	if (pArgs->GetArgCount() > 1)
+		count = max(1, atoi(pArgs->GetArg(1)));
+	if (pArgs->GetArgCount() > 2)
+		iterations = max(1, atoi(pArgs->GetArg(2)));
+
+	CAimAssistCandidates::Benchmark(count, iterations);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdObjectivesBenchmark(IConsoleCmdArgs *pArgs)
+{
+	string filename;
+	int iterations = 100000;
+	if (pArgs->GetArgCount() > 1)
+		filename = pArgs->GetArg(1);
+	else if (!CHUDMissionObjectiveSystem::GetLevelObjectivesFile(filename))
+		filename = "Libs/UI/Objectives_Coop.xml";
+	if (pArgs->GetArgCount() > 2)
+		iterations = max(1, atoi(pArgs->GetArg(2)));
+
+	CHUDMissionObjectiveSystem::Benchmark(filename.c_str(), iterations);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdLockStressTest(IConsoleCmdArgs *pArgs)
+{
+	int readers = 4;
+	int writers = 2;
+	float seconds = 2.0f;
+	if (pArgs->GetArgCount() > 1)
+		readers = CLAMP(atoi(pArgs->GetArg(1)), 0, 32);
+	if (pArgs->GetArgCount() > 2)
+		writers = CLAMP(atoi(pArgs->GetArg(2)), 0, 32);
+	if (pArgs->GetArgCount() > 3)
+		seconds = CLAMP((float)atof(pArgs->GetArg(3)), 0.1f, 60.0f);
+
+	if (!CLockDiagnostics::StressTest(readers, writers, seconds))
+		GameWarning("[LockStressTest] Spin lock stress test failed");
+}
+
+namespace
+{
+	// what a typical per frame HUD or weapon path does with its scratch containers
+	template <class VA, class LA, class MA>
+	int FrameArenaBenchmarkFrame(const VA &vectorAlloc, const LA &listAlloc, const MA &mapAlloc)
+	{
+		std::vector<int, VA> values(vectorAlloc);
+		std::list<int, LA> nodes(listAlloc);
+		std::map<int, int, std::less<int>, MA> lookup(std::less<int>(), mapAlloc);
+
+		for (int i=0; i<256; ++i)
+			values.push_back(i*7);
+		for (int i=0; i<64; ++i)
+			nodes.push_back(values[i]);
+		for (int i=0; i<32; ++i)
+			lookup[values[i*3]] = i;
+
+		int checksum = 0;
+		for (typename std::list<int, LA>::const_iterator it=nodes.begin(); it!=nodes.end(); ++it)
+			checksum += *it;
+		for (typename std::map<int, int, std::less<int>, MA>::const_iterator it=lookup.begin(); it!=lookup.end(); ++it)
+			checksum += it->second;
+		return checksum;
+	}
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdFrameArenaBenchmark(IConsoleCmdArgs *pArgs)
+{
+	int frames = 20000;
+	if (pArgs->GetArgCount() > 1)
+		frames = max(1, atoi(pArgs->GetArg(1)));
+
+	typedef std::pair<const int, int> TMapValue;
+	int checksums[3] = {0, 0, 0};
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<frames; ++n)
+		checksums[0] += FrameArenaBenchmarkFrame(std::allocator<int>(), std::allocator<int>(), std::allocator<TMapValue>());
+	const float defaultTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	// the pool only serves node containers, the vector stays on the default allocator
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<frames; ++n)
+		checksums[1] += FrameArenaBenchmarkFrame(std::allocator<int>(), stl::STLPoolAllocator<int>(), stl::STLPoolAllocator<TMapValue>());
+	const float poolTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	stl::FrameArena arena;
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<frames; ++n)
+	{
+		checksums[2] += FrameArenaBenchmarkFrame(stl::FrameArenaAllocator<int>(arena), stl::FrameArenaAllocator<int>(arena), stl::FrameArenaAllocator<TMapValue>(arena));
+		arena.Reset();
+	}
+	const float arenaTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	CryLogAlways("[FrameArena] %d frames: default %.3fms, pool %.3fms, arena %.3fms (high water mark %d bytes)",
+		frames, defaultTime, poolTime, arenaTime, (int)arena.GetHighWaterMark());
+
+	if (checksums[0] != checksums[1] || checksums[0] != checksums[2])
+		GameWarning("[FrameArena] Allocators disagree on the benchmark results");
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdPipeTest(IConsoleCmdArgs *pArgs)
+{
+	int items = 1000000;
+	int producers = 4;
+	if (pArgs->GetArgCount() > 1)
+		items = CLAMP(atoi(pArgs->GetArg(1)), 1, (int)PipeTest::MAX_SEQUENCE);
+	if (pArgs->GetArgCount() > 2)
+		producers = CLAMP(atoi(pArgs->GetArg(2)), 2, (int)MultiProducerPipe<int>::MAX_PRODUCERS);
+
+	int errors = 0;
+
+	PipeTest::Result result = PipeTest::TestSingleThread(2000);
+	CryLogAlways("[PipeTest] single thread: %d items, %d errors", result.items, result.errors);
+	errors += result.errors;
+
+	// producers, items per producer, batch size
+	const int runs[][3] = {
+		{ 1, items, 1 },
+		{ 1, items, 64 },
+		{ producers, items/producers, 1 },
+		{ producers, items/producers, 64 },
+	};
+
+	for (int i=0; i<(int)(sizeof(runs)/sizeof(runs[0])); ++i)
+	{
+		const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+		result = PipeTest::TestThreaded(runs[i][0], runs[i][1], runs[i][2]);
+		const float time = max(0.001f, (gEnv->pTimer->GetAsyncTime()-start).GetSeconds());
+
+		CryLogAlways("[PipeTest] %d producer(s), batch %d: %d items in %.3fs (%.2f M/s), %d errors",
+			runs[i][0], runs[i][2], result.items, time, result.items/time*0.000001f, result.errors);
+		errors += result.errors;
+	}
+
+	if (errors)
+		GameWarning("[PipeTest] Pipe test failed with %d errors", errors);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdProfileCaptureTest(IConsoleCmdArgs *pArgs)
+{
+	// the test reuses the module's capture buffers
+	if (g_pGame->GetProfileCapture()->IsCapturing())
+	{
+		GameWarning("[ProfileCapture] Wait for g_profileCapture to finish or stop it first");
+		return;
+	}
+	CProfileCapture::SelfTest();
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdGeoBatchTest(IConsoleCmdArgs *pArgs)
+{
+	int count = 1000;
+	int iterations = 10000;
+	if (pArgs->GetArgCount() > 1)
+		count = CLAMP(atoi(pArgs->GetArg(1)), 1, 100000);
+	if (pArgs->GetArgCount() > 2)
+		iterations = max(1, atoi(pArgs->GetArg(2)));
+
+	const IntersectBatchTest::Result result = IntersectBatchTest::TestAgainstScalar(2000);
+	CryLogAlways("[GeoBatchTest] %d tests against the scalar versions, %d errors, %d on the boundary", result.tests, result.errors, result.ambiguous);
+	if (result.errors)
+		GameWarning("[GeoBatchTest] Batched tests disagree with the scalar tests %d times", result.errors);
+
+	// actor sized shapes around the origin, linesegs from random points across the scene
+	IntersectBatchTest::Scene scene;
+	for (int i=0; i<count; ++i)
+	{
+		const Vec3 pos(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(0.0f, 20.0f));
+		scene.Add(AABB(pos-Vec3(0.5f,0.5f,1.0f), pos+Vec3(0.5f,0.5f,1.0f)), Sphere(pos, 1.0f));
+	}
+
+	const int numSegs = 64;
+	std::vector<Lineseg> segs;
+	segs.reserve(numSegs);
+	for (int i=0; i<numSegs; ++i)
+	{
+		const Vec3 start(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(0.0f, 20.0f));
+		segs.push_back(Lineseg(start, start+Vec3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-10.0f, 10.0f))));
+	}
+
+	const Intersect::AABBArrays boxes = scene.GetBoxes(0.0f);
+	const Intersect::SphereArrays spheres = scene.GetSpheres(0.0f);
+	std::vector<int> results(count);
+
+	int hits[4] = { 0, 0, 0, 0 };
+	float times[4];
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		hits[0] += Intersect::Lineseg_AABBs(segs[n%numSegs], boxes, &results[0], count);
+	times[0] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+	{
+		for (int i=0; i<count; ++i)
+			hits[1] += Overlap::Lineseg_AABB(segs[n%numSegs], scene.boxes[i]);
+	}
+	times[1] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		hits[2] += Intersect::Lineseg_Spheres(segs[n%numSegs], spheres, &results[0], count);
+	times[2] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+	{
+		for (int i=0; i<count; ++i)
+			hits[3] += Overlap::Lineseg_Sphere(segs[n%numSegs], scene.spheres[i]);
+	}
+	times[3] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	const float tests = 0.001f*count*iterations;
+	CryLogAlways("[GeoBatchTest] %d shapes, %d linesegs:", count, iterations);
+	CryLogAlways("[GeoBatchTest]   AABBs   batch %.3fms (%.2f M/s, %d hits), scalar %.3fms (%.2f M/s, %d hits)",
+		times[0], tests/max(0.001f, times[0]), hits[0], times[1], tests/max(0.001f, times[1]), hits[1]);
+	CryLogAlways("[GeoBatchTest]   spheres batch %.3fms (%.2f M/s, %d hits), scalar %.3fms (%.2f M/s, %d hits)",
+		times[2], tests/max(0.001f, times[2]), hits[2], times[3], tests/max(0.001f, times[3]), hits[3]);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdNameTableTest(IConsoleCmdArgs *pArgs)
+{
+	int threads = 4;
+	int iterations = 200000;
+	if (pArgs->GetArgCount() > 1)
+		threads = CLAMP(atoi(pArgs->GetArg(1)), 1, 32);
+	if (pArgs->GetArgCount() > 2)
+		iterations = max(1, atoi(pArgs->GetArg(2)));
+
+	// the stress test on the shared table, with one thread for the uncontended rate
+	const int runs[] = { 1, threads };
+	for (int i=0; i<2; ++i)
+	{
+		const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+		const CryNameTest::Result result = CryNameTest::TestThreaded(runs[i], iterations);
+		const float time = max(0.001f, (gEnv->pTimer->GetAsyncTime()-start).GetSeconds());
+		CryLogAlways("[NameTableTest] %d thread(s): %d names in %.3fs (%.2f M/s), %d errors", runs[i], result.names, time, result.names/time*0.000001f, result.errors);
+		if (result.errors)
+			GameWarning("[NameTableTest] Name table test failed with %d errors", result.errors);
+	}
+
+	// one thread, the previous table against a private instance of the new one
+	const int count = 1000;
+	std::vector<string> names(count), newNames(count);
+	std::vector<uint32> hashes(count);
+	for (int i=0; i<count; ++i)
+	{
+		names[i].Format("CryNameBenchmark_%d", i);
+		newNames[i].Format("CryNameBenchmarkNew_%d", i);
+		hashes[i] = CryNameHash(names[i].c_str());
+	}
+
+	CryNameTest::CLegacyNameTable legacyTable;
+	CNameTable table;
+	std::vector<INameTable::SNameEntry*> entries(count);
+	for (int i=0; i<count; ++i)
+	{
+		legacyTable.GetEntry(names[i].c_str())->AddRef();
+		entries[i] = table.GetEntry(names[i].c_str(), hashes[i]);
+	}
+
+	int checksums[5] = { 0, 0, 0, 0, 0 };
+	float times[5];
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		checksums[0] += CryNameTest::CreateAndDrop(legacyTable, names[n%count].c_str());
+	times[0] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		checksums[1] += CryNameTest::CreateAndDrop(table, names[n%count].c_str(), CryNameHash(names[n%count].c_str()));
+	times[1] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		checksums[2] += CryNameTest::CreateAndDrop(table, names[n%count].c_str(), hashes[n%count]);
+	times[2] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	// names nobody holds, every one is added and deleted again
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		checksums[3] += CryNameTest::CreateAndDrop(legacyTable, newNames[n%count].c_str());
+	times[3] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		checksums[4] += CryNameTest::CreateAndDrop(table, newNames[n%count].c_str(), CryNameHash(newNames[n%count].c_str()));
+	times[4] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	CryLogAlways("[NameTableTest] %d lookups of %d existing names: previous table %.3fms, new table %.3fms, with precomputed hashes %.3fms",
+		iterations, count, times[0], times[1], times[2]);
+	CryLogAlways("[NameTableTest] %d names added and deleted: previous table %.3fms, new table %.3fms", iterations, times[3], times[4]);
+
+	// comparisons: names compare their entries, strings compare characters
+	const CCryName first(names[0].c_str()), second(names[1].c_str());
+	int equalNames = 0, equalStrings = 0;
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		equalNames += ((n & 1 ? first : second) == first);
+	const float nameTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int n=0; n<iterations; ++n)
+		equalStrings += ((n & 1 ? first : second) == names[0].c_str());
+	const float stringTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	CryLogAlways("[NameTableTest] %d comparisons: CCryName %.3fms, string %.3fms", iterations, nameTime, stringTime);
+
+	if (checksums[0] != checksums[1] || checksums[0] != checksums[2] || checksums[3] != checksums[4] || equalNames != equalStrings)
+		GameWarning("[NameTableTest] Benchmark results disagree");
+
+	// the previous table frees its entries itself, ~CNameTable leaves referenced entries alone,
+	// so the references taken above are dropped here and the table is empty when it goes
+	for (int i=0; i<count; ++i)
+		table.Release(entries[i]);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdJobSystemTest(IConsoleCmdArgs *pArgs)
+{
+	int iterations = 10;
+	int count = 1000000;
+	if (pArgs->GetArgCount() > 1)
+		iterations = max(1, atoi(pArgs->GetArg(1)));
+	if (pArgs->GetArgCount() > 2)
+		count = max(1, atoi(pArgs->GetArg(2)));
+
+	CJobManager *pJobManager = g_pGame->GetJobManager();
+	const int workers = pJobManager->GetWorkerCount();
+
+	bool ok = CJobManager::SelfTest(*pJobManager, iterations);
+	CJobManager::Benchmark(*pJobManager, count);
+
+	// everything has to work without workers as well, the waiting thread then runs all jobs
+	if (workers > 0)
+	{
+		pJobManager->SetWorkerCount(0);
+		ok &= CJobManager::SelfTest(*pJobManager, iterations);
+		pJobManager->SetWorkerCount(workers);
+	}
+
+	if (!ok)
+		GameWarning("[JobManager] Job system test failed");
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdBinaryXmlBenchmark(IConsoleCmdArgs *pArgs)
+{
+	const char *folder = pArgs->GetArgCount() > 1 ? pArgs->GetArg(1) : "Scripts";
+	const char *binaryFolder = pArgs->GetArgCount() > 2 ? pArgs->GetArg(2) : "%USER%/BinaryXml";
+	CXMLBinaryDocument::Benchmark(folder, binaryFolder);
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdStructSerializerBenchmark(IConsoleCmdArgs *pArgs)
+{
+	int count = 100000;
+	if (pArgs->GetArgCount() > 1)
+		count = max(1, atoi(pArgs->GetArg(1)));
+
+	if (!CStructSerializer::Benchmark(count))
+		GameWarning("[StructSerializer] Struct serializer test failed");
+}
+
+//------------------------------------------------------------------------
+void CGame::CmdShotRandomTest(IConsoleCmdArgs *pArgs)
+{
+	int samples = 1<<20;
+	if (pArgs->GetArgCount() > 1)
+		samples = max(1, atoi(pArgs->GetArg(1)));
+
+	if (!CShotRandom::SelfTest(samples))
+		GameWarning("[ShotRandom] Shot random test failed");
+	CShotRandom::Benchmark(samples);
+}
+#endif
+
 //------------------------------------------------------------------------
 void CGame::CmdRestartGame(IConsoleCmdArgs *pArgs)
 {
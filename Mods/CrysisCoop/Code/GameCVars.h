@@ -95,6 +95,7 @@ struct SCVars
 	float i_offset_up;
 	float i_offset_right;
 	int		i_unlimitedammo;
+	int		i_shotgunBatchedPellets;
 	int   i_iceeffects;
 	int		i_lighteffectsShadows;
   
@@ -123,6 +124,8 @@ struct SCVars
 	float g_suitSpeedEnergyConsumption;
 	float g_suitSpeedEnergyConsumptionMultiplayer;
 	float g_suitCloakEnergyDrainAdjuster;
+	float g_suitEnergyNetThreshold;
+	int		g_suitEnergyNetDebug;
 	float g_AiSuitEnergyRechargeTime;
 	float g_AiSuitHealthRegenTime;
 	float g_AiSuitArmorModeHealthRegenTime;
@@ -153,6 +156,7 @@ struct SCVars
 	float g_fallAndPlayThreshold;
 	int		g_spRecordGameplay;
 	float g_spGameplayRecorderUpdateRate;
+	int		g_jobThreads;
 	int		g_useHitSoundFeedback;
 
 	int sv_pacifist;
@@ -249,6 +253,10 @@ struct SCVars
 	int   v_draw_suspension;
 	int   v_draw_slip;
 	int   v_pa_surface;    
+	float v_effectsLODNear;
+	float v_effectsLODFar;
+	float v_effectsLODCull;
+	int   v_debugEffectsLOD;
 	int   v_invertPitchControl;  
 	float v_wind_minspeed; 
 	float v_sprintSpeed;
@@ -38,6 +38,7 @@
 #include "MPTutorial.h"
 #include "Voting.h"
 #include "SPAnalyst.h"
+#include "Coop\CoopSystem.h"
 #include "IWorldQuery.h"
 
 #include <StlUtils.h>
@@ -46,6 +47,12 @@
 int CGameRules::s_invulnID = 0;
 int CGameRules::s_barbWireID = 0;
 
+static const float ENTITY_SCHEDULE_UNIQUE_RECHECK = 0.5f;
+static const float ENTITY_SCHEDULE_MIN_BACKOFF = 0.25f;
+static const float ENTITY_SCHEDULE_MAX_BACKOFF = 8.0f;
+// sampling interval of the view check while a removal waits for its time out of view
+static const float ENTITY_SCHEDULE_HIDDEN_RECHECK = 0.25f;
+
 //------------------------------------------------------------------------
 CGameRules::CGameRules()
 : m_pGameFramework(0),
@@ -73,7 +80,10 @@ CGameRules::CGameRules()
 	m_timeOfDayInitialized(false),
 	m_processingHit(0),
 	m_explosionScreenFX(true),
-	m_pShotValidator(0)
+	m_pShotValidator(0),
+	m_scheduleTime(0.0f),
+	m_scheduleSeq(0),
+	m_objectiveHandlesLoaded(false)
 {
 }
 
@@ -242,6 +252,13 @@ void CGameRules::PostInitClient(int channelId)
 	for (TMinimap::const_iterator mit=m_minimap.begin(); mit!=m_minimap.end(); ++mit)
 		GetGameObject()->InvokeRMIWithDependentObject(ClAddMinimapEntity(), AddMinimapEntityParams(mit->entityId, mit->lifetime, mit->type), eRMI_ToClientChannel, mit->entityId, channelId);
 
+	// coop synchronizer strings, the synchronizer RMIs only send indices into this table
+	CCoopStringTable &stringTable=CCoopSystem::GetInstance()->GetStringTable();
+	CCoopStringTable::SChunkParams chunk;
+	stringTable.OnSendTable(channelId);
+	for (int first=0; stringTable.GetChunk(first, chunk); first+=CCoopStringTable::CHUNK_SIZE)
+		GetGameObject()->InvokeRMI(ClCoopStringTable(), chunk, eRMI_ToClientChannel|eRMI_NoLocalCalls, channelId);
+
 	// freeze stuff on the clients
 	for (TFrozenEntities::const_iterator fit=m_frozen.begin(); fit!=m_frozen.end(); ++fit)
 		GetGameObject()->InvokeRMIWithDependentObject(ClFreezeEntity(), FreezeEntityParams(fit->first, true, false), eRMI_ToClientChannel, fit->first, channelId);
@@ -296,6 +313,8 @@ void CGameRules::FullSerialize( TSerialize ser )
 
 	if(g_pGame->GetWeaponSystem())
 		g_pGame->GetWeaponSystem()->Serialize(ser);
+
+	SerializeEntitySchedules(ser);
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -361,7 +380,10 @@ void CGameRules::Update( SEntityUpdateContext& ctx, int updateSlot )
 		m_pRadio->Update();
 
 	if (gEnv->bServer)
+	{
+		FlushObjectiveDeltas();
 		GetGameObject()->ChangedNetworkState( eEA_GameServerDynamic );
+	}
 }
 
 //------------------------------------------------------------------------
@@ -394,8 +416,7 @@ void CGameRules::ProcessEvent( SEntityEvent& event)
 		
       // TODO: move this from here
 		g_pGame->GetWeaponSystem()->GetTracerManager().Reset();
-		m_respawns.clear();
-		m_removals.clear();
+		ClearEntitySchedules();
 		break;
 
 	case ENTITY_EVENT_START_GAME:
@@ -532,6 +553,11 @@ void CGameRules::OnDisconnect(EDisconnectionCause cause, const char *desc)
 //------------------------------------------------------------------------
 void CGameRules::OnResetMap()
 {
+	// the handles are looked up again from the objectives file of the map that comes next
+	m_objectiveHandles.Clear();
+	m_objectiveHandlesLoaded=false;
+	m_objectiveDeltas.clear();
+
 	// Server will do similar in CGameRules::ResetEntities
 	if (!gEnv->bServer)
 	{
@@ -551,6 +577,11 @@ bool CGameRules::OnClientConnect(int channelId, bool isReset)
 		m_channelIds.push_back(channelId);
 		g_pGame->GetServerSynchedStorage()->OnClientConnect(channelId);
 
+		// the local client shares the server's string table
+		INetChannel *pNetChannel=m_pGameFramework->GetNetChannel(channelId);
+		if (pNetChannel && !pNetChannel->IsLocal())
+			CCoopSystem::GetInstance()->GetStringTable().AddChannel(channelId);
+
 		if (m_pShotValidator)
 			m_pShotValidator->Connected(channelId);
 	}
@@ -602,6 +633,8 @@ void CGameRules::OnClientDisconnect(int channelId, EDisconnectionCause cause, co
 	if (m_pShotValidator)
 		m_pShotValidator->Disconnected(channelId);
 
+	CCoopSystem::GetInstance()->GetStringTable().RemoveChannel(channelId);
+
 	CActor *pActor=GetActorByChannelId(channelId);
 	//assert(pActor);
 
@@ -1664,7 +1697,25 @@ void CGameRules::SetObjectiveStatus(int teamId, const char *objective, int statu
 
 	if (gEnv->bServer)
 	{
-		GAMERULES_INVOKE_ON_TEAM(teamId, ClSetObjectiveStatus(), SetObjectiveStatusParams(objective, status))
+		// objectives known to the level files go out as one delta per tick, see FlushObjectiveDeltas
+		int handle=GetObjectiveHandle(objective);
+		if (handle==CMissionObjectiveHandles::INVALID_HANDLE)
+		{
+			FlushObjectiveDeltas();
+			GAMERULES_INVOKE_ON_TEAM(teamId, ClSetObjectiveStatus(), SetObjectiveStatusParams(objective, status))
+			return;
+		}
+
+		TObjectiveDelta &delta=m_objectiveDeltas[teamId];
+		if ((int)delta.status.size()<=handle)
+		{
+			delta.status.resize(m_objectiveHandles.GetCount(), CHUDMissionObjective::DEACTIVATED);
+			delta.changed.resize((m_objectiveHandles.GetCount()+15)/16, 0);
+		}
+
+		delta.status[handle]=(uint8)status;
+		delta.changed[handle>>4]|=1<<(handle&15);
+		delta.any=true;
 	}
 }
 
@@ -1676,6 +1727,7 @@ void CGameRules::SetObjectiveEntity(int teamId, const char *objective, EntityId
 
 	if (gEnv->bServer)
 	{
+		FlushObjectiveDeltas();
 		GAMERULES_INVOKE_ON_TEAM(teamId, ClSetObjectiveEntity(), SetObjectiveEntityParams(objective, entityId))
 	}
 }
@@ -1695,6 +1747,8 @@ void CGameRules::RemoveObjective(int teamId, const char *objective)
 void CGameRules::ResetObjectives()
 {
 	m_objectives.clear();
+	// pending changes are superseded by the reset
+	m_objectiveDeltas.clear();
 
 	if (gEnv->bServer)
 		GetGameObject()->InvokeRMI(ClResetObjectives(), NoParams(), eRMI_ToAllClients);
@@ -1724,6 +1778,7 @@ CGameRules::TObjective *CGameRules::GetObjective(int teamId, const char *objecti
 //------------------------------------------------------------------------
 void CGameRules::UpdateObjectivesForPlayer(int channelId, int teamId)
 {
+	FlushObjectiveDeltas();
 	GetGameObject()->InvokeRMI(ClResetObjectives(), NoParams(), eRMI_ToClientChannel, channelId);
 
 	if (TObjectiveMap *pObjectives=GetTeamObjectives(teamId))
@@ -1736,6 +1791,58 @@ void CGameRules::UpdateObjectivesForPlayer(int channelId, int teamId)
 	}
 }
 
+//------------------------------------------------------------------------
+int CGameRules::GetObjectiveHandle(const char *objective)
+{
+	if (!m_objectiveHandlesLoaded)
+	{
+		string filename;
+		if (!CHUDMissionObjectiveSystem::GetLevelObjectivesFile(filename))
+			return CMissionObjectiveHandles::INVALID_HANDLE;
+
+		CHUDMissionObjectiveSystem::LoadObjectiveHandles(filename.c_str(), m_objectiveHandles);
+		m_objectiveHandlesLoaded=true;
+	}
+
+	int handle=m_objectiveHandles.Find(objective);
+
+	// the delta bitset is sent with an 8 bit word count
+	if (handle>=255*16)
+		return CMissionObjectiveHandles::INVALID_HANDLE;
+
+	return handle;
+}
+
+//------------------------------------------------------------------------
+void CGameRules::FlushObjectiveDeltas()
+{
+	// once per tick, and before any other objective RMI so clients get the changes in order
+	for (TTeamObjectiveDeltaMap::iterator it=m_objectiveDeltas.begin(); it!=m_objectiveDeltas.end(); ++it)
+	{
+		TObjectiveDelta &delta=it->second;
+		if (!delta.any)
+			continue;
+
+		SetObjectiveStatusDeltaParams params;
+
+		int nWords=(int)delta.changed.size();
+		while (nWords>0 && !delta.changed[nWords-1])
+			--nWords;
+
+		params.changed.assign(delta.changed.begin(), delta.changed.begin()+nWords);
+		for (int handle=0; handle<nWords*16; handle++)
+		{
+			if (delta.changed[handle>>4]&(1<<(handle&15)))
+				params.status.push_back(delta.status[handle]);
+		}
+
+		GAMERULES_INVOKE_ON_TEAM(it->first, ClSetObjectiveStatusDelta(), params)
+
+		std::fill(delta.changed.begin(), delta.changed.end(), 0);
+		delta.any=false;
+	}
+}
+
 //------------------------------------------------------------------------
 bool CGameRules::IsFrozen(EntityId entityId) const
 {
@@ -3549,6 +3656,7 @@ void CGameRules::ResetEntities()
  	}
 
 	m_respawns.clear();
+	m_respawnQueue=TEntityScheduleQueue();
 	m_entityteams.clear();
 	m_teamdefaultspawns.clear();
 
@@ -3678,85 +3786,129 @@ void CGameRules::ScheduleEntityRespawn(EntityId entityId, bool unique, float tim
 	if (!pEntity)
 		return;
 
+	if (m_respawns.find(entityId)!=m_respawns.end())
+		return;
+
 	SEntityRespawn respawn;
 	respawn.timer = timer;
 	respawn.unique = unique;
+	respawn.waiting = unique;
+
+	// unique respawns only start counting down once the entity is gone
+	PushEntitySchedule(m_respawnQueue, entityId, unique?ENTITY_SCHEDULE_UNIQUE_RECHECK:timer, respawn.seq);
 
 	m_respawns.insert(TEntityRespawnMap::value_type(entityId, respawn));
 }
 
+//------------------------------------------------------------------------
+void CGameRules::PushEntitySchedule(TEntityScheduleQueue &queue, EntityId entityId, float delay, uint32 &seq)
+{
+	seq=++m_scheduleSeq;
+	queue.push(SEntitySchedule(m_scheduleTime+delay, entityId, seq));
+}
+
+//------------------------------------------------------------------------
+void CGameRules::ClearEntitySchedules()
+{
+	m_respawns.clear();
+	m_removals.clear();
+	m_respawnQueue=TEntityScheduleQueue();
+	m_removalQueue=TEntityScheduleQueue();
+	m_scheduleTime=0.0f;
+}
+
 //------------------------------------------------------------------------
 void CGameRules::UpdateEntitySchedules(float frameTime)
 {
 	if (!gEnv->bServer || m_pGameFramework->IsEditing())
 		return;
 
-	TEntityRespawnMap::iterator next;
-	for (TEntityRespawnMap::iterator it=m_respawns.begin(); it!=m_respawns.end(); it=next)
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	m_scheduleTime += frameTime;
+
+	while (!m_respawnQueue.empty() && m_respawnQueue.top().due<=m_scheduleTime)
 	{
-		next=it; ++next;
-		EntityId id=it->first;
+		SEntitySchedule schedule=m_respawnQueue.top();
+		m_respawnQueue.pop();
+
+		TEntityRespawnMap::iterator it=m_respawns.find(schedule.id);
+		if (it==m_respawns.end() || it->second.seq!=schedule.seq)
+			continue;
+
+		EntityId id=schedule.id;
 		SEntityRespawn &respawn=it->second;
 
 		if (respawn.unique)
 		{
 			IEntity *pEntity=m_pEntitySystem->GetEntity(id);
 			if (pEntity)
+			{
+				respawn.waiting=true;
+				PushEntitySchedule(m_respawnQueue, id, ENTITY_SCHEDULE_UNIQUE_RECHECK, respawn.seq);
+				continue;
+			}
+			else if (respawn.waiting)
+			{
+				respawn.waiting=false;
+				PushEntitySchedule(m_respawnQueue, id, respawn.timer, respawn.seq);
 				continue;
+			}
 		}
 
-		respawn.timer -= frameTime;
-		if (respawn.timer<=0.0f)
+		TEntityRespawnDataMap::iterator dit=m_respawndata.find(id);
+		
+		if (dit==m_respawndata.end())
 		{
-			TEntityRespawnDataMap::iterator dit=m_respawndata.find(id);
-			
-			if (dit==m_respawndata.end())
-      {
-        m_respawns.erase(it);
-				continue;
-      }
+			m_respawns.erase(it);
+			continue;
+		}
 
-			SEntityRespawnData &data=dit->second;
+		SEntityRespawnData &data=dit->second;
 
-			SEntitySpawnParams params;
-			params.pClass=data.pClass;
-			params.qRotation=data.rotation;
-			params.vPosition=data.position;
-			params.vScale=data.scale;
-			params.nFlags=data.flags;
+		SEntitySpawnParams params;
+		params.pClass=data.pClass;
+		params.qRotation=data.rotation;
+		params.vPosition=data.position;
+		params.vScale=data.scale;
+		params.nFlags=data.flags;
 
-			string name;
+		string name;
 #ifdef _DEBUG
-			name=data.name;
-			name.append("_repop");
+		name=data.name;
+		name.append("_repop");
 #else
-			name=data.pClass->GetName();
+		name=data.pClass->GetName();
 #endif
-			params.sName = name.c_str();
+		params.sName = name.c_str();
 
-			IEntity *pEntity=m_pEntitySystem->SpawnEntity(params, false);
-			if (pEntity && data.properties.GetPtr())
+		IEntity *pEntity=m_pEntitySystem->SpawnEntity(params, false);
+		if (pEntity && data.properties.GetPtr())
+		{
+			SmartScriptTable properties;
+			IScriptTable *pScriptTable=pEntity->GetScriptTable();
+			if (pScriptTable && pScriptTable->GetValue("Properties", properties))
 			{
-				SmartScriptTable properties;
-				IScriptTable *pScriptTable=pEntity->GetScriptTable();
-				if (pScriptTable && pScriptTable->GetValue("Properties", properties))
-				{
-					if (properties.GetPtr())
-						properties->Clone(data.properties, true);
-				}
+				if (properties.GetPtr())
+					properties->Clone(data.properties, true);
 			}
-
-			m_pEntitySystem->InitEntity(pEntity, params);
-			m_respawns.erase(it);
-			m_respawndata.erase(dit);
 		}
+
+		m_pEntitySystem->InitEntity(pEntity, params);
+		m_respawns.erase(it);
+		m_respawndata.erase(dit);
 	}
 
-	TEntityRemovalMap::iterator rnext;
-	for (TEntityRemovalMap::iterator it=m_removals.begin(); it!=m_removals.end(); it=rnext)
+	while (!m_removalQueue.empty() && m_removalQueue.top().due<=m_scheduleTime)
 	{
-		rnext=it; ++rnext;
-		EntityId id=it->first;
+		SEntitySchedule schedule=m_removalQueue.top();
+		m_removalQueue.pop();
+
+		TEntityRemovalMap::iterator it=m_removals.find(schedule.id);
+		if (it==m_removals.end() || it->second.seq!=schedule.seq)
+			continue;
+
+		EntityId id=schedule.id;
 		SEntityRemovalData &removal=it->second;
 
 		IEntity *pEntity=m_pEntitySystem->GetEntity(id);
@@ -3774,18 +3926,274 @@ void CGameRules::UpdateEntitySchedules(float frameTime)
 			CCamera &camera=m_pSystem->GetViewCamera();
 			if (camera.IsAABBVisible_F(aabb))
 			{
-				removal.timer=removal.time;
+				// still in view, the time out of view starts over. back off exponentially before checking again
+				removal.hidden=false;
+				PushEntitySchedule(m_removalQueue, id, removal.backoff, removal.seq);
+				removal.backoff=min(removal.backoff*2.0f, ENTITY_SCHEDULE_MAX_BACKOFF);
+				continue;
+			}
+
+			// out of view, it has to stay so for removal.time. counting starts at the first check that
+			// doesn't see it, and the view is sampled until then so a glance back resets it
+			if (!removal.hidden)
+			{
+				removal.hidden=true;
+				removal.hiddenSince=m_scheduleTime;
+				removal.backoff=ENTITY_SCHEDULE_MIN_BACKOFF;
+			}
+
+			const float remaining=removal.time-(m_scheduleTime-removal.hiddenSince);
+			if (remaining>0.0f)
+			{
+				PushEntitySchedule(m_removalQueue, id, min(remaining, ENTITY_SCHEDULE_HIDDEN_RECHECK), removal.seq);
 				continue;
 			}
 		}
 
-		removal.timer-=frameTime;
-		if (removal.timer<=0.0f)
+		m_pEntitySystem->RemoveEntity(id);
+		m_removals.erase(it);
+	}
+}
+
+//------------------------------------------------------------------------
+void CGameRules::SerializeEntitySchedules(TSerialize ser)
+{
+	ser.BeginGroup("EntitySchedules");
+
+	// due times are stored relative to the schedule clock, stale heap entries are not saved
+	int count=0;
+	if (ser.IsWriting())
+	{
+		TEntityScheduleQueue queue(m_respawnQueue);
+		std::vector<SEntitySchedule> entries;
+		while (!queue.empty())
 		{
-			m_pEntitySystem->RemoveEntity(id);
-			m_removals.erase(it);
+			const SEntitySchedule &schedule=queue.top();
+			TEntityRespawnMap::const_iterator it=m_respawns.find(schedule.id);
+			if (it!=m_respawns.end() && it->second.seq==schedule.seq)
+				entries.push_back(schedule);
+			queue.pop();
+		}
+
+		count=(int)entries.size();
+		ser.Value("respawnCount", count);
+		for (int i=0; i<count; ++i)
+		{
+			const SEntityRespawn &respawn=m_respawns[entries[i].id];
+			float remaining=entries[i].due-m_scheduleTime;
+			bool unique=respawn.unique;
+			bool waiting=respawn.waiting;
+			float timer=respawn.timer;
+
+			ser.BeginGroup("Respawn");
+			ser.Value("id", entries[i].id);
+			ser.Value("remaining", remaining);
+			ser.Value("unique", unique);
+			ser.Value("waiting", waiting);
+			ser.Value("timer", timer);
+			ser.EndGroup();
+		}
+
+		queue=m_removalQueue;
+		entries.clear();
+		while (!queue.empty())
+		{
+			const SEntitySchedule &schedule=queue.top();
+			TEntityRemovalMap::const_iterator it=m_removals.find(schedule.id);
+			if (it!=m_removals.end() && it->second.seq==schedule.seq)
+				entries.push_back(schedule);
+			queue.pop();
+		}
+
+		count=(int)entries.size();
+		ser.Value("removalCount", count);
+		for (int i=0; i<count; ++i)
+		{
+			const SEntityRemovalData &removal=m_removals[entries[i].id];
+			float remaining=entries[i].due-m_scheduleTime;
+			float time=removal.time;
+			float backoff=removal.backoff;
+			float hiddenTime=removal.hidden?m_scheduleTime-removal.hiddenSince:0.0f;
+			bool hidden=removal.hidden;
+			bool visibility=removal.visibility;
+
+			ser.BeginGroup("Removal");
+			ser.Value("id", entries[i].id);
+			ser.Value("remaining", remaining);
+			ser.Value("time", time);
+			ser.Value("backoff", backoff);
+			ser.Value("hidden", hidden);
+			ser.Value("hiddenTime", hiddenTime);
+			ser.Value("visibility", visibility);
+			ser.EndGroup();
+		}
+	}
+	else
+	{
+		ClearEntitySchedules();
+
+		ser.Value("respawnCount", count);
+		for (int i=0; i<count; ++i)
+		{
+			EntityId id=0;
+			float remaining=0.0f;
+			SEntityRespawn respawn;
+
+			ser.BeginGroup("Respawn");
+			ser.Value("id", id);
+			ser.Value("remaining", remaining);
+			ser.Value("unique", respawn.unique);
+			ser.Value("waiting", respawn.waiting);
+			ser.Value("timer", respawn.timer);
+			ser.EndGroup();
+
+			PushEntitySchedule(m_respawnQueue, id, remaining, respawn.seq);
+			m_respawns.insert(TEntityRespawnMap::value_type(id, respawn));
+		}
+
+		count=0;
+		ser.Value("removalCount", count);
+		for (int i=0; i<count; ++i)
+		{
+			EntityId id=0;
+			float remaining=0.0f;
+			float hiddenTime=0.0f;
+			SEntityRemovalData removal;
+
+			ser.BeginGroup("Removal");
+			ser.Value("id", id);
+			ser.Value("remaining", remaining);
+			ser.Value("time", removal.time);
+			ser.Value("backoff", removal.backoff);
+			ser.Value("hidden", removal.hidden);
+			ser.Value("hiddenTime", hiddenTime);
+			ser.Value("visibility", removal.visibility);
+			ser.EndGroup();
+
+			removal.hiddenSince=m_scheduleTime-hiddenTime;
+
+			PushEntitySchedule(m_removalQueue, id, remaining, removal.seq);
+			m_removals.insert(TEntityRemovalMap::value_type(id, removal));
+		}
+	}
+
+	ser.EndGroup();
+}
+
+//------------------------------------------------------------------------
+void CGameRules::BenchmarkEntitySchedules(int count, int frames)
+{
+	if (!gEnv->bServer || m_pGameFramework->IsEditing())
+	{
+		GameWarning("[EntitySchedules] The benchmark needs a server outside of the editor");
+		return;
+	}
+
+	IEntityClass *pClass=m_pEntitySystem->GetClassRegistry()->GetDefaultClass();
+	if (!pClass)
+		return;
+
+	// the running schedules are put aside and restored afterwards
+	TEntityRespawnDataMap respawndata;
+	TEntityRespawnMap respawns;
+	TEntityRemovalMap removals;
+	TEntityScheduleQueue respawnQueue, removalQueue;
+	respawndata.swap(m_respawndata);
+	respawns.swap(m_respawns);
+	removals.swap(m_removals);
+	std::swap(respawnQueue, m_respawnQueue);
+	std::swap(removalQueue, m_removalQueue);
+	const float scheduleTime=m_scheduleTime;
+	m_scheduleTime=0.0f;
+
+	// spread around the view so part of the removals pass the view check. the timers are
+	// longer than the benchmark, nothing is due, every frame is the steady state
+	const float timer=1000.0f;
+	const Vec3 center=m_pSystem->GetViewCamera().GetPosition();
+	std::vector<EntityId> ids;
+	ids.reserve(count);
+	for (int i=0; i<count; ++i)
+	{
+		SEntitySpawnParams params;
+		params.pClass=pClass;
+		params.sName="EntityScheduleBenchmark";
+		params.vPosition=center+Vec3(Random(-100.0f, 100.0f), Random(-100.0f, 100.0f), Random(-10.0f, 10.0f));
+		params.nFlags=ENTITY_FLAG_NO_SAVE|ENTITY_FLAG_SERVER_ONLY;
+
+		IEntity *pEntity=m_pEntitySystem->SpawnEntity(params);
+		if (!pEntity)
+			continue;
+
+		ids.push_back(pEntity->GetId());
+		if (i&1)
+			ScheduleEntityRemoval(pEntity->GetId(), timer, (i&2)!=0);
+		else
+		{
+			CreateEntityRespawnData(pEntity->GetId());
+			ScheduleEntityRespawn(pEntity->GetId(), (i&2)!=0, timer);
+		}
+	}
+
+	const int respawnCount=(int)m_respawns.size();
+	const int removalCount=(int)m_removals.size();
+	const float frameTime=1.0f/30.0f;
+
+	CTimeValue start=gEnv->pTimer->GetAsyncTime();
+	for (int frame=0; frame<frames; ++frame)
+		UpdateEntitySchedules(frameTime);
+	const float queueTime=(gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	// what UpdateEntitySchedules did before the queues: every schedule every frame, on its own timers
+	std::vector<float> respawnTimers(respawnCount, timer), removalTimers(removalCount, timer);
+	start=gEnv->pTimer->GetAsyncTime();
+	for (int frame=0; frame<frames; ++frame)
+	{
+		int i=0;
+		for (TEntityRespawnMap::const_iterator it=m_respawns.begin(); it!=m_respawns.end(); ++it, ++i)
+		{
+			if (it->second.unique && m_pEntitySystem->GetEntity(it->first))
+				continue;
+			respawnTimers[i]-=frameTime;
+		}
+
+		i=0;
+		for (TEntityRemovalMap::const_iterator it=m_removals.begin(); it!=m_removals.end(); ++it, ++i)
+		{
+			IEntity *pEntity=m_pEntitySystem->GetEntity(it->first);
+			if (!pEntity)
+				continue;
+
+			if (it->second.visibility)
+			{
+				AABB aabb;
+				pEntity->GetWorldBounds(aabb);
+				if (m_pSystem->GetViewCamera().IsAABBVisible_F(aabb))
+				{
+					removalTimers[i]=it->second.time;
+					continue;
+				}
+			}
+			removalTimers[i]-=frameTime;
 		}
 	}
+	const float walkTime=(gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	const bool ok=(int)m_respawns.size()==respawnCount && (int)m_removals.size()==removalCount;
+
+	CryLogAlways("[EntitySchedules] %d respawns, %d removals, %d frames: due-time queues %.4f ms/frame, per frame walk %.4f ms/frame",
+		respawnCount, removalCount, frames, queueTime/max(frames, 1), walkTime/max(frames, 1));
+	if (!ok)
+		GameWarning("[EntitySchedules] Schedules were lost during the benchmark");
+
+	for (size_t i=0; i<ids.size(); ++i)
+		m_pEntitySystem->RemoveEntity(ids[i], true);
+
+	m_respawndata.swap(respawndata);
+	m_respawns.swap(respawns);
+	m_removals.swap(removals);
+	std::swap(respawnQueue, m_respawnQueue);
+	std::swap(removalQueue, m_removalQueue);
+	m_scheduleTime=scheduleTime;
 }
 
 //------------------------------------------------------------------------
@@ -3843,11 +4251,20 @@ void CGameRules::ScheduleEntityRemoval(EntityId entityId, float timer, bool visi
 	if (!pEntity)
 		return;
 
+	if (m_removals.find(entityId)!=m_removals.end())
+		return;
+
 	SEntityRemovalData removal;
 	removal.time = timer;
-	removal.timer = timer;
+	removal.backoff = ENTITY_SCHEDULE_MIN_BACKOFF;
+	removal.hiddenSince = 0.0f;
+	removal.hidden = false;
 	removal.visibility = visibility;
 
+	// removals that wait for the entity to be out of view check the view right away, the timer
+	// only runs while it is out of view
+	PushEntitySchedule(m_removalQueue, entityId, visibility?0.0f:timer, removal.seq);
+
 	m_removals.insert(TEntityRemovalMap::value_type(entityId, removal));
 }
 
@@ -27,6 +27,8 @@
 #include <queue>
 #include "Voting.h"
 #include "ShotValidator.h"
+#include "Coop\CoopStringTable.h"
+#include "HUD/HUDMissionObjectiveSystem.h"
 
 
 class CActor;
@@ -143,6 +145,18 @@ public:
 	typedef std::map<string, TObjective> TObjectiveMap;
 	typedef std::map<int, TObjectiveMap> TTeamObjectiveMap;
 
+	// objective status changes of a team since the last tick, indexed by objective handle
+	typedef struct TObjectiveDelta
+	{
+		TObjectiveDelta(): any(false) {};
+
+		std::vector<uint8>	status;
+		std::vector<uint16>	changed;	// one bit per handle
+		bool								any;
+	} TObjectiveDelta;
+
+	typedef std::map<int, TObjectiveDelta> TTeamObjectiveDeltaMap;
+
 	struct SGameRulesListener
 	{
 		virtual void GameOver(int localWinner) = 0;
@@ -308,6 +322,8 @@ public:
 	virtual TObjectiveMap *GetTeamObjectives(int teamId);
 	virtual TObjective *GetObjective(int teamId, const char *objective);
 	virtual void UpdateObjectivesForPlayer(int channelId, int teamId);
+	virtual int GetObjectiveHandle(const char *objective);
+	virtual void FlushObjectiveDeltas();
 
 	//------------------------------------------------------------------------
 	// materials
@@ -413,6 +429,10 @@ public:
 	virtual void AbortEntityRemoval(EntityId entityId);
 
 	virtual void UpdateEntitySchedules(float frameTime);
+	virtual void SerializeEntitySchedules(TSerialize ser);
+	// schedules count respawns and removals of fresh entities and times the due-time queues against a
+	// walk over every schedule per frame, leaves the existing schedules untouched
+	void BenchmarkEntitySchedules(int count, int frames);
   virtual void ProcessQueuedExplosions();
 	virtual void ProcessServerExplosion(const ExplosionInfo &explosionInfo);
 	
@@ -821,6 +841,32 @@ public:
 		}
 	};
 
+	struct SetObjectiveStatusDeltaParams
+	{
+		std::vector<uint16>	changed;	// bitset over objective handles, trailing zero words dropped
+		std::vector<int>		status;		// one per set bit, in handle order
+		void SerializeWith(TSerialize ser)
+		{
+			uint8 nWords=(uint8)changed.size();
+			ser.Value("nWords", nWords, 'ui8');
+			if (ser.IsReading())
+				changed.resize(nWords);
+
+			int nChanged=0;
+			for (int i=0; i<nWords; i++)
+			{
+				ser.Value("changed", changed[i], 'ui16');
+				for (uint16 bits=changed[i]; bits; bits&=bits-1)
+					++nChanged;
+			}
+
+			if (ser.IsReading())
+				status.resize(nChanged);
+			for (int i=0; i<nChanged; i++)
+				ser.Value("status", status[i], 'hSts');
+		}
+	};
+
 	struct SetObjectiveEntityParams
 	{
 		SetObjectiveEntityParams(): entityId(0) {};
@@ -927,6 +973,7 @@ public:
 
 	DECLARE_CLIENT_RMI_NOATTACH(ClSetObjective, SetObjectiveParams, eNRT_ReliableOrdered);
 	DECLARE_CLIENT_RMI_NOATTACH(ClSetObjectiveStatus, SetObjectiveStatusParams, eNRT_ReliableOrdered);
+	DECLARE_CLIENT_RMI_NOATTACH(ClSetObjectiveStatusDelta, SetObjectiveStatusDeltaParams, eNRT_ReliableOrdered);
 	DECLARE_CLIENT_RMI_NOATTACH(ClSetObjectiveEntity, SetObjectiveEntityParams, eNRT_ReliableOrdered);
 	DECLARE_CLIENT_RMI_NOATTACH(ClResetObjectives, NoParams, eNRT_ReliableOrdered);
 
@@ -948,6 +995,9 @@ public:
 
 	DECLARE_CLIENT_RMI_NOATTACH(ClEnteredGame, NoParams, eNRT_ReliableUnordered);
 
+	DECLARE_CLIENT_RMI_NOATTACH(ClCoopStringTable, CCoopStringTable::SChunkParams, eNRT_ReliableOrdered);
+	DECLARE_SERVER_RMI_NOATTACH(SvCoopStringTableAck, CCoopStringTable::SAckParams, eNRT_ReliableUnordered);
+
 	virtual void AddHitListener(IHitListener* pHitListener);
 	virtual void RemoveHitListener(IHitListener* pHitListener);
 
@@ -982,19 +1032,41 @@ public:
 	struct SEntityRespawn
 	{
 		bool							unique;
-		float							timer;
+		bool							waiting;	// unique respawn waiting for its entity to go away
+		float							timer;		// countdown started once the entity is gone
+		uint32						seq;
 	};
 
 	struct SEntityRemovalData
 	{
-		float							timer;
-		float							time;
+		float							time;		// seconds the entity has to stay out of view
+		float							backoff;	// recheck delay while the entity is in view
+		float							hiddenSince;	// schedule time the entity was first seen out of view
+		bool							hidden;		// out of view at every check since hiddenSince
 		bool							visibility;
+		uint32						seq;
+	};
+
+	// min-heap entry keyed by due time, so only due schedules get examined.
+	// aborted or rescheduled entries are left in the heap and skipped by seq.
+	struct SEntitySchedule
+	{
+		SEntitySchedule(float _due, EntityId _id, uint32 _seq): due(_due), id(_id), seq(_seq) {};
+
+		bool operator<(const SEntitySchedule &rhs) const { return due>rhs.due; };
+
+		float							due;
+		EntityId					id;
+		uint32						seq;
 	};
 
 	typedef std::map<EntityId, SEntityRespawnData>	TEntityRespawnDataMap;
 	typedef std::map<EntityId, SEntityRespawn>			TEntityRespawnMap;
 	typedef std::map<EntityId, SEntityRemovalData>	TEntityRemovalMap;
+	typedef std::priority_queue<SEntitySchedule>		TEntityScheduleQueue;
+
+	void PushEntitySchedule(TEntityScheduleQueue &queue, EntityId entityId, float delay, uint32 &seq);
+	void ClearEntitySchedules();
 
 	typedef std::vector<IHitListener*> THitListenerVec;
 
@@ -1128,9 +1200,16 @@ protected:
 	TEntityRespawnDataMap	m_respawndata;
 	TEntityRespawnMap			m_respawns;
 	TEntityRemovalMap			m_removals;
+	TEntityScheduleQueue	m_respawnQueue;
+	TEntityScheduleQueue	m_removalQueue;
+	float									m_scheduleTime;
+	uint32								m_scheduleSeq;
 
 	TMinimap						m_minimap;
 	TTeamObjectiveMap		m_objectives;
+	TTeamObjectiveDeltaMap	m_objectiveDeltas;
+	CMissionObjectiveHandles	m_objectiveHandles;
+	bool								m_objectiveHandlesLoaded;
 
 	TSpawnLocations			m_spawnLocations;
 	TSpawnGroupMap			m_spawnGroups;
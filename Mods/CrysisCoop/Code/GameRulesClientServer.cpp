@@ -32,6 +32,7 @@ History:
 #include "SoundMoods.h"
 #include "IWorldQuery.h"
 #include "ShotValidator.h"
+#include "Coop\CoopSystem.h"
 
 #include <StlUtils.h>
 
@@ -1125,6 +1126,29 @@ IMPLEMENT_RMI(CGameRules, ClSetObjectiveStatus)
 	return true;
 }
 
+//------------------------------------------------------------------------
+IMPLEMENT_RMI(CGameRules, ClSetObjectiveStatusDelta)
+{
+	CHUD *pHUD=g_pGame->GetHUD();
+	if (!pHUD)
+		return true;
+
+	CHUDMissionObjectiveSystem &mos=pHUD->GetMissionObjectiveSystem();
+
+	int next=0;
+	for (int handle=0; handle<(int)params.changed.size()*16 && next<(int)params.status.size(); handle++)
+	{
+		if (!(params.changed[handle>>4]&(1<<(handle&15))))
+			continue;
+
+		int status=params.status[next++];
+		if (CHUDMissionObjective *pObjective=mos.GetMissionObjective(handle))
+			pObjective->SetStatus((CHUDMissionObjective::HUDMissionStatus)status);
+	}
+
+	return true;
+}
+
 //------------------------------------------------------------------------
 IMPLEMENT_RMI(CGameRules, ClSetObjectiveEntity)
 {
@@ -1206,6 +1230,18 @@ IMPLEMENT_RMI(CGameRules, ClVotingStatus)
 }
 
 
+IMPLEMENT_RMI(CGameRules, ClCoopStringTable)
+{
+	CCoopSystem::GetInstance()->GetStringTable().SetChunk(params);
+	return true;
+}
+
+IMPLEMENT_RMI(CGameRules, SvCoopStringTableAck)
+{
+	CCoopSystem::GetInstance()->GetStringTable().Ack(params.nIndex, params.nCount, m_pGameFramework->GetGameChannelId(pNetChannel));
+	return true;
+}
+
 IMPLEMENT_RMI(CGameRules, ClEnteredGame)
 {
 	if(!gEnv->bServer && m_pGameFramework->GetClientActor())
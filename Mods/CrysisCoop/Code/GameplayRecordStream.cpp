@@ -0,0 +1,392 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "GameplayRecordStream.h"
+
+#include <ICryPak.h>
+
+namespace
+{
+	void AppendEscaped(string &out, const char *text)
+	{
+		for (const char *c = text; *c; ++c)
+		{
+			switch (*c)
+			{
+			case '&': out.append("&amp;"); break;
+			case '<': out.append("&lt;"); break;
+			case '>': out.append("&gt;"); break;
+			case '"': out.append("&quot;"); break;
+			default: out += *c; break;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+CGameplayRecordStream::CGameplayRecordStream()
+: m_fillIndex(0),
+	m_writeIndex(0),
+	m_pColumns(0),
+	m_columnCount(0),
+	m_recordSize(0),
+	m_pRecord(0),
+	m_pFile(0),
+	m_registered(false),
+	m_frames(0),
+	m_droppedFrames(0),
+	m_bytesWritten(0)
+{
+	for (int i=0; i<BUFFER_COUNT; ++i)
+	{
+		m_buffers[i].used = 0;
+		m_buffers[i].state = eBS_Free;
+	}
+}
+
+//------------------------------------------------------------------------
+CGameplayRecordStream::~CGameplayRecordStream()
+{
+	Close();
+}
+
+//------------------------------------------------------------------------
+bool CGameplayRecordStream::Open(const char *fileName, const char *recordName, const SColumn *pColumns, int columnCount)
+{
+	Close();
+
+	assert(columnCount > 0 && columnCount <= MAX_COLUMNS);
+	if (columnCount <= 0 || columnCount > MAX_COLUMNS)
+		return false;
+
+	// the mask of the set columns comes first
+	m_recordSize = sizeof(uint32);
+	for (int i=0; i<columnCount; ++i)
+	{
+		m_columnOffsets[i] = m_recordSize;
+		m_recordSize += GetColumnSize(pColumns[i].type);
+	}
+
+	m_pFile = gEnv->pCryPak->FOpen(fileName, "wb");
+	if (!m_pFile)
+		return false;
+
+	m_pColumns = pColumns;
+	m_columnCount = columnCount;
+
+	SHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = RECORD_MAGIC;
+	header.version = RECORD_VERSION;
+	strncpy(header.name, recordName, sizeof(header.name)-1);
+	header.columnCount = columnCount;
+	header.recordSize = m_recordSize;
+	gEnv->pCryPak->FWrite(&header, sizeof(header), 1, m_pFile);
+
+	for (int i=0; i<columnCount; ++i)
+	{
+		SColumnHeader column;
+		memset(&column, 0, sizeof(column));
+		column.type = pColumns[i].type;
+		strncpy(column.name, pColumns[i].name, MAX_NAME_LENGTH);
+		gEnv->pCryPak->FWrite(&column, sizeof(column), 1, m_pFile);
+	}
+
+	m_fillIndex = 0;
+	m_writeIndex = 0;
+	m_buffers[0].state = eBS_Filling;
+	m_pRecord = 0;
+	m_frames = 0;
+	m_droppedFrames = 0;
+	m_bytesWritten = sizeof(header) + columnCount*sizeof(SColumnHeader);
+
+	SThreadTaskParams params;
+	params.nFlags = 0;
+	params.nPreferedThread = 1;
+	gEnv->pSystem->GetIThreadTaskManager()->RegisterTask(this, params);
+	m_registered = true;
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+void CGameplayRecordStream::Close()
+{
+	if (!m_pFile)
+		return;
+
+	SubmitBuffer();
+
+	if (m_registered)
+	{
+		gEnv->pSystem->GetIThreadTaskManager()->UnregisterTask(this);
+		m_registered = false;
+	}
+
+	// flush whatever the task thread did not get to
+	while (WriteNextBuffer())
+		;
+
+	gEnv->pCryPak->FClose(m_pFile);
+	m_pFile = 0;
+
+	CryLogAlways("[GameplayRecord] %d frames, %d dropped, %d KB written", m_frames, m_droppedFrames, int(m_bytesWritten/1024));
+
+	for (int i=0; i<BUFFER_COUNT; ++i)
+	{
+		m_buffers[i].used = 0;
+		m_buffers[i].state = eBS_Free;
+	}
+	m_pColumns = 0;
+	m_columnCount = 0;
+	m_pRecord = 0;
+}
+
+//------------------------------------------------------------------------
+// the record only reaches the writer with its buffer, after the frame is complete
+void CGameplayRecordStream::BeginFrame()
+{
+	m_pRecord = 0;
+	if (!m_pFile)
+		return;
+
+	++m_frames;
+	if (!Reserve(m_recordSize))
+	{
+		++m_droppedFrames;
+		return;
+	}
+
+	SBuffer &buffer = m_buffers[m_fillIndex];
+	m_pRecord = buffer.data+buffer.used;
+	buffer.used += m_recordSize;
+	memset(m_pRecord, 0, m_recordSize);
+}
+
+//------------------------------------------------------------------------
+uint8* CGameplayRecordStream::GetSlot(int column, EColumnType type)
+{
+	if (!m_pRecord || column < 0 || column >= m_columnCount)
+		return 0;
+
+	assert(m_pColumns[column].type == type);
+	if (m_pColumns[column].type != type)
+		return 0;
+
+	*(uint32*)m_pRecord |= 1<<column;
+	return m_pRecord+m_columnOffsets[column];
+}
+
+//------------------------------------------------------------------------
+void CGameplayRecordStream::Write(int column, int value)
+{
+	if (uint8 *pSlot = GetSlot(column, eCT_Int))
+		*(int32*)pSlot = value;
+}
+
+//------------------------------------------------------------------------
+void CGameplayRecordStream::Write(int column, float value)
+{
+	if (uint8 *pSlot = GetSlot(column, eCT_Float))
+		*(float*)pSlot = value;
+}
+
+//------------------------------------------------------------------------
+// the slot is zeroed by BeginFrame, so the copy stays terminated
+void CGameplayRecordStream::Write(int column, const char *value)
+{
+	if (uint8 *pSlot = GetSlot(column, eCT_String))
+	{
+		memset(pSlot, 0, MAX_STRING_LENGTH+1);
+		if (value)
+			strncpy((char*)pSlot, value, MAX_STRING_LENGTH);
+	}
+}
+
+//------------------------------------------------------------------------
+// never waits for the writer: if the ring is full the caller drops the frame
+bool CGameplayRecordStream::Reserve(int size)
+{
+	SBuffer &buffer = m_buffers[m_fillIndex];
+	if (buffer.state == eBS_Filling && buffer.used+size <= BUFFER_SIZE)
+		return true;
+
+	SubmitBuffer();
+
+	CryAutoLock<CryFastLock> lock(m_lock);
+	SBuffer &next = m_buffers[m_fillIndex];
+	if (next.state == eBS_Filling)
+		return true;
+	if (next.state != eBS_Free)
+		return false;
+
+	next.used = 0;
+	next.state = eBS_Filling;
+	return true;
+}
+
+//------------------------------------------------------------------------
+void CGameplayRecordStream::SubmitBuffer()
+{
+	CryAutoLock<CryFastLock> lock(m_lock);
+
+	SBuffer &buffer = m_buffers[m_fillIndex];
+	if (buffer.state != eBS_Filling || buffer.used == 0)
+		return;
+
+	buffer.state = eBS_Full;
+	m_fillIndex = (m_fillIndex+1)%BUFFER_COUNT;
+}
+
+//------------------------------------------------------------------------
+void CGameplayRecordStream::OnUpdate()
+{
+	if (!WriteNextBuffer())
+		CrySleep(5);
+}
+
+//------------------------------------------------------------------------
+// buffers are written strictly in submit order, m_writeLock keeps the task
+// thread and Close from interleaving them
+bool CGameplayRecordStream::WriteNextBuffer()
+{
+	CryAutoLock<CryFastLock> writeLock(m_writeLock);
+
+	SBuffer *pBuffer = 0;
+	{
+		CryAutoLock<CryFastLock> lock(m_lock);
+		if (m_pFile && m_buffers[m_writeIndex].state == eBS_Full)
+			pBuffer = &m_buffers[m_writeIndex];
+	}
+
+	if (!pBuffer)
+		return false;
+
+	gEnv->pCryPak->FWrite(pBuffer->data, pBuffer->used, 1, m_pFile);
+	m_bytesWritten += pBuffer->used;
+
+	CryAutoLock<CryFastLock> lock(m_lock);
+	pBuffer->used = 0;
+	pBuffer->state = eBS_Free;
+	m_writeIndex = (m_writeIndex+1)%BUFFER_COUNT;
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+// keeps the "int.fraction" layout of the old xml recorder
+void CGameplayRecordStream::FormatFloat(float value, string &out)
+{
+	int high = (int)value;
+	int low = int((value-(float)high)*1000.0f);
+	char highbuffer[16];
+	itoa(high, highbuffer, 10);
+	char lowbuffer[16];
+	itoa(low, lowbuffer, 10);
+	out = highbuffer;
+	out.append(".");
+	out.append(lowbuffer);
+}
+
+//------------------------------------------------------------------------
+bool CGameplayRecordStream::ConvertToXML(const char *binFileName, const char *xmlFileName)
+{
+	ICryPak *pCryPak = gEnv->pCryPak;
+
+	FILE *pIn = pCryPak->FOpen(binFileName, "rb");
+	if (!pIn)
+		return false;
+
+	SHeader header;
+	if (pCryPak->FReadRaw(&header, sizeof(header), 1, pIn) != 1 || header.magic != RECORD_MAGIC || header.version != RECORD_VERSION ||
+		header.columnCount == 0 || header.columnCount > MAX_COLUMNS)
+	{
+		pCryPak->FClose(pIn);
+		return false;
+	}
+	header.name[sizeof(header.name)-1] = 0;
+
+	// the schema, and where each column sits in a record
+	std::vector<SColumnHeader> columns(header.columnCount);
+	std::vector<int> offsets(header.columnCount);
+	uint32 recordSize = sizeof(uint32);
+	bool valid = pCryPak->FReadRaw(&columns[0], sizeof(SColumnHeader), columns.size(), pIn) == columns.size();
+	for (uint32 i=0; valid && i<header.columnCount; ++i)
+	{
+		columns[i].name[MAX_NAME_LENGTH] = 0;
+		valid = columns[i].type <= eCT_String;
+		offsets[i] = recordSize;
+		recordSize += GetColumnSize((EColumnType)columns[i].type);
+	}
+
+	if (!valid || recordSize != header.recordSize)
+	{
+		pCryPak->FClose(pIn);
+		return false;
+	}
+
+	FILE *pOut = pCryPak->FOpen(xmlFileName, "wb");
+	if (!pOut)
+	{
+		pCryPak->FClose(pIn);
+		return false;
+	}
+
+	std::vector<uint8> record(recordSize);
+	string line;
+	string value;
+
+	line = "<?xml version=\"1.0\"?>\n<?mso-application progid=\"Excel.Sheet\"?>\n<";
+	line.append(header.name);
+	line.append(">\n");
+	pCryPak->FWrite((void*)line.c_str(), line.size(), 1, pOut);
+
+	while (pCryPak->FReadRaw(&record[0], recordSize, 1, pIn) == 1)
+	{
+		const uint32 mask = *(const uint32*)&record[0];
+
+		line = " <frame";
+		for (uint32 i=0; i<header.columnCount; ++i)
+		{
+			if (!(mask & (1<<i)))
+				continue;
+
+			const uint8 *pSlot = &record[offsets[i]];
+			switch (columns[i].type)
+			{
+			case eCT_Int:
+				{
+					char buffer[32];
+					itoa(*(const int32*)pSlot, buffer, 10);
+					value = buffer;
+				}
+				break;
+			case eCT_Float:
+				FormatFloat(*(const float*)pSlot, value);
+				break;
+			case eCT_String:
+				value.assign((const char*)pSlot, strnlen((const char*)pSlot, MAX_STRING_LENGTH+1));
+				break;
+			}
+
+			line.append(" ");
+			line.append(columns[i].name);
+			line.append("=\"");
+			AppendEscaped(line, value.c_str());
+			line.append("\"");
+		}
+		line.append("/>\n");
+		pCryPak->FWrite((void*)line.c_str(), line.size(), 1, pOut);
+	}
+
+	line = "</";
+	line.append(header.name);
+	line.append(">\n");
+	pCryPak->FWrite((void*)line.c_str(), line.size(), 1, pOut);
+
+	pCryPak->FClose(pOut);
+	pCryPak->FClose(pIn);
+	return true;
+}
@@ -0,0 +1,127 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __GAMEPLAY_RECORD_STREAM_H__
+#define __GAMEPLAY_RECORD_STREAM_H__
+
+#pragma once
+
+#include <IThreadTask.h>
+#include <CryThread.h>
+
+// Binary gameplay recording used by CSPAnalyst.
+// The file starts with the column schema, then holds one fixed size record
+// per frame: a mask of the columns set in the frame and a slot per column.
+// Records are reserved whole in a small ring of buffers and full buffers are
+// written to disk by a task thread; a frame that finds the ring full is
+// dropped entirely. ConvertToXML turns a recording into the Excel-XML layout.
+class CGameplayRecordStream : public IThreadTask
+{
+public:
+	enum EColumnType
+	{
+		eCT_Int = 0,
+		eCT_Float,
+		eCT_String,
+	};
+
+	struct SColumn
+	{
+		const char  *name;
+		EColumnType  type;
+	};
+
+	enum { MAX_COLUMNS = 32 };
+	enum { MAX_NAME_LENGTH = 31 };
+	// string values longer than this are cut off
+	enum { MAX_STRING_LENGTH = 63 };
+
+	CGameplayRecordStream();
+	virtual ~CGameplayRecordStream();
+
+	// the columns have to outlive the stream
+	bool Open(const char *fileName, const char *recordName, const SColumn *pColumns, int columnCount);
+	void Close();
+	bool IsOpen() const { return m_pFile != 0; }
+
+	// reserves the record of a new frame, following values belong to it
+	void BeginFrame();
+
+	void Write(int column, int value);
+	void Write(int column, float value);
+	void Write(int column, const char *value);
+
+	// writes the recording as Excel-XML without loading it into memory
+	static bool ConvertToXML(const char *binFileName, const char *xmlFileName);
+	static void FormatFloat(float value, string &out);
+
+	// IThreadTask
+	virtual void OnUpdate();
+	// ~IThreadTask
+
+private:
+	enum { RECORD_MAGIC = 0x42525047 }; // 'GPRB'
+	enum { RECORD_VERSION = 2 };
+	enum { BUFFER_COUNT = 4 };
+	enum { BUFFER_SIZE = 16*1024 };
+
+	struct SHeader
+	{
+		uint32 magic;
+		uint32 version;
+		char   name[128];
+		uint32 columnCount;
+		uint32 recordSize;
+	};
+
+	// follows the header once per column
+	struct SColumnHeader
+	{
+		uint32 type;
+		char   name[MAX_NAME_LENGTH+1];
+	};
+
+	enum EBufferState
+	{
+		eBS_Free = 0,
+		eBS_Filling,
+		eBS_Full,
+	};
+
+	struct SBuffer
+	{
+		uint8        data[BUFFER_SIZE];
+		int          used;
+		EBufferState state;
+	};
+
+	static int GetColumnSize(EColumnType type) { return type == eCT_String ? MAX_STRING_LENGTH+1 : 4; }
+
+	// the slot of the column in the current record, 0 if the frame was dropped
+	uint8* GetSlot(int column, EColumnType type);
+	bool   Reserve(int size);
+	void   SubmitBuffer();
+	bool   WriteNextBuffer();
+
+	SBuffer      m_buffers[BUFFER_COUNT];
+	int          m_fillIndex;
+	int          m_writeIndex;
+
+	const SColumn *m_pColumns;
+	int          m_columnCount;
+	int          m_columnOffsets[MAX_COLUMNS];
+	int          m_recordSize;
+	uint8       *m_pRecord;
+
+	FILE        *m_pFile;
+	bool         m_registered;
+	int          m_frames;
+	int          m_droppedFrames;
+	size_t       m_bytesWritten;
+
+	CryFastLock  m_lock;
+	CryFastLock  m_writeLock;
+};
+
+#endif //__GAMEPLAY_RECORD_STREAM_H__
@@ -3030,6 +3030,10 @@ void CHUD::OnPostUpdate(float frameTime)
 		m_fCutsceneSkipTimer -= frameTime;
 	}
 
+	// rebuild the PDA objectives list once for all status changes of the frame
+	if (m_missionObjectiveSystem.ConsumeChanges())
+		UpdateObjectivesTab();
+
 	int width = gEnv->pRenderer->GetWidth();
 	int height = gEnv->pRenderer->GetHeight();
 	if(width != m_width || height != m_height)
@@ -4432,7 +4436,13 @@ void CHUD::UpdateObjective(CHUDMissionObjective *pObjective)
 		//this gives the objective's (tracked) id to the Radar ...
 		m_pHUDRadar->UpdateMissionObjective(pObjective->GetTrackedEntity(), active, pObjective->GetMapLabel(), pObjective->IsSecondary());
 	}
+	else //status changes refresh the tab once per frame in OnPostUpdate, this forces it
+		UpdateObjectivesTab();
+}
+//-----------------------------------------------------------------------------------------------------
 
+void CHUD::UpdateObjectivesTab()
+{
 	if(!gEnv->bMultiplayer || m_currentGameRules == EHUD_POWERSTRUGGLE || m_currentGameRules == EHUD_COOP) //in multiplayer the objectives are set in the miniMap only
 	{
 		m_animObjectivesTab.Invoke("resetObjectives");
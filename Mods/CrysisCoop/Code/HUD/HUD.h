@@ -342,6 +342,7 @@ public:
 	void UpdateMissionObjectiveIcon(EntityId objective, int friendly, FlashOnScreenIcon iconType, bool forceNoOffset = false, const Vec3 rotationTarget=Vec3(0, 0, 0));
 	void UpdateAllMissionObjectives();
 	void UpdateObjective(CHUDMissionObjective* pObjective);
+	void UpdateObjectivesTab();
 	void SetMainObjective(const char* objectiveKey, bool isGoal);
 	const char* GetMainObjective();
 	void AddOnScreenMissionObjective(IEntity *pEntity, int friendly);
@@ -17,6 +17,8 @@ void CHUDMissionObjective::SetStatus(HUDMissionStatus status)
 
 	assert (m_pMOS != 0);
 
+	m_pMOS->OnStatusChanged(this);
+
 	SAFE_HUD_FUNC(UpdateObjective(this));
 
 	m_lastTimeChanged = gEnv->pTimer->GetFrameStartTime().GetSeconds();
@@ -68,37 +70,60 @@ void CHUDMissionObjectiveSystem::LoadLevelObjectives(bool forceReloading)
 	if(!m_bLoadedObjectives || forceReloading)
 	{
 		m_currentMissionObjectives.clear();
-		CryFixedStringT<32> filename;
-
-		//Crysis Co-op
-		//const char* gameRulesName = g_pGame->GetGameRules()->GetEntity()->GetClass()->GetName();
-		//filename = "Libs/UI/Objectives_new.xml";
-		filename = "Libs/UI/Objectives_Coop.xml";
-		//if(gEnv->bMultiplayer && strcmp(gameRulesName, "Coop") != 0)
-			//filename = "Libs/UI/MP_Objectives.xml";
-		// ~Crysis Co-op
-
-		//additional objectives
-		if(gEnv->bEditor)
-		{
-			char *levelName;
-			char *levelPath;
-			g_pGame->GetIGameFramework()->GetEditorLevel(&levelName, &levelPath);
-			filename = levelPath;
-		}
-		else
-		{
-			ILevel *pLevel = g_pGame->GetIGameFramework()->GetILevelSystem()->GetCurrentLevel();
-			if(!pLevel)
-				return;
-			filename = pLevel->GetLevelInfo()->GetPath();
-		}
-		filename.append("/objectives.xml");
-		LoadLevelObjectives(filename.c_str());
+		m_handles.Clear();
+		m_changed.clear();
+		m_bAnyChanged = false;
+
+		string filename;
+		if(GetLevelObjectivesFile(filename))
+			LoadLevelObjectives(filename.c_str());
+
+		m_changed.resize((m_currentMissionObjectives.size() + 31) / 32, 0);
 	}
 }
 
+bool CHUDMissionObjectiveSystem::GetLevelObjectivesFile(string& filename)
+{
+	//Crysis Co-op
+	//const char* gameRulesName = g_pGame->GetGameRules()->GetEntity()->GetClass()->GetName();
+	//filename = "Libs/UI/Objectives_new.xml";
+	filename = "Libs/UI/Objectives_Coop.xml";
+	//if(gEnv->bMultiplayer && strcmp(gameRulesName, "Coop") != 0)
+		//filename = "Libs/UI/MP_Objectives.xml";
+	// ~Crysis Co-op
+
+	//additional objectives
+	if(gEnv->bEditor)
+	{
+		char *levelName;
+		char *levelPath;
+		g_pGame->GetIGameFramework()->GetEditorLevel(&levelName, &levelPath);
+		filename = levelPath;
+	}
+	else
+	{
+		ILevel *pLevel = g_pGame->GetIGameFramework()->GetILevelSystem()->GetCurrentLevel();
+		if(!pLevel)
+			return false;
+		filename = pLevel->GetLevelInfo()->GetPath();
+	}
+	filename.append("/objectives.xml");
+	return true;
+}
+
 void CHUDMissionObjectiveSystem::LoadLevelObjectives(const char *filename)
+{
+	ParseObjectives(filename, this, m_handles);
+}
+
+void CHUDMissionObjectiveSystem::LoadObjectiveHandles(const char *filename, CMissionObjectiveHandles& handles)
+{
+	handles.Clear();
+	ParseObjectives(filename, NULL, handles);
+}
+
+//objectives are only created if pMOS is set, the ids are always interned into handles
+void CHUDMissionObjectiveSystem::ParseObjectives(const char *filename, CHUDMissionObjectiveSystem* pMOS, CMissionObjectiveHandles& handles)
 {
 	XmlNodeRef missionObjectives = GetISystem()->LoadXmlFile(filename);
 	if (missionObjectives == 0)
@@ -138,7 +163,13 @@ void CHUDMissionObjectiveSystem::LoadLevelObjectives(const char *filename)
 						}
 					}
 				}
-				m_currentMissionObjectives.push_back(CHUDMissionObjective(this, id.c_str(), objective, text, mapLabel, secondaryObjective));
+				//duplicate ids keep the first objective, like the old linear search did
+				if(handles.Find(id.c_str()) != CMissionObjectiveHandles::INVALID_HANDLE)
+					continue;
+
+				const int handle = handles.Add(id.c_str());
+				if(pMOS)
+					pMOS->m_currentMissionObjectives.push_back(CHUDMissionObjective(pMOS, handle, id.c_str(), objective, text, mapLabel, secondaryObjective));
 			}
 			else
 				GameWarning("Error reading mission objectives.");
@@ -163,14 +194,35 @@ void CHUDMissionObjectiveSystem::DeactivateObjectives(bool leaveOutRecentlyChang
 
 CHUDMissionObjective* CHUDMissionObjectiveSystem::GetMissionObjective(const char* id)
 {
-	std::vector<CHUDMissionObjective>::iterator it;
-	for(it = m_currentMissionObjectives.begin(); it != m_currentMissionObjectives.end(); ++it)
-	{
-		if(!strcmp( (*it).GetID(), id))
-			return &(*it);
-	}
+	return GetMissionObjective(m_handles.Find(id));
+}
+
+CHUDMissionObjective* CHUDMissionObjectiveSystem::GetMissionObjective(int handle)
+{
+	if(handle < 0 || handle >= (int)m_currentMissionObjectives.size())
+		return NULL;
+
+	return &m_currentMissionObjectives[handle];
+}
+
+void CHUDMissionObjectiveSystem::OnStatusChanged(const CHUDMissionObjective* pObjective)
+{
+	const int handle = pObjective->GetHandle();
+	if(handle < 0 || (handle >> 5) >= (int)m_changed.size())
+		return;
+
+	m_changed[handle >> 5] |= 1u << (handle & 31);
+	m_bAnyChanged = true;
+}
 
-	return NULL;
+bool CHUDMissionObjectiveSystem::ConsumeChanges()
+{
+	if(!m_bAnyChanged)
+		return false;
+
+	std::fill(m_changed.begin(), m_changed.end(), 0);
+	m_bAnyChanged = false;
+	return true;
 }
 
 void CHUDMissionObjectiveSystem::Serialize(TSerialize ser)	//not tested!!
@@ -189,6 +241,8 @@ void CHUDMissionObjectiveSystem::Serialize(TSerialize ser)	//not tested!!
 
 		if(ser.IsReading() && (*it).m_eStatus != CHUDMissionObjective::DEACTIVATED)
 		{				
+			OnStatusChanged(&(*it));
+
 			CHUDMissionObjective obj = *it;
 			obj.m_lastTimeChanged = now;
 			bool isSilent = obj.IsSilent();
@@ -205,6 +259,89 @@ void CHUDMissionObjectiveSystem::GetMemoryStatistics(ICrySizer * s)
 	s->AddContainer(m_currentMissionObjectives);
 	for (size_t i=0; i<m_currentMissionObjectives.size(); i++)
 		m_currentMissionObjectives[i].GetMemoryStatistics(s);
+	m_handles.GetMemoryStatistics(s);
+	s->AddContainer(m_changed);
+}
+
+void CHUDMissionObjectiveSystem::Benchmark(const char *filename, int iterations)
+{
+	CHUDMissionObjectiveSystem mos;
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	mos.LoadLevelObjectives(filename);
+	const float loadTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	const int count = mos.GetObjectiveCount();
+	if(!count)
+	{
+		GameWarning("[HUDObjectives] No objectives in '%s'", filename);
+		return;
+	}
+
+	//ids are copied so the lookups don't hit the objectives' own strings
+	std::vector<string> ids;
+	ids.reserve(count);
+	for(int i = 0; i < count; ++i)
+		ids.push_back(mos.m_currentMissionObjectives[i].GetID());
+
+	int found = 0;
+	start = gEnv->pTimer->GetAsyncTime();
+	for(int n = 0; n < iterations; ++n)
+		found += mos.GetMissionObjective(ids[n%count].c_str()) != NULL;
+	const float handleTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	//the string search every lookup used to do
+	int foundLinear = 0;
+	start = gEnv->pTimer->GetAsyncTime();
+	for(int n = 0; n < iterations; ++n)
+	{
+		const char *id = ids[n%count].c_str();
+		for(std::vector<CHUDMissionObjective>::const_iterator it = mos.m_currentMissionObjectives.begin(); it != mos.m_currentMissionObjectives.end(); ++it)
+		{
+			if(!strcmp(it->GetID(), id))
+			{
+				++foundLinear;
+				break;
+			}
+		}
+	}
+	const float linearTime = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	CryLogAlways("[HUDObjectives] '%s': %d objectives loaded in %.3fms", filename, count, loadTime);
+	CryLogAlways("[HUDObjectives] %d lookups: interned %.3fms (%.3fus each), linear %.3fms (%.3fus each)",
+		iterations, handleTime, handleTime*1000.0f/max(1, iterations), linearTime, linearTime*1000.0f/max(1, iterations));
+
+	if(found != iterations || foundLinear != iterations)
+		GameWarning("[HUDObjectives] Lookups failed: %d interned, %d linear of %d", iterations-found, iterations-foundLinear, iterations);
+}
+
+void CMissionObjectiveHandles::Clear()
+{
+	m_ids.clear();
+	m_handles.clear();
+}
+
+int CMissionObjectiveHandles::Add(const char* id)
+{
+	const int handle = (int)m_ids.size();
+	m_ids.push_back(id);
+	m_handles.insert(THandleMap::value_type(m_ids.back(), handle));
+	return handle;
+}
+
+int CMissionObjectiveHandles::Find(const char* id) const
+{
+	THandleMap::const_iterator it = m_handles.find(CONST_TEMP_STRING(id));
+	if(it == m_handles.end())
+		return INVALID_HANDLE;
+	return it->second;
+}
+
+void CMissionObjectiveHandles::GetMemoryStatistics(ICrySizer * s)
+{
+	s->AddContainer(m_ids);
+	for (size_t i=0; i<m_ids.size(); i++)
+		s->Add(m_ids[i]);
 }
 
 void CHUDMissionObjective::SetTrackedEntity(EntityId entityID)
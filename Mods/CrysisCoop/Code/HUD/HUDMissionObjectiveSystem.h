@@ -45,12 +45,12 @@ public:
 		{}
 	};
 
-	CHUDMissionObjective() : m_pMOS(0), m_trackedEntity(0), m_eStatus(DEACTIVATED), m_lastTimeChanged(0), m_secondary(false)
+	CHUDMissionObjective() : m_pMOS(0), m_handle(-1), m_trackedEntity(0), m_eStatus(DEACTIVATED), m_lastTimeChanged(0), m_secondary(false)
 	{
 	}
 
-	CHUDMissionObjective(CHUDMissionObjectiveSystem* pMOS, const char* id, const char* shortMsg, const char* msg = 0, const char* mapLabel = 0, bool secondaryObjective = false)
-											: m_pMOS(pMOS), m_shortMessage(shortMsg), m_screenMessage(msg), m_id(id), m_silent(false), m_mapLabel(mapLabel)
+	CHUDMissionObjective(CHUDMissionObjectiveSystem* pMOS, int handle, const char* id, const char* shortMsg, const char* msg = 0, const char* mapLabel = 0, bool secondaryObjective = false)
+											: m_pMOS(pMOS), m_handle(handle), m_shortMessage(shortMsg), m_screenMessage(msg), m_id(id), m_silent(false), m_mapLabel(mapLabel)
 	{
 		m_eStatus = DEACTIVATED;
 		m_trackedEntity = 0;
@@ -109,6 +109,11 @@ public:
 		return m_id.c_str();
 	}
 
+	ILINE int GetHandle() const
+	{
+		return m_handle;
+	}
+
 	ILINE const char* GetMessage() const
 	{
 		return m_screenMessage.c_str();
@@ -151,6 +156,7 @@ protected:
 
 private:
 	CHUDMissionObjectiveSystem* m_pMOS;
+	int								m_handle;
 	string						m_shortMessage;
 	string						m_screenMessage;
 	string						m_id;
@@ -164,15 +170,42 @@ private:
 	std::map<int, HUDMissionStatusChange> m_mpChangeMap;
 };
 
+//interns the objective ids of a level into integer handles (0..count-1)
+//the handles follow the order of the objectives files, so they are the same on server and clients
+class CMissionObjectiveHandles
+{
+public:
+	enum { INVALID_HANDLE = -1 };
+
+	void Clear();
+	int Add(const char* id);
+	int Find(const char* id) const;
+
+	ILINE const char* GetID(int handle) const { return m_ids[handle].c_str(); }
+	ILINE int GetCount() const { return (int)m_ids.size(); }
+
+	void GetMemoryStatistics(ICrySizer * s);
+
+private:
+	typedef stl::hash_map<string, int, stl::hash_strcmp<string> > THandleMap;
+
+	std::vector<string>	m_ids;
+	THandleMap					m_handles;
+};
+
 class CHUDMissionObjectiveSystem
 {
-	//this is a list of the current level's mission objectives ...
+	//this is a list of the current level's mission objectives, indexed by handle ...
 	std::vector<CHUDMissionObjective> m_currentMissionObjectives;
+	CMissionObjectiveHandles m_handles;
+	//one bit per handle, set when the objective's status changed since the last ConsumeChanges
+	std::vector<uint32> m_changed;
+	bool m_bAnyChanged;
 	bool m_bLoadedObjectives;
 
 public:
 
-	CHUDMissionObjectiveSystem() : m_bLoadedObjectives(false)
+	CHUDMissionObjectiveSystem() : m_bAnyChanged(false), m_bLoadedObjectives(false)
 	{
 	}
 
@@ -198,11 +231,31 @@ public:
 	//get a pointer to the objective (NULL if not available)
 	//TODO: don't return ptr into a vector! If vector changes, ptr is trash!
 	CHUDMissionObjective* GetMissionObjective(const char* id);
+	CHUDMissionObjective* GetMissionObjective(int handle);
+
+	ILINE int GetObjectiveHandle(const char* id) const { return m_handles.Find(id); }
+	ILINE int GetObjectiveCount() const { return (int)m_currentMissionObjectives.size(); }
+
+	//called by CHUDMissionObjective::SetStatus
+	void OnStatusChanged(const CHUDMissionObjective* pObjective);
+
+	//returns true (and clears the bits) if any objective status changed since the last call
+	bool ConsumeChanges();
 
 	void Serialize(TSerialize ser);	//not tested!!
 
+	//path of the current level's objectives file
+	static bool GetLevelObjectivesFile(string& filename);
+
+	//interns the objective ids of the file without creating the objectives (dedicated server)
+	static void LoadObjectiveHandles(const char *filename, CMissionObjectiveHandles& handles);
+
+	//loads the file into a temporary system and times id lookups, see hud_objectivesBenchmark
+	static void Benchmark(const char *filename, int iterations);
+
 private:
 	void LoadLevelObjectives(const char *filename);
+	static void ParseObjectives(const char *filename, CHUDMissionObjectiveSystem* pMOS, CMissionObjectiveHandles& handles);
 };
 
 #endif
\ No newline at end of file
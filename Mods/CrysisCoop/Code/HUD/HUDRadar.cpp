@@ -74,6 +74,7 @@ CHUDRadar::CHUDRadar()
 	m_jammingValue = 0.0f;
 	m_jammerID = 0;
 	m_jammerDisconnectMap = false;
+	m_mapOverlayValueCount = 0;
 	m_mapId = 0;
 	m_fPDAZoomFactor = 1.0;
 	m_fPDATempZoomFactor = 1.0;
@@ -1753,7 +1754,9 @@ void CHUDRadar::RenderMapOverlay()
 
 	m_possibleOnScreenObjectives.resize(0);
 	//double array buffer for flash transfer optimization
-	std::vector<double> entityValues;
+	TDoubleArray entityValues;
+	// as many as the last map had, so the vector rarely grows
+	entityValues.reserve(m_mapOverlayValueCount);
 	int numOfValues = 0;
 	//array of text strings
 	std::map<EntityId, string> textOnMap;
@@ -1762,7 +1765,7 @@ void CHUDRadar::RenderMapOverlay()
 	float fY = 0;
 
 	//draw vehicles only once
-	std::map<EntityId, bool> drawnVehicles;
+	std::map<EntityId, bool, std::less<EntityId>, stl::FrameArenaAllocator<std::pair<const EntityId, bool> > > drawnVehicles;
 	
 	//the current GameRules
 	CGameRules *pGameRules = (CGameRules*)(gEnv->pGame->GetIGameFramework()->GetIGameRulesSystem()->GetCurrentGameRules());
@@ -2187,6 +2190,7 @@ void CHUDRadar::RenderMapOverlay()
 
 
 	ComputePositioning(vPlayerPos, &entityValues);
+	m_mapOverlayValueCount = entityValues.size();
 
 	//tell flash file that we are done ...
 	//m_flashMap->Invoke("updateObjects", "");
@@ -2205,7 +2209,7 @@ void CHUDRadar::RenderMapOverlay()
 //-----------------------------------------------------------------------------------------------------
 
 //calculate correct map positions, while the map is zoomed or translated
-void CHUDRadar::ComputePositioning(Vec2 playerpos, std::vector<double> *doubleArray)
+void CHUDRadar::ComputePositioning(Vec2 playerpos, TDoubleArray *doubleArray)
 {
 
 	bool bUpdate = false;
@@ -2685,7 +2689,7 @@ FlashRadarType CHUDRadar::GetSynchedEntityType(int type)
 	return EFirstType;
 }
 
-int CHUDRadar::FillUpDoubleArray(std::vector<double> *doubleArray, double a, double b, double c, double d, double e, double f, double g, double h, double i, double j, double k)
+int CHUDRadar::FillUpDoubleArray(TDoubleArray *doubleArray, double a, double b, double c, double d, double e, double f, double g, double h, double i, double j, double k)
 {
 	doubleArray->push_back(a);
 	doubleArray->push_back(b);
@@ -19,6 +19,7 @@ History:
 #include "HUDObject.h"
 #include <deque>
 #include <list>
+#include <STLFrameArenaAllocator.h>
 
 class CGameFlashAnimation;
 struct IActor;
@@ -39,6 +40,9 @@ class CHUDRadar : public CHUDObject
 
 	friend class CHUD;
 
+	// value stream of the PDA map icons, rebuilt every frame in the frame arena
+	typedef std::vector<double, stl::FrameArenaAllocator<double> > TDoubleArray;
+
 	struct RadarSound
 	{
 		Vec3		m_pos;
@@ -247,12 +251,12 @@ private:
 	//return whether the entity is friend or foe to the player
 	FlashRadarFaction	FriendOrFoe(bool multiplayer, int playerTeam, IEntity *entity, CGameRules *pGameRules);
 	//helper function to write (flash-) icon data to a double stream (implicitly casting for readability)
-	int FillUpDoubleArray(std::vector<double> *doubleArray, double entityId, double iconID, double posX, double posY,
+	int FillUpDoubleArray(TDoubleArray *doubleArray, double entityId, double iconID, double posX, double posY,
 												double rotation, double faction, double scaleX = 100.0, double scaleY = 100.0, double isOnScreenObjective = false, double isCurrentSpawnPoint = false, double isUnderAttack = false);
 	//helper function to scan an area for entities - currently the results are saved in m_entitiesInProximity
 	void ScanProximity(Vec3 &pos, float &radius);
 	//calculates minimap zoom and translation
-	void ComputePositioning(Vec2 playerpos, std::vector<double> *doubleArray);
+	void ComputePositioning(Vec2 playerpos, TDoubleArray *doubleArray);
 	//checks a transformed radar position for being inside the asset boudaries, if not returns the intersection point
 	bool RadarBounds_Inside(const Vec2 &pos, Vec2 &intersectionPoint);
 	//this is a 2d line intersection test (AB - PM)
@@ -306,6 +310,7 @@ private:
 	float			m_jammerRadius;
 	float			m_jammingValue;
 	bool			m_jammerDisconnectMap;
+	size_t		m_mapOverlayValueCount;
 
 	//broad scan parameter
 	bool		m_bsUseParameter, m_bsKeepEntries;
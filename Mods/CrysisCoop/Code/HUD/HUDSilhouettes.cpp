@@ -26,6 +26,15 @@ History:
 CHUDSilhouettes::CHUDSilhouettes()
 {
 	m_silhouettesVector.resize(256);
+
+	// slot 0 is handed out first
+	m_freeSlots.reserve(m_silhouettesVector.size());
+	for(int i=(int)m_silhouettesVector.size()-1; i>=0; --i)
+	{
+		m_silhouettesVector[i].iSlot = i;
+		m_freeSlots.push_back(i);
+	}
+	m_activeSlots.reserve(m_silhouettesVector.size());
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -53,6 +62,61 @@ void CHUDSilhouettes::SetVisionParams(EntityId uiEntityId,float r,float g,float
 
 //-----------------------------------------------------------------------------------------------------
 
+void CHUDSilhouettes::FlushVisionParams()
+{
+	for(TVisionParamsVector::const_iterator iter=m_visionParams.begin(); iter!=m_visionParams.end(); ++iter)
+		SetVisionParams(iter->uiEntityId,iter->r,iter->g,iter->b,iter->a);
+	m_visionParams.resize(0);
+}
+
+//-----------------------------------------------------------------------------------------------------
+
+CHUDSilhouettes::SSilhouette *CHUDSilhouettes::GetSlot(EntityId uiEntityId)
+{
+	TSlotMap::const_iterator iter = m_slotMap.find(uiEntityId);
+	if(iter == m_slotMap.end())
+		return NULL;
+	return &m_silhouettesVector[iter->second];
+}
+
+//-----------------------------------------------------------------------------------------------------
+
+CHUDSilhouettes::SSilhouette *CHUDSilhouettes::AllocSlot(EntityId uiEntityId)
+{
+	if(m_freeSlots.empty())
+		return NULL;
+
+	SSilhouette *pSilhouette = &m_silhouettesVector[m_freeSlots.back()];
+	m_freeSlots.pop_back();
+
+	pSilhouette->uiEntityId = uiEntityId;
+	pSilhouette->bValid = true;
+	pSilhouette->iActiveIndex = (int)m_activeSlots.size();
+	m_activeSlots.push_back(pSilhouette->iSlot);
+	m_slotMap[uiEntityId] = pSilhouette->iSlot;
+
+	return pSilhouette;
+}
+
+//-----------------------------------------------------------------------------------------------------
+
+void CHUDSilhouettes::ReleaseSlot(SSilhouette *pSilhouette)
+{
+	// swap the last active slot into the hole
+	int iLast = m_activeSlots.back();
+	m_activeSlots[pSilhouette->iActiveIndex] = iLast;
+	m_silhouettesVector[iLast].iActiveIndex = pSilhouette->iActiveIndex;
+	m_activeSlots.pop_back();
+
+	m_slotMap.erase(pSilhouette->uiEntityId);
+	m_freeSlots.push_back(pSilhouette->iSlot);
+
+	pSilhouette->bValid = false;
+	pSilhouette->iActiveIndex = -1;
+}
+
+//-----------------------------------------------------------------------------------------------------
+
 void CHUDSilhouettes::SetFlowGraphSilhouette(IEntity *pEntity,float r,float g,float b,float a,float fDuration)
 {
 	if(!pEntity)
@@ -85,40 +149,16 @@ void CHUDSilhouettes::SetSilhouette(IEntity *pEntity,float r,float g,float b,flo
 	if(!pEntity)
 		return;
 
-	SSilhouette *pSilhouette = NULL;
-
-	// First pass: is that Id already in a slot?
-	for(TSilhouettesVector::iterator iter=m_silhouettesVector.begin(); iter!=m_silhouettesVector.end(); ++iter)
-	{
-		SSilhouette *pSil = &(*iter);
-		if(pEntity->GetId() == pSil->uiEntityId)
-		{
-			pSilhouette = pSil;
-			break;
-		}
-	}
-
+	SSilhouette *pSilhouette = GetSlot(pEntity->GetId());
 	if(!pSilhouette)
-	{
-		// Second pass: try to find a free slot
-		for(TSilhouettesVector::iterator iter=m_silhouettesVector.begin(); iter!=m_silhouettesVector.end(); ++iter)
-		{
-			SSilhouette *pSil = &(*iter);
-			if(!pSil->bValid)
-			{
-				pSilhouette = pSil;
-				break;
-			}
-		}
-	}
+		pSilhouette = AllocSlot(pEntity->GetId());
 
 	CRY_ASSERT_MESSAGE(pSilhouette,"Vector size should be increased!");
 
 	if(pSilhouette)
 	{
-		pSilhouette->uiEntityId	= pEntity->GetId();
 		pSilhouette->fTime = fDuration;
-		pSilhouette->bValid			= true;
+		pSilhouette->iFadeStep = -1;
 		pSilhouette->r = r;
 		pSilhouette->g = g;
 		pSilhouette->b = b;
@@ -176,26 +216,20 @@ void CHUDSilhouettes::SetSilhouette(IVehicle *pVehicle,float r,float g,float b,f
 
 void CHUDSilhouettes::ResetSilhouette(EntityId uiEntityId)
 {
-	for(TSilhouettesVector::iterator iter=m_silhouettesVector.begin(); iter!=m_silhouettesVector.end(); ++iter)
-	{
-		SSilhouette *pSilhouette = &(*iter);
-
-		if(pSilhouette->uiEntityId == uiEntityId && pSilhouette->bValid)
-		{
-			std::map<EntityId, Vec3>::iterator it = GetFGSilhouette(pSilhouette->uiEntityId);
-			if(it != m_silhouettesFGVector.end())
-			{
-				Vec3 color = it->second;
-				SetVisionParams(uiEntityId, color.x, color.y, color.z, 1.0f);
-			}
-			else
-			{
-				SetVisionParams(pSilhouette->uiEntityId,0,0,0,0);
-				pSilhouette->bValid = false;
-			}
+	SSilhouette *pSilhouette = GetSlot(uiEntityId);
+	if(!pSilhouette)
+		return;
 
-			return;
-		}
+	std::map<EntityId, Vec3>::iterator it = GetFGSilhouette(pSilhouette->uiEntityId);
+	if(it != m_silhouettesFGVector.end())
+	{
+		Vec3 color = it->second;
+		SetVisionParams(uiEntityId, color.x, color.y, color.z, 1.0f);
+	}
+	else
+	{
+		SetVisionParams(pSilhouette->uiEntityId,0,0,0,0);
+		ReleaseSlot(pSilhouette);
 	}
 }
 
@@ -206,25 +240,22 @@ void CHUDSilhouettes::SetType(int iType)
 	// Exit of binoculars: we need to reset all silhouettes
 	if(0 == iType)
 	{
-		for(TSilhouettesVector::iterator iter=m_silhouettesVector.begin(); iter!=m_silhouettesVector.end(); ++iter)
+		// backwards, released slots are swapped in from the end
+		for(int i=(int)m_activeSlots.size()-1; i>=0; --i)
 		{
-			SSilhouette *pSilhouette = &(*iter);
+			SSilhouette *pSilhouette = &m_silhouettesVector[m_activeSlots[i]];
 
-			if(pSilhouette->bValid)
+			std::map<EntityId, Vec3>::iterator it = GetFGSilhouette(pSilhouette->uiEntityId);
+			if(it != m_silhouettesFGVector.end())
 			{
-				std::map<EntityId, Vec3>::iterator it = GetFGSilhouette(pSilhouette->uiEntityId);
-				if(it != m_silhouettesFGVector.end())
-				{
-					Vec3 color = it->second;
-					SetVisionParams(pSilhouette->uiEntityId, color.x, color.y, color.z, 1.0f);
-				}
-				else
-				{
-					SetVisionParams(pSilhouette->uiEntityId,0,0,0,0);
-					pSilhouette->bValid = false;
-				}
+				Vec3 color = it->second;
+				SetVisionParams(pSilhouette->uiEntityId, color.x, color.y, color.z, 1.0f);
+			}
+			else
+			{
+				SetVisionParams(pSilhouette->uiEntityId,0,0,0,0);
+				ReleaseSlot(pSilhouette);
 			}
-
 		}
 	}
 
@@ -235,28 +266,38 @@ void CHUDSilhouettes::SetType(int iType)
 
 void CHUDSilhouettes::Update(float frameTime)
 {
-	for(TSilhouettesVector::iterator iter=m_silhouettesVector.begin(); iter!=m_silhouettesVector.end(); ++iter)
+	// backwards, released slots are swapped in from the end
+	for(int i=(int)m_activeSlots.size()-1; i>=0; --i)
 	{
-		SSilhouette *pSilhouette = &(*iter);
+		SSilhouette *pSilhouette = &m_silhouettesVector[m_activeSlots[i]];
 
-		if(pSilhouette->bValid && pSilhouette->fTime != -1)
+		if(pSilhouette->fTime != -1)
 		{
 			pSilhouette->fTime -= frameTime;
 			if(pSilhouette->fTime < 0.0f)
 			{
-				SetVisionParams(pSilhouette->uiEntityId,0,0,0,0);
-				pSilhouette->bValid = false;
+				SVisionParams params = { pSilhouette->uiEntityId, 0, 0, 0, 0 };
+				m_visionParams.push_back(params);
 				pSilhouette->fTime = 0.0f;
+				ReleaseSlot(pSilhouette);
 			}
 			else if (pSilhouette->fTime < 1.0f)
 			{
-				// fade out for the last second
+				// fade out for the last second, the proxy only needs to hear about visible steps
 				float scale = pSilhouette->fTime ;
 				scale *= scale;
-				SetVisionParams(pSilhouette->uiEntityId,pSilhouette->r*scale,pSilhouette->g*scale,pSilhouette->b*scale,pSilhouette->a*scale);
+				int iFadeStep = int(scale*255.0f);
+				if(iFadeStep != pSilhouette->iFadeStep)
+				{
+					pSilhouette->iFadeStep = iFadeStep;
+					SVisionParams params = { pSilhouette->uiEntityId, pSilhouette->r*scale, pSilhouette->g*scale, pSilhouette->b*scale, pSilhouette->a*scale };
+					m_visionParams.push_back(params);
+				}
 			}
 		}
 	}
+
+	FlushVisionParams();
 }
 
 //-----------------------------------------------------------------------------------------------------
@@ -303,14 +344,5 @@ void CHUDSilhouettes::Serialize(TSerialize &ser)
 
 std::map<EntityId, Vec3>::iterator CHUDSilhouettes::GetFGSilhouette(EntityId id)
 {
-	std::map<EntityId, Vec3>::iterator returnVal = m_silhouettesFGVector.end();
-
-	std::map<EntityId, Vec3>::iterator it = m_silhouettesFGVector.begin();
-	std::map<EntityId, Vec3>::iterator end = m_silhouettesFGVector.end();
-	for(; it != end; ++it)
-	{
-		if(it->first == id)
-			returnVal = it;
-	}
-	return returnVal;
+	return m_silhouettesFGVector.find(id);
 }
\ No newline at end of file
@@ -42,17 +42,27 @@ public:
 private:
 
 	void SetVisionParams(EntityId uiEntityId,float r,float g,float b,float a);
+	void FlushVisionParams();
 
 	std::map<EntityId, Vec3>::iterator GetFGSilhouette(EntityId id);
 
+	struct SSilhouette;
+
+	SSilhouette *GetSlot(EntityId uiEntityId);
+	SSilhouette *AllocSlot(EntityId uiEntityId);
+	void ReleaseSlot(SSilhouette *pSilhouette);
+
 	struct SSilhouette
 	{
 		EntityId uiEntityId;
 		float fTime;
 		bool bValid;
 		float r, g, b, a;
+		int iSlot;
+		int iActiveIndex;		// position in m_activeSlots
+		int iFadeStep;			// last fade step sent to the render proxy, -1 if none
 
-		SSilhouette() : bValid(false)
+		SSilhouette() : bValid(false), iSlot(-1), iActiveIndex(-1), iFadeStep(-1)
 		{
 		}
 
@@ -68,8 +78,22 @@ private:
 		}
 	};
 
+	struct SVisionParams
+	{
+		EntityId uiEntityId;
+		float r, g, b, a;
+	};
+
 	typedef std::vector<SSilhouette> TSilhouettesVector;
+	typedef stl::hash_map<EntityId, int, stl::hash_uint32> TSlotMap;
+	typedef std::vector<int> TSlotVector;
+	typedef std::vector<SVisionParams> TVisionParamsVector;
+
 	TSilhouettesVector m_silhouettesVector;
+	TSlotMap m_slotMap;								// valid silhouettes by entity
+	TSlotVector m_freeSlots;					// stack of unused slots
+	TSlotVector m_activeSlots;				// valid slots, compact, iterated by Update
+	TVisionParamsVector m_visionParams;	// fade updates applied once per Update
 	std::map<EntityId, Vec3> m_silhouettesFGVector;
 };
 
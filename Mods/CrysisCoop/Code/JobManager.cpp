@@ -0,0 +1,632 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "JobManager.h"
+
+namespace
+{
+	// queue of the calling thread, workers set it at the start of their task update
+	THREADLOCAL int s_threadQueue = 0;
+
+	// ranges ParallelFor makes per thread, more than one so threads that are done early can steal
+	const int RANGES_PER_THREAD = 4;
+	// back-off rounds an idle worker keeps looking for jobs before it sleeps
+	const int IDLE_SPINS = 32;
+	// longest sleep of an idle worker, queuing a job wakes it earlier
+	const int SLEEP_MS = 5;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::CWorker::OnUpdate()
+{
+	// counted before m_active is checked, SetWorkerCount waits for it after clearing m_active
+	CryInterlockedIncrement(&m_inUpdate);
+
+	if (CryLoadAcquire(&m_active))
+	{
+		s_threadQueue = m_queue;
+
+		// the next batch of a frame usually follows right away, look for it a little before sleeping
+		CCrySpinBackoff backoff;
+		for (int idle=0; idle<IDLE_SPINS; ++idle)
+		{
+			if (m_pManager->RunOne(m_queue))
+			{
+				backoff = CCrySpinBackoff();
+				idle = -1;
+			}
+			else
+				backoff.Wait();
+		}
+
+		m_pManager->Sleep();
+	}
+
+	CryInterlockedDecrement(&m_inUpdate);
+}
+
+//------------------------------------------------------------------------
+CJobManager::CJobManager()
+: m_workerCount(0),
+	m_queued(0),
+	m_sleeping(0)
+{
+	for (int i=0; i<MAX_WORKERS; ++i)
+	{
+		m_workers[i].m_pManager = this;
+		m_workers[i].m_queue = i+1;
+	}
+}
+
+//------------------------------------------------------------------------
+CJobManager::~CJobManager()
+{
+	SetWorkerCount(0);
+
+	// groups that are still waited for must not be left behind
+	while (RunOne(0))
+		;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::SetWorkerCount(int count)
+{
+	count = CLAMP(count, 0, (int)MAX_WORKERS);
+
+	IThreadTaskManager *pTaskManager = gEnv->pSystem->GetIThreadTaskManager();
+	for (int i=0; i<MAX_WORKERS; ++i)
+	{
+		CWorker &worker = m_workers[i];
+		if (i < count && !worker.m_registered)
+		{
+			CryInterlockedTrySet(&worker.m_active, 0, 1);
+
+			SThreadTaskParams params;
+			params.nFlags = 0;
+			params.nPreferedThread = (i+1) % MAX_TASK_THREADS_COUNT;
+			pTaskManager->RegisterTask(&worker, params);
+			worker.m_registered = true;
+		}
+		else if (i >= count && worker.m_registered)
+		{
+			CryInterlockedTrySet(&worker.m_active, 1, 0);
+
+			pTaskManager->UnregisterTask(&worker);
+			worker.m_registered = false;
+		}
+	}
+
+	m_workerCount = count;
+
+	// wake the workers that were let go and wait until they finished their current job
+	{
+		CryAutoLock< CryCondLock<CRYLOCK_FAST> > lock(m_sleepLock);
+		m_sleepCond.Notify();
+	}
+	for (int i=count; i<MAX_WORKERS; ++i)
+	{
+		while (CryLoadAcquire(&m_workers[i].m_inUpdate))
+			CrySleep(1);
+	}
+}
+
+//------------------------------------------------------------------------
+int CJobManager::GetThreadQueue()
+{
+	return s_threadQueue;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Run(const SJob &job, CJobGroup &group, CJobGroup *pDependency)
+{
+	assert(job.pFunc || job.pRangeFunc);
+
+	SJob queued(job);
+	queued.pGroup = &group;
+	CryInterlockedIncrement(&group.m_pending);
+
+	if (pDependency)
+	{
+		// the last job of the dependency takes the same lock before it releases the waiting jobs
+		WriteLock lock(pDependency->m_lock);
+		if (CryLoadAcquire(&pDependency->m_pending) > 0)
+		{
+			pDependency->m_dependents.push_back(queued);
+			return;
+		}
+	}
+
+	Push(queued);
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Push(const SJob &job)
+{
+	const int queue = GetThreadQueue();
+	SQueue &q = m_queues[queue];
+
+	// counted first, so the count never drops below the jobs that are really queued
+	CryInterlockedIncrement(&m_queued);
+
+	bool queued = false;
+	{
+		WriteLock lock(q.lock);
+		if (q.count < QUEUE_SIZE)
+		{
+			q.ring[(q.head + q.count) % QUEUE_SIZE] = job;
+			CryStoreRelease(&q.count, q.count+1);
+			queued = true;
+		}
+	}
+
+	if (!queued)
+	{
+		// the queue is full, the thread that fills it has to do some of the work itself
+		CryInterlockedDecrement(&m_queued);
+		Execute(job, queue);
+		return;
+	}
+
+	// a wake up that is missed only costs the sleep timeout
+	if (CryLoadAcquire(&m_sleeping) > 0)
+	{
+		CryAutoLock< CryCondLock<CRYLOCK_FAST> > lock(m_sleepLock);
+		m_sleepCond.Notify();
+	}
+}
+
+//------------------------------------------------------------------------
+// runs the newest job of the queue or steals the oldest of another one,
+// returns false if there was none
+bool CJobManager::RunOne(int queue)
+{
+	if (CryLoadAcquire(&m_queued) <= 0)
+		return false;
+
+	SJob job;
+	bool found = false;
+	bool stolen = false;
+
+	for (int i=0; i<=MAX_WORKERS && !found; ++i)
+	{
+		// start next to our own queue, so thieves spread over the others
+		SQueue &q = m_queues[(queue + i) % (MAX_WORKERS+1)];
+		if (CryLoadAcquire(&q.count) == 0)
+			continue;
+
+		WriteLock lock(q.lock);
+		if (q.count == 0)
+			continue;
+
+		if (i == 0)
+		{
+			job = q.ring[(q.head + q.count - 1) % QUEUE_SIZE];
+		}
+		else
+		{
+			job = q.ring[q.head];
+			q.head = (q.head + 1) % QUEUE_SIZE;
+			stolen = true;
+		}
+		CryStoreRelease(&q.count, q.count-1);
+		found = true;
+	}
+
+	if (!found)
+		return false;
+
+	CryInterlockedDecrement(&m_queued);
+	if (stolen)
+		CryInterlockedIncrement(&m_queues[queue].stolen);
+
+	Execute(job, queue);
+	return true;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Execute(const SJob &job, int queue)
+{
+	{
+#if defined(USE_FRAME_PROFILER) && (!defined(_RELEASE) || defined(WIN64))
+		static CFrameProfiler s_jobProfiler(gEnv->pSystem, "CJobManager::Job", PROFILE_GAME);
+		CFrameProfilerSection section(job.pProfiler ? job.pProfiler : &s_jobProfiler);
+#endif
+
+		if (job.pFunc)
+			job.pFunc(job.pData);
+		else
+			job.pRangeFunc(job.pData, job.nBegin, job.nEnd);
+	}
+
+	CryInterlockedIncrement(&m_queues[queue].jobs);
+	Finish(*job.pGroup);
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Finish(CJobGroup &group)
+{
+	// all but the last job just count down, the group can be gone as soon as the last one let go of it
+	for (;;)
+	{
+		const int pending = CryLoadAcquire(&group.m_pending);
+		assert(pending > 0);
+		if (pending <= 1)
+			break;
+		if (CryInterlockedTrySet(&group.m_pending, pending, pending-1))
+			return;
+	}
+
+	std::vector<SJob> dependents;
+	{
+		WriteLock lock(group.m_lock);
+		// a job that was added meanwhile is the last one now
+		if (CryInterlockedDecrement(&group.m_pending) == 0)
+			dependents.swap(group.m_dependents);
+	}
+
+	for (int i=0; i<(int)dependents.size(); ++i)
+		Push(dependents[i]);
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Wait(CJobGroup &group)
+{
+	FRAME_PROFILER("CJobManager::Wait", gEnv->pSystem, PROFILE_GAME);
+
+	const int queue = GetThreadQueue();
+	CCrySpinBackoff backoff;
+	while (!group.IsDone())
+	{
+		if (RunOne(queue))
+			backoff = CCrySpinBackoff();
+		else
+			backoff.Wait();
+	}
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Sleep()
+{
+	CryAutoLock< CryCondLock<CRYLOCK_FAST> > lock(m_sleepLock);
+
+	CryInterlockedIncrement(&m_sleeping);
+	if (CryLoadAcquire(&m_queued) <= 0)
+		m_sleepCond.TimedWait(m_sleepLock, SLEEP_MS);
+	CryInterlockedDecrement(&m_sleeping);
+}
+
+//------------------------------------------------------------------------
+void CJobManager::ParallelFor(int count, int grainSize, JobRangeFunc pFunc, void *pData, CFrameProfiler *pProfiler)
+{
+	if (count <= 0)
+		return;
+
+	const int ranges = CLAMP(count / max(1, grainSize), 1, (m_workerCount+1) * RANGES_PER_THREAD);
+
+	CJobGroup group;
+	for (int i=0; i<ranges; ++i)
+	{
+		const int begin = (int)((int64)count * i / ranges);
+		const int end = (int)((int64)count * (i+1) / ranges);
+		Run(SJob(pFunc, pData, begin, end, pProfiler), group);
+	}
+
+	Wait(group);
+}
+
+//------------------------------------------------------------------------
+int CJobManager::GetStats(SStats *pStats, int maxStats)
+{
+	const int count = min(maxStats, (int)MAX_WORKERS+1);
+	for (int i=0; i<count; ++i)
+	{
+		pStats[i].jobs = CryLoadAcquire(&m_queues[i].jobs);
+		pStats[i].stolen = CryLoadAcquire(&m_queues[i].stolen);
+	}
+	return count;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::ResetStats()
+{
+	for (int i=0; i<=MAX_WORKERS; ++i)
+	{
+		CryStoreRelease(&m_queues[i].jobs, 0);
+		CryStoreRelease(&m_queues[i].stolen, 0);
+	}
+}
+
+//------------------------------------------------------------------------
+// Self test and benchmark
+//------------------------------------------------------------------------
+namespace
+{
+	void TestSpin(int rounds)
+	{
+		for (int i=0; i<rounds; ++i)
+			CryCpuPause();
+	}
+
+	void TestCount(void *pData)
+	{
+		CryInterlockedIncrement((volatile int*)pData);
+	}
+
+	struct SStageTest
+	{
+		volatile int done[3];
+		volatile int errors;
+		int jobs;
+	};
+
+	template <int stage> void TestStage(void *pData)
+	{
+		SStageTest &test = *(SStageTest*)pData;
+		// every job of the previous stage has to be finished before this one is queued
+		if (stage > 0 && CryLoadAcquire(&test.done[stage-1]) != test.jobs)
+			CryInterlockedIncrement(&test.errors);
+		TestSpin(64);
+		CryInterlockedIncrement(&test.done[stage]);
+	}
+
+	struct SNestedTest
+	{
+		CJobManager *pManager;
+		volatile int *pNodes;
+		int depth;
+	};
+
+	// every job runs four children and waits for them, so the workers wait inside jobs
+	void TestNested(void *pData)
+	{
+		const SNestedTest &parent = *(const SNestedTest*)pData;
+		CryInterlockedIncrement(parent.pNodes);
+		if (parent.depth <= 0)
+			return;
+
+		SNestedTest children[4];
+		CJobGroup group;
+		for (int i=0; i<4; ++i)
+		{
+			children[i] = parent;
+			children[i].depth = parent.depth-1;
+			parent.pManager->Run(SJob(TestNested, &children[i]), group);
+		}
+		parent.pManager->Wait(group);
+	}
+
+	struct SForTest
+	{
+		CJobManager *pManager;
+		std::vector<int> visits;
+		volatile int errors;
+		int count;
+		bool nested;
+	};
+
+	void TestFor(void *pData, int begin, int end)
+	{
+		SForTest &test = *(SForTest*)pData;
+		if (begin < 0 || end > test.count || begin >= end)
+		{
+			CryInterlockedIncrement(&test.errors);
+			return;
+		}
+
+		for (int i=begin; i<end; ++i)
+			++test.visits[i];
+
+		if (test.nested)
+		{
+			SForTest inner;
+			inner.pManager = test.pManager;
+			inner.visits.resize(17, 0);
+			inner.errors = 0;
+			inner.count = 17;
+			inner.nested = false;
+			test.pManager->ParallelFor(inner.count, 2, TestFor, &inner);
+			for (int i=0; i<inner.count; ++i)
+			{
+				if (inner.visits[i] != 1)
+					CryInterlockedIncrement(&test.errors);
+			}
+			if (inner.errors)
+				CryInterlockedIncrement(&test.errors);
+		}
+	}
+
+	bool TestParallelFor(CJobManager &manager, int count, int grainSize, bool nested)
+	{
+		SForTest test;
+		test.pManager = &manager;
+		test.visits.resize(count, 0);
+		test.errors = 0;
+		test.count = count;
+		test.nested = nested;
+
+		manager.ParallelFor(count, grainSize, TestFor, &test);
+
+		int wrong = 0;
+		for (int i=0; i<count; ++i)
+		{
+			if (test.visits[i] != 1)
+				++wrong;
+		}
+		if (wrong || test.errors)
+		{
+			GameWarning("[JobManager] ParallelFor(%d, %d%s): %d elements not visited once, %d bad ranges",
+				count, grainSize, nested ? ", nested" : "", wrong, (int)test.errors);
+			return false;
+		}
+		return true;
+	}
+
+	struct SBenchmarkData
+	{
+		std::vector<float> values;
+	};
+
+	ILINE float BenchmarkElement(int i)
+	{
+		float x = (float)(i & 1023) * 0.01f;
+		for (int j=0; j<32; ++j)
+			x = sqrtf(x*x + 1.0f) * 0.75f;
+		return x;
+	}
+
+	void BenchmarkRange(void *pData, int begin, int end)
+	{
+		SBenchmarkData &data = *(SBenchmarkData*)pData;
+		for (int i=begin; i<end; ++i)
+			data.values[i] = BenchmarkElement(i);
+	}
+
+	void BenchmarkEmpty(void *pData)
+	{
+	}
+}
+
+//------------------------------------------------------------------------
+bool CJobManager::SelfTest(CJobManager &manager, int iterations)
+{
+	bool ok = true;
+	manager.ResetStats();
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	for (int iteration=0; iteration<iterations; ++iteration)
+	{
+		// one group reused for several rounds, more jobs than a queue holds in the last one
+		{
+			CJobGroup group;
+			const int rounds[] = { 1, 100, QUEUE_SIZE*3 };
+			for (int r=0; r<3; ++r)
+			{
+				volatile int counter = 0;
+				for (int i=0; i<rounds[r]; ++i)
+					manager.Run(SJob(TestCount, (void*)&counter), group);
+				manager.Wait(group);
+				if (counter != rounds[r])
+				{
+					GameWarning("[JobManager] %d of %d jobs ran", (int)counter, rounds[r]);
+					ok = false;
+				}
+			}
+		}
+
+		// three stages, each waiting for the one before, and a dependency that is already done
+		{
+			SStageTest test;
+			memset(&test, 0, sizeof(test));
+			test.jobs = 64;
+
+			CJobGroup stages[3];
+			for (int i=0; i<test.jobs; ++i)
+				manager.Run(SJob(TestStage<0>, &test), stages[0]);
+			for (int i=0; i<test.jobs; ++i)
+				manager.Run(SJob(TestStage<1>, &test), stages[1], &stages[0]);
+			for (int i=0; i<test.jobs; ++i)
+				manager.Run(SJob(TestStage<2>, &test), stages[2], &stages[1]);
+			manager.Wait(stages[2]);
+
+			if (!stages[0].IsDone() || !stages[1].IsDone())
+			{
+				GameWarning("[JobManager] A group finished before the group it depends on");
+				ok = false;
+				manager.Wait(stages[0]);
+				manager.Wait(stages[1]);
+			}
+
+			volatile int counter = 0;
+			CJobGroup late;
+			manager.Run(SJob(TestCount, (void*)&counter), late, &stages[0]);
+			manager.Wait(late);
+
+			if (test.errors || test.done[2] != test.jobs || counter != 1)
+			{
+				GameWarning("[JobManager] Dependencies: %d jobs started early, %d of %d jobs ran in the last stage",
+					(int)test.errors, (int)test.done[2], test.jobs);
+				ok = false;
+			}
+		}
+
+		// jobs that wait for jobs
+		{
+			volatile int nodes = 0;
+			SNestedTest root;
+			root.pManager = &manager;
+			root.pNodes = &nodes;
+			root.depth = 4;
+
+			CJobGroup group;
+			manager.Run(SJob(TestNested, &root), group);
+			manager.Wait(group);
+
+			const int expected = 1 + 4 + 16 + 64 + 256;
+			if (nodes != expected)
+			{
+				GameWarning("[JobManager] Nested waits: %d of %d jobs ran", (int)nodes, expected);
+				ok = false;
+			}
+		}
+
+		const int counts[] = { 0, 1, 7, 1000, 100003 };
+		const int grains[] = { 1, 16, 1000 };
+		for (int c=0; c<5; ++c)
+		{
+			for (int g=0; g<3; ++g)
+				ok &= TestParallelFor(manager, counts[c], grains[g], false);
+		}
+		ok &= TestParallelFor(manager, 64, 1, true);
+	}
+
+	const float seconds = (gEnv->pTimer->GetAsyncTime()-startTime).GetSeconds();
+
+	SStats stats[MAX_WORKERS+1];
+	const int statCount = manager.GetStats(stats, MAX_WORKERS+1);
+	string perQueue;
+	for (int i=0; i<statCount; ++i)
+	{
+		string entry;
+		entry.Format(" %d/%d", stats[i].jobs, stats[i].stolen);
+		perQueue += entry;
+	}
+
+	CryLogAlways("[JobManager] Self test %s with %d workers: %d iterations in %.3fs, jobs/stolen per queue:%s",
+		ok ? "passed" : "FAILED", manager.GetWorkerCount(), iterations, seconds, perQueue.c_str());
+	return ok;
+}
+
+//------------------------------------------------------------------------
+void CJobManager::Benchmark(CJobManager &manager, int count)
+{
+	count = max(1, count);
+
+	SBenchmarkData serial, parallel;
+	serial.values.resize(count, 0.0f);
+	parallel.values.resize(count, 0.0f);
+
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	BenchmarkRange(&serial, 0, count);
+	const float serialTime = max(0.000001f, (gEnv->pTimer->GetAsyncTime()-start).GetSeconds());
+
+	start = gEnv->pTimer->GetAsyncTime();
+	manager.ParallelFor(count, 1024, BenchmarkRange, &parallel);
+	const float parallelTime = max(0.000001f, (gEnv->pTimer->GetAsyncTime()-start).GetSeconds());
+
+	if (serial.values != parallel.values)
+		GameWarning("[JobManager] The parallel loop computed different values");
+
+	// cost of a job that does nothing, queuing, running and counting it down
+	const int jobs = 100000;
+	CJobGroup group;
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int i=0; i<jobs; ++i)
+		manager.Run(SJob(BenchmarkEmpty, 0), group);
+	manager.Wait(group);
+	const float jobTime = (gEnv->pTimer->GetAsyncTime()-start).GetSeconds();
+
+	CryLogAlways("[JobManager] %d elements with %d workers: loop %.3fms, parallel-for %.3fms (%.2fx), empty job %.3fus",
+		count, manager.GetWorkerCount(), serialTime*1000.0f, parallelTime*1000.0f, serialTime/parallelTime, jobTime*1000000.0f/jobs);
+}
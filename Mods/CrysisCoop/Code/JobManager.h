@@ -0,0 +1,186 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __JOB_MANAGER_H__
+#define __JOB_MANAGER_H__
+
+#pragma once
+
+#include <IThreadTask.h>
+#include <CryThread.h>
+
+// Short fork/join jobs for the game module.
+// IThreadTaskManager only runs long lived tasks, so the job manager
+// registers one worker task per task thread (g_jobThreads of them, none by
+// default since an idle worker still polls its task thread) and feeds it
+// from its own queue of small jobs:
+//  - every worker, and all other threads together, own a queue. A thread
+//    runs its newest job first and, when its queue is empty, steals the
+//    oldest job of another queue
+//  - jobs are counted by a CJobGroup, a job can also wait for another group
+//    to finish before it is queued
+//  - Wait() runs queued jobs until the group is done, so waiting inside a
+//    job never blocks a worker, and everything still runs with 0 workers
+// Every job runs inside a frame profiler section, of the profiler given
+// with the job (see JOB_PROFILER) or of "CJobManager::Job".
+// No game system queues jobs yet. The per-entity loops that would profit,
+// like the radar classification in CHUDRadar::UpdateRadarEntities, query the
+// entity, actor and AI systems, which may only be used on the main thread.
+
+class CJobGroup;
+
+typedef void (*JobFunc)(void *pData);
+// processes the elements [nBegin, nEnd)
+typedef void (*JobRangeFunc)(void *pData, int nBegin, int nEnd);
+
+struct SJob
+{
+	SJob() : pFunc(0), pRangeFunc(0), pData(0), nBegin(0), nEnd(0), pProfiler(0), pGroup(0) {}
+	SJob(JobFunc func, void *data, CFrameProfiler *profiler=0)
+		: pFunc(func), pRangeFunc(0), pData(data), nBegin(0), nEnd(0), pProfiler(profiler), pGroup(0) {}
+	SJob(JobRangeFunc func, void *data, int begin, int end, CFrameProfiler *profiler=0)
+		: pFunc(0), pRangeFunc(func), pData(data), nBegin(begin), nEnd(end), pProfiler(profiler), pGroup(0) {}
+
+	JobFunc pFunc;
+	JobRangeFunc pRangeFunc;
+	void *pData;
+	int nBegin;
+	int nEnd;
+	CFrameProfiler *pProfiler;
+	CJobGroup *pGroup;         // set by CJobManager::Run
+};
+
+// Declares the profiler the jobs of a call site report to:
+//   JOB_PROFILER(pProfiler, "CMySystem::UpdateRange");
+//   pJobManager->ParallelFor(count, 16, UpdateRange, this, pProfiler);
+#if defined(USE_FRAME_PROFILER) && (!defined(_RELEASE) || defined(WIN64))
+#define JOB_PROFILER(var, szName) \
+	static CFrameProfiler var##Instance(gEnv->pSystem, szName, PROFILE_GAME); \
+	CFrameProfiler *var = &var##Instance
+#else
+#define JOB_PROFILER(var, szName) CFrameProfiler *var = 0
+#endif
+
+// Counts the jobs that were run on it and have not finished yet.
+// A group can be reused once it is done, it must not be destroyed before.
+class CJobGroup
+{
+public:
+	CJobGroup() : m_pending(0), m_lock(0) {}
+	~CJobGroup() { assert(IsDone()); }
+
+	bool IsDone()
+	{
+		// the last job releases the group under m_lock, the group is only free once it let go of it
+		return CryLoadAcquire(&m_pending) == 0 && CryLoadAcquire(&m_lock) == 0;
+	}
+
+private:
+	friend class CJobManager;
+
+	CJobGroup(const CJobGroup&);
+	CJobGroup& operator=(const CJobGroup&);
+
+	volatile int m_pending;
+	volatile int m_lock;
+	// jobs that wait for this group to finish
+	std::vector<SJob> m_dependents;
+};
+
+class CJobManager
+{
+public:
+	enum { MAX_WORKERS = MAX_TASK_THREADS_COUNT };
+	// jobs a queue holds, a thread runs jobs itself when its queue is full
+	enum { QUEUE_SIZE = 1024 };
+
+	struct SStats
+	{
+		int jobs;      // jobs run by the threads of a queue
+		int stolen;    // of them taken from another queue
+	};
+
+	CJobManager();
+	~CJobManager();
+
+	// registers or unregisters worker tasks, main thread only
+	void SetWorkerCount(int count);
+	int GetWorkerCount() const { return m_workerCount; }
+
+	// queues a job, group counts it until it has run; with a dependency the job is
+	// only queued once that group is done
+	void Run(const SJob &job, CJobGroup &group, CJobGroup *pDependency=0);
+	// runs queued jobs until all jobs of the group have finished
+	void Wait(CJobGroup &group);
+
+	// splits [0, count) into ranges of at least grainSize elements, runs them on the
+	// workers and the calling thread and returns once all are done
+	void ParallelFor(int count, int grainSize, JobRangeFunc pFunc, void *pData, CFrameProfiler *pProfiler=0);
+
+	// stats of queue 0 (all threads but the workers) and of every worker queue since the last reset,
+	// returns the number of entries written
+	int GetStats(SStats *pStats, int maxStats);
+	void ResetStats();
+
+	// runs groups, dependencies, nested waits, queue overflow and parallel-for on this manager,
+	// returns false (and logs why) if anything is wrong
+	static bool SelfTest(CJobManager &manager, int iterations);
+	// times a parallel-for over count elements against a plain loop, and the cost of tiny jobs
+	static void Benchmark(CJobManager &manager, int count);
+
+private:
+	class CWorker : public IThreadTask
+	{
+	public:
+		CWorker() : m_pManager(0), m_queue(0), m_active(0), m_inUpdate(0), m_registered(false) {}
+
+		// IThreadTask
+		virtual void OnUpdate();
+		// ~IThreadTask
+
+		CJobManager *m_pManager;
+		int m_queue;
+		volatile int m_active;
+		volatile int m_inUpdate;
+		bool m_registered;
+	};
+
+	// Ring buffer of jobs, the owner works at the back, thieves take from the front.
+	struct SQueue
+	{
+		SQueue() : lock(0), head(0), count(0), jobs(0), stolen(0) {}
+
+		volatile int lock;
+		int head;
+		volatile int count;
+		volatile int jobs;
+		volatile int stolen;
+		SJob ring[QUEUE_SIZE];
+	};
+
+	CJobManager(const CJobManager&);
+	CJobManager& operator=(const CJobManager&);
+
+	// queue of the calling thread
+	static int GetThreadQueue();
+
+	void Push(const SJob &job);
+	bool RunOne(int queue);
+	void Execute(const SJob &job, int queue);
+	void Finish(CJobGroup &group);
+	// parks an idle worker until jobs are queued or a few ms passed
+	void Sleep();
+
+	SQueue m_queues[MAX_WORKERS+1];
+	CWorker m_workers[MAX_WORKERS];
+	int m_workerCount;
+
+	// queued jobs over all queues, lets idle threads skip the scan
+	volatile int m_queued;
+	volatile int m_sleeping;
+	CryCondLock<CRYLOCK_FAST> m_sleepLock;
+	CryCond< CryCondLock<CRYLOCK_FAST> > m_sleepCond;
+};
+
+#endif //__JOB_MANAGER_H__
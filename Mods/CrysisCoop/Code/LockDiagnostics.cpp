@@ -0,0 +1,156 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "LockDiagnostics.h"
+
+namespace
+{
+	struct SStressShared
+	{
+		SStressShared() : lock(0), writersInside(0), a(0), b(0), stop(0), finished(0), errors(0) {}
+
+		volatile int lock;
+		volatile int writersInside;
+		// a writer changes both, readers must never see them differ
+		volatile int a;
+		volatile int b;
+		volatile int stop;
+		volatile int finished;
+		volatile int errors;
+	};
+
+	struct SStressThread
+	{
+		SStressThread() : pShared(0), ops(0) {}
+
+		SStressShared *pShared;
+		int ops;
+	};
+
+	// some work outside the lock, otherwise the readers never let the count drop to zero
+	void StressIdle()
+	{
+		for (int i=0; i<32; ++i)
+			CryCpuPause();
+	}
+
+	void StressReader(void *pParam)
+	{
+		SStressThread *pThread = (SStressThread*)pParam;
+		SStressShared &shared = *pThread->pShared;
+
+		while (!shared.stop)
+		{
+			{
+				ReadLock lock(shared.lock);
+				if (shared.a != shared.b || shared.writersInside)
+					CryInterlockedAdd(&shared.errors, 1);
+			}
+			++pThread->ops;
+			StressIdle();
+		}
+
+		CryInterlockedIncrement(&shared.finished);
+	}
+
+	void StressWriter(void *pParam)
+	{
+		SStressThread *pThread = (SStressThread*)pParam;
+		SStressShared &shared = *pThread->pShared;
+
+		while (!shared.stop)
+		{
+			{
+				WriteLock lock(shared.lock);
+				if (CryInterlockedIncrement(&shared.writersInside) != 1)
+					CryInterlockedAdd(&shared.errors, 1);
+				++shared.a;
+				CryCpuPause();
+				++shared.b;
+				CryInterlockedDecrement(&shared.writersInside);
+			}
+			++pThread->ops;
+			StressIdle();
+		}
+
+		CryInterlockedIncrement(&shared.finished);
+	}
+
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	bool CompareWaitTicks(const SCryLockContentionStats &lhs, const SCryLockContentionStats &rhs)
+	{
+		return lhs.nWaitTicks > rhs.nWaitTicks;
+	}
+#endif
+}
+
+//------------------------------------------------------------------------
+void CLockDiagnostics::DumpContention(bool reset)
+{
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	std::vector<SCryLockContentionStats> stats(CRY_LOCK_CONTENTION_MAX_LOCKS);
+	stats.resize(CryLockContentionGetStats(&stats[0], CRY_LOCK_CONTENTION_MAX_LOCKS));
+	std::sort(stats.begin(), stats.end(), CompareWaitTicks);
+
+	CryLogAlways("[LockContention] %d contended locks in the game module", (int)stats.size());
+	CryLogAlways("[LockContention] %-18s %-24s %10s %12s %10s %14s %12s", "lock", "name", "contended", "spins", "yields", "wait ticks", "max wait");
+	for (size_t i=0; i<stats.size(); ++i)
+	{
+		const SCryLockContentionStats &s = stats[i];
+		CryLogAlways("[LockContention] %-18p %-24s %10I64d %12I64d %10I64d %14I64d %12I64d",
+			(const void*)s.pLock, s.sName ? s.sName : "", s.nContended, s.nSpins, s.nYields, s.nWaitTicks, s.nMaxWaitTicks);
+	}
+
+	if (reset)
+		CryLockContentionReset();
+#else
+	CryLogAlways("[LockContention] The game module was built without CRY_LOCK_CONTENTION_PROFILE");
+#endif
+}
+
+//------------------------------------------------------------------------
+bool CLockDiagnostics::StressTest(int readers, int writers, float seconds)
+{
+	SStressShared shared;
+	std::vector<SStressThread> threads(readers+writers);
+	std::vector<CCryThread*> handles;
+
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	CryLockContentionSetName(&shared.lock, "stress test");
+#endif
+
+	const CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int i=0; i<readers+writers; ++i)
+	{
+		threads[i].pShared = &shared;
+		handles.push_back(new CCryThread(i<readers ? StressReader : StressWriter, &threads[i]));
+	}
+
+	CrySleep((unsigned int)(seconds*1000.0f));
+	shared.stop = 1;
+
+	// CCryThread can't be relied on to join, threads started with _beginthread close their own handle
+	while (shared.finished < readers+writers)
+		CrySleep(1);
+	for (size_t i=0; i<handles.size(); ++i)
+		delete handles[i];
+	const float time = max(0.001f, (gEnv->pTimer->GetAsyncTime()-start).GetSeconds());
+
+	int readOps = 0, writeOps = 0;
+	for (int i=0; i<readers+writers; ++i)
+		(i<readers ? readOps : writeOps) += threads[i].ops;
+
+	// every write was seen by the counters exactly once, and nobody still holds the lock
+	const bool passed = !shared.errors && shared.a == writeOps && shared.b == writeOps && !shared.lock;
+
+	CryLogAlways("[LockStressTest] %d readers, %d writers, %.2fs: %d reads (%.0f/s), %d writes (%.0f/s), %d violations, %s",
+		readers, writers, time, readOps, readOps/time, writeOps, writeOps/time, shared.errors, passed ? "passed" : "FAILED");
+
+#if defined(CRY_LOCK_CONTENTION_PROFILE)
+	DumpContention(false);
+#endif
+
+	return passed;
+}
@@ -0,0 +1,26 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __LOCK_DIAGNOSTICS_H__
+#define __LOCK_DIAGNOSTICS_H__
+
+#pragma once
+
+// Console diagnostics for the spin locks of MultiThread.h.
+// The contention table only has content in modules compiled with
+// CRY_LOCK_CONTENTION_PROFILE, which the Profile configurations of the game
+// module define. It only covers the locks taken by the game module itself,
+// every module keeps its own table.
+class CLockDiagnostics
+{
+public:
+	// prints the contended locks of the game module sorted by total wait time
+	static void DumpContention(bool reset);
+
+	// runs readers and writers against one ReadLock/WriteLock word for the given time,
+	// checks mutual exclusion and logs the throughput, returns false on a violation
+	static bool StressTest(int readers, int writers, float seconds);
+};
+
+#endif //__LOCK_DIAGNOSTICS_H__
@@ -248,6 +248,13 @@ void CNanoSuit::Reset(CPlayer *owner)
 	m_bSprintUnderwater = false;
 	m_energy = 0.0f;
 
+	m_netEnergy = 0.0f;
+	m_netEnergyRate = 0.0f;
+	m_netEnergyTime = 0.0f;
+	m_netEnergyChanges = 0;
+	m_netEnergySends = 0;
+	m_netEnergyDebugTime = 0.0f;
+
 	m_bNightVisionEnabled = false;
 
 	for(int k = 0; k < NANOSLOT_LAST; ++k)
@@ -518,8 +525,13 @@ void CNanoSuit::Update(float frameTime)
 		if (recharge < 0.0f || m_energyRechargeDelay <= 0.0f)
 		{
 			SetSuitEnergy(clamp(m_energy + recharge*frameTime, 0.0f, NANOSUIT_ENERGY));
+			NetUpdateEnergy(recharge);
 		}
+		else
+			NetUpdateEnergy(0.0f);
 	}
+	else
+		NetPredictEnergy(frameTime);
 
 	//CryLogAlways("%s Suit Energy: %.3f", m_pOwner->GetEntity()->GetName(), m_energy);
 
@@ -562,8 +574,7 @@ void CNanoSuit::Update(float frameTime)
 
 	if (m_energy!=m_lastEnergy)
 	{
-		if (isServer)
-			m_pOwner->GetGameObject()->ChangedNetworkState(CPlayer::ASPECT_NANO_SUIT_ENERGY);
+		++m_netEnergyChanges;
 
 		// call listeners on nano energy change
 		if (m_listeners.empty() == false)
@@ -612,6 +623,163 @@ void CNanoSuit::Update(float frameTime)
 	m_lastEnergy = m_energy;
 }
 
+//quantization for the energy aspect: 8 bits of energy, rate in whole points per second
+static ILINE uint8 QuantizeNetEnergy(float energy)
+{
+	return (uint8)int_round(clamp(energy, 0.0f, NANOSUIT_ENERGY) * (255.0f / NANOSUIT_ENERGY));
+}
+
+static ILINE float DequantizeNetEnergy(uint8 energy)
+{
+	return energy * (NANOSUIT_ENERGY / 255.0f);
+}
+
+static ILINE uint8 QuantizeNetEnergyRate(float rate)
+{
+	return (uint8)(clamp(int_round(rate), -127, 127) + 128);
+}
+
+static ILINE float DequantizeNetEnergyRate(uint8 rate)
+{
+	return (float)((int)rate - 128);
+}
+
+void CNanoSuit::NetUpdateEnergy(float rate)
+{
+	//AI suits are not serialized, see CPlayer::NetSerialize
+	if (!gEnv->bMultiplayer || !m_pOwner->IsPlayer())
+		return;
+
+	if ((rate > 0.0f && m_energy >= NANOSUIT_ENERGY) || (rate < 0.0f && m_energy <= 0.0f))
+		rate = 0.0f;
+
+	float now = gEnv->pTimer->GetFrameStartTime().GetSeconds();
+
+	if (NetEnergyNeedsUpdate(m_netEnergy, m_netEnergyRate, now - m_netEnergyTime, m_energy, rate))
+	{
+		bool sentThisFrame = (m_netEnergyTime == now);
+
+		m_netEnergy = m_energy;
+		m_netEnergyRate = DequantizeNetEnergyRate(QuantizeNetEnergyRate(rate));
+		m_netEnergyTime = now;
+
+		if (!sentThisFrame)
+		{
+			++m_netEnergySends;
+			m_pOwner->GetGameObject()->ChangedNetworkState(CPlayer::ASPECT_NANO_SUIT_ENERGY);
+		}
+	}
+
+	if (g_pGameCVars->g_suitEnergyNetDebug && now - m_netEnergyDebugTime > 5.0f)
+	{
+		CryLogAlways("[nano] %s energy: %d changes, %d updates sent (%d bytes vs %d bytes)", m_pOwner->GetEntity()->GetName(),
+			m_netEnergyChanges, m_netEnergySends, m_netEnergySends * 2, m_netEnergyChanges * 4);
+		m_netEnergyChanges = 0;
+		m_netEnergySends = 0;
+		m_netEnergyDebugTime = now;
+	}
+}
+
+bool CNanoSuit::NetEnergyNeedsUpdate(float netEnergy, float netRate, float elapsed, float energy, float rate)
+{
+	float predicted = clamp(netEnergy + netRate * elapsed, 0.0f, NANOSUIT_ENERGY);
+
+	//resend when the client drifted, the rate changed, or to settle exactly on empty/full
+	bool drifted = fabsf(predicted - energy) > g_pGameCVars->g_suitEnergyNetThreshold;
+	bool rateChanged = QuantizeNetEnergyRate(rate) != QuantizeNetEnergyRate(netRate);
+	bool settled = (energy <= 0.0f || energy >= NANOSUIT_ENERGY) && QuantizeNetEnergy(predicted) != QuantizeNetEnergy(energy);
+
+	return drifted || rateChanged || settled;
+}
+
+void CNanoSuit::NetPredictEnergy(float frameTime)
+{
+	if (!gEnv->bMultiplayer || m_netEnergyRate == 0.0f)
+		return;
+
+	//integrate rather than overwrite, so local energy consumption shows until the server corrects it
+	m_energy = clamp(m_energy + m_netEnergyRate * frameTime, 0.0f, NANOSUIT_ENERGY);
+}
+
+void CNanoSuit::BenchmarkNetEnergy(float seconds, int fps, int sendRate)
+{
+	//a 30 second loop of a multiplayer player: sprint, recharge, cloak at varying speed, get hit, recharge
+	const float frameTime = 1.0f / fps;
+	const float sendInterval = 1.0f / sendRate;
+	const float rechargeRate = NANOSUIT_ENERGY / max(0.01f, g_pGameCVars->g_playerSuitEnergyRechargeTime);
+	const float sprintRate = -g_pGameCVars->g_suitSpeedEnergyConsumptionMultiplayer;
+	const float cloakCost = 2.0f * g_pGameCVars->g_suitCloakEnergyDrainAdjuster;
+
+	//old policy: the aspect is dirtied on every change and goes out with the next packet as a float
+	int oldUpdates = 0;
+	//new policy: NetEnergyNeedsUpdate, two bytes per update, the client predicts in between
+	int newUpdates = 0;
+	float netEnergy = NANOSUIT_ENERGY, netRate = 0.0f, netTime = 0.0f;
+	bool oldDirty = false, newDirty = false;
+	float client = NANOSUIT_ENERGY, maxError = 0.0f, sumError = 0.0f;
+	float nextSend = 0.0f;
+
+	float energy = NANOSUIT_ENERGY;
+	const int frames = (int)(seconds * fps);
+	for (int i = 0; i < frames; ++i)
+	{
+		float t = i * frameTime;
+		float cycle = fmodf(t, 30.0f);
+
+		float rate = rechargeRate;
+		if (cycle < 3.0f)
+			rate = sprintRate;
+		else if (cycle >= 10.0f && cycle < 18.0f)
+			rate = -max(1.0f, cloakCost * (2.0f + 1.5f * sinf(t * 1.3f)) * 0.5f);
+		else if (cycle >= 18.0f && cycle < 19.0f)
+			rate = 0.0f; //recharge delay after the hits
+
+		float last = energy;
+		energy = clamp(energy + rate * frameTime, 0.0f, NANOSUIT_ENERGY);
+		if (cycle >= 18.0f && cycle - frameTime < 18.0f)
+			energy = max(0.0f, energy - 40.0f);
+
+		if ((rate > 0.0f && energy >= NANOSUIT_ENERGY) || (rate < 0.0f && energy <= 0.0f))
+			rate = 0.0f;
+
+		if (energy != last)
+			oldDirty = true;
+
+		if (NetEnergyNeedsUpdate(netEnergy, netRate, t - netTime, energy, rate))
+		{
+			netEnergy = energy;
+			netRate = DequantizeNetEnergyRate(QuantizeNetEnergyRate(rate));
+			netTime = t;
+			newDirty = true;
+		}
+
+		//packets go out at the send rate, a dirty aspect is written once per packet
+		client = clamp(client + netRate * frameTime, 0.0f, NANOSUIT_ENERGY);
+		if (t >= nextSend)
+		{
+			nextSend += sendInterval;
+			if (oldDirty)
+				++oldUpdates;
+			if (newDirty)
+			{
+				++newUpdates;
+				client = DequantizeNetEnergy(QuantizeNetEnergy(netEnergy + netRate * (t - netTime)));
+			}
+			oldDirty = newDirty = false;
+		}
+
+		float error = fabsf(client - energy);
+		maxError = max(maxError, error);
+		sumError += error;
+	}
+
+	//payload only, the aspect header is the same per update in both policies
+	CryLogAlways("[nano] energy aspect over %.0fs at %d fps, %d packets/s, threshold %.1f", seconds, fps, sendRate, g_pGameCVars->g_suitEnergyNetThreshold);
+	CryLogAlways("[nano]   old: %.1f updates/s, %.1f bytes/s (float energy)", oldUpdates / seconds, oldUpdates * 4 / seconds);
+	CryLogAlways("[nano]   new: %.1f updates/s, %.1f bytes/s (8 bit energy + 8 bit rate)", newUpdates / seconds, newUpdates * 2 / seconds);
+	CryLogAlways("[nano]   client prediction error: %.2f average, %.2f max (of %.0f)", sumError / max(1, frames), maxError, NANOSUIT_ENERGY);
+}
+
 void CNanoSuit::Balance(float energy)
 {
 	for(int i = 0; i < NANOSLOT_LAST; i++)
@@ -624,8 +792,6 @@ void CNanoSuit::Balance(float energy)
 void CNanoSuit::SetSuitEnergy(float value, bool playerInitiated /* = false */)
 {
 	value = clamp(value, 0.0f, NANOSUIT_ENERGY);
-	if (m_pOwner && value!=m_energy && gEnv->bServer)
-		m_pOwner->GetGameObject()->ChangedNetworkState(CPlayer::ASPECT_NANO_SUIT_ENERGY);
 
 	// Crysis co-op :: removed multiplayer check
 	//if (!gEnv->bMultiplayer)
@@ -681,6 +847,10 @@ void CNanoSuit::SetSuitEnergy(float value, bool playerInitiated /* = false */)
 	}
 
 	m_energy = value;
+
+	//discrete changes (hits, actions, scripts) are checked against the prediction right away
+	if (m_pOwner && gEnv->bServer)
+		NetUpdateEnergy(m_netEnergyRate);
 }
 
 void CNanoSuit::Hit(int damage)
@@ -1316,9 +1486,20 @@ void CNanoSuit::Serialize(TSerialize ser, unsigned aspects)
 		}
 		if (aspects&CPlayer::ASPECT_NANO_SUIT_ENERGY)
 		{
-			ser.Value("energy", m_energy, 'nNRG');
+			//write the prediction as of now, so late joiners start on the same curve
+			float now = gEnv->pTimer->GetFrameStartTime().GetSeconds();
+			uint8 energy = QuantizeNetEnergy(m_netEnergy + m_netEnergyRate * (now - m_netEnergyTime));
+			uint8 rate = QuantizeNetEnergyRate(m_netEnergyRate);
+			ser.Value("energy", energy, 'ui8');
+			ser.Value("energyRate", rate, 'ui8');
 			if (ser.IsReading())
+			{
+				m_netEnergy = DequantizeNetEnergy(energy);
+				m_netEnergyRate = DequantizeNetEnergyRate(rate);
+				m_netEnergyTime = now;
+				m_energy = m_netEnergy;
 				Balance(m_energy);
+			}
 		}
 		if (aspects&CPlayer::ASPECT_NANO_SUIT_INVULNERABLE)
 		{
@@ -258,12 +258,20 @@ public:
 	void AddListener(INanoSuitListener* pListener);
 	void RemoveListener(INanoSuitListener* pListener);
 
+	//replays a scripted energy curve through the old and new energy aspect policies, logs bytes per second
+	static void BenchmarkNetEnergy(float seconds, int fps, int sendRate);
+
 private:
 	void Precache();
 	void Balance(float energy);
 	bool SetAllSlots(float armor, float strength, float speed);
 	int  GetButtonFromMode(ENanoMode mode);
 	void UpdateSprinting(float &recharge, const SPlayerStats &stats, float frametime);
+	//server: dirties the energy aspect only when the client prediction drifted too far
+	void NetUpdateEnergy(float rate);
+	static bool NetEnergyNeedsUpdate(float netEnergy, float netRate, float elapsed, float energy, float rate);
+	//client: integrates the last received energy rate
+	void NetPredictEnergy(float frameTime);
 
 	IGameFramework *m_pGameFramework;
 	
@@ -298,6 +306,14 @@ private:
 	float m_healthRegenDelay;
 	float m_defenseHitTimer;
 
+	//network energy prediction, energy and rate as last sent/received
+	float m_netEnergy;
+	float m_netEnergyRate;
+	float m_netEnergyTime;
+	int		m_netEnergyChanges;
+	int		m_netEnergySends;
+	float m_netEnergyDebugTime;
+
 	//this is used as a mask for nanosuit features
 	uint16 m_featureMask;
 
@@ -0,0 +1,724 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "ProfileCapture.h"
+
+// Binary capture (.fpc), all numbers little endian, "varint" is 7 bits per byte, low bits first:
+//   "FPC1"
+//   uint32 name count, uint32 thread count, uint32 frame count, uint32 event count, uint32 dropped events
+//   float64 ticks per second, int64 duration in ticks
+//   names:   varint length, characters
+//   threads: uint32 thread id
+//   frames:  varint start delta to the previous frame
+//   events:  grouped by thread in start order, per event varint thread, name, depth, subsystem,
+//            start delta to the previous event of the same thread, duration
+namespace
+{
+	const char FPC_MAGIC[4] = {'F', 'P', 'C', '1'};
+
+	const char *const SUBSYSTEM_NAMES[] =
+	{
+		"Any", "Renderer", "3DEngine", "Particle", "AI", "Animation", "Movie", "Entity", "Font", "Network",
+		"Physics", "Script", "Sound", "Music", "Editor", "System", "Game", "Input", "Sync", "NetworkTraffic",
+	};
+
+	const char *GetSubsystemName(int subsystem)
+	{
+		if (subsystem >= 0 && subsystem < (int)(sizeof(SUBSYSTEM_NAMES)/sizeof(SUBSYSTEM_NAMES[0])))
+			return SUBSYSTEM_NAMES[subsystem];
+		return "Unknown";
+	}
+
+	bool EventLess(const CProfileCapture::SEvent &a, const CProfileCapture::SEvent &b)
+	{
+		if (a.nThread != b.nThread)
+			return a.nThread < b.nThread;
+		if (a.nStart != b.nStart)
+			return a.nStart < b.nStart;
+		// a parent that started in the same tick encloses its child
+		if (a.nDepth != b.nDepth)
+			return a.nDepth < b.nDepth;
+		return a.nEnd < b.nEnd;
+	}
+
+	//------------------------------------------------------------------------
+	struct SCollectContext
+	{
+		CProfileCapture::SCapture *pCapture;
+		int64 startTicks;
+		std::map<const char*, int> names;
+		std::map<int, int> threads;
+	};
+
+	void CollectEvents(int thread, uint32 threadId, const SFrameProfileCaptureEvent *pEvents, int count, void *pUserData)
+	{
+		SCollectContext &context = *(SCollectContext*)pUserData;
+		CProfileCapture::SCapture &capture = *context.pCapture;
+
+		// OS thread ids can be reused by threads that started after others ended, so they don't identify the buffer
+		std::map<int, int>::iterator threadIt = context.threads.find(thread);
+		if (threadIt == context.threads.end())
+		{
+			threadIt = context.threads.insert(std::make_pair(thread, (int)capture.threads.size())).first;
+			capture.threads.push_back(threadId);
+		}
+
+		for (int i=0; i<count; ++i)
+		{
+			const SFrameProfileCaptureEvent &in = pEvents[i];
+
+			std::map<const char*, int>::iterator nameIt = context.names.find(in.sName);
+			if (nameIt == context.names.end())
+			{
+				nameIt = context.names.insert(std::make_pair(in.sName, (int)capture.names.size())).first;
+				capture.names.push_back(in.sName ? in.sName : "");
+			}
+
+			CProfileCapture::SEvent event;
+			event.nName = nameIt->second;
+			event.nThread = threadIt->second;
+			event.nStart = in.nStart - context.startTicks;
+			event.nEnd = in.nEnd - context.startTicks;
+			event.nDepth = in.nDepth;
+			event.nSubsystem = in.nSubsystem;
+			capture.events.push_back(event);
+		}
+	}
+
+	//------------------------------------------------------------------------
+	void AppendJsonString(string &out, const char *str)
+	{
+		out += '"';
+		for (const char *c = str; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				out += '\\';
+				out += *c;
+			}
+			else if ((unsigned char)*c < 0x20)
+			{
+				char buffer[8];
+				_snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned char)*c);
+				out += buffer;
+			}
+			else
+				out += *c;
+		}
+		out += '"';
+	}
+
+	void AppendBytes(std::vector<uint8> &out, const void *pData, size_t size)
+	{
+		out.insert(out.end(), (const uint8*)pData, (const uint8*)pData + size);
+	}
+
+	void AppendFixed(std::vector<uint8> &out, uint64 value, int bytes)
+	{
+		for (int i=0; i<bytes; ++i, value >>= 8)
+			out.push_back((uint8)value);
+	}
+
+	void AppendVarint(std::vector<uint8> &out, uint64 value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8)value);
+	}
+
+	// bounds checked reading, once it ran past the end every further read fails
+	struct SBinaryReader
+	{
+		SBinaryReader(const uint8 *_pData, size_t _size) : pData(_pData), size(_size), pos(0), ok(true) {}
+
+		bool Fixed(uint64 &value, int bytes)
+		{
+			value = 0;
+			if (!ok || size-pos < (size_t)bytes)
+				return ok = false;
+			for (int i=0; i<bytes; ++i)
+				value |= (uint64)pData[pos++] << (8*i);
+			return true;
+		}
+
+		bool Varint(uint64 &value)
+		{
+			value = 0;
+			for (int shift = 0; ok && shift < 64; shift += 7)
+			{
+				if (pos == size)
+					break;
+				const uint8 byte = pData[pos++];
+				value |= (uint64)(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+			return ok = false;
+		}
+
+		bool Bytes(const uint8 *&pBytes, size_t count)
+		{
+			if (!ok || size-pos < count)
+				return ok = false;
+			pBytes = pData + pos;
+			pos += count;
+			return true;
+		}
+
+		const uint8 *pData;
+		size_t size;
+		size_t pos;
+		bool ok;
+	};
+}
+
+//------------------------------------------------------------------------
+CProfileCapture::CProfileCapture()
+: m_framesLeft(0),
+	m_startTicks(0),
+	m_started(false)
+{
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::Start(int frames, const char *fileName)
+{
+#if defined(FRAME_PROFILE_CAPTURE)
+	if (IsCapturing())
+		Stop();
+
+	// recording starts at the next frame boundary, so only whole frames are captured
+	m_fileName = fileName;
+	m_frames.resize(0);
+	m_framesLeft = max(1, frames);
+	m_started = false;
+	CryLogAlways("[ProfileCapture] Capturing the next %d frames into %s.json/.fpc", m_framesLeft, m_fileName.c_str());
+#else
+	GameWarning("[ProfileCapture] Profile capture is not available in this build");
+#endif
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::Stop()
+{
+	if (m_started)
+		Finish();
+	m_framesLeft = 0;
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::Update()
+{
+	if (m_framesLeft <= 0)
+		return;
+
+#if defined(FRAME_PROFILE_CAPTURE)
+	if (!m_started)
+	{
+		// taken first, so no recorded section starts before it
+		m_startTicks = CryGetTicks();
+		CryFrameProfileCaptureStart();
+		m_startTime = gEnv->pTimer->GetAsyncTime();
+		m_started = true;
+		m_frames.push_back(0);
+		return;
+	}
+
+	if (--m_framesLeft == 0)
+		Finish();
+	else
+		m_frames.push_back(CryGetTicks() - m_startTicks);
+#endif
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::Finish()
+{
+#if defined(FRAME_PROFILE_CAPTURE)
+	CryFrameProfileCaptureStop();
+	const int64 stopTicks = CryGetTicks();
+	const float seconds = max(0.000001f, (gEnv->pTimer->GetAsyncTime()-m_startTime).GetSeconds());
+
+	SCapture capture;
+	Collect(m_startTicks, stopTicks, (double)(stopTicks-m_startTicks) / seconds, capture);
+	capture.frames = m_frames;
+
+	m_started = false;
+	m_framesLeft = 0;
+
+	string json;
+	WriteJson(capture, json);
+	std::vector<uint8> binary;
+	WriteBinary(capture, binary);
+
+	bool written = true;
+	const string jsonFile = m_fileName + ".json";
+	const string binaryFile = m_fileName + ".fpc";
+	if (FILE *pFile = gEnv->pCryPak->FOpen(jsonFile.c_str(), "wb"))
+	{
+		gEnv->pCryPak->FWrite((void*)json.c_str(), json.size(), 1, pFile);
+		gEnv->pCryPak->FClose(pFile);
+	}
+	else
+		written = false;
+	if (FILE *pFile = gEnv->pCryPak->FOpen(binaryFile.c_str(), "wb"))
+	{
+		gEnv->pCryPak->FWrite(binary.empty() ? 0 : &binary[0], binary.size(), 1, pFile);
+		gEnv->pCryPak->FClose(pFile);
+	}
+	else
+		written = false;
+
+	if (!written)
+		GameWarning("[ProfileCapture] Failed to write %s/%s", jsonFile.c_str(), binaryFile.c_str());
+
+	CryLogAlways("[ProfileCapture] %d frames, %.3fs: %d sections on %d threads, %d dropped, %d bytes JSON, %d bytes binary",
+		(int)capture.frames.size(), seconds, (int)capture.events.size(), (int)capture.threads.size(), capture.nDropped,
+		(int)json.size(), (int)binary.size());
+#endif
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::Collect(int64 startTicks, int64 stopTicks, double ticksPerSecond, SCapture &capture)
+{
+	capture = SCapture();
+	capture.fTicksPerSecond = ticksPerSecond;
+	capture.nDuration = stopTicks - startTicks;
+
+#if defined(FRAME_PROFILE_CAPTURE)
+	SCollectContext context;
+	context.pCapture = &capture;
+	context.startTicks = startTicks;
+	capture.nDropped = CryFrameProfileCaptureEnumerate(CollectEvents, &context);
+	std::sort(capture.events.begin(), capture.events.end(), EventLess);
+#endif
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::WriteJson(const SCapture &capture, string &out)
+{
+	const double toMicroseconds = (capture.fTicksPerSecond > 0.0 ? 1000000.0 / capture.fTicksPerSecond : 0.0);
+	char buffer[256];
+
+	out.reserve(out.size() + 128 + capture.events.size()*128);
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	// tids are the thread indices, starting at 1, the OS thread id goes into the thread name
+	bool first = true;
+	for (int i=0; i<(int)capture.threads.size(); ++i)
+	{
+		_snprintf(buffer, sizeof(buffer), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %u\"}}",
+			first ? "" : ",\n", i+1, capture.threads[i]);
+		out += buffer;
+		first = false;
+	}
+
+	for (int i=0; i<(int)capture.frames.size(); ++i)
+	{
+		_snprintf(buffer, sizeof(buffer), "%s{\"name\":\"Frame %d\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+			first ? "" : ",\n", i, capture.frames[i] * toMicroseconds);
+		out += buffer;
+		first = false;
+	}
+
+	for (std::vector<SEvent>::const_iterator it = capture.events.begin(); it != capture.events.end(); ++it)
+	{
+		out += (first ? "{\"name\":" : ",\n{\"name\":");
+		AppendJsonString(out, capture.names[it->nName].c_str());
+		_snprintf(buffer, sizeof(buffer), ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%d}}",
+			GetSubsystemName(it->nSubsystem), it->nThread+1, it->nStart * toMicroseconds,
+			(it->nEnd - it->nStart) * toMicroseconds, (int)it->nDepth);
+		out += buffer;
+		first = false;
+	}
+
+	out += "\n]}\n";
+}
+
+//------------------------------------------------------------------------
+void CProfileCapture::WriteBinary(const SCapture &capture, std::vector<uint8> &out)
+{
+	AppendBytes(out, FPC_MAGIC, sizeof(FPC_MAGIC));
+	AppendFixed(out, capture.names.size(), 4);
+	AppendFixed(out, capture.threads.size(), 4);
+	AppendFixed(out, capture.frames.size(), 4);
+	AppendFixed(out, capture.events.size(), 4);
+	AppendFixed(out, capture.nDropped, 4);
+
+	uint64 ticksPerSecond;
+	memcpy(&ticksPerSecond, &capture.fTicksPerSecond, sizeof(ticksPerSecond));
+	AppendFixed(out, ticksPerSecond, 8);
+	AppendFixed(out, capture.nDuration, 8);
+
+	for (int i=0; i<(int)capture.names.size(); ++i)
+	{
+		AppendVarint(out, capture.names[i].size());
+		AppendBytes(out, capture.names[i].c_str(), capture.names[i].size());
+	}
+
+	for (int i=0; i<(int)capture.threads.size(); ++i)
+		AppendFixed(out, capture.threads[i], 4);
+
+	int64 lastFrame = 0;
+	for (int i=0; i<(int)capture.frames.size(); ++i)
+	{
+		AppendVarint(out, capture.frames[i] - lastFrame);
+		lastFrame = capture.frames[i];
+	}
+
+	// the events are sorted by thread and start, so the start deltas are never negative
+	int lastThread = -1;
+	int64 lastStart = 0;
+	for (std::vector<SEvent>::const_iterator it = capture.events.begin(); it != capture.events.end(); ++it)
+	{
+		if (it->nThread != lastThread)
+		{
+			lastThread = it->nThread;
+			lastStart = 0;
+		}
+		AppendVarint(out, it->nThread);
+		AppendVarint(out, it->nName);
+		AppendVarint(out, it->nDepth);
+		AppendVarint(out, it->nSubsystem);
+		AppendVarint(out, it->nStart - lastStart);
+		AppendVarint(out, it->nEnd - it->nStart);
+		lastStart = it->nStart;
+	}
+}
+
+//------------------------------------------------------------------------
+bool CProfileCapture::ReadBinary(const uint8 *pData, size_t size, SCapture &capture)
+{
+	capture = SCapture();
+	SBinaryReader reader(pData, size);
+
+	const uint8 *pMagic;
+	if (!reader.Bytes(pMagic, sizeof(FPC_MAGIC)) || memcmp(pMagic, FPC_MAGIC, sizeof(FPC_MAGIC)))
+		return false;
+
+	uint64 nameCount, threadCount, frameCount, eventCount, dropped, ticksPerSecond, duration;
+	reader.Fixed(nameCount, 4);
+	reader.Fixed(threadCount, 4);
+	reader.Fixed(frameCount, 4);
+	reader.Fixed(eventCount, 4);
+	reader.Fixed(dropped, 4);
+	reader.Fixed(ticksPerSecond, 8);
+	reader.Fixed(duration, 8);
+	// every entry takes at least one byte, which also keeps corrupt counts from allocating
+	if (!reader.ok || nameCount + threadCount + frameCount + eventCount > size - reader.pos)
+		return false;
+
+	memcpy(&capture.fTicksPerSecond, &ticksPerSecond, sizeof(ticksPerSecond));
+	capture.nDuration = (int64)duration;
+	capture.nDropped = (int)dropped;
+
+	capture.names.resize((size_t)nameCount);
+	for (size_t i=0; i<capture.names.size(); ++i)
+	{
+		uint64 length;
+		const uint8 *pName;
+		if (!reader.Varint(length) || length > size || !reader.Bytes(pName, (size_t)length))
+			return false;
+		capture.names[i].assign((const char*)pName, (size_t)length);
+	}
+
+	capture.threads.resize((size_t)threadCount);
+	for (size_t i=0; i<capture.threads.size(); ++i)
+	{
+		uint64 threadId;
+		if (!reader.Fixed(threadId, 4))
+			return false;
+		capture.threads[i] = (uint32)threadId;
+	}
+
+	capture.frames.resize((size_t)frameCount);
+	int64 lastFrame = 0;
+	for (size_t i=0; i<capture.frames.size(); ++i)
+	{
+		uint64 delta;
+		if (!reader.Varint(delta))
+			return false;
+		capture.frames[i] = lastFrame = lastFrame + (int64)delta;
+	}
+
+	capture.events.resize((size_t)eventCount);
+	int lastThread = -1;
+	int64 lastStart = 0;
+	for (size_t i=0; i<capture.events.size(); ++i)
+	{
+		uint64 thread, name, depth, subsystem, startDelta, length;
+		reader.Varint(thread);
+		reader.Varint(name);
+		reader.Varint(depth);
+		reader.Varint(subsystem);
+		reader.Varint(startDelta);
+		if (!reader.Varint(length) || thread >= threadCount || name >= nameCount || depth > 0xffff || subsystem > 0xffff)
+			return false;
+
+		if ((int)thread != lastThread)
+		{
+			lastThread = (int)thread;
+			lastStart = 0;
+		}
+
+		SEvent &event = capture.events[i];
+		event.nThread = (int)thread;
+		event.nName = (int)name;
+		event.nDepth = (uint16)depth;
+		event.nSubsystem = (uint16)subsystem;
+		event.nStart = lastStart + (int64)startDelta;
+		event.nEnd = event.nStart + (int64)length;
+		lastStart = event.nStart;
+	}
+
+	return reader.pos == size;
+}
+
+//------------------------------------------------------------------------
+#if defined(FRAME_PROFILE_CAPTURE)
+namespace
+{
+	enum
+	{
+		TEST_THREADS = 3, // including the calling thread
+		TEST_FRAMES = 8,
+		TEST_OUTER = 3,   // outer sections per frame
+		TEST_INNER = 4,   // inner sections per outer section
+	};
+
+	const char *const TEST_NAMES[] = {"ProfileCaptureTest::Frame", "ProfileCaptureTest::Outer", "ProfileCaptureTest::Inner"};
+	const int TEST_COUNTS[] = {TEST_FRAMES, TEST_FRAMES*TEST_OUTER, TEST_FRAMES*TEST_OUTER*TEST_INNER};
+
+	void TestSpin(int iterations)
+	{
+		volatile int sink = 0;
+		for (int i=0; i<iterations; ++i)
+			sink = sink + i;
+	}
+
+	void TestWorkload(std::vector<int64> *pFrames)
+	{
+		for (int frame=0; frame<TEST_FRAMES; ++frame)
+		{
+			if (pFrames)
+				pFrames->push_back(CryGetTicks());
+
+			FRAME_PROFILER("ProfileCaptureTest::Frame", gEnv->pSystem, PROFILE_GAME);
+			for (int outer=0; outer<TEST_OUTER; ++outer)
+			{
+				FRAME_PROFILER("ProfileCaptureTest::Outer", gEnv->pSystem, PROFILE_GAME);
+				TestSpin(500);
+				for (int inner=0; inner<TEST_INNER; ++inner)
+				{
+					FRAME_PROFILER("ProfileCaptureTest::Inner", gEnv->pSystem, PROFILE_GAME);
+					TestSpin(1000);
+				}
+			}
+		}
+	}
+
+	void TestWorkerThread(void *pParam)
+	{
+		TestWorkload(0);
+		CryInterlockedIncrement((volatile int*)pParam);
+	}
+
+	int GetTestName(const char *name)
+	{
+		for (int i=0; i<(int)(sizeof(TEST_NAMES)/sizeof(TEST_NAMES[0])); ++i)
+		{
+			if (!strcmp(name, TEST_NAMES[i]))
+				return i;
+		}
+		return -1;
+	}
+
+	// Rebuilds the section stack of every thread from the recorded depths and checks that siblings don't overlap
+	// and children lie within their parent, then that the test sections nest as written and were all recorded.
+	// The depths are used rather than only the times, sections can be shorter than a tick.
+	bool ValidateTestCapture(const CProfileCapture::SCapture &capture)
+	{
+		std::vector<const CProfileCapture::SEvent*> stack;
+		std::vector<int> counts(capture.threads.size() * 3, 0);
+		int errors = 0;
+
+		for (int i=0; i<(int)capture.events.size(); ++i)
+		{
+			const CProfileCapture::SEvent &event = capture.events[i];
+			if (i == 0 || event.nThread != capture.events[i-1].nThread)
+				stack.resize(0);
+			bool nested = (event.nEnd >= event.nStart && event.nDepth <= stack.size());
+			while (stack.size() > event.nDepth)
+			{
+				nested = nested && (stack.back()->nEnd <= event.nStart);
+				stack.pop_back();
+			}
+
+			const CProfileCapture::SEvent *pParent = (stack.empty() ? 0 : stack.back());
+			if (!nested || (pParent && (event.nStart < pParent->nStart || event.nEnd > pParent->nEnd)))
+			{
+				GameWarning("[ProfileCapture] '%s' on thread %u is not nested properly", capture.names[event.nName].c_str(), capture.threads[event.nThread]);
+				++errors;
+			}
+
+			const int test = GetTestName(capture.names[event.nName].c_str());
+			if (test >= 0)
+			{
+				++counts[event.nThread*3 + test];
+				if (test > 0 && (!pParent || GetTestName(capture.names[pParent->nName].c_str()) != test-1))
+				{
+					GameWarning("[ProfileCapture] '%s' on thread %u is not inside '%s'", TEST_NAMES[test], capture.threads[event.nThread], TEST_NAMES[test-1]);
+					++errors;
+				}
+			}
+			stack.push_back(&event);
+		}
+
+		int testThreads = 0;
+		for (int thread=0; thread<(int)capture.threads.size(); ++thread)
+		{
+			if (!counts[thread*3] && !counts[thread*3+1] && !counts[thread*3+2])
+				continue;
+			++testThreads;
+			for (int test=0; test<3; ++test)
+			{
+				if (counts[thread*3 + test] != TEST_COUNTS[test])
+				{
+					GameWarning("[ProfileCapture] %d of %d '%s' sections recorded on thread %u", counts[thread*3 + test], TEST_COUNTS[test], TEST_NAMES[test], capture.threads[thread]);
+					++errors;
+				}
+			}
+		}
+		if (testThreads != TEST_THREADS)
+		{
+			GameWarning("[ProfileCapture] Test sections recorded on %d threads instead of %d", testThreads, TEST_THREADS);
+			++errors;
+		}
+
+		return !errors && !capture.nDropped;
+	}
+
+	bool CapturesEqual(const CProfileCapture::SCapture &a, const CProfileCapture::SCapture &b)
+	{
+		if (a.names != b.names || a.threads != b.threads || a.frames != b.frames || a.events.size() != b.events.size() ||
+			a.fTicksPerSecond != b.fTicksPerSecond || a.nDuration != b.nDuration || a.nDropped != b.nDropped)
+			return false;
+
+		for (size_t i=0; i<a.events.size(); ++i)
+		{
+			const CProfileCapture::SEvent &ea = a.events[i];
+			const CProfileCapture::SEvent &eb = b.events[i];
+			if (ea.nName != eb.nName || ea.nThread != eb.nThread || ea.nStart != eb.nStart || ea.nEnd != eb.nEnd ||
+				ea.nDepth != eb.nDepth || ea.nSubsystem != eb.nSubsystem)
+				return false;
+		}
+		return true;
+	}
+
+	int CountOccurrences(const string &text, const char *pattern)
+	{
+		int count = 0;
+		for (size_t pos = text.find(pattern); pos != string::npos; pos = text.find(pattern, pos+1))
+			++count;
+		return count;
+	}
+
+	// brackets have to balance outside of strings
+	bool JsonBalanced(const string &json)
+	{
+		std::vector<char> open;
+		bool inString = false;
+		for (size_t i=0; i<json.size(); ++i)
+		{
+			const char c = json[i];
+			if (inString)
+			{
+				if (c == '\\')
+					++i;
+				else if (c == '"')
+					inString = false;
+			}
+			else if (c == '"')
+				inString = true;
+			else if (c == '{' || c == '[')
+				open.push_back(c == '{' ? '}' : ']');
+			else if (c == '}' || c == ']')
+			{
+				if (open.empty() || open.back() != c)
+					return false;
+				open.pop_back();
+			}
+		}
+		return open.empty() && !inString;
+	}
+}
+#endif
+
+bool CProfileCapture::SelfTest()
+{
+#if defined(FRAME_PROFILE_CAPTURE)
+	const int64 startTicks = CryGetTicks();
+	CryFrameProfileCaptureStart();
+	const CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+	volatile int finished = 0;
+	CCryThread *threads[TEST_THREADS-1];
+	for (int i=0; i<TEST_THREADS-1; ++i)
+		threads[i] = new CCryThread(TestWorkerThread, (void*)&finished);
+
+	std::vector<int64> frameTicks;
+	TestWorkload(&frameTicks);
+
+	while (CryLoadAcquire(&finished) < TEST_THREADS-1)
+		CrySleep(1);
+	for (int i=0; i<TEST_THREADS-1; ++i)
+		delete threads[i];
+
+	CryFrameProfileCaptureStop();
+	const int64 stopTicks = CryGetTicks();
+	const float seconds = max(0.000001f, (gEnv->pTimer->GetAsyncTime()-startTime).GetSeconds());
+
+	SCapture capture;
+	Collect(startTicks, stopTicks, (double)(stopTicks-startTicks) / seconds, capture);
+	for (int i=0; i<(int)frameTicks.size(); ++i)
+		capture.frames.push_back(frameTicks[i] - startTicks);
+
+	bool ok = ValidateTestCapture(capture);
+
+	std::vector<uint8> binary;
+	WriteBinary(capture, binary);
+	SCapture loaded;
+	if (!ReadBinary(binary.empty() ? 0 : &binary[0], binary.size(), loaded) || !CapturesEqual(capture, loaded))
+	{
+		GameWarning("[ProfileCapture] The binary capture does not read back");
+		ok = false;
+	}
+	if (binary.size() > 1 && ReadBinary(&binary[0], binary.size()-1, loaded))
+	{
+		GameWarning("[ProfileCapture] A truncated binary capture was accepted");
+		ok = false;
+	}
+
+	string json;
+	WriteJson(capture, json);
+	if (!JsonBalanced(json) || CountOccurrences(json, "\"ph\":\"X\"") != (int)capture.events.size() ||
+		CountOccurrences(json, "\"ph\":\"i\"") != (int)capture.frames.size())
+	{
+		GameWarning("[ProfileCapture] The JSON capture is malformed");
+		ok = false;
+	}
+
+	CryLogAlways("[ProfileCapture] Self test %s: %d sections on %d threads, %d bytes JSON, %d bytes binary (%.1f bytes per section)",
+		ok ? "passed" : "FAILED", (int)capture.events.size(), (int)capture.threads.size(), (int)json.size(), (int)binary.size(),
+		capture.events.empty() ? 0.0f : (float)binary.size() / capture.events.size());
+	return ok;
+#else
+	GameWarning("[ProfileCapture] Profile capture is not available in this build");
+	return false;
+#endif
+}
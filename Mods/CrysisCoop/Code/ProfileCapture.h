@@ -0,0 +1,79 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __PROFILE_CAPTURE_H__
+#define __PROFILE_CAPTURE_H__
+
+#pragma once
+
+// Captures the FRAME_PROFILER/FUNCTION_PROFILER sections of the game module
+// for a number of frames (see FRAME_PROFILE_CAPTURE in FrameProfiler.h) and
+// writes them as Chrome trace event JSON (chrome://tracing, Perfetto) and in
+// a compact binary format for offline tools.
+// Sections of the engine modules are not included, every module records
+// into its own buffers.
+class CProfileCapture
+{
+public:
+	struct SEvent
+	{
+		int nName;           // index into SCapture::names
+		int nThread;         // index into SCapture::threads
+		int64 nStart;        // ticks since the capture started
+		int64 nEnd;
+		uint16 nDepth;       // recorded sections enclosing this one on the same thread
+		uint16 nSubsystem;   // EProfiledSubsystem
+	};
+
+	struct SCapture
+	{
+		SCapture() : fTicksPerSecond(0.0), nDuration(0), nDropped(0) {}
+
+		std::vector<string> names;
+		// OS id of every recording thread, the same id can appear twice if a thread ended and another reused it
+		std::vector<uint32> threads;
+		// sorted by thread, then start time, so a parent always comes before its children
+		std::vector<SEvent> events;
+		// start of every captured frame, in ticks since the capture started
+		std::vector<int64> frames;
+		double fTicksPerSecond;
+		int64 nDuration;
+		int nDropped;
+	};
+
+	CProfileCapture();
+
+	// records the next frames and writes <fileName>.json and <fileName>.fpc after the last one
+	void Start(int frames, const char *fileName);
+	// stops early, the frames captured so far are written
+	void Stop();
+	bool IsCapturing() const { return m_framesLeft > 0; }
+
+	// frame boundary, called at the start of CGame::Update
+	void Update();
+
+	// reads the events of the last capture of the game module
+	static void Collect(int64 startTicks, int64 stopTicks, double ticksPerSecond, SCapture &capture);
+
+	static void WriteJson(const SCapture &capture, string &out);
+	static void WriteBinary(const SCapture &capture, std::vector<uint8> &out);
+	// returns false if the data is not a complete capture
+	static bool ReadBinary(const uint8 *pData, size_t size, SCapture &capture);
+
+	// profiles a nested workload on several threads and checks the capture and both exports,
+	// returns false (and logs why) if anything is wrong
+	static bool SelfTest();
+
+private:
+	void Finish();
+
+	string m_fileName;
+	std::vector<int64> m_frames;
+	int m_framesLeft;
+	int64 m_startTicks;
+	CTimeValue m_startTime;
+	bool m_started;
+};
+
+#endif //__PROFILE_CAPTURE_H__
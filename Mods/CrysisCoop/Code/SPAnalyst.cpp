@@ -27,6 +27,39 @@
 #include "HUD/HUD.h"
 #include "HUD/HUDRadar.h"
 
+const CGameplayRecordStream::SColumn CSPAnalyst::s_recordColumns[CSPAnalyst::eRC_Last] =
+{
+	{ "nr",                       CGameplayRecordStream::eCT_Int },
+	{ "time",                     CGameplayRecordStream::eCT_Float },
+	{ "stats.posX",               CGameplayRecordStream::eCT_Float },
+	{ "stats.posY",               CGameplayRecordStream::eCT_Float },
+	{ "stats.posZ",               CGameplayRecordStream::eCT_Float },
+	{ "stats.health",             CGameplayRecordStream::eCT_Int },
+	{ "stats.kills",              CGameplayRecordStream::eCT_Int },
+	{ "stats.weapon",             CGameplayRecordStream::eCT_String },
+	{ "suit.energy",              CGameplayRecordStream::eCT_Float },
+	{ "suit.mode",                CGameplayRecordStream::eCT_Int },
+	{ "player.nightvision",       CGameplayRecordStream::eCT_String },
+	{ "player.timesFired",        CGameplayRecordStream::eCT_Int },
+	{ "ai.all",                   CGameplayRecordStream::eCT_Int },
+	{ "ai.alertness",             CGameplayRecordStream::eCT_Float },
+	{ "ai.proximity",             CGameplayRecordStream::eCT_Int },
+	{ "ai.proximityAlerted",      CGameplayRecordStream::eCT_Int },
+	{ "ai.proximityAttacking",    CGameplayRecordStream::eCT_Int },
+	{ "ai.proximityVehicle",      CGameplayRecordStream::eCT_Int },
+	{ "vehicle.used",             CGameplayRecordStream::eCT_String },
+	{ "vehicle.damage",           CGameplayRecordStream::eCT_Float },
+	{ "event.itemSelected",       CGameplayRecordStream::eCT_String },
+	{ "event.itemPickedUp",       CGameplayRecordStream::eCT_String },
+	{ "event.itemDropped",        CGameplayRecordStream::eCT_String },
+	{ "EnteredVehicle",           CGameplayRecordStream::eCT_String },
+	{ "WeaponReload",             CGameplayRecordStream::eCT_Int },
+	{ "PlayerDeath",              CGameplayRecordStream::eCT_Int },
+	{ "GameDisconnected",         CGameplayRecordStream::eCT_Int },
+	{ "event.gameSaved",          CGameplayRecordStream::eCT_String },
+	{ "event.gameLoaded",         CGameplayRecordStream::eCT_String },
+};
+
 CSPAnalyst::CSPAnalyst() : m_bEnabled(false), m_bChainLoad(false), m_fUpdateTimer(0.0f), m_iTimesFired(0)
 {
 	IGameFramework* pGF = g_pGame->GetIGameFramework();
@@ -36,7 +69,7 @@ CSPAnalyst::CSPAnalyst() : m_bEnabled(false), m_bChainLoad(false), m_fUpdateTime
 
 CSPAnalyst::~CSPAnalyst()
 {
-	WriteXML();
+	m_recordStream.Close();
 	IGameFramework* pGF = g_pGame->GetIGameFramework();
 	if (m_bEnabled)
 		pGF->GetIGameplayRecorder()->UnregisterListener(this);
@@ -66,7 +99,7 @@ void CSPAnalyst::OnPostUpdate(float fDeltaTime)
 
 	if(g_pGameCVars->g_spRecordGameplay)
 	{
-		if(!m_recordingData)
+		if(!m_recordStream.IsOpen())
 			StartRecording();
 
 		m_fUpdateTimer += fDeltaTime;
@@ -138,36 +171,30 @@ void CSPAnalyst::OnGameplayEvent(IEntity *pEntity, const GameplayEvent &event)
 				if(IItem* pItem = g_pGame->GetIGameFramework()->GetIItemSystem()->GetItem(entityId))
 				{
 					if(event.event == eGE_ItemSelected)
-						WriteValue("event.itemSelected", string(pItem->GetEntity()->GetClass()->GetName()));
+						WriteValue(eRC_ItemSelected, pItem->GetEntity()->GetClass()->GetName());
 					else if(event.event == eGE_ItemPickedUp)
-						WriteValue("event.itemPickedUp", string(pItem->GetEntity()->GetClass()->GetName()));
+						WriteValue(eRC_ItemPickedUp, pItem->GetEntity()->GetClass()->GetName());
 					else if(event.event == eGE_ItemDropped)
-						WriteValue("event.itemDropped", string(pItem->GetEntity()->GetClass()->GetName()));
+						WriteValue(eRC_ItemDropped, pItem->GetEntity()->GetClass()->GetName());
 				}
 			}
 		}
 		break;
 	case eGE_EnteredVehicle:
-		{
-			if(event.extra)
-			{
-				EntityId entityId = EntityId((int)(event.extra));
-				if(IVehicle *pVehicle = g_pGame->GetIGameFramework()->GetIVehicleSystem()->GetVehicle(entityId))
-					WriteValue("EnteredVehicle", pVehicle->GetEntity()->GetClass()->GetName());
-				else
-					WriteValue("EnteredVehicle", int(entityId));
-			}
-		}
-		break;
 	case eGE_LeftVehicle:
 		{
 			if(event.extra)
 			{
 				EntityId entityId = EntityId((int)(event.extra));
 				if(IVehicle *pVehicle = g_pGame->GetIGameFramework()->GetIVehicleSystem()->GetVehicle(entityId))
-					WriteValue("EnteredVehicle", pVehicle->GetEntity()->GetClass()->GetName());
+					WriteValue(eRC_EnteredVehicle, pVehicle->GetEntity()->GetClass()->GetName());
 				else
-					WriteValue("EnteredVehicle", int(entityId));
+				{
+					// the column is text, the id is written as the number it was before
+					char buffer[16];
+					itoa(int(entityId), buffer, 10);
+					WriteValue(eRC_EnteredVehicle, (const char*)buffer);
+				}
 			}
 		}
 		break;
@@ -179,16 +206,16 @@ void CSPAnalyst::OnGameplayEvent(IEntity *pEntity, const GameplayEvent &event)
 		break;
 	case eGE_WeaponReload:
 		{
-			WriteValue("WeaponReload", int(eGE_WeaponReload));
+			WriteValue(eRC_WeaponReload, int(eGE_WeaponReload));
 		}
 		break;
 	case eGE_Death:
 		{
-			WriteValue("PlayerDeath", int(eGE_Death));
+			WriteValue(eRC_PlayerDeath, int(eGE_Death));
 		}
 	case eGE_Disconnected:
 		{
-			WriteValue("GameDisconnected", int(eGE_Disconnected));
+			WriteValue(eRC_GameDisconnected, int(eGE_Disconnected));
 		}
 		break;
 	case eGE_GameEnd:
@@ -257,7 +284,7 @@ void CSPAnalyst::OnLoadingStart(ILevelInfo *pLevelInfo)
 	if (pLevelInfo == 0)
 		return;
 
-	WriteXML(); //close old record
+	m_recordStream.Close(); //close old record
 
 	// when we load 'Island' the Game starts
 	if (stricmp(pLevelInfo->GetName(), "island") == 0 || !m_bChainLoad)
@@ -288,12 +315,12 @@ void CSPAnalyst::OnSaveGame(ISaveGame* pSaveGame)
 	pSaveGame->AddMetadata("sp_levelPlayTime", (int)((now-m_gameAnalysis.levelStartTime).GetSeconds()));
 	pSaveGame->AddMetadata("sp_gamePlayTime", (int)((now-m_gameAnalysis.gameStartTime).GetSeconds()));
 
-	WriteValue("event.gameSaved", pSaveGame->GetFileName());
+	WriteValue(eRC_GameSaved, pSaveGame->GetFileName());
 }
 
 void CSPAnalyst::OnLoadGame(ILoadGame* pLoadGame)
 {
-	WriteValue("event.gameLoaded", pLoadGame->GetFileName());
+	WriteValue(eRC_GameLoaded, pLoadGame->GetFileName());
 }
 
 void CSPAnalyst::OnLevelEnd(const char *nextLevel)
@@ -305,47 +332,53 @@ void CSPAnalyst::StartRecording()
 {
 	if(g_pGame->GetIGameFramework()->IsGameStarted())
 	{
-		m_recordingFileName = string("GameplayRecord_");
-		m_recordingFileName.append(g_pGame->CreateSaveGameName());
-		m_recordingData = GetISystem()->CreateXmlNode(m_recordingFileName.c_str());
-		m_frameCount = 0;
+		string recordName("GameplayRecord_");
+		recordName.append(g_pGame->CreateSaveGameName());
+
+		// frames are streamed to disk as they are recorded, use
+		// g_spConvertGameplayRecord to get the Excel-XML layout
+		char path[256];
+		CryGetCurrentDirectory(256, path);
+		string filename(path);
+		filename.append("\\");
+		filename.append(recordName);
+		filename.append(".gpr");
+
+		if(m_recordStream.Open(filename.c_str(), recordName.c_str(), s_recordColumns, eRC_Last))
+			m_frameCount = 0;
 	}
 }
 
 void CSPAnalyst::RecordGameplayFrame()
 {
-	if(!m_recordingData)
+	if(!m_recordStream.IsOpen())
 		return;
 
-	m_currentRecordingSection = GetISystem()->CreateXmlNode("frame");
 	m_frameCount++;
-	if(!m_currentRecordingSection)
-		m_recordingData = m_currentRecordingSection;
-	else
-		m_recordingData->addChild(m_currentRecordingSection);
+	m_recordStream.BeginFrame();
 
-	WriteValue("nr", m_frameCount);
-	WriteValue("time", (gEnv->pTimer->GetFrameStartTime()-m_gameAnalysis.levelStartTime).GetSeconds());
+	WriteValue(eRC_Nr, m_frameCount);
+	WriteValue(eRC_Time, (gEnv->pTimer->GetFrameStartTime()-m_gameAnalysis.levelStartTime).GetSeconds());
 
 	if(CPlayer *pPlayer = static_cast<CPlayer*>(g_pGame->GetIGameFramework()->GetClientActor()))
 	{
-		WriteValue("stats.posX", pPlayer->GetEntity()->GetWorldPos().x);
-		WriteValue("stats.posY", pPlayer->GetEntity()->GetWorldPos().y);
-		WriteValue("stats.posZ", pPlayer->GetEntity()->GetWorldPos().z);
+		WriteValue(eRC_PosX, pPlayer->GetEntity()->GetWorldPos().x);
+		WriteValue(eRC_PosY, pPlayer->GetEntity()->GetWorldPos().y);
+		WriteValue(eRC_PosZ, pPlayer->GetEntity()->GetWorldPos().z);
 
-		WriteValue("stats.health", pPlayer->GetHealth());
-		WriteValue("stats.kills", m_gameAnalysis.player.kills);
-		WriteValue("stats.weapon", pPlayer->GetCurrentItem()?pPlayer->GetCurrentItem()->GetEntity()->GetClass()->GetName():"none");
+		WriteValue(eRC_Health, int(pPlayer->GetHealth()));
+		WriteValue(eRC_Kills, m_gameAnalysis.player.kills);
+		WriteValue(eRC_Weapon, pPlayer->GetCurrentItem()?pPlayer->GetCurrentItem()->GetEntity()->GetClass()->GetName():"none");
 
 		if(CNanoSuit *pSuit = pPlayer->GetNanoSuit())
 		{
-			WriteValue("suit.energy", pSuit->GetSuitEnergy());
-			WriteValue("suit.mode", int(pSuit->GetMode()));
+			WriteValue(eRC_SuitEnergy, pSuit->GetSuitEnergy());
+			WriteValue(eRC_SuitMode, int(pSuit->GetMode()));
 
-			WriteValue("player.nightvision", pSuit->IsNightVisionEnabled()?"on":"off");
+			WriteValue(eRC_NightVision, pSuit->IsNightVisionEnabled()?"on":"off");
 		}
 
-		WriteValue("player.timesFired", m_iTimesFired);
+		WriteValue(eRC_TimesFired, m_iTimesFired);
 		m_iTimesFired = 0;
 
 		if(CHUDRadar *pRadar = g_pGame->GetHUD()->GetRadar())
@@ -382,87 +415,23 @@ void CSPAnalyst::RecordGameplayFrame()
 				}
 			}
 
-			WriteValue("ai.all", allAI);
-			WriteValue("ai.alertness", pRadar->GetStealthValue());
-			WriteValue("ai.proximity", enemyAI);
-			WriteValue("ai.proximityAlerted", enemyAIAlerted);
-			WriteValue("ai.proximityAttacking", enemyAIAttacking);
-			WriteValue("ai.proximityVehicle", enemyAIInVehicle);
+			WriteValue(eRC_AIAll, allAI);
+			WriteValue(eRC_AIAlertness, pRadar->GetStealthValue());
+			WriteValue(eRC_AIProximity, enemyAI);
+			WriteValue(eRC_AIProximityAlerted, enemyAIAlerted);
+			WriteValue(eRC_AIProximityAttacking, enemyAIAttacking);
+			WriteValue(eRC_AIProximityVehicle, enemyAIInVehicle);
 		}
 
 		if(IVehicle *pVehicle = pPlayer->GetLinkedVehicle())
 		{
-			WriteValue("vehicle.used", pVehicle->GetEntity()->GetClass()->GetName());
-			WriteValue("vehicle.damage", pVehicle->GetDamageRatio(true));
+			WriteValue(eRC_VehicleUsed, pVehicle->GetEntity()->GetClass()->GetName());
+			WriteValue(eRC_VehicleDamage, pVehicle->GetDamageRatio(true));
 		}
 		else
 		{
-			WriteValue("vehicle.used", 0);
-			WriteValue("vehicle.damage", 0);
+			WriteValue(eRC_VehicleUsed, "0");
+			WriteValue(eRC_VehicleDamage, 0.0f);
 		}
 	}
 }
-
-void CSPAnalyst::WriteXML()
-{
-	if(m_recordingData)
-	{
-		const string xmlHeader("<?xml version=\"1.0\"?>\n<?mso-application progid=\"Excel.Sheet\"?>\n");
-
-		char path[256];
-		CryGetCurrentDirectory(256, path);
-		string filename(path);
-		filename.append("\\");
-		filename.append(m_recordingFileName);
-		filename.append(".xml");
-
-		FILE *pFile = gEnv->pCryPak->FOpen(filename,"wb");
-		if (pFile)
-		{
-			_smart_ptr<IXmlStringData> pXmlStrData = m_recordingData->getXMLData( 6000000 );
-			gEnv->pCryPak->FWrite((void*)xmlHeader.c_str(), xmlHeader.size(), 1, pFile);
-			gEnv->pCryPak->FWrite((void*)pXmlStrData->GetString(), pXmlStrData->GetStringLength(), 1, pFile);
-			gEnv->pCryPak->FClose(pFile);
-		}
-		m_recordingData = NULL;
-		m_currentRecordingSection = NULL;
-	}
-}
-
-void CSPAnalyst::WriteToSection(const char* name, int value)
-{
-	if(m_currentRecordingSection)
-	{
-		char buffer[32];
-		itoa(value, buffer, 10);
-		m_currentRecordingSection->setAttr(name, string(buffer));
-	}
-}
-
-void CSPAnalyst::WriteToSection(const char* name, const char* value)
-{
-	WriteToSection(name, string(value));
-}
-
-void CSPAnalyst::WriteToSection(const char* name, string value)
-{
-	if(m_currentRecordingSection)
-		m_currentRecordingSection->setAttr(name, value);
-}
-
-void CSPAnalyst::WriteToSection(const char* name, float value)
-{
-	if(m_currentRecordingSection)
-	{
-		int high = (int)value;
-		int low = int((value-(float)high)*1000.0f);
-		char highbuffer[16];
-		itoa(high, highbuffer, 10);
-		char lowbuffer[16];
-		itoa(low, lowbuffer, 10);
-		string floatAsString(highbuffer);
-		floatAsString.append(".");
-		floatAsString.append(lowbuffer);
-		m_currentRecordingSection->setAttr(name, floatAsString);
-	}
-}
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <IGameplayRecorder.h>
 #include <ILevelSystem.h>
 #include <SerializeFwd.h>
+#include "GameplayRecordStream.h"
 
 struct ISaveGame;
 
@@ -61,7 +62,7 @@ public:
 	virtual void OnActionEvent(const SActionEvent& event) {};
 	// ~IGameFrameworkListener
 
-	ILINE void StopRecording() {WriteXML();}
+	ILINE void StopRecording() {m_recordStream.Close();}
 	ILINE int GetTimePlayed() { return (int)((gEnv->pTimer->GetFrameStartTime()-m_gameAnalysis.levelStartTime).GetSeconds()); }
 
 protected:
@@ -99,19 +100,54 @@ protected:
 
 private:
 
-	//************** XML recording
+	//************** gameplay recording
+	// the columns of a recorded frame, see s_recordColumns for names and types
+	enum ERecordColumn
+	{
+		eRC_Nr = 0,
+		eRC_Time,
+		eRC_PosX,
+		eRC_PosY,
+		eRC_PosZ,
+		eRC_Health,
+		eRC_Kills,
+		eRC_Weapon,
+		eRC_SuitEnergy,
+		eRC_SuitMode,
+		eRC_NightVision,
+		eRC_TimesFired,
+		eRC_AIAll,
+		eRC_AIAlertness,
+		eRC_AIProximity,
+		eRC_AIProximityAlerted,
+		eRC_AIProximityAttacking,
+		eRC_AIProximityVehicle,
+		eRC_VehicleUsed,
+		eRC_VehicleDamage,
+		// events, recorded into the last frame
+		eRC_ItemSelected,
+		eRC_ItemPickedUp,
+		eRC_ItemDropped,
+		eRC_EnteredVehicle,
+		eRC_WeaponReload,
+		eRC_PlayerDeath,
+		eRC_GameDisconnected,
+		eRC_GameSaved,
+		eRC_GameLoaded,
+		eRC_Last
+	};
+	static const CGameplayRecordStream::SColumn s_recordColumns[eRC_Last];
+
 	void StartRecording();
-	void WriteXML();
 	void RecordGameplayFrame();
-	template<class T> void WriteValue(const char* name, T value)
+	template<class T> void WriteValue(ERecordColumn column, T value)
 	{
-		if(m_recordingData)
-			WriteToSection(name, value);
+		if(m_recordStream.IsOpen())
+			WriteToSection(column, value);
 	}
-	void WriteToSection(const char* name, int value);
-	void WriteToSection(const char* name, float value);
-	void WriteToSection(const char* name, const char* value);
-	void WriteToSection(const char* name, string value);
+	void WriteToSection(ERecordColumn column, int value) { m_recordStream.Write(column, value); }
+	void WriteToSection(ERecordColumn column, float value) { m_recordStream.Write(column, value); }
+	void WriteToSection(ERecordColumn column, const char* value) { m_recordStream.Write(column, value); }
 	//***************
 
 protected:
@@ -119,9 +155,8 @@ protected:
 	bool m_bChainLoad;
 	GameAnalysis m_gameAnalysis;
 
-	//XML recording helpers
-	XmlNodeRef	m_recordingData, m_currentRecordingSection;
-	string			m_recordingFileName;
+	//gameplay recording helpers, see GameplayRecordStream.h
+	CGameplayRecordStream m_recordStream;
 	float				m_fUpdateTimer;
 	int					m_iTimesFired;
 	int					m_frameCount;
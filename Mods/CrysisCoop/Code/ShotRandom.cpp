@@ -0,0 +1,305 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "ShotRandom.h"
+#include <MTPseudoRandom.h>
+
+namespace
+{
+	struct SKnownAnswer
+	{
+		uint32 counter[4];
+		uint32 key[2];
+		uint32 out[4];
+	};
+
+	// the philox4x32-10 vectors of the Random123 distribution
+	const SKnownAnswer g_knownAnswers[] =
+	{
+		{ { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+		{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+		{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+	};
+
+	// an arbitrary weapon class hash, the tests must pass for any key
+	const uint32 g_testKey = 0x5ca7f00d;
+
+	// the results are kept here so the timed loops can't be optimized away
+	volatile uint32 g_sink;
+
+	// correlation coefficient of pairs of samples
+	class CCorrelation
+	{
+	public:
+		CCorrelation() : m_n(0), m_x(0), m_y(0), m_xx(0), m_yy(0), m_xy(0) {}
+
+		void Add(double x, double y)
+		{
+			++m_n;
+			m_x += x; m_y += y;
+			m_xx += x*x; m_yy += y*y; m_xy += x*y;
+		}
+
+		double Get() const
+		{
+			const double cov = m_n*m_xy - m_x*m_y;
+			const double var = (m_n*m_xx - m_x*m_x) * (m_n*m_yy - m_y*m_y);
+			return var > 0.0 ? cov/sqrt(var) : 0.0;
+		}
+
+		// uncorrelated samples stay within 5 standard deviations
+		double GetBound() const { return 5.0/sqrt((double)max(m_n, 1)); }
+
+	private:
+		int m_n;
+		double m_x, m_y, m_xx, m_yy, m_xy;
+	};
+
+	// chi-square of 256 buckets against the uniform distribution
+	double ChiSquare(const int buckets[256], int samples)
+	{
+		const double expected = samples/256.0;
+		double chi = 0.0;
+		for (int i=0; i<256; ++i)
+			chi += (buckets[i]-expected)*(buckets[i]-expected)/expected;
+		return chi;
+	}
+
+	// 255 degrees of freedom, mean 255 and deviation sqrt(510), 5 deviations either way
+	bool ChiSquareOk(double chi)
+	{
+		const double bound = 5.0*sqrt(510.0);
+		return chi > 255.0-bound && chi < 255.0+bound;
+	}
+
+	int CountBits(uint32 x)
+	{
+		int n = 0;
+		for (; x; x &= x-1)
+			++n;
+		return n;
+	}
+
+	bool Report(bool ok, const char *test, const char *result)
+	{
+		CryLogAlways("[ShotRandom] %s %s: %s", ok ? "passed" : "FAILED", test, result);
+		return ok;
+	}
+}
+
+//------------------------------------------------------------------------
+bool CShotRandom::SelfTest(int samples)
+{
+	samples = max(samples, 65536);
+	bool ok = true;
+	string result;
+
+	// known answers
+	{
+		int failed = 0;
+		for (int i=0; i<sizeof(g_knownAnswers)/sizeof(g_knownAnswers[0]); ++i)
+		{
+			uint32 out[4];
+			Philox(g_knownAnswers[i].counter, g_knownAnswers[i].key, out);
+			failed += memcmp(out, g_knownAnswers[i].out, sizeof(out)) != 0;
+		}
+		result.Format("%d of %d vectors wrong", failed, (int)(sizeof(g_knownAnswers)/sizeof(g_knownAnswers[0])));
+		ok &= Report(failed == 0, "known answers", result.c_str());
+	}
+
+	// a number depends only on its key and index, not on what was drawn before
+	{
+		CShotRandom stream(g_testKey, 1), same(g_testKey, 1);
+		int failed = 0;
+		for (int i=255; i>=0; --i)
+		{
+			uint32 out[4];
+			stream.GetBlock(i>>2, out);
+			failed += out[i&3] != same.GetUInt(i);
+			failed += ToFloat(out[i&3]) != same.GetFloat(i);
+
+			float a, b;
+			same.GetFloat2(i>>1, a, b);
+			failed += (i&1 ? b : a) != stream.GetFloat(i);
+		}
+		result.Format("%d mismatches", failed);
+		ok &= Report(failed == 0, "determinism", result.c_str());
+	}
+
+	// one stream: uniform high and low bytes, balanced bits, uniform floats without serial correlation
+	{
+		int high[256] = {0}, low[256] = {0}, ones[32] = {0};
+		double sum = 0.0;
+		float minValue = 1.0f, maxValue = 0.0f;
+		CCorrelation serial;
+
+		CShotRandom stream(g_testKey, 2);
+		float last = stream.GetFloat(0);
+		for (int i=0; i<samples; ++i)
+		{
+			const uint32 x = stream.GetUInt(i);
+			++high[x>>24];
+			++low[x&0xff];
+			for (int bit=0; bit<32; ++bit)
+				ones[bit] += (x>>bit)&1;
+
+			const float f = ToFloat(x);
+			sum += f;
+			minValue = min(minValue, f);
+			maxValue = max(maxValue, f);
+			if (i)
+				serial.Add(last, f);
+			last = f;
+		}
+
+		const double chiHigh = ChiSquare(high, samples), chiLow = ChiSquare(low, samples);
+		result.Format("high byte %.1f, low byte %.1f (255 expected)", chiHigh, chiLow);
+		ok &= Report(ChiSquareOk(chiHigh) && ChiSquareOk(chiLow), "chi-square", result.c_str());
+
+		double worst = 0.0;
+		for (int bit=0; bit<32; ++bit)
+			worst = max(worst, fabs(ones[bit]-samples*0.5)/sqrt(samples*0.25));
+		result.Format("worst bit %.2f deviations off", worst);
+		ok &= Report(worst < 5.0, "bit balance", result.c_str());
+
+		const double mean = sum/samples;
+		const double meanBound = 5.0*sqrt(1.0/(12.0*samples));
+		result.Format("mean %.5f, range [%f, %f]", mean, minValue, maxValue);
+		ok &= Report(fabs(mean-0.5) < meanBound && minValue >= 0.0f && maxValue < 1.0f, "floats", result.c_str());
+
+		result.Format("%.5f (bound %.5f)", serial.Get(), serial.GetBound());
+		ok &= Report(fabs(serial.Get()) < serial.GetBound(), "serial correlation", result.c_str());
+	}
+
+	// streams of neighbouring shots, streams of one shot and neighbouring weapon classes don't correlate,
+	// and the first draw of every shot is uniform over all sequence numbers
+	{
+		int firstDraw[256] = {0};
+		CCorrelation nextShot, nextStream, nextKey;
+
+		const int shots = min(samples, 65536);
+		for (int seq=0; seq<shots; ++seq)
+		{
+			const float spread = CShotRandom(g_testKey, seq|(eSRS_Spread<<16)).GetFloat(0);
+			nextShot.Add(spread, CShotRandom(g_testKey, (seq+1)|(eSRS_Spread<<16)).GetFloat(0));
+			nextStream.Add(spread, CShotRandom(g_testKey, seq|(eSRS_Recoil<<16)).GetFloat(0));
+			nextKey.Add(spread, CShotRandom(g_testKey+1, seq|(eSRS_Spread<<16)).GetFloat(0));
+			++firstDraw[(int)(spread*256.0f)];
+		}
+
+		const double bound = nextShot.GetBound();
+		result.Format("next shot %.5f, next stream %.5f, next key %.5f (bound %.5f)", nextShot.Get(), nextStream.Get(), nextKey.Get(), bound);
+		ok &= Report(fabs(nextShot.Get()) < bound && fabs(nextStream.Get()) < bound && fabs(nextKey.Get()) < bound, "stream independence", result.c_str());
+
+		const double chi = ChiSquare(firstDraw, shots);
+		result.Format("%.1f over %d shots (255 expected)", chi, shots);
+		ok &= Report(ChiSquareOk(chi), "first draw chi-square", result.c_str());
+	}
+
+	// avalanche: flipping any bit of counter or key flips half of the 128 output bits
+	{
+		const int trials = max(samples/(192*16), 16);
+		double total = 0.0, worstBit = 0.0;
+		int flips[192] = {0};
+
+		CShotRandom inputs(g_testKey, 3);
+		for (int t=0; t<trials; ++t)
+		{
+			uint32 counter[4], key[2], out[4];
+			inputs.GetBlock(2*t, counter);
+			uint32 more[4];
+			inputs.GetBlock(2*t+1, more);
+			key[0] = more[0]; key[1] = more[1];
+			Philox(counter, key, out);
+
+			for (int bit=0; bit<192; ++bit)
+			{
+				uint32 c[4] = { counter[0], counter[1], counter[2], counter[3] };
+				uint32 k[2] = { key[0], key[1] };
+				if (bit < 128)
+					c[bit>>5] ^= 1u<<(bit&31);
+				else
+					k[(bit-128)>>5] ^= 1u<<(bit&31);
+
+				uint32 flipped[4];
+				Philox(c, k, flipped);
+				for (int i=0; i<4; ++i)
+					flips[bit] += CountBits(out[i]^flipped[i]);
+			}
+		}
+
+		for (int bit=0; bit<192; ++bit)
+		{
+			total += flips[bit];
+			worstBit = max(worstBit, fabs((double)flips[bit]/trials-64.0));
+		}
+
+		// a flip changes 64 bits on average with deviation sqrt(32)
+		const double mean = total/(192.0*trials);
+		const double meanBound = 5.0*sqrt(32.0/(192.0*trials));
+		const double bitBound = 5.0*sqrt(32.0/trials);
+		result.Format("%.3f bits per flip, worst input bit %.3f off (64 expected, bounds %.3f/%.3f)", mean, worstBit, meanBound, bitBound);
+		ok &= Report(fabs(mean-64.0) < meanBound && worstBit < bitBound, "avalanche", result.c_str());
+	}
+
+	return ok;
+}
+
+//------------------------------------------------------------------------
+void CShotRandom::Benchmark(int count)
+{
+	count = max(count&~3, 4);
+	const int shots = max(count/16, 1);
+	float time[4];
+	uint32 sink = 0;
+
+	// bulk: count numbers from one stream and from one Mersenne Twister
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	CShotRandom stream(g_testKey, 0);
+	for (int i=0; i<count; i+=4)
+	{
+		uint32 out[4];
+		stream.GetBlock(i>>2, out);
+		sink += out[0] ^ out[1] ^ out[2] ^ out[3];
+	}
+	time[0] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	CMTRand_int32 mt(g_testKey);
+	for (int i=0; i<count; ++i)
+		sink += mt.Generate();
+	time[1] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	// per shot: a generator for the shot and the two spread angles, the twister has to be
+	// reseeded for every shot to give the same numbers on every machine
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int seq=0; seq<shots; ++seq)
+	{
+		float a, b;
+		CShotRandom(g_testKey, seq).GetFloat2(0, a, b);
+		sink += (uint32)((a+b)*1024.0f);
+	}
+	time[2] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int seq=0; seq<shots; ++seq)
+	{
+		mt.seed(g_testKey^seq);
+		const float a = mt.GenerateFloat();
+		const float b = mt.GenerateFloat();
+		sink += (uint32)((a+b)*1024.0f);
+	}
+	time[3] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+	g_sink = sink;
+
+	// all CMTRand_int32 share one state, the one cry_rand draws from, don't leave it at a known seed
+	mt.seed((uint32)gEnv->pTimer->GetAsyncTime().GetValue());
+
+	CryLogAlways("[ShotRandom] bulk x %d: Philox %.3fms (%.2fns each), CMTRand_int32 %.3fms (%.2fns each)",
+		count, time[0], time[0]*1000000.0f/count, time[1], time[1]*1000000.0f/count);
+	CryLogAlways("[ShotRandom] per shot x %d: Philox %.3fms (%.2fns each), reseeded CMTRand_int32 %.3fms (%.2fns each)",
+		shots, time[2], time[2]*1000000.0f/shots, time[3], time[3]*1000000.0f/shots);
+}
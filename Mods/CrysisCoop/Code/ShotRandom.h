@@ -0,0 +1,103 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __SHOT_RANDOM_H__
+#define __SHOT_RANDOM_H__
+
+#pragma once
+
+// Counter based random numbers for weapon shots (Philox4x32-10, Salmon et
+// al., "Parallel random numbers: as easy as 1, 2, 3").
+// A number of a stream is a pure function of the key of the stream and the
+// index of the number, so every machine that knows the key draws the same
+// numbers, in any order, and there is no generator state to send or to
+// keep in step. A stream costs two words, where CMTRand_int32 shares one
+// 2.5KB state that has to be reseeded and advanced in order.
+//
+// Weapons key a stream by their class and the shoot sequence number every
+// shot already carries over the network (CWeapon::GetShotRandom), so the
+// shooter, the server and the other clients spread the same shot the same
+// way. Entity ids can't be part of the key, they differ between machines,
+// so weapons of one class share their patterns (see CWeapon::GetShotRandom).
+
+class CShotRandom
+{
+public:
+	// the draws of one shot for different uses come from different streams
+	enum EStream
+	{
+		eSRS_Spread = 0,
+		eSRS_Recoil,
+		eSRS_Pellets,
+	};
+
+	CShotRandom(uint32 key0, uint32 key1) { m_key[0] = key0; m_key[1] = key1; }
+
+	// the four numbers [4*block, 4*block+4) of the stream
+	ILINE void GetBlock(uint32 block, uint32 out[4]) const
+	{
+		const uint32 counter[4] = { block, 0, 0, 0 };
+		Philox(counter, m_key, out);
+	}
+
+	ILINE uint32 GetUInt(uint32 index) const
+	{
+		uint32 out[4];
+		GetBlock(index>>2, out);
+		return out[index&3];
+	}
+
+	// in [0, 1), 24 bits
+	ILINE float GetFloat(uint32 index) const
+	{
+		return ToFloat(GetUInt(index));
+	}
+
+	// the numbers 2*pair and 2*pair+1 as floats in [0, 1), two pairs share a block
+	ILINE void GetFloat2(uint32 pair, float &a, float &b) const
+	{
+		uint32 out[4];
+		GetBlock(pair>>1, out);
+		const int i = (pair&1)<<1;
+		a = ToFloat(out[i]);
+		b = ToFloat(out[i+1]);
+	}
+
+	static ILINE float ToFloat(uint32 x) { return (x>>8) * (1.0f/16777216.0f); }
+
+	// the generator itself, 128 bit counter and 64 bit key to 128 random bits
+	static ILINE void Philox(const uint32 counter[4], const uint32 key[2], uint32 out[4])
+	{
+		uint32 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+		uint32 k0 = key[0], k1 = key[1];
+
+		for (int round=0; round<10; ++round)
+		{
+			if (round)
+			{
+				k0 += 0x9E3779B9;
+				k1 += 0xBB67AE85;
+			}
+
+			const uint64 p0 = (uint64)0xD2511F53 * c0;
+			const uint64 p1 = (uint64)0xCD9E8D57 * c2;
+			c0 = (uint32)(p1>>32) ^ c1 ^ k0;
+			c1 = (uint32)p1;
+			c2 = (uint32)(p0>>32) ^ c3 ^ k1;
+			c3 = (uint32)p0;
+		}
+
+		out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+	}
+
+	// known answers and statistical checks over about samples numbers, logs the results
+	static bool SelfTest(int samples);
+	// times count numbers drawn in bulk and per shot, against CMTRand_int32
+	static void Benchmark(int count);
+
+private:
+	uint32 m_key[2];
+};
+
+#endif //__SHOT_RANDOM_H__
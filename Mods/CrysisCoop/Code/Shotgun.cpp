@@ -11,15 +11,47 @@
 #include "Projectile.h"
 #include "GameRules.h"
 #include "GameCVars.h"
+#include "IMaterialEffects.h"
+
+namespace
+{
+	// a pending i_shotgunBenchmark, picked up by the next update of the weapon's fire mode
+	EntityId s_benchmarkWeaponId = 0;
+	int s_benchmarkShots = 0;
+	int s_benchmarkInterval = 0;
+
+	// frames after the last shot of a phase, for the projectiles to hit
+	const int BENCHMARK_SETTLE_FRAMES = 30;
+}
 
 CShotgun::CShotgun(void)
 {
+	m_benchmark.phase = eBP_None;
 }
 
 CShotgun::~CShotgun(void)
 {
 }
 
+//------------------------------------------------------------------------
+void CShotgun::Update(float frameTime, uint frameId)
+{
+	CSingle::Update(frameTime, frameId);
+
+	if (s_benchmarkWeaponId && s_benchmarkWeaponId == m_pWeapon->GetEntityId())
+	{
+		s_benchmarkWeaponId = 0;
+
+		memset(&m_benchmark, 0, sizeof(m_benchmark));
+		m_benchmark.phase = eBP_Baseline;
+		m_benchmark.shots = s_benchmarkShots;
+		m_benchmark.interval = s_benchmarkInterval;
+	}
+
+	if (m_benchmark.phase != eBP_None)
+		UpdateBenchmark();
+}
+
 void CShotgun::Activate(bool activate)
 {
 	CSingle::Activate(activate);
@@ -299,7 +331,7 @@ bool CShotgun::Shoot(bool resetAnimation, bool autoreload/* =true */, bool noSou
 
 	Vec3 hit = GetProbableHit(WEAPON_HIT_RANGE);
 	Vec3 pos = GetFiringPos(hit);
-	Vec3 fdir = ApplySpread(GetFiringDir(hit, pos), GetSpread());
+	Vec3 fdir = ApplySpread(GetFiringDir(hit, pos), GetSpread(), m_pWeapon->GetNextShootSeqN());
 	Vec3 vel = GetFiringVelocity(fdir);
 	Vec3 dir;
 
@@ -309,27 +341,42 @@ bool CShotgun::Shoot(bool resetAnimation, bool autoreload/* =true */, bool noSou
 	uint16 seqn=m_pWeapon->GenerateShootSeqN();
 	uint16 seqr=m_shotgunparams.pellets-1;
 
-	for (int i = 0; i < m_shotgunparams.pellets; i++)
+	const bool batched = IsBatched();
+	if (batched)
 	{
-		CProjectile *pAmmo = m_pWeapon->SpawnAmmo(ammo, false);
-		if (pAmmo)
+		// the pellets keep consecutive sequence numbers for the shot validator
+		seqr = min((int)m_shotgunparams.pellets, (int)MAX_PELLETS)-1;
+		for (int i = 0; i < seqr; i++)
+			m_pWeapon->GenerateShootSeqN();
+
+		bool tracers = (!m_tracerparams.geometry.empty() || !m_tracerparams.effect.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0));
+		ShootPellets(pos, fdir, seqn, false, tracers);
+		dir = fdir;
+	}
+	else
+	{
+		for (int i = 0; i < m_shotgunparams.pellets; i++)
 		{
-			dir = ApplySpread(fdir, m_shotgunparams.spread);      
-      int hitTypeId = g_pGame->GetGameRules()->GetHitTypeId(m_fireparams.hit_type.c_str());			
-      
-			pAmmo->SetParams(m_pWeapon->GetOwnerId(), m_pWeapon->GetHostId(), m_pWeapon->GetEntityId(), m_pWeapon->GetFireModeIdx(GetName()),
-				m_shotgunparams.pelletdamage, hitTypeId);
-			pAmmo->SetSequence(m_pWeapon->GetShootSeqN());
-			pAmmo->SetDestination(m_pWeapon->GetDestination());
-			pAmmo->Launch(pos, dir, vel);
-
-			if ((!m_tracerparams.geometry.empty() || !m_tracerparams.effect.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0)))
-				EmitTracer(pos,hit,false);
-
-			m_projectileId = pAmmo->GetEntity()->GetId();
-		}
+			CProjectile *pAmmo = m_pWeapon->SpawnAmmo(ammo, false);
+			if (pAmmo)
+			{
+				dir = ApplyPelletSpread(fdir, seqn, i);
+				int hitTypeId = g_pGame->GetGameRules()->GetHitTypeId(m_fireparams.hit_type.c_str());			
+
+				pAmmo->SetParams(m_pWeapon->GetOwnerId(), m_pWeapon->GetHostId(), m_pWeapon->GetEntityId(), m_pWeapon->GetFireModeIdx(GetName()),
+					m_shotgunparams.pelletdamage, hitTypeId);
+				pAmmo->SetSequence(m_pWeapon->GetShootSeqN());
+				pAmmo->SetDestination(m_pWeapon->GetDestination());
+				pAmmo->Launch(pos, dir, vel);
 
-		m_pWeapon->GenerateShootSeqN();
+				if ((!m_tracerparams.geometry.empty() || !m_tracerparams.effect.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0)))
+					EmitTracer(pos,hit,false);
+
+				m_projectileId = pAmmo->GetEntity()->GetId();
+			}
+
+			m_pWeapon->GenerateShootSeqN();
+		}
 	}
 
 	m_pWeapon->OnShoot(m_pWeapon->GetOwnerId(), 0, ammo, pos, dir, vel);
@@ -397,7 +444,10 @@ bool CShotgun::Shoot(bool resetAnimation, bool autoreload/* =true */, bool noSou
 		}
 	}
 
-	m_pWeapon->RequestShoot(ammo, pos, dir, vel, hit, 1.0f, 0, seqn, seqr, false);
+	if (batched)
+		m_pWeapon->RequestShootPellets(pos, fdir, seqn, (uint8)seqr);
+	else
+		m_pWeapon->RequestShoot(ammo, pos, dir, vel, hit, 1.0f, 0, seqn, seqr, false);
 
 	return true;
 }
@@ -407,6 +457,18 @@ void CShotgun::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, con
 {
 	assert(0 == ph);
 
+	NetShootCommon(pos, dir, vel, hit, m_pWeapon->GetNetShootSeqN(), false);
+}
+
+//------------------------------------------------------------------------
+void CShotgun::NetShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq)
+{
+	NetShootCommon(pos, dir, GetFiringVelocity(dir), pos+dir*WEAPON_HIT_RANGE, seq, true);
+}
+
+//------------------------------------------------------------------------
+void CShotgun::NetShootCommon(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, uint16 seq, bool batched)
+{
 	IEntityClass* ammo = m_fireparams.ammo_type_class;
 	const char *action = m_actions.fire_cock.c_str();
 
@@ -425,31 +487,38 @@ void CShotgun::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, con
 
 	Vec3 pdir;
 
+	bool emit = false;
+	if(m_pWeapon->GetStats().fp)
+		emit = (!m_tracerparams.geometryFP.empty() || !m_tracerparams.effectFP.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0));
+	else
+		emit = (!m_tracerparams.geometry.empty() || !m_tracerparams.effect.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0));
+
 	// SHOT HERE
-	for (int i = 0; i < m_shotgunparams.pellets; i++)
+	if (batched)
+	{
+		ShootPellets(pos, dir, seq, true, emit);
+	}
+	else
 	{
-		CProjectile *pAmmo = m_pWeapon->SpawnAmmo(ammo, true);
-		if (pAmmo)
+		for (int i = 0; i < m_shotgunparams.pellets; i++)
 		{
-			pdir = ApplySpread(dir, m_shotgunparams.spread);
-      int hitTypeId = g_pGame->GetGameRules()->GetHitTypeId(m_fireparams.hit_type.c_str());			
-
-			pAmmo->SetParams(m_pWeapon->GetOwnerId(), m_pWeapon->GetHostId(), m_pWeapon->GetEntityId(), m_pWeapon->GetFireModeIdx(GetName()),
-				m_shotgunparams.pelletdamage, hitTypeId);
-			pAmmo->SetDestination(m_pWeapon->GetDestination());
-			pAmmo->SetRemote(true);
-			pAmmo->Launch(pos, pdir, vel);
-
-			bool emit = false;
-			if(m_pWeapon->GetStats().fp)
-				emit = (!m_tracerparams.geometryFP.empty() || !m_tracerparams.effectFP.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0));
-			else
-				emit = (!m_tracerparams.geometry.empty() || !m_tracerparams.effect.empty()) && (ammoCount==GetClipSize() || (ammoCount%m_tracerparams.frequency==0));
+			CProjectile *pAmmo = m_pWeapon->SpawnAmmo(ammo, true);
+			if (pAmmo)
+			{
+				pdir = ApplyPelletSpread(dir, seq, i);
+				int hitTypeId = g_pGame->GetGameRules()->GetHitTypeId(m_fireparams.hit_type.c_str());			
+
+				pAmmo->SetParams(m_pWeapon->GetOwnerId(), m_pWeapon->GetHostId(), m_pWeapon->GetEntityId(), m_pWeapon->GetFireModeIdx(GetName()),
+					m_shotgunparams.pelletdamage, hitTypeId);
+				pAmmo->SetDestination(m_pWeapon->GetDestination());
+				pAmmo->SetRemote(true);
+				pAmmo->Launch(pos, pdir, vel);
 
-			if (emit)
-				EmitTracer(pos,hit,false);
+				if (emit)
+					EmitTracer(pos,hit,false);
 
-			m_projectileId = pAmmo->GetEntity()->GetId();
+				m_projectileId = pAmmo->GetEntity()->GetId();
+			}
 		}
 	}
 
@@ -485,6 +554,277 @@ void CShotgun::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, con
 	m_pWeapon->RequireUpdate(eIUS_FireMode);
 }
 
+//------------------------------------------------------------------------
+bool CShotgun::IsBatched() const
+{
+	if (m_benchmark.phase == eBP_Projectiles)
+		return false;
+	else if (m_benchmark.phase == eBP_Batched)
+		return true;
+
+	return m_shotgunparams.batched || g_pGameCVars->i_shotgunBatchedPellets;
+}
+
+//------------------------------------------------------------------------
+namespace
+{
+	ILINE uint16 NextShootSeqN(uint16 seq)
+	{
+		return ++seq ? seq : 1;
+	}
+
+	// the pellets that hit one material of one target, the game rules scale the
+	// damage by the material (head, limbs), so materials can't share a hit
+	struct SPelletHit
+	{
+		EntityId targetId;
+		int material;
+		int partId;	// of the first pellet of the group
+		int pellets;
+		uint16 seq;
+		Vec3 pos, dir, normal;
+	};
+}
+
+//------------------------------------------------------------------------
+Vec3 CShotgun::ApplyPelletSpread(const Vec3 &dir, uint16 seq, int pellet) const
+{
+	Ang3 angles=Ang3::GetAnglesXYZ(Matrix33::CreateRotationVDir(dir));
+
+	float rx, rz;
+	m_pWeapon->GetShotRandom(seq, CShotRandom::eSRS_Pellets).GetFloat2(pellet, rx, rz);
+	rx-=0.5f;
+	rz-=0.5f;
+
+	angles.x+=rx*DEG2RAD(m_shotgunparams.spread);
+	angles.z+=rz*DEG2RAD(m_shotgunparams.spread);
+
+	return Matrix33::CreateRotationXYZ(angles).GetColumn(1).normalized();
+}
+
+//------------------------------------------------------------------------
+// Summary:
+//	Traces all pellets of one shot and reports one hit per target and hit material,
+//	carrying the damage of the pellets in that group and the part of the first one.
+//	Every pellet still pushes what it hits. The spread comes from the sequence number
+//	of the first pellet, so remote machines trace the same pattern.
+int CShotgun::ShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq, bool remote, bool tracers)
+{
+	FUNCTION_PROFILER(GetISystem(), PROFILE_GAME);
+
+	IEntityClass* ammo = m_fireparams.ammo_type_class;
+	CGameRules *pGameRules = g_pGame->GetGameRules();
+	if (!ammo || !pGameRules)
+		return 0;
+
+	const int numPellets = min((int)m_shotgunparams.pellets, (int)MAX_PELLETS);
+
+	// one pass over all pellets with a shared skip list
+	IPhysicalEntity* pSkipEnts[10];
+	int nSkipEnts = GetSkipEntities(m_pWeapon, pSkipEnts, 10);
+
+	Vec3 dirs[MAX_PELLETS];
+	ray_hit hits[MAX_PELLETS];
+	bool hasHit[MAX_PELLETS];
+
+	for (int i = 0; i < numPellets; i++)
+	{
+		dirs[i] = ApplyPelletSpread(dir, seq, i);
+		hasHit[i] = gEnv->pPhysicalWorld->RayWorldIntersection(pos, dirs[i]*WEAPON_HIT_RANGE, ent_all|ent_water,
+			rwi_stop_at_pierceable|rwi_ignore_back_faces, &hits[i], 1, pSkipEnts, nSkipEnts) > 0;
+	}
+
+	const SAmmoParams *pAmmoParams = g_pGame->GetWeaponSystem()->GetAmmoParams(ammo);
+	const pe_params_particle *pParticle = pAmmoParams ? pAmmoParams->pParticleParams : 0;
+	const float impulse = pParticle ? pParticle->mass*pParticle->velocity : 0.0f;
+
+	IActor *pOwner = m_pWeapon->GetOwnerActor();
+	IEntity *pShooter = m_pWeapon->GetOwner();
+	IMaterialEffects *pMaterialEffects = g_pGame->GetIGameFramework()->GetIMaterialEffects();
+	static int htMelee = pGameRules->GetHitTypeId("melee");
+	int hitTypeId = pGameRules->GetHitTypeId(m_fireparams.hit_type.c_str());
+
+	SPelletHit targets[MAX_PELLETS];
+	int numTargets = 0;
+	uint16 pelletSeq = seq;
+
+	for (int i = 0; i < numPellets; i++)
+	{
+		if (i > 0)
+			pelletSeq = NextShootSeqN(pelletSeq);
+
+		if (tracers)
+			EmitTracer(pos, hasHit[i] ? hits[i].pt : pos+dirs[i]*WEAPON_HIT_RANGE, false);
+
+		if (!hasHit[i])
+			continue;
+
+		const ray_hit &hit = hits[i];
+		int material = pGameRules->GetHitMaterialIdFromSurfaceId(hit.surface_idx);
+
+		// impact effect, the projectile collision would have triggered it
+		TMFXEffectId effectId = pMaterialEffects->GetEffectId(ammo, hit.surface_idx);
+		if (effectId != InvalidEffectId)
+		{
+			SMFXRunTimeEffectParams params;
+			params.pos = hit.pt;
+			params.normal = hit.n;
+			params.dir[0] = dirs[i];
+			params.trgSurfaceId = hit.surface_idx;
+			pMaterialEffects->ExecuteEffect(effectId, params);
+		}
+
+		// Notify AI
+		if (gEnv->pAISystem && !gEnv->bMultiplayer && pShooter && hitTypeId != htMelee)
+		{
+			ISurfaceType *pSurfaceType = pGameRules->GetHitMaterial(material);
+			const ISurfaceType::SSurfaceTypeAIParams* pParams = pSurfaceType ? pSurfaceType->GetAIParams() : 0;
+			const float radius = pParams ? pParams->fImpactRadius : 2.5f;
+			const float soundRadius = pParams ? pParams->fImpactSoundRadius : 20.0f;
+			gEnv->pAISystem->BulletHitEvent(hit.pt, radius, soundRadius, pShooter->GetAI());
+		}
+
+		// the momentum of the pellet, the projectile would have passed it on in its collision
+		if (hit.pCollider && impulse > 0.0f)
+		{
+			pe_action_impulse action;
+			action.impulse = dirs[i]*impulse;
+			action.point = hit.pt;
+			action.partid = hit.partid;
+			hit.pCollider->Action(&action);
+		}
+
+		IEntity *pTarget = hit.pCollider ? gEnv->pEntitySystem->GetEntityFromPhysics(hit.pCollider) : 0;
+		if (!pTarget)
+			continue;
+
+		if (!gEnv->bMultiplayer && pOwner && pOwner->IsPlayer())
+		{
+			IActor* pAITarget = g_pGame->GetIGameFramework()->GetIActorSystem()->GetActor(pTarget->GetId());
+			if (pAITarget && pTarget->GetAI() && !pTarget->GetAI()->IsHostile(pOwner->GetEntity()->GetAI(),false))
+			{
+				pGameRules->SetEntityToIgnore(pTarget->GetId());
+				continue;
+			}
+		}
+
+		int t = 0;
+		while (t < numTargets && (targets[t].targetId != pTarget->GetId() || targets[t].material != material))
+			++t;
+
+		if (t == numTargets)
+		{
+			SPelletHit &target = targets[numTargets++];
+			target.targetId = pTarget->GetId();
+			target.material = material;
+			target.partId = hit.partid;
+			target.pellets = 0;
+			target.seq = pelletSeq;
+			target.pos = hit.pt;
+			target.dir = dirs[i];
+			target.normal = hit.n;
+		}
+
+		++targets[t].pellets;
+	}
+
+	const int bulletType = pAmmoParams ? pAmmoParams->bulletType : -1;
+	const int forcedMaterial = m_pWeapon->GetForcedHitMaterial();
+
+	for (int t = 0; t < numTargets; t++)
+	{
+		const SPelletHit &target = targets[t];
+
+		HitInfo hitInfo(m_pWeapon->GetOwnerId(), target.targetId, m_pWeapon->GetEntityId(),
+			m_pWeapon->GetFireModeIdx(GetName()), 0.0f, target.material, target.partId,
+			hitTypeId, target.pos, target.dir, target.normal);
+
+		hitInfo.remote = remote;
+		hitInfo.bulletType = bulletType;
+		if (!remote)
+			hitInfo.seq = target.seq;
+		hitInfo.damage = (float)(m_shotgunparams.pelletdamage * target.pellets);
+
+		if (forcedMaterial != -1)
+			hitInfo.material = pGameRules->GetHitMaterialIdFromSurfaceId(forcedMaterial);
+
+		pGameRules->ClientHit(hitInfo);
+	}
+
+	return numTargets;
+}
+
+//------------------------------------------------------------------------
+void CShotgun::RequestBenchmark(EntityId weaponId, int shots, int interval)
+{
+	s_benchmarkWeaponId = weaponId;
+	s_benchmarkShots = max(1, shots);
+	s_benchmarkInterval = max(1, interval);
+}
+
+//------------------------------------------------------------------------
+void CShotgun::UpdateBenchmark()
+{
+	SBenchmark &bench = m_benchmark;
+
+	// the frame that just ended, including the physics and hits of earlier shots
+	const float frameTime = gEnv->pTimer->GetRealFrameTime()*1000.0f;
+	bench.time[bench.phase] += frameTime;
+	bench.maxTime[bench.phase] = max(bench.maxTime[bench.phase], frameTime);
+	++bench.frames[bench.phase];
+
+	if (bench.phase != eBP_Baseline && bench.fired < bench.shots && (bench.frame % bench.interval) == 0)
+	{
+		if (m_fireparams.clip_size > 0)
+			m_pWeapon->SetAmmoCount(m_fireparams.ammo_type_class, m_fireparams.clip_size);
+		m_next_shot = 0.0f;
+
+		if (!Shoot(true))
+		{
+			GameWarning("[Shotgun] Benchmark stopped, %s could not shoot", m_pWeapon->GetEntity()->GetName());
+			bench.phase = eBP_None;
+			return;
+		}
+
+		++bench.fired;
+	}
+
+	if (++bench.frame >= bench.shots*bench.interval + BENCHMARK_SETTLE_FRAMES)
+	{
+		bench.frame = 0;
+		bench.fired = 0;
+
+		if (++bench.phase == eBP_Last)
+		{
+			LogBenchmark();
+			bench.phase = eBP_None;
+			return;
+		}
+	}
+
+	m_pWeapon->RequireUpdate(eIUS_FireMode);
+}
+
+//------------------------------------------------------------------------
+void CShotgun::LogBenchmark() const
+{
+	const SBenchmark &bench = m_benchmark;
+	const float baseline = bench.time[eBP_Baseline]/max(1, bench.frames[eBP_Baseline]);
+
+	CryLogAlways("[Shotgun] Benchmark %s: %d shots of %d pellets, one every %d frames",
+		m_pWeapon->GetEntity()->GetName(), bench.shots, min((int)m_shotgunparams.pellets, (int)MAX_PELLETS), bench.interval);
+	CryLogAlways("[Shotgun]   no shots:    %.2fms/frame, max %.2fms over %d frames",
+		baseline, bench.maxTime[eBP_Baseline], bench.frames[eBP_Baseline]);
+
+	static const char *names[eBP_Last] = { 0, 0, "projectiles:", "batched:    " };
+	for (int phase = eBP_Projectiles; phase < eBP_Last; ++phase)
+	{
+		const float perShot = (bench.time[phase] - baseline*bench.frames[phase])/bench.shots;
+		CryLogAlways("[Shotgun]   %s %.2fms/frame, max %.2fms over %d frames, %.3fms per shot above no shots",
+			names[phase], bench.time[phase]/max(1, bench.frames[phase]), bench.maxTime[phase], bench.frames[phase], perShot);
+	}
+}
+
 //------------------------------------------------------------------------
 void CShotgun::ResetParams(const struct IItemParamsNode *params)
 {
@@ -25,17 +25,20 @@ protected:
 			ResetValue(pellets,			10);
 			ResetValue(pelletdamage,				20);
 			ResetValue(spread,			.1f);
+			ResetValue(batched,			false);
 		}
 
 		short pellets;
 		short	pelletdamage;
 		float spread;
+		bool	batched;	// trace the pellets of a shot instead of spawning projectiles
 
 	} SShotgunParams;
 public:
 	CShotgun(void);
 	~CShotgun(void);
 	virtual void GetMemoryStatistics(ICrySizer * s) { s->Add(*this); CSingle::GetMemoryStatistics(s); }
+	virtual void Update(float frameTime, uint frameId);
 	virtual void Activate(bool activate);
 	virtual void Reload(int zoomed);
 	virtual void StartReload(int zoomed);
@@ -49,12 +52,51 @@ public:
 
 	virtual bool Shoot(bool resetAnimation, bool autoreload = true , bool noSound = false );
 	virtual void NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int ph);
+	// all pellets of a shot in one call, see CWeapon::NetShootPellets
+	void NetShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq);
 
 	virtual void ResetParams(const struct IItemParamsNode *params);
 	virtual void PatchParams(const struct IItemParamsNode *patch);
 
 	virtual const char* GetType() const;
+
+	// the shotgun fire mode of weaponId shoots shots times, once every interval frames,
+	// with projectiles and with traced pellets, and logs the frame time of both against
+	// as many frames without shots
+	static void RequestBenchmark(EntityId weaponId, int shots, int interval);
+
 protected:
+	enum { MAX_PELLETS = 32 };	// seqr is sent in 5 bits
+
+	enum EBenchmarkPhase
+	{
+		eBP_None = 0,
+		eBP_Baseline,
+		eBP_Projectiles,
+		eBP_Batched,
+		eBP_Last,
+	};
+
+	struct SBenchmark
+	{
+		int		phase;
+		int		shots;
+		int		interval;
+		int		frame;
+		int		fired;
+		int		frames[eBP_Last];
+		float	time[eBP_Last];
+		float	maxTime[eBP_Last];
+	};
+
+	void UpdateBenchmark();
+	void LogBenchmark() const;
+
+	bool IsBatched() const;
+	Vec3 ApplyPelletSpread(const Vec3 &dir, uint16 seq, int pellet) const;
+	int ShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq, bool remote, bool tracers);
+	void NetShootCommon(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, uint16 seq, bool batched);
+
 	SShotgunParams m_shotgunparams;
 	bool					 m_reload_pump;
 	bool					 m_break_reload;
@@ -62,4 +104,6 @@ protected:
 
 	int            m_max_shells;
 
+	SBenchmark		 m_benchmark;
+
 };
@@ -20,8 +20,8 @@ History:
 #include "Game.h"
 #include "GameCVars.h"
 #include "HUD/HUD.h"
-#include "HUD/HUDRadar.h"
 #include "WeaponSystem.h"
+#include "AimAssistCandidates.h"
 #include <IEntitySystem.h>
 #include "ISound.h"
 #include <IVehicleSystem.h>
@@ -564,17 +564,40 @@ void CSingle::UpdateAutoAim(float frameTime)
 	Vec3 aimPos = state.eyePosition;
 	
 	float maxDistance = m_fireparams.autoaim_distance;
+
+	// the ray is only needed if the aim line crosses the bounds of a possible target,
+	// or to check the tolerance of the current lock
+	bool needRay = m_bLocked || m_bLocking;
+	if (!needRay)
+	{
+		CAimAssistCandidates &candidates = g_pGame->GetWeaponSystem()->GetAimAssistCandidates();
+		candidates.Refresh(maxDistance);
+
+		int hits[CAimAssistCandidates::MAX_HITS];
+		int numHits = candidates.IntersectSegment(Lineseg(aimPos, aimPos + aimDir * maxDistance), 0.0f, hits, CAimAssistCandidates::MAX_HITS);
+		for (int i=0; i<numHits && !needRay; ++i)
+		{
+			IEntity *pCandidate = gEnv->pEntitySystem->GetEntity(candidates.GetEntityId(hits[i]));
+			needRay = pCandidate && IsValidAutoAimTarget(pCandidate);
+		}
+	}
   
   ray_hit ray;
-  
-  IPhysicalEntity* pSkipEnts[10];
-  int nSkipEnts = GetSkipEntities(m_pWeapon, pSkipEnts, 10);
-  	
-	const int objects = ent_all;
-	const int flags = (geom_colltype_ray << rwi_colltype_bit) | rwi_colltype_any | (8 & rwi_pierceability_mask) | (geom_colltype14 << rwi_colltype_bit);
+  ray.dist = 2.f * maxDistance;
+  ray.pCollider = 0;
+  int result = 0;
 
-	int result = gEnv->pPhysicalWorld->RayWorldIntersection(aimPos, aimDir * 2.f * maxDistance, 
-		objects, flags, &ray, 1, pSkipEnts, nSkipEnts);		
+  if (needRay)
+  {
+    IPhysicalEntity* pSkipEnts[10];
+    int nSkipEnts = GetSkipEntities(m_pWeapon, pSkipEnts, 10);
+
+    const int objects = ent_all;
+    const int flags = (geom_colltype_ray << rwi_colltype_bit) | rwi_colltype_any | (8 & rwi_pierceability_mask) | (geom_colltype14 << rwi_colltype_bit);
+
+    result = gEnv->pPhysicalWorld->RayWorldIntersection(aimPos, aimDir * 2.f * maxDistance, 
+      objects, flags, &ray, 1, pSkipEnts, nSkipEnts);		
+  }
 
   bool hitValidTarget = false;
   IEntity* pEntity = 0;
@@ -1223,7 +1246,7 @@ bool CSingle::CrosshairAssistAiming(const Vec3& firingPos, Vec3& firingDir, ray_
   // farcry-style crosshair-overlap aim assistance
   
   IEntity* pSelf = m_pWeapon->GetOwner();
-  if (!pSelf || !g_pGame->GetHUD())
+  if (!pSelf)
     return false;
 
   IEntity* pEntity = pRayhit->pCollider ? gEnv->pEntitySystem->GetEntityFromPhysics(pRayhit->pCollider) : 0;  
@@ -1236,14 +1259,22 @@ bool CSingle::CrosshairAssistAiming(const Vec3& firingPos, Vec3& firingDir, ray_
   float t = 0.f;  
   AABB bounds;
   int debugY = 100;
-  std::vector<IEntity*> ents;
+  std::vector<IEntity*>& ents = m_assistTargets;
+  ents.resize(0);
+
+  CAimAssistCandidates& candidates = g_pGame->GetWeaponSystem()->GetAimAssistCandidates();
+  candidates.Refresh(m_fireparams.crosshair_assist_range);
+
+  // the candidate bounds grown by the max. distance from the line of view 
+  // are a conservative fast reject for the center distance check below
+  int hits[CAimAssistCandidates::MAX_HITS];
+  int numHits = candidates.IntersectSegment(lineseg, 10.f, hits, CAimAssistCandidates::MAX_HITS);
     
-  const std::vector<EntityId> *pEntities = g_pGame->GetHUD()->GetRadar()->GetNearbyEntities();
-  for(int i=0,n=pEntities->size(); i<n; ++i)  
+  for(int i=0; i<numHits; ++i)  
   {
     // fast reject everything behind player, or too far away from line of view
     // rest is sorted by distance and checked against the crosshair in screen-space    
-    IEntity* pEntity = gEnv->pEntitySystem->GetEntity((*pEntities)[i]);
+    IEntity* pEntity = gEnv->pEntitySystem->GetEntity(candidates.GetEntityId(hits[i]));
 		if(!pEntity)
 			continue;
 
@@ -1415,7 +1446,9 @@ bool CSingle::Shoot(bool resetAnimation, bool autoreload, bool noSound)
   
   Vec3 hit = GetProbableHit(WEAPON_HIT_RANGE, &bHit, &rayhit);
 	Vec3 pos = GetFiringPos(hit);
-	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread());
+	// the shot keeps its number even if no projectile spawns, RequestShoot sends it along
+	uint16 seq = m_pWeapon->GenerateShootSeqN();
+	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread(), seq);
 	Vec3 vel = GetFiringVelocity(dir);
 
 	// Advanced aiming (VTOL Ascension)
@@ -1497,7 +1530,7 @@ bool CSingle::Shoot(bool resetAnimation, bool autoreload, bool noSound)
 
 		pAmmo->SetParams(m_pWeapon->GetOwnerId(), m_pWeapon->GetHostId(), m_pWeapon->GetEntityId(), m_pWeapon->GetFireModeIdx(GetName()),
 			(int)damage, pGameRules->GetHitTypeId(m_fireparams.hit_type.c_str()));
-		pAmmo->SetSequence(m_pWeapon->GenerateShootSeqN());
+		pAmmo->SetSequence(seq);
 		// this must be done after owner is set
 		pAmmo->InitWithAI();
     
@@ -1611,7 +1644,7 @@ bool CSingle::Shoot(bool resetAnimation, bool autoreload, bool noSound)
 	//---------------------------------------------------------------------------
 
 	//CryLog("RequestShoot - pos(%f,%f,%f), dir(%f,%f,%f), hit(%f,%f,%f)", pos.x, pos.y, pos.z, dir.x, dir.y, dir.z, hit.x, hit.y, hit.z);
-	m_pWeapon->RequestShoot(ammo, pos, dir, vel, hit, m_speed_scale, pAmmo? pAmmo->GetGameObject()->GetPredictionHandle() : 0, m_pWeapon->GetShootSeqN(), 0, false);
+	m_pWeapon->RequestShoot(ammo, pos, dir, vel, hit, m_speed_scale, pAmmo? pAmmo->GetGameObject()->GetPredictionHandle() : 0, seq, 0, false);
 
 	return true;
 }
@@ -2064,12 +2097,14 @@ Vec3 CSingle::NetGetFiringVelocity(const Vec3 &dir) const
 }
 
 //------------------------------------------------------------------------
-Vec3 CSingle::ApplySpread(const Vec3 &dir, float spread)
+Vec3 CSingle::ApplySpread(const Vec3 &dir, float spread, uint16 seq)
 {
 	Ang3 angles=Ang3::GetAnglesXYZ(Matrix33::CreateRotationVDir(dir));
 	
-	float rx=Random()-0.5f;
-	float rz=Random()-0.5f;
+	float rx, rz;
+	m_pWeapon->GetShotRandom(seq, CShotRandom::eSRS_Spread).GetFloat2(0, rx, rz);
+	rx-=0.5f;
+	rz-=0.5f;
 
 	angles.x+=rx*DEG2RAD(spread);
 	angles.z+=rz*DEG2RAD(spread);
@@ -2718,7 +2753,9 @@ void CSingle::UpdateRecoil(float frameTime)
 		{
 			if (m_fired)
 			{
-				Vec2 rdir(Random()*m_recoilparams.randomness,BiRandom(m_recoilparams.randomness));
+				float rx, ry;
+				m_pWeapon->GetShotRandom(m_pWeapon->GetShootSeqN(), CShotRandom::eSRS_Recoil).GetFloat2(0, rx, ry);
+				Vec2 rdir(rx*m_recoilparams.randomness,(ry*2.0f-1.0f)*m_recoilparams.randomness);
 				m_recoil_dir = Vec2(recoil_dir_add.x+rdir.x, recoil_dir_add.y+rdir.y);
 				m_recoil_dir.NormalizeSafe();
 			}
@@ -2770,7 +2807,7 @@ void CSingle::ResetRecoil(bool spread)
 void CSingle::NetShoot(const Vec3 &hit, int predictionHandle)
 {
 	Vec3 pos = NetGetFiringPos(hit);
-	Vec3 dir = ApplySpread(NetGetFiringDir(hit, pos), GetSpread());
+	Vec3 dir = ApplySpread(NetGetFiringDir(hit, pos), GetSpread(), m_pWeapon->GetNetShootSeqN());
 	Vec3 vel = NetGetFiringVelocity(dir);
 
 	NetShootEx(pos, dir, vel, hit, 1.0f, predictionHandle);
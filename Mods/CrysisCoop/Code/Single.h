@@ -654,7 +654,8 @@ public:
 	virtual Vec3 GetFiringPos(const Vec3 &probableHit) const;
 	virtual Vec3 GetFiringDir(const Vec3 &probableHit, const Vec3& firingPos) const;
 	virtual Vec3 GetFiringVelocity(const Vec3& dir) const;
-	virtual Vec3 ApplySpread(const Vec3 &dir, float spread);
+	// the spread of shot seq, drawn from its spread stream so every machine spreads it the same
+	virtual Vec3 ApplySpread(const Vec3 &dir, float spread, uint16 seq);
 
 	virtual Vec3 NetGetFiringPos(const Vec3 &probableHit) const;
 	virtual Vec3 NetGetFiringDir(const Vec3 &probableHit, const Vec3& firingPos) const;
@@ -721,6 +722,7 @@ protected:
 	void EmitTracer(const Vec3& pos,const Vec3& destination,bool ooa);
 
 	std::vector<IStatObj *> m_tracerCache;
+	std::vector<IEntity *>	m_assistTargets;	// reused by CrosshairAssistAiming
 
 
 	CWeapon		*m_pWeapon;
@@ -0,0 +1,273 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "StructSerializer.h"
+#include "Weapon.h"
+#include <SimpleSerialize.h>
+
+//------------------------------------------------------------------------
+int CStructBitWriter::Finish()
+{
+	while (m_bits > 0)
+	{
+		if (m_pos < m_size)
+			m_pBuffer[m_pos] = (uint8)m_acc;
+		else
+			m_overflow = true;
+		++m_pos;
+		m_acc >>= 8;
+		m_bits -= 8;
+	}
+	m_acc = 0;
+	m_bits = 0;
+
+	return m_overflow ? -1 : m_pos;
+}
+
+//------------------------------------------------------------------------
+void CStructBitReader::RefillTail(int bits)
+{
+	for (int i=0; i<4 && m_pos<m_size; ++i, ++m_pos, m_bits+=8)
+		m_acc |= (uint64)m_pBuffer[m_pos] << m_bits;
+
+	if (m_bits < bits)
+	{
+		m_overflow = true;
+		m_bits = bits;
+	}
+}
+
+//------------------------------------------------------------------------
+void CStructLayout::Write(CStructBitWriter &writer, const void *pObject) const
+{
+	for (std::vector<SStructFieldInfo>::const_iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		const SStructFieldInfo &field = *it;
+		const void *pValue = (const char*)pObject + field.offset;
+		switch (field.type)
+		{
+		case eSFT_Bool:		SStructFieldCodec::Write(writer, *(const bool*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int8:		SStructFieldCodec::Write(writer, *(const int8*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt8:	SStructFieldCodec::Write(writer, *(const uint8*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int16:	SStructFieldCodec::Write(writer, *(const int16*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt16:	SStructFieldCodec::Write(writer, *(const uint16*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int32:	SStructFieldCodec::Write(writer, *(const int32*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt32:	SStructFieldCodec::Write(writer, *(const uint32*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Float:	SStructFieldCodec::Write(writer, *(const float*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Vec3:		SStructFieldCodec::Write(writer, *(const Vec3*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Quat:		SStructFieldCodec::Write(writer, *(const Quat*)pValue, field.fMin, field.fMax, field.nBits); break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+void CStructLayout::Read(CStructBitReader &reader, void *pObject) const
+{
+	for (std::vector<SStructFieldInfo>::const_iterator it = m_fields.begin(); it != m_fields.end(); ++it)
+	{
+		const SStructFieldInfo &field = *it;
+		void *pValue = (char*)pObject + field.offset;
+		switch (field.type)
+		{
+		case eSFT_Bool:		SStructFieldCodec::Read(reader, *(bool*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int8:		SStructFieldCodec::Read(reader, *(int8*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt8:	SStructFieldCodec::Read(reader, *(uint8*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int16:	SStructFieldCodec::Read(reader, *(int16*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt16:	SStructFieldCodec::Read(reader, *(uint16*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Int32:	SStructFieldCodec::Read(reader, *(int32*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_UInt32:	SStructFieldCodec::Read(reader, *(uint32*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Float:	SStructFieldCodec::Read(reader, *(float*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Vec3:		SStructFieldCodec::Read(reader, *(Vec3*)pValue, field.fMin, field.fMax, field.nBits); break;
+		case eSFT_Quat:		SStructFieldCodec::Read(reader, *(Quat*)pValue, field.fMin, field.fMax, field.nBits); break;
+		}
+	}
+}
+
+//------------------------------------------------------------------------
+// Benchmark
+//------------------------------------------------------------------------
+
+// field lists of the weapon RMI parameters, their policies are the ones of SerializeWith
+SERIALIZE_INFO_TYPE_BEGIN(CWeapon::SvRequestShootExParams)
+	SERIALIZE_QUANT_INFO(pos, 'wrld', -4096.0f, 4096.0f, 22)
+	SERIALIZE_QUANT_INFO(dir, 'dir3', -1.0f, 1.0f, 12)
+	SERIALIZE_QUANT_INFO(vel, 'vel0', -256.0f, 256.0f, 16)
+	SERIALIZE_QUANT_INFO(hit, 'wrld', -4096.0f, 4096.0f, 22)
+	SERIALIZE_VAR_INFO(extra, 'smal')
+	SERIALIZE_VAR_INFO(seq, 'ui16')
+	SERIALIZE_QUANT_INFO(seqr, 'ui5', 0, 31, 5)
+	SERIALIZE_VAR_INFO(predictionHandle, 'phdl')
+SERIALIZE_INFO_TYPE_END(CWeapon::SvRequestShootExParams)
+
+SERIALIZE_INFO_TYPE_BEGIN(CWeapon::RequestMeleeAttackParams)
+	SERIALIZE_VAR_INFO(wmelee, 'bool')
+	SERIALIZE_QUANT_INFO(pos, 'wrld', -4096.0f, 4096.0f, 22)
+	SERIALIZE_QUANT_INFO(dir, 'dir3', -1.0f, 1.0f, 12)
+	SERIALIZE_VAR_INFO(seq, 'ui16')
+SERIALIZE_INFO_TYPE_END(CWeapon::RequestMeleeAttackParams)
+
+namespace
+{
+	// TSerialize into the bit stream at full width, the policies are compression policies of the
+	// network and not known here
+	template <bool READING>
+	class CBitSerializeImpl : public CSimpleSerializeImpl<READING, eST_Network>
+	{
+	public:
+		CBitSerializeImpl(CStructBitWriter *pWriter, CStructBitReader *pReader) : m_pWriter(pWriter), m_pReader(pReader) {}
+
+		template <class T> void Value(const char *name, T &value, uint32 policy)
+		{
+			if (READING)
+				SStructFieldCodec::Read(*m_pReader, value, 0.0f, 0.0f, 0);
+			else
+				SStructFieldCodec::Write(*m_pWriter, value, 0.0f, 0.0f, 0);
+		}
+		void Value(const char *name, Vec2 &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, Ang3 &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, int64 &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, uint64 &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, ScriptAnyValue &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, CTimeValue &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, SNetObjectID &value, uint32 policy) { this->Failed(); }
+		void Value(const char *name, SSerializeString &value, uint32 policy) { this->Failed(); }
+
+		bool BeginOptionalGroup(const char *name, bool condition)
+		{
+			bool present = condition;
+			Value(name, present, 0);
+			return present;
+		}
+
+	private:
+		CStructBitWriter *m_pWriter;
+		CStructBitReader *m_pReader;
+	};
+
+	void RandomFill(CWeapon::SvRequestShootExParams &params)
+	{
+		params.pos = Vec3(Random(-2000.0f, 2000.0f), Random(-2000.0f, 2000.0f), Random(0.0f, 500.0f));
+		params.dir = Vec3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)).GetNormalizedSafe(Vec3(0, 1.0f, 0));
+		params.vel = params.dir * Random(0.0f, 200.0f);
+		params.hit = params.pos + params.dir * Random(0.0f, 300.0f);
+		params.extra = Random(0.0f, 1.0f);
+		params.seq = (uint16)(rand() & 0xffff);
+		params.seqr = (uint8)(rand() & 31);
+		params.predictionHandle = rand();
+	}
+
+	void RandomFill(CWeapon::RequestMeleeAttackParams &params)
+	{
+		params.wmelee = (rand() & 1) != 0;
+		params.pos = Vec3(Random(-2000.0f, 2000.0f), Random(-2000.0f, 2000.0f), Random(0.0f, 500.0f));
+		params.dir = Vec3(Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f)).GetNormalizedSafe(Vec3(0, 1.0f, 0));
+		params.seq = (uint16)(rand() & 0xffff);
+	}
+
+	// full width, so the hand written path has to read back exactly what it wrote
+	bool Equals(const CWeapon::SvRequestShootExParams &a, const CWeapon::SvRequestShootExParams &b)
+	{
+		return a.pos == b.pos && a.dir == b.dir && a.vel == b.vel && a.hit == b.hit && a.extra == b.extra &&
+			a.seq == b.seq && a.seqr == b.seqr && a.predictionHandle == b.predictionHandle;
+	}
+
+	bool Equals(const CWeapon::RequestMeleeAttackParams &a, const CWeapon::RequestMeleeAttackParams &b)
+	{
+		return a.wmelee == b.wmelee && a.pos == b.pos && a.dir == b.dir && a.seq == b.seq;
+	}
+
+	template <class T>
+	bool BenchmarkStruct(const char *name, int count)
+	{
+		std::vector<T> objects(count);
+		for (int i=0; i<count; ++i)
+			RandomFill(objects[i]);
+
+		const CStructLayout &layout = CStructSerializer::GetLayout<T>(name);
+		const int bufferSize = count * (sizeof(T) + 8);
+		std::vector<uint8> unrolled(bufferSize), table(bufferSize), manual(bufferSize);
+		std::vector<T> unrolledRead(count), tableRead(count), manualRead(count);
+		float time[6];
+
+		CTimeValue start = gEnv->pTimer->GetAsyncTime();
+		CStructBitWriter unrolledWriter(&unrolled[0], bufferSize);
+		for (int i=0; i<count; ++i)
+			CStructSerializer::Write(unrolledWriter, objects[i]);
+		const int unrolledSize = unrolledWriter.Finish();
+		time[0] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		start = gEnv->pTimer->GetAsyncTime();
+		CStructBitWriter tableWriter(&table[0], bufferSize);
+		for (int i=0; i<count; ++i)
+			layout.Write(tableWriter, &objects[i]);
+		const int tableSize = tableWriter.Finish();
+		time[1] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		start = gEnv->pTimer->GetAsyncTime();
+		CStructBitWriter manualWriter(&manual[0], bufferSize);
+		CBitSerializeImpl<false> writeImpl(&manualWriter, 0);
+		CSimpleSerialize< CBitSerializeImpl<false> > writeSerialize(writeImpl);
+		TSerialize writeSer(&writeSerialize);
+		for (int i=0; i<count; ++i)
+			objects[i].SerializeWith(writeSer);
+		const int manualSize = manualWriter.Finish();
+		time[2] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		start = gEnv->pTimer->GetAsyncTime();
+		CStructBitReader unrolledReader(&unrolled[0], max(unrolledSize, 0));
+		for (int i=0; i<count; ++i)
+			CStructSerializer::Read(unrolledReader, unrolledRead[i]);
+		time[3] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		start = gEnv->pTimer->GetAsyncTime();
+		CStructBitReader tableReader(&table[0], max(tableSize, 0));
+		for (int i=0; i<count; ++i)
+			layout.Read(tableReader, &tableRead[i]);
+		time[4] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		start = gEnv->pTimer->GetAsyncTime();
+		CStructBitReader manualReader(&manual[0], max(manualSize, 0));
+		CBitSerializeImpl<true> readImpl(0, &manualReader);
+		CSimpleSerialize< CBitSerializeImpl<true> > readSerialize(readImpl);
+		TSerialize readSer(&readSerialize);
+		for (int i=0; i<count; ++i)
+			manualRead[i].SerializeWith(readSer);
+		time[5] = (gEnv->pTimer->GetAsyncTime()-start).GetMilliSeconds();
+
+		CryLogAlways("[StructSerializer] %s x %d: unrolled %.3f/%.3fms (%d bytes), table %.3f/%.3fms, SerializeWith %.3f/%.3fms (%d bytes) write/read",
+			name, count, time[0], time[3], unrolledSize, time[1], time[4], time[2], time[5], manualSize);
+
+		// both field list paths write the same bits, and what they read writes those bits again
+		bool ok = unrolledSize > 0 && tableSize == unrolledSize && !memcmp(&unrolled[0], &table[0], unrolledSize);
+		ok = ok && !unrolledReader.Overflow() && !tableReader.Overflow() && unrolledReader.GetBitCount() == tableReader.GetBitCount();
+
+		std::vector<uint8> rewritten(bufferSize);
+		CStructBitWriter unrolledRewriter(&rewritten[0], bufferSize);
+		for (int i=0; i<count; ++i)
+			CStructSerializer::Write(unrolledRewriter, unrolledRead[i]);
+		ok = ok && unrolledRewriter.Finish() == unrolledSize && !memcmp(&rewritten[0], &unrolled[0], unrolledSize);
+
+		CStructBitWriter tableRewriter(&rewritten[0], bufferSize);
+		for (int i=0; i<count; ++i)
+			layout.Write(tableRewriter, &tableRead[i]);
+		ok = ok && tableRewriter.Finish() == unrolledSize && !memcmp(&rewritten[0], &unrolled[0], unrolledSize);
+
+		ok = ok && manualSize > 0 && !manualReader.Overflow() && writeImpl.Ok() && readImpl.Ok();
+		for (int i=0; i<count && ok; ++i)
+			ok = Equals(objects[i], manualRead[i]);
+
+		if (!ok)
+			GameWarning("[StructSerializer] %s: the serializers disagree", name);
+		return ok;
+	}
+}
+
+//------------------------------------------------------------------------
+bool CStructSerializer::Benchmark(int count)
+{
+	bool ok = BenchmarkStruct<CWeapon::SvRequestShootExParams>("SvRequestShootExParams", count);
+	ok &= BenchmarkStruct<CWeapon::RequestMeleeAttackParams>("RequestMeleeAttackParams", count);
+	return ok;
+}
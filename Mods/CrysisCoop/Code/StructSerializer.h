@@ -0,0 +1,404 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __STRUCT_SERIALIZER_H__
+#define __STRUCT_SERIALIZER_H__
+
+#pragma once
+
+#include <ISerialize.h>
+
+// Binary serialization from a field list.
+// A struct lists its fields once, in the shape of a TypeInfo declaration:
+//
+//   struct SHit
+//   {
+//     Vec3 pos;
+//     float damage;
+//     uint8 material;
+//
+//     SERIALIZE_INFO_BEGIN(SHit)
+//       SERIALIZE_VAR_INFO(pos, 'wrld')
+//       SERIALIZE_QUANT_INFO(damage, 0, 0.0f, 1000.0f, 12)   // 12 bits over [0, 1000]
+//       SERIALIZE_QUANT_INFO(material, 'ui8', 0, 63, 6)
+//     SERIALIZE_INFO_END(SHit)
+//   };
+//
+// or, for structs that can't be changed, outside of them with
+// SERIALIZE_INFO_TYPE_BEGIN / SERIALIZE_INFO_TYPE_END.
+//
+// The list expands to a template that visits every field, so for each struct
+// the compiler produces its own serializer: CStructSerializer::Write/Read are
+// straight field by field code with the quantization constants folded in, no
+// table, no virtual call, no type dispatch. The same list gives
+// CStructSerializer::Serialize, the ser.Value() calls of a SerializeWith, with
+// the policy of every field, and a CStructLayout table for code that only
+// knows a struct at run time.
+//
+// Quantized fields are written with the given number of bits over [min, max]:
+// floats and the components of vectors (up to 24 bits), integers as the
+// offset from min. Other fields are written at full width, bools as one bit.
+// Supported types: bool, int8, uint8, int16, uint16, int32, uint32, float, Vec3
+// and Quat. The binary form is little endian and not versioned, for data that
+// is written and read by the same build.
+
+//------------------------------------------------------------------------
+// Bit packing into a caller owned buffer. Running past the end sets the
+// overflow flag, reads past the end return 0.
+class CStructBitWriter
+{
+public:
+	CStructBitWriter(uint8 *pBuffer, int size) : m_pBuffer(pBuffer), m_size(size), m_pos(0), m_acc(0), m_bits(0), m_overflow(false) {}
+
+	// bits 1..32, the bits of value above them are ignored
+	ILINE void Write(uint32 value, int bits)
+	{
+		assert(bits > 0 && bits <= 32);
+		m_acc |= (uint64)(value & (0xffffffffu >> (32-bits))) << m_bits;
+		m_bits += bits;
+		if (m_bits >= 32)
+		{
+			if (m_pos + 4 <= m_size)
+			{
+				m_pBuffer[m_pos+0] = (uint8)m_acc;
+				m_pBuffer[m_pos+1] = (uint8)(m_acc >> 8);
+				m_pBuffer[m_pos+2] = (uint8)(m_acc >> 16);
+				m_pBuffer[m_pos+3] = (uint8)(m_acc >> 24);
+			}
+			else
+				m_overflow = true;
+			m_pos += 4;
+			m_acc >>= 32;
+			m_bits -= 32;
+		}
+	}
+
+	// writes the partial last byte, returns the bytes written or -1 if the buffer was too small
+	int Finish();
+
+	int GetBitCount() const { return m_pos*8 + m_bits; }
+	bool Overflow() const { return m_overflow; }
+
+private:
+	uint8 *m_pBuffer;
+	int m_size;
+	int m_pos;
+	uint64 m_acc;
+	int m_bits;
+	bool m_overflow;
+};
+
+class CStructBitReader
+{
+public:
+	CStructBitReader(const uint8 *pBuffer, int size) : m_pBuffer(pBuffer), m_size(size), m_pos(0), m_acc(0), m_bits(0), m_overflow(false) {}
+
+	ILINE uint32 Read(int bits)
+	{
+		assert(bits > 0 && bits <= 32);
+		if (m_bits < bits)
+		{
+			// m_bits < 32, so 4 more bytes always fit the accumulator
+			if (m_pos + 4 <= m_size)
+			{
+				m_acc |= (uint64)(m_pBuffer[m_pos] | (m_pBuffer[m_pos+1] << 8) | (m_pBuffer[m_pos+2] << 16) | ((uint32)m_pBuffer[m_pos+3] << 24)) << m_bits;
+				m_pos += 4;
+				m_bits += 32;
+			}
+			else
+				RefillTail(bits);
+		}
+		const uint32 value = (uint32)m_acc & (0xffffffffu >> (32-bits));
+		m_acc >>= bits;
+		m_bits -= bits;
+		return value;
+	}
+
+	int GetBitCount() const { return m_pos*8 - m_bits; }
+	bool Overflow() const { return m_overflow; }
+
+private:
+	// the last bytes of the buffer
+	void RefillTail(int bits);
+
+	const uint8 *m_pBuffer;
+	int m_size;
+	int m_pos;
+	uint64 m_acc;
+	int m_bits;
+	bool m_overflow;
+};
+
+//------------------------------------------------------------------------
+// Writes and reads one value, shared by the unrolled serializers and the layout
+// walker so both produce the same bits. nBits 0 means full width.
+struct SStructFieldCodec
+{
+	static ILINE uint32 QuantizeFloat(float value, float fMin, float fMax, int nBits)
+	{
+		const float steps = (float)((1 << nBits) - 1);
+		const float t = (clamp(value, fMin, fMax) - fMin) / (fMax - fMin);
+		return (uint32)(t * steps + 0.5f);
+	}
+	static ILINE float DequantizeFloat(uint32 value, float fMin, float fMax, int nBits)
+	{
+		return fMin + (float)value * ((fMax - fMin) / (float)((1 << nBits) - 1));
+	}
+
+	static ILINE void Write(CStructBitWriter &writer, float value, float fMin, float fMax, int nBits)
+	{
+		if (nBits)
+			writer.Write(QuantizeFloat(value, fMin, fMax, nBits), nBits);
+		else
+		{
+			union { float f; uint32 u; } bits;
+			bits.f = value;
+			writer.Write(bits.u, 32);
+		}
+	}
+	static ILINE void Read(CStructBitReader &reader, float &value, float fMin, float fMax, int nBits)
+	{
+		if (nBits)
+			value = DequantizeFloat(reader.Read(nBits), fMin, fMax, nBits);
+		else
+		{
+			union { float f; uint32 u; } bits;
+			bits.u = reader.Read(32);
+			value = bits.f;
+		}
+	}
+
+	template <class T> static ILINE void WriteInt(CStructBitWriter &writer, T value, float fMin, int nBits)
+	{
+		if (nBits)
+			writer.Write((uint32)((int64)value - (int64)fMin), nBits);
+		else
+			writer.Write((uint32)value, sizeof(T)*8);
+	}
+	template <class T> static ILINE void ReadInt(CStructBitReader &reader, T &value, float fMin, int nBits)
+	{
+		if (nBits)
+			value = (T)((int64)reader.Read(nBits) + (int64)fMin);
+		else
+			value = (T)reader.Read(sizeof(T)*8);
+	}
+
+	static ILINE void Write(CStructBitWriter &writer, bool value, float, float, int) { writer.Write(value ? 1 : 0, 1); }
+	static ILINE void Read(CStructBitReader &reader, bool &value, float, float, int) { value = reader.Read(1) != 0; }
+
+#define STRUCT_FIELD_CODEC_INT(T) \
+	static ILINE void Write(CStructBitWriter &writer, T value, float fMin, float, int nBits) { WriteInt(writer, value, fMin, nBits); } \
+	static ILINE void Read(CStructBitReader &reader, T &value, float fMin, float, int nBits) { ReadInt(reader, value, fMin, nBits); }
+	STRUCT_FIELD_CODEC_INT(int8)
+	STRUCT_FIELD_CODEC_INT(uint8)
+	STRUCT_FIELD_CODEC_INT(int16)
+	STRUCT_FIELD_CODEC_INT(uint16)
+	STRUCT_FIELD_CODEC_INT(int32)
+	STRUCT_FIELD_CODEC_INT(uint32)
+#undef STRUCT_FIELD_CODEC_INT
+
+	static ILINE void Write(CStructBitWriter &writer, const Vec3 &value, float fMin, float fMax, int nBits)
+	{
+		Write(writer, value.x, fMin, fMax, nBits);
+		Write(writer, value.y, fMin, fMax, nBits);
+		Write(writer, value.z, fMin, fMax, nBits);
+	}
+	static ILINE void Read(CStructBitReader &reader, Vec3 &value, float fMin, float fMax, int nBits)
+	{
+		Read(reader, value.x, fMin, fMax, nBits);
+		Read(reader, value.y, fMin, fMax, nBits);
+		Read(reader, value.z, fMin, fMax, nBits);
+	}
+
+	static ILINE void Write(CStructBitWriter &writer, const Quat &value, float fMin, float fMax, int nBits)
+	{
+		Write(writer, value.w, fMin, fMax, nBits);
+		Write(writer, value.v, fMin, fMax, nBits);
+	}
+	static ILINE void Read(CStructBitReader &reader, Quat &value, float fMin, float fMax, int nBits)
+	{
+		Read(reader, value.w, fMin, fMax, nBits);
+		Read(reader, value.v, fMin, fMax, nBits);
+	}
+};
+
+//------------------------------------------------------------------------
+// Field list declaration
+
+// A struct without a field list is visited through its member.
+template <class V, class T>
+ILINE void VisitStructFields(V &visitor, T &object)
+{
+	object.VisitFields(visitor);
+}
+
+#define SERIALIZE_INFO_BEGIN(T)																\
+	template <class V> void VisitFields(V &visitor)							\
+	{																														\
+		T &object = *this;																				\
+
+#define SERIALIZE_INFO_END(T)																	\
+	}																														\
+
+#define SERIALIZE_INFO_TYPE_BEGIN(T)													\
+	template <class V> ILINE void VisitStructFields(V &visitor, T &object)	\
+	{																														\
+
+#define SERIALIZE_INFO_TYPE_END(T)														\
+	}																														\
+
+#define SERIALIZE_VAR_INFO(VarName, Policy)										\
+		visitor.Field(#VarName, object.VarName, Policy, 0.0f, 0.0f, 0);		\
+
+#define SERIALIZE_QUANT_INFO(VarName, Policy, Min, Max, Bits)	\
+		visitor.Field(#VarName, object.VarName, Policy, (float)(Min), (float)(Max), Bits);	\
+
+//------------------------------------------------------------------------
+// Run time description of a field list, walked by field type
+
+enum EStructFieldType
+{
+	eSFT_Bool,
+	eSFT_Int8,
+	eSFT_UInt8,
+	eSFT_Int16,
+	eSFT_UInt16,
+	eSFT_Int32,
+	eSFT_UInt32,
+	eSFT_Float,
+	eSFT_Vec3,
+	eSFT_Quat,
+};
+
+struct SStructFieldInfo
+{
+	const char *name;
+	int offset;
+	EStructFieldType type;
+	uint32 policy;
+	float fMin;
+	float fMax;
+	int nBits;
+};
+
+class CStructLayout
+{
+public:
+	CStructLayout(const char *name, int size) : m_name(name), m_size(size) {}
+
+	const char* GetName() const { return m_name; }
+	int GetSize() const { return m_size; }
+	int GetFieldCount() const { return (int)m_fields.size(); }
+	const SStructFieldInfo& GetField(int i) const { return m_fields[i]; }
+
+	void AddField(const SStructFieldInfo &field) { m_fields.push_back(field); }
+
+	// write and read the object like CStructSerializer::Write/Read, field by field from the table
+	void Write(CStructBitWriter &writer, const void *pObject) const;
+	void Read(CStructBitReader &reader, void *pObject) const;
+
+private:
+	const char *m_name;
+	int m_size;
+	std::vector<SStructFieldInfo> m_fields;
+};
+
+//------------------------------------------------------------------------
+class CStructSerializer
+{
+public:
+	template <class T> static ILINE void Write(CStructBitWriter &writer, const T &object)
+	{
+		SWriteVisitor visitor(writer);
+		VisitStructFields(visitor, const_cast<T&>(object));
+	}
+
+	template <class T> static ILINE void Read(CStructBitReader &reader, T &object)
+	{
+		SReadVisitor visitor(reader);
+		VisitStructFields(visitor, object);
+	}
+
+	// the ser.Value() calls of the field list, with the policy of every field
+	template <class T> static ILINE void Serialize(TSerialize ser, T &object)
+	{
+		SSerializeVisitor visitor(ser);
+		VisitStructFields(visitor, object);
+	}
+
+	// built on first use, from the main thread
+	template <class T> static const CStructLayout& GetLayout(const char *name)
+	{
+		static CStructLayout layout(name, sizeof(T));
+		if (!layout.GetFieldCount())
+		{
+			T object;
+			SLayoutVisitor visitor(layout, &object);
+			VisitStructFields(visitor, object);
+		}
+		return layout;
+	}
+
+	// times the unrolled serializers against the layout walker and the hand written
+	// SerializeWith of weapon RMI parameters, returns false (and logs why) if they disagree
+	static bool Benchmark(int count);
+
+private:
+	struct SWriteVisitor
+	{
+		SWriteVisitor(CStructBitWriter &_writer) : writer(_writer) {}
+		template <class F> ILINE void Field(const char *, const F &value, uint32, float fMin, float fMax, int nBits)
+		{
+			SStructFieldCodec::Write(writer, value, fMin, fMax, nBits);
+		}
+		CStructBitWriter &writer;
+	};
+
+	struct SReadVisitor
+	{
+		SReadVisitor(CStructBitReader &_reader) : reader(_reader) {}
+		template <class F> ILINE void Field(const char *, F &value, uint32, float fMin, float fMax, int nBits)
+		{
+			SStructFieldCodec::Read(reader, value, fMin, fMax, nBits);
+		}
+		CStructBitReader &reader;
+	};
+
+	struct SSerializeVisitor
+	{
+		SSerializeVisitor(TSerialize _ser) : ser(_ser) {}
+		template <class F> ILINE void Field(const char *name, F &value, uint32 policy, float, float, int)
+		{
+			ser.Value(name, value, policy);
+		}
+		TSerialize ser;
+	};
+
+	struct SLayoutVisitor
+	{
+		SLayoutVisitor(CStructLayout &_layout, const void *_pObject) : layout(_layout), pObject(_pObject) {}
+
+		void Add(const char *name, const void *pValue, EStructFieldType type, uint32 policy, float fMin, float fMax, int nBits)
+		{
+			SStructFieldInfo field = { name, (int)((const char*)pValue - (const char*)pObject), type, policy, fMin, fMax, nBits };
+			layout.AddField(field);
+		}
+
+		void Field(const char *name, bool &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Bool, policy, fMin, fMax, nBits); }
+		void Field(const char *name, int8 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Int8, policy, fMin, fMax, nBits); }
+		void Field(const char *name, uint8 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_UInt8, policy, fMin, fMax, nBits); }
+		void Field(const char *name, int16 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Int16, policy, fMin, fMax, nBits); }
+		void Field(const char *name, uint16 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_UInt16, policy, fMin, fMax, nBits); }
+		void Field(const char *name, int32 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Int32, policy, fMin, fMax, nBits); }
+		void Field(const char *name, uint32 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_UInt32, policy, fMin, fMax, nBits); }
+		void Field(const char *name, float &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Float, policy, fMin, fMax, nBits); }
+		void Field(const char *name, Vec3 &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Vec3, policy, fMin, fMax, nBits); }
+		void Field(const char *name, Quat &value, uint32 policy, float fMin, float fMax, int nBits) { Add(name, &value, eSFT_Quat, policy, fMin, fMax, nBits); }
+
+		CStructLayout &layout;
+		const void *pObject;
+	};
+};
+
+#endif //__STRUCT_SERIALIZER_H__
@@ -463,7 +463,7 @@ void CThrow::ThrowObject(IEntity* pEntity, IPhysicalEntity* pPE)
 
 	Vec3 hit = GetProbableHit(WEAPON_HIT_RANGE);
 	Vec3 pos = GetFiringPos(hit);
-	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread());
+	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread(), m_pWeapon->GetNextShootSeqN());
 	Vec3 vel = GetFiringVelocity(dir);
 
 	float speed = 12.0f;
@@ -511,7 +511,7 @@ void CThrow::ThrowLivingEntity(IEntity* pEntity, IPhysicalEntity* pPE)
 {
 	Vec3 hit = GetProbableHit(WEAPON_HIT_RANGE);
 	Vec3 pos = GetFiringPos(hit);
-	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread());
+	Vec3 dir = ApplySpread(GetFiringDir(hit, pos), GetSpread(), m_pWeapon->GetNextShootSeqN());
 	Vec3 vel = GetFiringVelocity(dir);
 
 	CPlayer *pPlayer = static_cast<CPlayer*>(m_pWeapon->GetOwnerActor());
@@ -65,7 +65,10 @@ CVehicleMovementBase::CVehicleMovementBase()
   m_soundMasterVolume(1.f),
   m_dampAngle(ZERO),
   m_dampAngVel(ZERO),
-	m_pPaParams(NULL)
+	m_pPaParams(NULL),
+  m_effectLOD(eVEL_Full),
+  m_effectLODTimer(0.f),
+  m_effectUpdateTime(0.f)
 { 
   m_pWind[0] = m_pWind[1] = NULL;
 }
@@ -309,6 +312,11 @@ void CVehicleMovementBase::Reset()
   }
 
   //InitWind();
+
+  m_effectIdCache.clear();
+  m_effectCollection.clear();
+  m_effectLOD = eVEL_Full;
+  m_effectLODTimer = 0.f;
     
 	m_movementAction.Clear();
   m_movementAction.brake = true;  
@@ -409,11 +417,12 @@ void CVehicleMovementBase::Update(const float deltaTime)
 				Boost(m_boost);
 		}
 		m_wasBoosting = m_boost;
+  }
 
-    UpdateExhaust(deltaTime);
-    UpdateSurfaceEffects(deltaTime);
-    UpdateWind(deltaTime);
-  }  
+  float effectDeltaTime = 0.f;
+  bool updateEffects = UpdateEffectLOD(deltaTime, effectDeltaTime);
+  if (updateEffects)
+    UpdateEffects(effectDeltaTime);
     
   DebugDraw(deltaTime);
       
@@ -493,7 +502,8 @@ void CVehicleMovementBase::Update(const float deltaTime)
 			if (!GetSound(eSID_Run))
 				PlaySound(eSID_Run, 0.f, m_enginePos);
 
-			UpdateRunSound(deltaTime);
+			if (updateEffects)
+				UpdateRunSound(effectDeltaTime);
 
 			if(m_pVehicle->IsPlayerPassenger())
 				if (gEnv->pInput) gEnv->pInput->ForceFeedbackEvent( SFFOutputEvent(eDI_XI, eFF_Rumble_Basic, 0.15f, 0.01f, clamp_tpl(m_rpmScale, 0.0f, 0.5f)));
@@ -511,6 +521,86 @@ void CVehicleMovementBase::Update(const float deltaTime)
   SetSoundParam(eSID_Ambience, "thirdperson", 1.f-firstperson);
     
   UpdateGameTokens(deltaTime);
+
+  if (g_pGameCVars->v_debugEffectsLOD)
+    DrawEffectLODDebug();
+}
+
+//------------------------------------------------------------------------
+bool CVehicleMovementBase::UpdateEffectLOD(const float deltaTime, float& effectDeltaTime)
+{
+  static const float intervals[eVEL_Last] = { 0.f, 0.1f, 0.25f, 0.5f, 0.f };
+
+  if (!gEnv->bClient || gEnv->pSystem->IsDedicated())
+  {
+    m_effectLOD = eVEL_Headless;
+    return false;
+  }
+
+  EVehicleEffectLOD lastLOD = m_effectLOD;
+
+  // only one local viewer per client, passengers always get full effects
+  if (m_pVehicle->IsPlayerPassenger() || g_pGameCVars->v_effectsLODNear <= 0.f)
+    m_effectLOD = eVEL_Full;
+  else
+  {
+    float distSq = m_pEntity->GetWorldPos().GetSquaredDistance(GetISystem()->GetViewCamera().GetPosition());
+
+    // within the near radius visibility doesn't matter, a vehicle right behind the viewer keeps full effects
+    if (distSq <= sqr(g_pGameCVars->v_effectsLODNear))
+      m_effectLOD = eVEL_Full;
+    else if (distSq > sqr(g_pGameCVars->v_effectsLODCull))
+      m_effectLOD = eVEL_Culled;
+    else if (distSq > sqr(g_pGameCVars->v_effectsLODFar) || !m_pVehicle->GetGameObject()->IsProbablyVisible())
+      m_effectLOD = eVEL_Far;
+    else
+      m_effectLOD = eVEL_Near;
+  }
+
+  // wind is not updated beyond near, so don't leave the last wind blowing at a stale position
+  if (m_pWind[0] && m_effectLOD > eVEL_Near && lastLOD <= eVEL_Near)
+    SetWind(Vec3(ZERO));
+
+  if (m_effectLOD == eVEL_Culled && lastLOD != eVEL_Culled)
+    RemoveSurfaceEffects();
+
+  m_effectLODTimer += deltaTime;
+  if (m_effectLODTimer < intervals[m_effectLOD])
+    return false;
+
+  effectDeltaTime = m_effectLODTimer;
+  m_effectLODTimer = 0.f;
+
+  return true;
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::UpdateEffects(const float effectDeltaTime)
+{
+  CTimeValue startTime = gEnv->pTimer->GetAsyncTime();
+
+  UpdateExhaust(effectDeltaTime);
+
+  if (m_effectLOD <= eVEL_Far)
+    UpdateSurfaceEffects(effectDeltaTime);
+
+  if (m_effectLOD <= eVEL_Near)
+    UpdateWind(effectDeltaTime);
+
+  float time = (gEnv->pTimer->GetAsyncTime() - startTime).GetMilliSeconds();
+  Interpolate(m_effectUpdateTime, time, 2.f, effectDeltaTime);
+}
+
+//------------------------------------------------------------------------
+void CVehicleMovementBase::DrawEffectLODDebug()
+{
+  static const char* tiers[eVEL_Last] = { "full", "near", "far", "culled", "headless" };
+
+  if (gEnv->pRenderer)
+  {
+    Vec3 pos = m_pEntity->GetWorldPos() + Vec3(0.f, 0.f, 2.f);
+    gEnv->pRenderer->DrawLabel(pos, 1.3f, "effects: %s, %.3f ms", tiers[m_effectLOD], m_effectUpdateTime);
+  }
 }
 
 //------------------------------------------------------------------------
@@ -1535,10 +1625,22 @@ SMFXResourceListPtr CVehicleMovementBase::GetEffectNode(int matId)
 
   IMaterialEffects *mfx = g_pGame->GetIGameFramework()->GetIMaterialEffects();
 
-  // maybe cache this
-	CryFixedStringT<256> effCol = "vfx_";
-	effCol += m_pEntity->GetClass()->GetName();
-  TMFXEffectId effectId = mfx->GetEffectId(effCol.MakeLower().c_str(), matId);
+  if (m_effectCollection.empty())
+  {
+    m_effectCollection = "vfx_";
+    m_effectCollection += m_pEntity->GetClass()->GetName();
+    m_effectCollection.MakeLower();
+  }
+
+  TMFXEffectId effectId;
+  TEffectIdCache::const_iterator it = m_effectIdCache.find(matId);
+  if (it != m_effectIdCache.end())
+    effectId = it->second;
+  else
+  {
+    effectId = mfx->GetEffectId(m_effectCollection.c_str(), matId);
+    m_effectIdCache.insert(TEffectIdCache::value_type(matId, effectId));
+  }
   
   if (effectId != InvalidEffectId)
   { 
@@ -1547,7 +1649,7 @@ SMFXResourceListPtr CVehicleMovementBase::GetEffectNode(int matId)
   else
   {
     if (DebugParticles())
-      CryLog("GetEffectString for %s -> %i failed", effCol.c_str(), matId);
+      CryLog("GetEffectString for %s -> %i failed", m_effectCollection.c_str(), matId);
   }
 
   return 0;
@@ -211,6 +211,17 @@ enum EVehicleMovementAnimation
   eVMA_Max,
 };
 
+// update tier for the per-frame surface/exhaust/wind/run sound effects
+enum EVehicleEffectLOD
+{
+  eVEL_Full = 0,  // every frame
+  eVEL_Near,      // throttled, all effects
+  eVEL_Far,       // throttled, wind areas zeroed
+  eVEL_Culled,    // rarely, exhaust and run sound state only, surface emitters off
+  eVEL_Headless,  // no client (dedicated server), nothing
+  eVEL_Last
+};
+
 struct SMovementSoundStatus
 {
   SMovementSoundStatus(){ Reset(); }
@@ -372,6 +383,11 @@ protected:
   Vec3 GetWindPos(Vec3& posRad, Vec3& posLin);
   // ~surface particle/sound methods
 
+  // effect LOD
+  bool UpdateEffectLOD(const float deltaTime, float& effectDeltaTime);
+  void UpdateEffects(const float effectDeltaTime);
+  void DrawEffectLODDebug();
+
 	IVehicle* m_pVehicle;
 	IEntity* m_pEntity;
 	IEntitySoundProxy* m_pEntitySoundsProxy;	
@@ -449,6 +465,15 @@ protected:
   typedef std::map<string, SSurfaceSoundInfo> TSurfaceSoundInfo;
   static TSurfaceSoundInfo m_surfaceSoundInfo;
 
+  // material id -> effect id, resolved once per vehicle
+  typedef std::map<int, TMFXEffectId> TEffectIdCache;
+  TEffectIdCache m_effectIdCache;
+  string m_effectCollection;
+
+  EVehicleEffectLOD m_effectLOD;
+  float m_effectLODTimer;   // time accumulated since the last effect update
+  float m_effectUpdateTime; // smoothed cost of an effect update, ms
+
 	CVehicleMovementTweaks m_movementTweaks;
 	CVehicleMovementTweaks::TTweakGroupId m_aiTweaksId;
 	CVehicleMovementTweaks::TTweakGroupId m_playerTweaksId;
@@ -42,6 +42,7 @@ History:
 
 #include "IPlayerInput.h"
 #include <IWorldQuery.h>
+#include <CryName.h>
 
 //------------------------------------------------------------------------
 CWeapon::CWeapon()
@@ -74,7 +75,9 @@ CWeapon::CWeapon()
 	m_raiseProbability(0.0f),
 	m_requestedFire(false),
 	m_nextShotTime(0.0f),
-	m_shootSeqN(1)
+	m_shootSeqN(1),
+	m_netShootSeqN(0),
+	m_shotRandomKey(0)
 {
 	RegisterActions();
 }
@@ -515,6 +518,8 @@ bool CWeapon::Init( IGameObject * pGameObject )
 
 	g_pGame->GetWeaponScriptBind()->AttachTo(this);
 
+	m_shotRandomKey = CryNameHash(GetEntity()->GetClass()->GetName());
+
 	return true;
 }
 
@@ -2124,6 +2129,19 @@ bool CWeapon::IsServerSpawn(IEntityClass* pAmmoType) const
 	return g_pGame->GetWeaponSystem()->IsServerSpawn(pAmmoType);
 }
 
+//------------------------------------------------------------------------
+// Summary:
+//	The stream of one shot. The key is the hashed class name and not the entity id,
+//	entity ids differ between machines, the sequence number comes with the shot.
+//	Nothing else about a weapon is known to every machine (channel ids are server
+//	side only, owner names change), so weapons of a class that are at the same
+//	sequence number, e.g. AI that started firing together, spread the same way.
+//	Their owners aim differently and spread is small against that, so this is accepted.
+CShotRandom CWeapon::GetShotRandom(uint16 seq, CShotRandom::EStream stream) const
+{
+	return CShotRandom(m_shotRandomKey, seq|(stream<<16));
+}
+
 //------------------------------------------------------------------------
 CProjectile *CWeapon::SpawnAmmo(IEntityClass* pAmmoType, bool remote)
 {
@@ -25,6 +25,7 @@ History:
 #include <VectorMap.h>
 #include <IMusicSystem.h>
 #include "Item.h"
+#include "ShotRandom.h"
 
 
 #define WEAPON_FADECROSSHAIR_SELECT	(0.250f)
@@ -359,13 +360,15 @@ public:
 	struct ClShootParams
 	{
 		ClShootParams() {};
-		ClShootParams(const Vec3 &at, int ph): hit(at), predictionHandle(ph) {};
+		ClShootParams(const Vec3 &at, int ph, uint16 seqn): hit(at), predictionHandle(ph), seq(seqn) {};
 
 		Vec3 hit;
 		int predictionHandle;
+		uint16 seq;
 		void SerializeWith(TSerialize ser)
 		{
 			ser.Value("hit", hit, 'sHit');
+			ser.Value("seq", seq, 'ui16');
 			ser.Value("predictionHandle", predictionHandle, 'phdl');
 		};
 	};
@@ -373,21 +376,44 @@ public:
 	struct ClShootXParams
 	{
 		ClShootXParams() {};
-		ClShootXParams(EntityId eid_, bool hit0_, const Vec3& hit_, int ph) : eid(eid_), hit0(hit0_), hit(hit_), predictionHandle(ph) {};
+		ClShootXParams(EntityId eid_, bool hit0_, const Vec3& hit_, int ph, uint16 seqn) : eid(eid_), hit0(hit0_), hit(hit_), predictionHandle(ph), seq(seqn) {};
 
 		EntityId eid;
 		bool hit0;
 		Vec3 hit;
 		int predictionHandle;
+		uint16 seq;
 		void SerializeWith(TSerialize ser)
 		{
 			ser.Value("ref_eid", eid, 'eid');
 			ser.Value("use_hit", hit0, 'bool');
 			ser.Value("ref_hit", hit, hit0 ? 'hit0' : 'hit1');
+			ser.Value("seq", seq, 'ui16');
 			ser.Value("predictionHandle", predictionHandle, 'phdl');
 		}
 	};
 
+	// one batched shotgun shot, pellet directions follow from the seed (first pellet seq)
+	struct ShootPelletsParams
+	{
+		ShootPelletsParams() {};
+		ShootPelletsParams(const Vec3 &_pos, const Vec3 &_dir, uint16 seqn, uint8 seqnr)
+		: pos(_pos), dir(_dir), seq(seqn), seqr(seqnr) {};
+
+		Vec3 pos;
+		Vec3 dir;
+		uint16 seq;
+		uint8 seqr;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("pos", pos, 'wrld');
+			ser.Value("dir", dir, 'dir3');
+			ser.Value("seq", seq, 'ui16');
+			ser.Value("seqr", seqr, 'ui5');
+		};
+	};
+
 	struct SvRequestShootExParams
 	{
 		SvRequestShootExParams() {};
@@ -532,6 +558,8 @@ public:
 	DECLARE_SERVER_RMI_NOATTACH_FAST(SvRequestShootEx, SvRequestShootExParams, eNRT_ReliableUnordered);
 	DECLARE_CLIENT_RMI_NOATTACH_FAST(ClShoot, ClShootParams, eNRT_UnreliableOrdered);
 	DECLARE_CLIENT_RMI_NOATTACH_FAST(ClShootX, ClShootXParams, eNRT_UnreliableOrdered);
+	DECLARE_SERVER_RMI_NOATTACH_FAST(SvRequestShootPellets, ShootPelletsParams, eNRT_ReliableUnordered);
+	DECLARE_CLIENT_RMI_NOATTACH_FAST(ClShootPellets, ShootPelletsParams, eNRT_UnreliableOrdered);
 
 	DECLARE_SERVER_RMI_NOATTACH_FAST(SvRequestStartFire, EmptyParams, eNRT_ReliableUnordered);
 	DECLARE_SERVER_RMI_NOATTACH_FAST(SvRequestStopFire, EmptyParams, eNRT_ReliableUnordered);
@@ -569,7 +597,11 @@ public:
 	virtual void NetSetCurrentAmmoCount(int count);
 
 	virtual void NetShoot(const Vec3 &hit, int predictionHandle);
+	// a remote shot, seq keys the random numbers of the shot (GetNetShootSeqN while it runs)
+	void NetShoot(const Vec3 &hit, int predictionHandle, uint16 seq);
 	virtual void NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int predictionHandle);
+	void NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int predictionHandle, uint16 seq);
+	void NetShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq);
 	
 	virtual void NetStartFire();
 	virtual void NetStopFire();
@@ -586,9 +618,17 @@ public:
 		return m_shootSeqN;
 	};
 	uint16 ILINE GetShootSeqN() const { return m_shootSeqN; };
+	// the number GenerateShootSeqN returns next
+	uint16 ILINE GetNextShootSeqN() const { return (uint16)(m_shootSeqN+1) ? (uint16)(m_shootSeqN+1) : 1; };
+	// the sequence number of the remote shot being fired, 0 outside of NetShoot and NetShootEx
+	uint16 ILINE GetNetShootSeqN() const { return m_netShootSeqN; };
+
+	// the random numbers of shot seq, the same on every machine
+	CShotRandom GetShotRandom(uint16 seq, CShotRandom::EStream stream) const;
 
 	void SendEndReload();
 	void RequestShoot(IEntityClass* pAmmoType, const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int predictionHandle, uint16 seq, uint8 seqr, bool forceExtended);
+	void RequestShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq, uint8 seqr);
 	void RequestStartFire();
 	void RequestStopFire();
 	void RequestReload();
@@ -707,6 +747,9 @@ protected:
 
 	uint8					m_raisePose;
 	uint16					m_shootSeqN;
+	uint16					m_netShootSeqN;
+	// CryNameHash of the class name, the key of GetShotRandom
+	uint32					m_shotRandomKey;
 
 private:
 
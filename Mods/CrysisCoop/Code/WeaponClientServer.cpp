@@ -15,6 +15,7 @@
 #include "Actor.h"
 #include "Game.h"
 #include "GameRules.h"
+#include "Shotgun.h"
 
 /*
 #define CHECK_OWNER_REQUEST()	\
@@ -67,6 +68,14 @@ void CWeapon::NetShoot(const Vec3 &hit, int predictionHandle)
 		m_fm->NetShoot(hit, predictionHandle);
 }
 
+//------------------------------------------------------------------------
+void CWeapon::NetShoot(const Vec3 &hit, int predictionHandle, uint16 seq)
+{
+	m_netShootSeqN = seq;
+	NetShoot(hit, predictionHandle);
+	m_netShootSeqN = 0;
+}
+
 //------------------------------------------------------------------------
 void CWeapon::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int predictionHandle)
 {
@@ -74,6 +83,22 @@ void CWeapon::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, cons
 		m_fm->NetShootEx(pos, dir, vel, hit, extra, predictionHandle);
 }
 
+//------------------------------------------------------------------------
+void CWeapon::NetShootEx(const Vec3 &pos, const Vec3 &dir, const Vec3 &vel, const Vec3 &hit, float extra, int predictionHandle, uint16 seq)
+{
+	m_netShootSeqN = seq;
+	NetShootEx(pos, dir, vel, hit, extra, predictionHandle);
+	m_netShootSeqN = 0;
+}
+
+//------------------------------------------------------------------------
+// only CShotgun batches its pellets, it is the fire mode registered as "Shotgun"
+void CWeapon::NetShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq)
+{
+	if (m_fm && !strcmp(m_fm->GetType(), "Shotgun"))
+		static_cast<CShotgun *>(m_fm)->NetShootPellets(pos, dir, seq);
+}
+
 //------------------------------------------------------------------------
 void CWeapon::NetStartFire()
 {
@@ -150,17 +175,37 @@ void CWeapon::RequestShoot(IEntityClass* pAmmoType, const Vec3 &pos, const Vec3
 	{
 		if (IsServerSpawn(pAmmoType) || forceExtended)
 		{
-			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(pos+dir*5.0f, predictionHandle), eRMI_ToAllClients);
-			NetShootEx(pos, dir, vel, hit, extra, predictionHandle);
+			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(pos+dir*5.0f, predictionHandle, seq), eRMI_ToAllClients);
+			NetShootEx(pos, dir, vel, hit, extra, predictionHandle, seq);
 		}
 		else
 		{
-			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(hit, predictionHandle), eRMI_ToAllClients);
-			NetShoot(hit, predictionHandle);
+			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(hit, predictionHandle, seq), eRMI_ToAllClients);
+			NetShoot(hit, predictionHandle, seq);
 		}
 	}
 }
 
+//------------------------------------------------------------------------
+void CWeapon::RequestShootPellets(const Vec3 &pos, const Vec3 &dir, uint16 seq, uint8 seqr)
+{
+	IActor *pActor=m_pGameFramework->GetClientActor();
+
+	if ((!pActor || pActor->IsClient()) && IsClient())
+	{
+		if (pActor)
+			pActor->GetGameObject()->Pulse('bang');
+		GetGameObject()->Pulse('bang');
+
+		GetGameObject()->InvokeRMI(CWeapon::SvRequestShootPellets(), ShootPelletsParams(pos, dir, seq, seqr), eRMI_ToServer);
+	}
+	else if (!IsClient() && IsServer())
+	{
+		// the pellets were already traced here by the shooting fire mode
+		GetGameObject()->InvokeRMI(CWeapon::ClShootPellets(), ShootPelletsParams(pos, dir, seq, seqr), eRMI_ToAllClients);
+	}
+}
+
 //------------------------------------------------------------------------
 void CWeapon::RequestMeleeAttack(bool weaponMelee, const Vec3 &pos, const Vec3 &dir, uint16 seq)
 {
@@ -397,23 +442,23 @@ IMPLEMENT_RMI(CWeapon, SvRequestShoot)
 					AABB bbox; pEntity->GetWorldBounds(bbox);
 					bool hit0 = bbox.GetRadius() < 1.0f; // this (radius*2) must match the value in CompressionPolicy.xml ("hit0")
 					Vec3 hitLocal = pEntity->GetWorldTM().GetInvertedFast() * rh.pt;
-					//GetGameObject()->InvokeRMI(CWeapon::ClShootX(), ClShootXParams(pEntity->GetId(), hit0, hitLocal, params.predictionHandle),
+					//GetGameObject()->InvokeRMI(CWeapon::ClShootX(), ClShootXParams(pEntity->GetId(), hit0, hitLocal, params.predictionHandle, params.seq),
 					//	eRMI_ToOtherClients|eRMI_NoLocalCalls, m_pGameFramework->GetGameChannelId(pNetChannel));
-					GetGameObject()->InvokeRMIWithDependentObject(CWeapon::ClShootX(), ClShootXParams(pEntity->GetId(), hit0, hitLocal, params.predictionHandle),
+					GetGameObject()->InvokeRMIWithDependentObject(CWeapon::ClShootX(), ClShootXParams(pEntity->GetId(), hit0, hitLocal, params.predictionHandle, params.seq),
 						eRMI_ToOtherClients|eRMI_NoLocalCalls, pEntity->GetId(), m_pGameFramework->GetGameChannelId(pNetChannel));
 
 				}
 			}
 		}
 		else
-			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(params.hit, params.predictionHandle), 
+			GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(params.hit, params.predictionHandle, params.seq), 
 				eRMI_ToOtherClients|eRMI_NoLocalCalls, m_pGameFramework->GetGameChannelId(pNetChannel));
 
 		IActor *pLocalActor=m_pGameFramework->GetClientActor();
 		bool isLocal = pLocalActor && (pLocalActor->GetChannelId() == pActor->GetChannelId());
 
 		if (!isLocal)
-			NetShoot(params.hit, params.predictionHandle);
+			NetShoot(params.hit, params.predictionHandle, params.seq);
 
 		if (pActor && !isLocal && params.seq)
 		{
@@ -446,14 +491,52 @@ IMPLEMENT_RMI(CWeapon, SvRequestShootEx)
 			pActor->GetGameObject()->Pulse('bang');
 		GetGameObject()->Pulse('bang');
 
-		GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(params.pos+params.dir*5.0f, params.predictionHandle),
+		GetGameObject()->InvokeRMI(CWeapon::ClShoot(), ClShootParams(params.pos+params.dir*5.0f, params.predictionHandle, params.seq),
 			eRMI_ToOtherClients|eRMI_NoLocalCalls, m_pGameFramework->GetGameChannelId(pNetChannel));
 
 		IActor *pLocalActor=m_pGameFramework->GetClientActor();
 		bool isLocal = pLocalActor && (pLocalActor->GetChannelId() == pActor->GetChannelId());
 
 		if (!isLocal)
-			NetShootEx(params.pos, params.dir, params.vel, params.hit, params.extra, params.predictionHandle);
+			NetShootEx(params.pos, params.dir, params.vel, params.hit, params.extra, params.predictionHandle, params.seq);
+
+		if (pActor && !isLocal && params.seq)
+		{
+			if (CGameRules *pGameRules=g_pGame->GetGameRules())
+				pGameRules->ValidateShot(pActor->GetEntityId(), GetEntityId(), params.seq, params.seqr);
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+IMPLEMENT_RMI(CWeapon, SvRequestShootPellets)
+{
+	// Crysis Co-op :: Fixes the weapon sync for Co-op AI
+	//CHECK_OWNER_REQUEST();
+
+	bool ok=true;
+	CActor *pActor=GetActorByNetChannel(pNetChannel);
+
+	// ~Crysis Co-op
+
+	ok &= !OutOfAmmo(false);
+
+	if (ok)
+	{
+		if (pActor)
+			pActor->GetGameObject()->Pulse('bang');
+		GetGameObject()->Pulse('bang');
+
+		GetGameObject()->InvokeRMI(CWeapon::ClShootPellets(), params,
+			eRMI_ToOtherClients|eRMI_NoLocalCalls, m_pGameFramework->GetGameChannelId(pNetChannel));
+
+		IActor *pLocalActor=m_pGameFramework->GetClientActor();
+		bool isLocal = pLocalActor && pActor && (pLocalActor->GetChannelId() == pActor->GetChannelId());
+
+		if (!isLocal)
+			NetShootPellets(params.pos, params.dir, params.seq);
 
 		if (pActor && !isLocal && params.seq)
 		{
@@ -465,10 +548,18 @@ IMPLEMENT_RMI(CWeapon, SvRequestShootEx)
 	return true;
 }
 
+//------------------------------------------------------------------------
+IMPLEMENT_RMI(CWeapon, ClShootPellets)
+{
+	NetShootPellets(params.pos, params.dir, params.seq);
+
+	return true;
+}
+
 //------------------------------------------------------------------------
 IMPLEMENT_RMI(CWeapon, ClShoot)
 {
-	NetShoot(params.hit, params.predictionHandle);
+	NetShoot(params.hit, params.predictionHandle, params.seq);
 
 	return true;
 }
@@ -479,7 +570,7 @@ IMPLEMENT_RMI(CWeapon, ClShootX)
 	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(params.eid))
 	{
 		Vec3 hit = pEntity->GetWorldTM() * params.hit;
-		NetShoot(hit, params.predictionHandle);
+		NetShoot(hit, params.predictionHandle, params.seq);
 	}
 	else
 	{
@@ -205,6 +205,8 @@ void CWeaponSystem::OnLoadingStart(ILevelInfo *pLevel)
 
 	// force shared item params to be refreshed
 	g_pGame->GetItemSharedParamsList()->Reset();
+
+	m_aimAssistCandidates.Reset();
 }
 
 //------------------------------------------------------------------------
@@ -722,6 +724,7 @@ void CWeaponSystem::GetMemoryStatistics(ICrySizer * s)
 	s->AddObject(this,nSize);
 
 	m_tracerManager.GetMemoryStatistics(s);
+	m_aimAssistCandidates.GetMemoryStatistics(s);
 	s->AddContainer(m_fmregistry);
 	s->AddContainer(m_zmregistry);
 	s->AddContainer(m_projectileregistry);
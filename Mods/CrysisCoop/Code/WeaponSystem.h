@@ -25,6 +25,7 @@ History:
 #include <IGameTokens.h>
 #include "Item.h"
 #include "TracerManager.h"
+#include "AimAssistCandidates.h"
 #include "VectorMap.h"
 #include "AmmoParams.h"
 
@@ -102,6 +103,7 @@ public:
 	int	QueryProjectiles(SProjectileQuery& q);
 
 	CTracerManager &GetTracerManager() { return m_tracerManager; };
+	CAimAssistCandidates &GetAimAssistCandidates() { return m_aimAssistCandidates; };
 
 	void Scan(const char *folderName);
 	bool ScanXML(XmlNodeRef &root, const char *xmlFile);
@@ -126,6 +128,7 @@ private:
 	IItemSystem					*m_pItemSystem;
 
 	CTracerManager			m_tracerManager;
+	CAimAssistCandidates	m_aimAssistCandidates;
 
 	TFireModeRegistry		m_fmregistry;
 	TZoomModeRegistry		m_zmregistry;
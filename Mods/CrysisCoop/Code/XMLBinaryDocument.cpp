@@ -0,0 +1,745 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#include "StdAfx.h"
+#include "XMLBinaryDocument.h"
+#include <ICryPak.h>
+
+#if defined(WIN32) && !defined(XENON)
+#include <windows.h>
+#elif defined(LINUX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// File layout, all numbers little endian:
+//   BinaryFileHeader
+//   Node[nNodeCount]            in document order, a parent before its children, the root first
+//   Attribute[nAttributeCount]  the attributes of a node are consecutive
+//   String[nStringCount]
+//   string data                 every string is followed by a 0
+namespace
+{
+	// BinaryFileHeader::sk_szCorrectSignature of the engine, which is not exported to the game
+	const char BINARY_SIGNATURE[8] = "CryXmlB";
+
+	bool TableFits(int position, int count, size_t elementSize, size_t fileSize)
+	{
+		if (position < 0 || count < 0 || (position & 3))
+			return false;
+		return (uint64)position + (uint64)count * elementSize <= (uint64)fileSize;
+	}
+
+	ILINE bool KeyEquals(const char *a, const char *b)
+	{
+#if defined(CNAMETABLE_CASE_SENSITIVE)
+		return strcmp(a, b) == 0;
+#else
+		return stricmp(a, b) == 0;
+#endif
+	}
+}
+
+//------------------------------------------------------------------------
+const char* CXMLBinaryNode::getTag() const
+{
+	if (!m_pDocument)
+		return "";
+	return m_pDocument->GetString(m_pDocument->m_pNodes[m_index].nTagStringIndex);
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::isTag(const char *tag) const
+{
+	return m_pDocument && stricmp(getTag(), tag) == 0;
+}
+
+//------------------------------------------------------------------------
+const char* CXMLBinaryNode::getContent() const
+{
+	if (!m_pDocument)
+		return "";
+	return m_pDocument->GetString(m_pDocument->m_pNodes[m_index].nContentStringIndex);
+}
+
+//------------------------------------------------------------------------
+int CXMLBinaryNode::getChildCount() const
+{
+	if (!m_pDocument)
+		return 0;
+	return m_pDocument->m_childStart[m_index+1] - m_pDocument->m_childStart[m_index];
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryNode CXMLBinaryNode::getChild(int i) const
+{
+	if (i < 0 || i >= getChildCount())
+		return CXMLBinaryNode();
+	return CXMLBinaryNode(m_pDocument, m_pDocument->m_children[m_pDocument->m_childStart[m_index] + i]);
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryNode CXMLBinaryNode::findChild(const char *tag) const
+{
+	const int count = getChildCount();
+	for (int i=0; i<count; ++i)
+	{
+		CXMLBinaryNode child = getChild(i);
+		if (child.isTag(tag))
+			return child;
+	}
+	return CXMLBinaryNode();
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryNode CXMLBinaryNode::getParent() const
+{
+	if (!m_pDocument || m_index == 0)
+		return CXMLBinaryNode();
+	return CXMLBinaryNode(m_pDocument, m_pDocument->m_pNodes[m_index].nParentIndex);
+}
+
+//------------------------------------------------------------------------
+int CXMLBinaryNode::getNumAttributes() const
+{
+	if (!m_pDocument)
+		return 0;
+	return m_pDocument->m_pNodes[m_index].nAttributeCount;
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::getAttributeByIndex(int index, const char **key, const char **value) const
+{
+	if (index < 0 || index >= getNumAttributes())
+		return false;
+
+	const XMLBinary::Attribute &attribute = m_pDocument->m_pAttributes[m_pDocument->m_pNodes[m_index].nFirstAttributeIndex + index];
+	*key = m_pDocument->GetString(attribute.nKeyStringIndex);
+	*value = m_pDocument->GetString(attribute.nValueStringIndex);
+	return true;
+}
+
+//------------------------------------------------------------------------
+const char* CXMLBinaryNode::FindValue(const char *key, uint32 hash) const
+{
+	if (!m_pDocument)
+		return 0;
+
+	const XMLBinary::Node &node = m_pDocument->m_pNodes[m_index];
+	for (int i=0; i<node.nAttributeCount; ++i)
+	{
+		const int attributeIndex = node.nFirstAttributeIndex + i;
+		if (m_pDocument->m_attributeHashes[attributeIndex] != hash)
+			continue;
+
+		const XMLBinary::Attribute &attribute = m_pDocument->m_pAttributes[attributeIndex];
+		if (KeyEquals(m_pDocument->GetString(attribute.nKeyStringIndex), key))
+			return m_pDocument->GetString(attribute.nValueStringIndex);
+	}
+	return 0;
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::haveAttr(const char *key) const
+{
+	return FindValue(key, CryNameHash(key)) != 0;
+}
+
+//------------------------------------------------------------------------
+const char* CXMLBinaryNode::getAttr(const char *key) const
+{
+	const char *value = FindValue(key, CryNameHash(key));
+	return value ? value : "";
+}
+
+//------------------------------------------------------------------------
+const char* CXMLBinaryNode::getAttr(const SCryNameHashed &key) const
+{
+	const char *value = FindValue(key.str, key.nHash);
+	return value ? value : "";
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::getAttr(const char *key, int &value) const
+{
+	const char *svalue = FindValue(key, CryNameHash(key));
+	if (!svalue)
+		return false;
+	value = atoi(svalue);
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::getAttr(const char *key, float &value) const
+{
+	const char *svalue = FindValue(key, CryNameHash(key));
+	if (!svalue)
+		return false;
+	value = (float)atof(svalue);
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::getAttr(const char *key, bool &value) const
+{
+	const char *svalue = FindValue(key, CryNameHash(key));
+	if (!svalue)
+		return false;
+	value = (atoi(svalue) != 0 || stricmp(svalue, "true") == 0);
+	return true;
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryNode::getAttr(const char *key, Vec3 &value) const
+{
+	const char *svalue = FindValue(key, CryNameHash(key));
+	if (!svalue)
+		return false;
+	float x, y, z;
+	if (sscanf(svalue, "%f,%f,%f", &x, &y, &z) != 3)
+		return false;
+	value.Set(x, y, z);
+	return true;
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryDocument::CXMLBinaryDocument()
+: m_pData(0),
+	m_size(0),
+	m_pNodes(0),
+	m_pAttributes(0),
+	m_pStrings(0),
+	m_pStringData(0),
+	m_nodeCount(0),
+	m_attributeCount(0),
+	m_stringCount(0),
+	m_pMapping(0),
+	m_mappedSize(0),
+	m_hFile(0),
+	m_hMapping(0)
+{
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryDocument::~CXMLBinaryDocument()
+{
+	Close();
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryDocument::Open(const char *fileName)
+{
+	Close();
+
+	ICryPak *pCryPak = gEnv->pCryPak;
+	FILE *pFile = pCryPak->FOpen(fileName, "rb");
+	if (!pFile)
+	{
+		GameWarning("[XMLBinary] Can't open '%s'", fileName);
+		return false;
+	}
+
+	if (!pCryPak->IsInPak(pFile))
+	{
+		pCryPak->FClose(pFile);
+
+		char path[ICryPak::g_nMaxPath];
+		const char *realPath = pCryPak->AdjustFileName(fileName, path, 0);
+		if (realPath && Map(realPath))
+			return Attach((const uint8*)m_pMapping, m_mappedSize, fileName);
+
+		// not mappable on this platform, read it like a file in a pak
+		pFile = pCryPak->FOpen(fileName, "rb");
+		if (!pFile)
+			return false;
+	}
+
+	m_buffer.resize(pCryPak->FGetSize(pFile));
+	const size_t read = m_buffer.empty() ? 0 : pCryPak->FReadRawAll(&m_buffer[0], m_buffer.size(), pFile);
+	pCryPak->FClose(pFile);
+
+	if (read != m_buffer.size())
+	{
+		GameWarning("[XMLBinary] Can't read '%s'", fileName);
+		Close();
+		return false;
+	}
+
+	return Attach(m_buffer.empty() ? 0 : &m_buffer[0], m_buffer.size(), fileName);
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryDocument::OpenMemory(const void *pData, size_t size)
+{
+	Close();
+	return Attach((const uint8*)pData, size, "memory");
+}
+
+//------------------------------------------------------------------------
+void CXMLBinaryDocument::Close()
+{
+	Unmap();
+	std::vector<uint8>().swap(m_buffer);
+	std::vector<int>().swap(m_childStart);
+	std::vector<int>().swap(m_children);
+	std::vector<uint32>().swap(m_attributeHashes);
+
+	m_pData = 0;
+	m_size = 0;
+	m_pNodes = 0;
+	m_pAttributes = 0;
+	m_pStrings = 0;
+	m_pStringData = 0;
+	m_nodeCount = 0;
+	m_attributeCount = 0;
+	m_stringCount = 0;
+}
+
+//------------------------------------------------------------------------
+CXMLBinaryNode CXMLBinaryDocument::GetRoot() const
+{
+	if (!m_pData)
+		return CXMLBinaryNode();
+	return CXMLBinaryNode(this, 0);
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryDocument::Map(const char *fileName)
+{
+#if defined(WIN32) && !defined(XENON)
+	HANDLE hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	const DWORD size = GetFileSize(hFile, 0);
+	HANDLE hMapping = (size != INVALID_FILE_SIZE && size > 0) ? CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0) : 0;
+	void *pMapping = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : 0;
+	if (!pMapping)
+	{
+		if (hMapping)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+	m_pMapping = pMapping;
+	m_mappedSize = size;
+	return true;
+#elif defined(LINUX)
+	const int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	void *pMapping = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		pMapping = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps the file referenced
+	close(fd);
+	if (pMapping == MAP_FAILED)
+		return false;
+
+	m_pMapping = pMapping;
+	m_mappedSize = st.st_size;
+	return true;
+#else
+	return false;
+#endif
+}
+
+//------------------------------------------------------------------------
+void CXMLBinaryDocument::Unmap()
+{
+	if (!m_pMapping)
+		return;
+
+#if defined(WIN32) && !defined(XENON)
+	UnmapViewOfFile(m_pMapping);
+	CloseHandle((HANDLE)m_hMapping);
+	CloseHandle((HANDLE)m_hFile);
+#elif defined(LINUX)
+	munmap(m_pMapping, m_mappedSize);
+#endif
+
+	m_pMapping = 0;
+	m_mappedSize = 0;
+	m_hMapping = 0;
+	m_hFile = 0;
+}
+
+//------------------------------------------------------------------------
+// checks every index of the file once, so the accessors don't have to
+bool CXMLBinaryDocument::Attach(const uint8 *pData, size_t size, const char *name)
+{
+	using namespace XMLBinary;
+
+	const BinaryFileHeader *pHeader = (const BinaryFileHeader*)pData;
+	const char *error = 0;
+
+	if (!pData || size < sizeof(BinaryFileHeader) || ((UINT_PTR)pData & 3))
+		error = "too small";
+	else if (memcmp(pHeader->szSignature, BINARY_SIGNATURE, sizeof(BINARY_SIGNATURE)) != 0)
+		error = "not a binary XML file";
+	else if (pHeader->nXMLSize < 0 || (size_t)pHeader->nXMLSize > size || pHeader->nNodeCount < 1 ||
+		!TableFits(pHeader->nNodeTablePosition, pHeader->nNodeCount, sizeof(Node), pHeader->nXMLSize) ||
+		!TableFits(pHeader->nAttributeTablePosition, pHeader->nAttributeCount, sizeof(Attribute), pHeader->nXMLSize) ||
+		!TableFits(pHeader->nStringTablePosition, pHeader->nStringCount, sizeof(String), pHeader->nXMLSize) ||
+		pHeader->nStringDataPosition < 0 || pHeader->nStringDataSize < 0 ||
+		(uint64)pHeader->nStringDataPosition + (uint64)pHeader->nStringDataSize > (uint64)pHeader->nXMLSize)
+		error = "the tables don't fit the file";
+
+	if (!error)
+	{
+		m_pData = pData;
+		m_size = pHeader->nXMLSize;
+		m_pNodes = (const Node*)(pData + pHeader->nNodeTablePosition);
+		m_pAttributes = (const Attribute*)(pData + pHeader->nAttributeTablePosition);
+		m_pStrings = (const String*)(pData + pHeader->nStringTablePosition);
+		m_pStringData = (const char*)(pData + pHeader->nStringDataPosition);
+		m_nodeCount = pHeader->nNodeCount;
+		m_attributeCount = pHeader->nAttributeCount;
+		m_stringCount = pHeader->nStringCount;
+
+		for (int i=0; i<m_stringCount && !error; ++i)
+		{
+			const String &str = m_pStrings[i];
+			if (str.nPosition < 0 || str.nLength < 0 || (int64)str.nPosition + str.nLength >= pHeader->nStringDataSize ||
+				m_pStringData[str.nPosition + str.nLength] != 0)
+				error = "a string is out of range or not terminated";
+		}
+
+		for (int i=0; i<m_nodeCount && !error; ++i)
+		{
+			const Node &node = m_pNodes[i];
+			if ((unsigned)node.nTagStringIndex >= (unsigned)m_stringCount || (unsigned)node.nContentStringIndex >= (unsigned)m_stringCount)
+				error = "a node string is out of range";
+			else if (i == 0 ? node.nParentIndex != -1 : (node.nParentIndex < 0 || node.nParentIndex >= i))
+				error = "the nodes are not in document order";
+			else if (node.nFirstAttributeIndex < 0 || node.nAttributeCount < 0 ||
+				(int64)node.nFirstAttributeIndex + node.nAttributeCount > m_attributeCount)
+				error = "node attributes are out of range";
+		}
+
+		for (int i=0; i<m_attributeCount && !error; ++i)
+		{
+			const Attribute &attribute = m_pAttributes[i];
+			if ((unsigned)attribute.nKeyStringIndex >= (unsigned)m_stringCount || (unsigned)attribute.nValueStringIndex >= (unsigned)m_stringCount)
+				error = "an attribute string is out of range";
+		}
+	}
+
+	if (error)
+	{
+		GameWarning("[XMLBinary] '%s': %s", name, error);
+		Close();
+		return false;
+	}
+
+	// children by parent, a counting sort keeps them in file order
+	m_childStart.assign(m_nodeCount+1, 0);
+	for (int i=1; i<m_nodeCount; ++i)
+		++m_childStart[m_pNodes[i].nParentIndex+1];
+	for (int i=0; i<m_nodeCount; ++i)
+		m_childStart[i+1] += m_childStart[i];
+
+	m_children.resize(m_nodeCount-1);
+	std::vector<int> next(m_childStart.begin(), m_childStart.end()-1);
+	for (int i=1; i<m_nodeCount; ++i)
+		m_children[next[m_pNodes[i].nParentIndex]++] = i;
+
+	m_attributeHashes.resize(m_attributeCount);
+	for (int i=0; i<m_attributeCount; ++i)
+		m_attributeHashes[i] = CryNameHash(GetString(m_pAttributes[i].nKeyStringIndex));
+
+	return true;
+}
+
+//------------------------------------------------------------------------
+// Converter
+//------------------------------------------------------------------------
+namespace
+{
+	struct SBinaryWriter
+	{
+		std::vector<XMLBinary::Node> nodes;
+		std::vector<XMLBinary::Attribute> attributes;
+		std::vector<XMLBinary::String> strings;
+		std::vector<char> stringData;
+		std::map<string, int> stringIndices;
+
+		int AddString(const char *str)
+		{
+			if (!str)
+				str = "";
+
+			std::map<string, int>::iterator it = stringIndices.find(CONST_TEMP_STRING(str));
+			if (it != stringIndices.end())
+				return it->second;
+
+			XMLBinary::String entry;
+			entry.nPosition = (int)stringData.size();
+			entry.nLength = (int)strlen(str);
+			stringData.insert(stringData.end(), str, str + entry.nLength + 1);
+
+			const int index = (int)strings.size();
+			strings.push_back(entry);
+			stringIndices.insert(std::make_pair(string(str), index));
+			return index;
+		}
+
+		// the node comes before its children and its attributes before theirs
+		void AddNode(const XmlNodeRef &node, int parent)
+		{
+			const int index = (int)nodes.size();
+			nodes.push_back(XMLBinary::Node());
+			nodes[index].nTagStringIndex = AddString(node->getTag());
+			nodes[index].nContentStringIndex = AddString(node->getContent());
+			nodes[index].nParentIndex = parent;
+			nodes[index].nFirstAttributeIndex = (int)attributes.size();
+			nodes[index].nAttributeCount = node->getNumAttributes();
+
+			for (int i=0; i<nodes[index].nAttributeCount; ++i)
+			{
+				const char *key = "", *value = "";
+				node->getAttributeByIndex(i, &key, &value);
+				XMLBinary::Attribute attribute;
+				attribute.nKeyStringIndex = AddString(key);
+				attribute.nValueStringIndex = AddString(value);
+				attributes.push_back(attribute);
+			}
+
+			const int childCount = node->getChildCount();
+			for (int i=0; i<childCount; ++i)
+				AddNode(node->getChild(i), index);
+		}
+	};
+
+	template <class T> void AppendTable(std::vector<uint8> &out, const std::vector<T> &table)
+	{
+		if (!table.empty())
+			out.insert(out.end(), (const uint8*)&table[0], (const uint8*)&table[0] + table.size()*sizeof(T));
+	}
+}
+
+//------------------------------------------------------------------------
+void CXMLBinaryDocument::Write(const XmlNodeRef &root, std::vector<uint8> &out)
+{
+	SBinaryWriter writer;
+	writer.AddNode(root, -1);
+
+	XMLBinary::BinaryFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.szSignature, BINARY_SIGNATURE, sizeof(BINARY_SIGNATURE));
+	header.nNodeTablePosition = sizeof(header);
+	header.nNodeCount = (int)writer.nodes.size();
+	header.nAttributeTablePosition = header.nNodeTablePosition + header.nNodeCount * sizeof(XMLBinary::Node);
+	header.nAttributeCount = (int)writer.attributes.size();
+	header.nStringTablePosition = header.nAttributeTablePosition + header.nAttributeCount * sizeof(XMLBinary::Attribute);
+	header.nStringCount = (int)writer.strings.size();
+	header.nStringDataPosition = header.nStringTablePosition + header.nStringCount * sizeof(XMLBinary::String);
+	header.nStringDataSize = (int)writer.stringData.size();
+	header.nXMLSize = header.nStringDataPosition + header.nStringDataSize;
+
+	out.clear();
+	out.reserve(header.nXMLSize);
+	out.insert(out.end(), (const uint8*)&header, (const uint8*)&header + sizeof(header));
+	AppendTable(out, writer.nodes);
+	AppendTable(out, writer.attributes);
+	AppendTable(out, writer.strings);
+	AppendTable(out, writer.stringData);
+	assert((int)out.size() == header.nXMLSize);
+}
+
+//------------------------------------------------------------------------
+bool CXMLBinaryDocument::ConvertFile(const char *xmlFile, const char *binaryFile)
+{
+	XmlNodeRef root = GetISystem()->LoadXmlFile(xmlFile);
+	if (!root)
+	{
+		GameWarning("[XMLBinary] Can't load '%s'", xmlFile);
+		return false;
+	}
+
+	std::vector<uint8> data;
+	Write(root, data);
+
+	ICryPak *pCryPak = gEnv->pCryPak;
+	pCryPak->MakeDir(PathUtil::GetPath(string(binaryFile)).c_str());
+	FILE *pFile = pCryPak->FOpen(binaryFile, "wb");
+	if (!pFile)
+	{
+		GameWarning("[XMLBinary] Can't write '%s'", binaryFile);
+		return false;
+	}
+
+	const bool written = pCryPak->FWrite(&data[0], data.size(), 1, pFile) == 1;
+	pCryPak->FClose(pFile);
+	return written;
+}
+
+//------------------------------------------------------------------------
+// Benchmark
+//------------------------------------------------------------------------
+namespace
+{
+	struct SWalkStats
+	{
+		SWalkStats() : nodes(0), attributes(0), checksum(2166136261u), errors(0) {}
+
+		int nodes;
+		int attributes;
+		uint32 checksum;
+		int errors;
+
+		// case sensitive, unlike CryNameHash, the formats have to agree on every character
+		void Add(const char *str)
+		{
+			do
+			{
+				checksum = (checksum ^ (uint8)*str) * 16777619u;
+			} while (*str++);
+		}
+	};
+
+	// reads everything a loader would: tags, content, and every attribute by index and by name
+	void WalkText(const XmlNodeRef &node, SWalkStats &stats)
+	{
+		++stats.nodes;
+		stats.Add(node->getTag());
+		stats.Add(node->getContent());
+
+		const int attributeCount = node->getNumAttributes();
+		for (int i=0; i<attributeCount; ++i)
+		{
+			const char *key = "", *value = "";
+			node->getAttributeByIndex(i, &key, &value);
+			stats.Add(key);
+			stats.Add(value);
+			if (strcmp(node->getAttr(key), value) != 0)
+				++stats.errors;
+		}
+		stats.attributes += attributeCount;
+
+		const int childCount = node->getChildCount();
+		for (int i=0; i<childCount; ++i)
+			WalkText(node->getChild(i), stats);
+	}
+
+	void WalkBinary(const CXMLBinaryNode &node, SWalkStats &stats)
+	{
+		++stats.nodes;
+		stats.Add(node.getTag());
+		stats.Add(node.getContent());
+
+		const int attributeCount = node.getNumAttributes();
+		for (int i=0; i<attributeCount; ++i)
+		{
+			const char *key = "", *value = "";
+			node.getAttributeByIndex(i, &key, &value);
+			stats.Add(key);
+			stats.Add(value);
+			if (strcmp(node.getAttr(key), value) != 0)
+				++stats.errors;
+		}
+		stats.attributes += attributeCount;
+
+		const int childCount = node.getChildCount();
+		for (int i=0; i<childCount; ++i)
+			WalkBinary(node.getChild(i), stats);
+	}
+}
+
+//------------------------------------------------------------------------
+void CXMLBinaryDocument::FindXmlFiles(const string &folder, std::vector<string> &files, size_t &totalSize)
+{
+	ICryPak *pCryPak = gEnv->pCryPak;
+	_finddata_t fd;
+	intptr_t handle = pCryPak->FindFirst((folder + "/*.*").c_str(), &fd);
+	if (handle == -1)
+		return;
+
+	do
+	{
+		if (!strcmp(fd.name, ".") || !strcmp(fd.name, ".."))
+			continue;
+
+		if (fd.attrib & _A_SUBDIR)
+			FindXmlFiles(folder + "/" + fd.name, files, totalSize);
+		else if (!stricmp(PathUtil::GetExt(fd.name), "xml"))
+		{
+			files.push_back(folder + "/" + fd.name);
+			totalSize += fd.size;
+		}
+	} while (pCryPak->FindNext(handle, &fd) >= 0);
+
+	pCryPak->FindClose(handle);
+}
+
+//------------------------------------------------------------------------
+void CXMLBinaryDocument::Benchmark(const char *folder, const char *binaryFolder)
+{
+	std::vector<string> files;
+	size_t textSize = 0;
+	FindXmlFiles(PathUtil::RemoveSlash(folder), files, textSize);
+	if (files.empty())
+	{
+		GameWarning("[XMLBinary] No XML files in '%s'", folder);
+		return;
+	}
+
+	std::vector<string> binaryFiles(files.size());
+	for (int i=0; i<(int)files.size(); ++i)
+	{
+		binaryFiles[i] = PathUtil::RemoveSlash(binaryFolder) + "/" + files[i];
+		if (!ConvertFile(files[i].c_str(), binaryFiles[i].c_str()))
+			binaryFiles[i].clear();
+	}
+
+	// text as the game loads it now
+	std::vector<SWalkStats> textStats(files.size());
+	CTimeValue start = gEnv->pTimer->GetAsyncTime();
+	for (int i=0; i<(int)files.size(); ++i)
+	{
+		if (XmlNodeRef root = GetISystem()->LoadXmlFile(files[i].c_str()))
+			WalkText(root, textStats[i]);
+	}
+	const float textTime = (gEnv->pTimer->GetAsyncTime()-start).GetSeconds();
+
+	std::vector<SWalkStats> binaryStats(files.size());
+	size_t binarySize = 0;
+	int mapped = 0;
+	start = gEnv->pTimer->GetAsyncTime();
+	for (int i=0; i<(int)files.size(); ++i)
+	{
+		CXMLBinaryDocument document;
+		if (!binaryFiles[i].empty() && document.Open(binaryFiles[i].c_str()))
+		{
+			WalkBinary(document.GetRoot(), binaryStats[i]);
+			binarySize += document.GetSize();
+			mapped += document.IsMapped() ? 1 : 0;
+		}
+	}
+	const float binaryTime = (gEnv->pTimer->GetAsyncTime()-start).GetSeconds();
+
+	int nodes = 0, attributes = 0, mismatches = 0;
+	for (int i=0; i<(int)files.size(); ++i)
+	{
+		nodes += textStats[i].nodes;
+		attributes += textStats[i].attributes;
+		if (textStats[i].nodes != binaryStats[i].nodes || textStats[i].attributes != binaryStats[i].attributes ||
+			textStats[i].checksum != binaryStats[i].checksum || textStats[i].errors || binaryStats[i].errors)
+		{
+			GameWarning("[XMLBinary] '%s' reads differently in binary form", files[i].c_str());
+			++mismatches;
+		}
+	}
+
+	CryLogAlways("[XMLBinary] %d files (%d mapped), %d nodes, %d attributes: text %d KB in %.3fms, binary %d KB in %.3fms (%.1fx), %d mismatches",
+		(int)files.size(), mapped, nodes, attributes, (int)(textSize/1024), textTime*1000.0f, (int)(binarySize/1024), binaryTime*1000.0f,
+		binaryTime > 0.0f ? textTime/binaryTime : 0.0f, mismatches);
+}
@@ -0,0 +1,141 @@
+// -------------------------------------------------------------------------
+// Crytek Source File.
+// Copyright (C) Crytek GmbH, 2001-2008.
+// -------------------------------------------------------------------------
+#ifndef __XML_BINARY_DOCUMENT_H__
+#define __XML_BINARY_DOCUMENT_H__
+
+#pragma once
+
+#include <XMLBinaryHeaders.h>
+#include <CryName.h>
+
+// Read-only access to binary XML files (XMLBinaryHeaders.h layout).
+// Loose files are memory mapped, files in paks are read into one buffer.
+// Nodes and attributes are read straight from the tables of the file and
+// every string is returned as a pointer into its string data, nothing is
+// parsed or copied. Opening builds two small indices: the children of
+// every node, and the hashed name of every attribute (CryNameHash, so
+// names match like CCryName, case insensitive by default), so an
+// attribute lookup compares integers before it compares a string.
+//
+// CXMLBinaryNode mirrors the reading half of IXmlNode, code that reads an
+// XmlNodeRef can switch over by changing the type. Nodes are small values
+// and stay valid as long as the document is open.
+
+class CXMLBinaryDocument;
+
+class CXMLBinaryNode
+{
+public:
+	CXMLBinaryNode() : m_pDocument(0), m_index(-1) {}
+
+	bool IsValid() const { return m_pDocument != 0; }
+
+	const char* getTag() const;
+	bool isTag(const char *tag) const;
+	const char* getContent() const;
+
+	int getChildCount() const;
+	CXMLBinaryNode getChild(int i) const;
+	// first child with the tag, invalid if there is none
+	CXMLBinaryNode findChild(const char *tag) const;
+	CXMLBinaryNode getParent() const;
+
+	int getNumAttributes() const;
+	bool getAttributeByIndex(int index, const char **key, const char **value) const;
+
+	bool haveAttr(const char *key) const;
+	// value of the attribute, "" if the node doesn't have it
+	const char* getAttr(const char *key) const;
+	// with the name hashed at compile time: getAttr(CRY_NAME_LITERAL("name"))
+	const char* getAttr(const SCryNameHashed &key) const;
+
+	bool getAttr(const char *key, int &value) const;
+	bool getAttr(const char *key, float &value) const;
+	bool getAttr(const char *key, bool &value) const;
+	bool getAttr(const char *key, Vec3 &value) const;
+
+private:
+	friend class CXMLBinaryDocument;
+
+	CXMLBinaryNode(const CXMLBinaryDocument *pDocument, int index) : m_pDocument(pDocument), m_index(index) {}
+
+	// the value string of the attribute, 0 if there is none
+	const char* FindValue(const char *key, uint32 hash) const;
+
+	const CXMLBinaryDocument *m_pDocument;
+	int m_index;
+};
+
+class CXMLBinaryDocument
+{
+public:
+	CXMLBinaryDocument();
+	~CXMLBinaryDocument();
+
+	// maps a loose file or reads it from its pak, returns false (and logs why) if it
+	// is not a valid binary XML file
+	bool Open(const char *fileName);
+	// uses data the caller keeps alive and unchanged while the document is open
+	bool OpenMemory(const void *pData, size_t size);
+	void Close();
+
+	bool IsOpen() const { return m_pData != 0; }
+	bool IsMapped() const { return m_pMapping != 0; }
+	size_t GetSize() const { return m_size; }
+
+	// invalid if the document is not open
+	CXMLBinaryNode GetRoot() const;
+
+	// Converter: writes the tree below root in binary form. Strings are pooled, every
+	// distinct string is stored once.
+	static void Write(const XmlNodeRef &root, std::vector<uint8> &out);
+	// loads a text XML file and writes it in binary form
+	static bool ConvertFile(const char *xmlFile, const char *binaryFile);
+	// appends every XML file below the folder, and adds their sizes to totalSize
+	static void FindXmlFiles(const string &folder, std::vector<string> &files, size_t &totalSize);
+
+	// loads every XML file below the folder as text and, converted, in binary form, checks
+	// that both read the same and logs the time each format takes
+	static void Benchmark(const char *folder, const char *binaryFolder);
+
+private:
+	friend class CXMLBinaryNode;
+
+	CXMLBinaryDocument(const CXMLBinaryDocument&);
+	CXMLBinaryDocument& operator=(const CXMLBinaryDocument&);
+
+	bool Map(const char *fileName);
+	void Unmap();
+	bool Attach(const uint8 *pData, size_t size, const char *name);
+
+	const char* GetString(int index) const { return m_pStringData + m_pStrings[index].nPosition; }
+
+	const uint8 *m_pData;
+	size_t m_size;
+
+	const XMLBinary::Node *m_pNodes;
+	const XMLBinary::Attribute *m_pAttributes;
+	const XMLBinary::String *m_pStrings;
+	const char *m_pStringData;
+	int m_nodeCount;
+	int m_attributeCount;
+	int m_stringCount;
+
+	// children of node i are m_children[m_childStart[i] .. m_childStart[i+1]), in file order
+	std::vector<int> m_childStart;
+	std::vector<int> m_children;
+	// CryNameHash of every attribute name, parallel to the attribute table
+	std::vector<uint32> m_attributeHashes;
+
+	// the mapped file, or the file read from a pak
+	void *m_pMapping;
+	// the length of the view, m_size is only the part the header covers
+	size_t m_mappedSize;
+	void *m_hFile;
+	void *m_hMapping;
+	std::vector<uint8> m_buffer;
+};
+
+#endif //__XML_BINARY_DOCUMENT_H__